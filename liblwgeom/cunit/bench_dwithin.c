@@ -0,0 +1,208 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+/*
+** Within distance throughput. Points of interest are matched against
+** the roads, routes and parcels whose boxes come within the tolerance,
+** as an index scan would hand them over, once by comparing the minimum
+** distance with the tolerance and once with lwgeom_dwithin2d. Prints
+** the rate in pairs per second of each. Run with "make bench".
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "liblwgeom_internal.h"
+
+#define BENCH_POIS 2000
+#define BENCH_FEATURES 200
+#define BENCH_EXTENT 10000.0
+
+/* Each case runs over the candidate pairs this many times */
+#define BENCH_ROUNDS 5
+
+static double bench_rand(void)
+{
+	return (double) rand() / RAND_MAX;
+}
+
+/* A road wandering away from (x, y) in steps of about step */
+static POINTARRAY* bench_road(double x, double y, int npoints, double step)
+{
+	POINTARRAY *pa = ptarray_construct_empty(LW_FALSE, LW_FALSE, npoints);
+	double heading = bench_rand() * 2 * M_PI;
+	POINT4D pt;
+	int i;
+
+	pt.z = pt.m = 0.0;
+	for ( i = 0; i < npoints; i++ )
+	{
+		pt.x = x;
+		pt.y = y;
+		ptarray_append_point(pa, &pt, LW_TRUE);
+		heading += (bench_rand() - 0.5) * 0.5;
+		x += step * cos(heading);
+		y += step * sin(heading);
+	}
+	return pa;
+}
+
+/* A parcel of npoints vertices around (x, y) */
+static LWGEOM* bench_parcel(double x, double y, int npoints, double radius)
+{
+	POINTARRAY **rings = lwalloc(sizeof(POINTARRAY*));
+	POINT4D pt;
+	int i;
+
+	rings[0] = ptarray_construct_empty(LW_FALSE, LW_FALSE, npoints + 1);
+	pt.z = pt.m = 0.0;
+	for ( i = 0; i <= npoints; i++ )
+	{
+		int j = i % npoints;
+		double r = radius * (0.8 + 0.2 * sin(j * 0.3));
+		pt.x = x + r * cos(2 * M_PI * j / npoints);
+		pt.y = y + r * sin(2 * M_PI * j / npoints);
+		ptarray_append_point(rings[0], &pt, LW_TRUE);
+	}
+	return lwpoly_as_lwgeom(lwpoly_construct(SRID_UNKNOWN, NULL, 1, rings));
+}
+
+static LWGEOM* bench_feature(int kind)
+{
+	double x = bench_rand() * BENCH_EXTENT;
+	double y = bench_rand() * BENCH_EXTENT;
+	LWCOLLECTION *col;
+	int i;
+
+	switch ( kind )
+	{
+	case LINETYPE:
+		return lwline_as_lwgeom(lwline_construct(SRID_UNKNOWN, NULL, bench_road(x, y, 200, 10.0)));
+	case MULTILINETYPE:
+		col = lwcollection_construct_empty(MULTILINETYPE, SRID_UNKNOWN, LW_FALSE, LW_FALSE);
+		for ( i = 0; i < 20; i++ )
+		{
+			POINTARRAY *pa = bench_road(x + bench_rand() * 500, y + bench_rand() * 500, 30, 10.0);
+			col = lwcollection_add_lwgeom(col, lwline_as_lwgeom(lwline_construct(SRID_UNKNOWN, NULL, pa)));
+		}
+		return lwcollection_as_lwgeom(col);
+	default:
+		return bench_parcel(x, y, 500, 300.0);
+	}
+}
+
+static void bench_dwithin(const char *name, LWGEOM **pois, int npois, LWGEOM **features, int nfeatures, double tolerance)
+{
+	int *pairs = lwalloc(sizeof(int) * 2 * npois * nfeatures);
+	int npairs = 0;
+	int i, j, round, found_distance = 0, found_dwithin = 0;
+	clock_t start;
+	double distance_secs, dwithin_secs;
+
+	/* The pairs an index would hand over */
+	for ( i = 0; i < npois; i++ )
+	{
+		for ( j = 0; j < nfeatures; j++ )
+		{
+			GBOX box = *(pois[i]->bbox);
+			gbox_expand(&box, tolerance);
+			if ( gbox_overlaps_2d(&box, features[j]->bbox) )
+			{
+				pairs[2 * npairs] = i;
+				pairs[2 * npairs + 1] = j;
+				npairs++;
+			}
+		}
+	}
+
+	start = clock();
+	for ( round = 0; round < BENCH_ROUNDS; round++ )
+	{
+		for ( i = 0; i < npairs; i++ )
+			found_distance += lwgeom_mindistance2d_tolerance(pois[pairs[2*i]], features[pairs[2*i+1]], tolerance) <= tolerance;
+	}
+	distance_secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	start = clock();
+	for ( round = 0; round < BENCH_ROUNDS; round++ )
+	{
+		for ( i = 0; i < npairs; i++ )
+			found_dwithin += lwgeom_dwithin2d(pois[pairs[2*i]], features[pairs[2*i+1]], tolerance);
+	}
+	dwithin_secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	if ( found_distance != found_dwithin )
+		printf("%s: %d pairs within by distance, %d by dwithin\n", name, found_distance, found_dwithin);
+
+	printf("%-28s %8d pairs %6d within %12.0f pairs/s distance %12.0f pairs/s dwithin\n", name,
+	       npairs, found_dwithin / BENCH_ROUNDS,
+	       npairs * BENCH_ROUNDS / distance_secs, npairs * BENCH_ROUNDS / dwithin_secs);
+
+	lwfree(pairs);
+}
+
+int main(void)
+{
+	LWGEOM *pois[BENCH_POIS];
+	LWGEOM *features[BENCH_FEATURES];
+	LWGEOM *roads[BENCH_FEATURES];
+	int kinds[] = {LINETYPE, MULTILINETYPE, POLYGONTYPE};
+	const char *names[] = {"poi near road, %gm", "poi near route, %gm", "poi near parcel, %gm"};
+	double tolerances[] = {10.0, 100.0};
+	char name[64];
+	int i, k, t;
+
+	srand(1);
+
+	for ( i = 0; i < BENCH_POIS; i++ )
+	{
+		pois[i] = lwpoint_as_lwgeom(lwpoint_make2d(SRID_UNKNOWN, bench_rand() * BENCH_EXTENT, bench_rand() * BENCH_EXTENT));
+		lwgeom_add_bbox(pois[i]);
+	}
+
+	printf("Within distance, %d points against %d features, %d rounds\n", BENCH_POIS, BENCH_FEATURES, BENCH_ROUNDS);
+
+	for ( k = 0; k < 3; k++ )
+	{
+		for ( i = 0; i < BENCH_FEATURES; i++ )
+		{
+			features[i] = bench_feature(kinds[k]);
+			lwgeom_add_bbox(features[i]);
+		}
+		for ( t = 0; t < 2; t++ )
+		{
+			snprintf(name, sizeof(name), names[k], tolerances[t]);
+			bench_dwithin(name, pois, BENCH_POIS, features, BENCH_FEATURES, tolerances[t]);
+		}
+		for ( i = 0; i < BENCH_FEATURES; i++ )
+			lwgeom_free(features[i]);
+	}
+
+	/* Roads against other roads, big enough for the edge trees */
+	for ( i = 0; i < BENCH_FEATURES; i++ )
+	{
+		features[i] = bench_feature(LINETYPE);
+		lwgeom_add_bbox(features[i]);
+		roads[i] = bench_feature(LINETYPE);
+		lwgeom_add_bbox(roads[i]);
+	}
+	bench_dwithin("road near road, 10m", roads, BENCH_FEATURES, features, BENCH_FEATURES, 10.0);
+	for ( i = 0; i < BENCH_FEATURES; i++ )
+	{
+		lwgeom_free(features[i]);
+		lwgeom_free(roads[i]);
+	}
+
+	for ( i = 0; i < BENCH_POIS; i++ )
+		lwgeom_free(pois[i]);
+	return 0;
+}
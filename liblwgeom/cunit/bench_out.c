@@ -0,0 +1,104 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+/*
+** Text output throughput. Writes a random linestring in each text
+** format over and over and prints the rate in MB of text per second.
+** Run with "make bench".
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "liblwgeom_internal.h"
+
+/* Roughly this many bytes of text are written for each case */
+#define BENCH_BYTES (64 * 1024 * 1024)
+
+#define BENCH_WKT 0
+#define BENCH_GEOJSON 1
+#define BENCH_GML 2
+#define BENCH_KML 3
+#define BENCH_SVG 4
+#define BENCH_X3D 5
+
+static char* bench_write(const LWGEOM *geom, int format, int precision)
+{
+	switch (format)
+	{
+	case BENCH_WKT:
+		return lwgeom_to_wkt(geom, WKT_ISO, precision, NULL);
+	case BENCH_GEOJSON:
+		return lwgeom_to_geojson(geom, NULL, precision, 0);
+	case BENCH_GML:
+		return lwgeom_to_gml3(geom, NULL, precision, 0, "gml:", NULL);
+	case BENCH_KML:
+		return lwgeom_to_kml2(geom, precision, "");
+	case BENCH_SVG:
+		return lwgeom_to_svg(geom, precision, 0);
+	default:
+		return lwgeom_to_x3d3(geom, NULL, precision, 0, "");
+	}
+}
+
+static void bench_out(const char *name, const LWGEOM *geom, int format, int precision)
+{
+	char *out = bench_write(geom, format, precision);
+	size_t len = strlen(out);
+	long i, n = BENCH_BYTES / len + 1;
+	clock_t start;
+	double secs;
+
+	lwfree(out);
+	start = clock();
+	for ( i = 0; i < n; i++ )
+		lwfree(bench_write(geom, format, precision));
+
+	secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+	printf("%-28s %10ld geoms %9.1f MB/s %12.0f geoms/s\n", name, n,
+	       n * len / secs / (1024.0 * 1024.0), n / secs);
+}
+
+int main(void)
+{
+	POINTARRAY *pa;
+	LWGEOM *line;
+	POINT4D pt;
+	int i;
+
+	srand(1);
+
+	pa = ptarray_construct_empty(LW_TRUE, LW_FALSE, 1000);
+	for ( i = 0; i < 1000; i++ )
+	{
+		pt.x = (rand() - RAND_MAX / 2) / 1234.5678;
+		pt.y = (rand() - RAND_MAX / 2) / 1234.5678;
+		pt.z = rand() / 1234.5678;
+		pt.m = 0;
+		ptarray_append_point(pa, &pt, LW_TRUE);
+	}
+	line = lwline_as_lwgeom(lwline_construct(SRID_UNKNOWN, NULL, pa));
+
+	printf("Text output, linestring z of 1000 points, %d MB per case\n", BENCH_BYTES / (1024 * 1024));
+
+	bench_out("wkt, 15 digits", line, BENCH_WKT, 15);
+	bench_out("wkt, 6 digits", line, BENCH_WKT, 6);
+	bench_out("geojson, 15 decimals", line, BENCH_GEOJSON, 15);
+	bench_out("geojson, 6 decimals", line, BENCH_GEOJSON, 6);
+	bench_out("gml3, 15 decimals", line, BENCH_GML, 15);
+	bench_out("kml, 15 decimals", line, BENCH_KML, 15);
+	bench_out("svg, 15 decimals", line, BENCH_SVG, 15);
+	bench_out("x3d, 15 decimals", line, BENCH_X3D, 15);
+
+	lwgeom_free(line);
+	return 0;
+}
@@ -0,0 +1,104 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+/*
+** WKT input throughput. Parses generated WKT of a few shapes
+** over and over and prints the rate in MB of text per second.
+** Run with "make bench".
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "liblwgeom_internal.h"
+#include "stringbuffer.h"
+
+/* Roughly this many bytes of WKT are parsed for each case */
+#define BENCH_BYTES (64 * 1024 * 1024)
+
+/* Random coordinates, the first point repeated at the end to close rings */
+static char* bench_points_wkt(const char *prefix, const char *suffix, int npoints, int ndims, int closed)
+{
+	stringbuffer_t *sb = stringbuffer_create();
+	char *wkt;
+	double first[4];
+	int i, j;
+
+	stringbuffer_append(sb, prefix);
+	for ( i = 0; i < npoints; i++ )
+	{
+		if ( i ) stringbuffer_append(sb, ",");
+		for ( j = 0; j < ndims; j++ )
+		{
+			double d = (closed && i == npoints - 1) ? first[j] : (rand() - RAND_MAX / 2) / 1234.5678;
+			if ( i == 0 ) first[j] = d;
+			stringbuffer_aprintf(sb, "%s%.15g", j ? " " : "", d);
+		}
+	}
+	stringbuffer_append(sb, suffix);
+	wkt = stringbuffer_getstringcopy(sb);
+	stringbuffer_destroy(sb);
+	return wkt;
+}
+
+static void bench_wkt(const char *name, const char *wkt)
+{
+	size_t len = strlen(wkt);
+	long i, n = BENCH_BYTES / len + 1;
+	clock_t start = clock();
+	double secs;
+
+	for ( i = 0; i < n; i++ )
+		lwgeom_free(lwgeom_from_wkt(wkt, LW_PARSER_CHECK_ALL));
+
+	secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+	printf("%-28s %10ld geoms %9.1f MB/s %12.0f geoms/s\n", name, n,
+	       n * len / secs / (1024.0 * 1024.0), n / secs);
+}
+
+int main(void)
+{
+	char *wkt;
+
+	srand(1);
+
+	printf("WKT input, %d MB per case\n", BENCH_BYTES / (1024 * 1024));
+
+	bench_wkt("point", "POINT(-71.0603 42.3583)");
+	bench_wkt("point z", "POINT Z (-71.0603 42.3583 12.5)");
+	bench_wkt("srid point", "SRID=4326;POINT(-71.0603 42.3583)");
+
+	wkt = bench_points_wkt("LINESTRING(", ")", 10, 2, LW_FALSE);
+	bench_wkt("linestring, 10 points", wkt);
+	lwfree(wkt);
+
+	wkt = bench_points_wkt("LINESTRING(", ")", 1000, 2, LW_FALSE);
+	bench_wkt("linestring, 1000 points", wkt);
+	lwfree(wkt);
+
+	wkt = bench_points_wkt("LINESTRING Z (", ")", 1000, 3, LW_FALSE);
+	bench_wkt("linestring z, 1000 points", wkt);
+	lwfree(wkt);
+
+	wkt = bench_points_wkt("MULTIPOINT(", ")", 100, 2, LW_FALSE);
+	bench_wkt("multipoint, 100 points", wkt);
+	lwfree(wkt);
+
+	wkt = bench_points_wkt("POLYGON((", "))", 100, 2, LW_TRUE);
+	bench_wkt("polygon, 100 points", wkt);
+	lwfree(wkt);
+
+	/* Curves always take the grammar */
+	bench_wkt("circularstring", "CIRCULARSTRING(0 0,1 1,2 0,3 -1,4 0)");
+
+	return 0;
+}
@@ -225,6 +225,100 @@ static void test_twkb_in_precision(void)
 }
 
 
+/*
+** Read a collection with an idlist back member by member, all at
+** once and then cut into chunks of every size.
+*/
+static void cu_twkb_in_iterator(char *wkt, int64_t *idlist, uint8_t iter_variant)
+{
+	LWGEOM *g = lwgeom_from_wkt(wkt, LW_PARSER_CHECK_NONE);
+	LWCOLLECTION *col = lwgeom_as_lwcollection(g);
+	LWTWKB_ITERATOR *it;
+	LWGEOM *member;
+	uint8_t *twkb_a, *twkb_b, *twkb;
+	size_t size_a, size_b, size;
+	int64_t id;
+	int has_id, n;
+	size_t chunk, i;
+	char *ewkt_a, *ewkt_b;
+
+	/* With ids, then again without, which comes out whole */
+	twkb_a = lwgeom_to_twkb_with_idlist(g, idlist, iter_variant, 0, 0, 0, &size_a);
+	twkb_b = lwgeom_to_twkb(g, iter_variant, 0, 0, 0, &size_b);
+	size = size_a + size_b;
+	twkb = lwalloc(size);
+	memcpy(twkb, twkb_a, size_a);
+	memcpy(twkb + size_a, twkb_b, size_b);
+	lwfree(twkb_a);
+	lwfree(twkb_b);
+
+	for ( chunk = 0; chunk <= size; chunk++ )
+	{
+		/* Chunk size zero reads everything in place */
+		if ( chunk )
+		{
+			it = lwtwkb_iterator_create_stream(LW_PARSER_CHECK_NONE);
+			lwtwkb_iterator_append(it, twkb, 0);
+		}
+		else
+		{
+			it = lwtwkb_iterator_create(twkb, size, LW_PARSER_CHECK_NONE);
+		}
+
+		n = 0;
+		i = 0;
+		while ( LW_TRUE )
+		{
+			member = lwtwkb_iterator_next(it, &id, &has_id);
+			if ( ! member )
+			{
+				if ( ! chunk || i >= size )
+					break;
+				lwtwkb_iterator_append(it, twkb + i, FP_MIN(chunk, size - i));
+				i += chunk;
+				if ( i >= size )
+					lwtwkb_iterator_end(it);
+				continue;
+			}
+
+			if ( n < col->ngeoms )
+			{
+				CU_ASSERT(has_id);
+				CU_ASSERT_EQUAL(id, idlist[n]);
+				ewkt_a = lwgeom_to_ewkt(col->geoms[n]);
+			}
+			else
+			{
+				CU_ASSERT(! has_id);
+				ewkt_a = lwgeom_to_ewkt(g);
+			}
+			ewkt_b = lwgeom_to_ewkt(member);
+			CU_ASSERT_STRING_EQUAL(ewkt_a, ewkt_b);
+			lwfree(ewkt_a);
+			lwfree(ewkt_b);
+			lwgeom_free(member);
+			n++;
+		}
+		CU_ASSERT_EQUAL(n, col->ngeoms + 1);
+		lwtwkb_iterator_destroy(it);
+	}
+
+	lwfree(twkb);
+	lwgeom_free(g);
+}
+
+static void test_twkb_in_iterator(void)
+{
+	int64_t idlist[] = {10, -2, 3000000000LL};
+
+	cu_twkb_in_iterator("MULTIPOINT(1 2,3 4,-5 6)", idlist, 0);
+	cu_twkb_in_iterator("MULTILINESTRING((0 0 1,1 1 2),(2 2 3,4 4 5),(7 7 7,8 8 8))", idlist, 0);
+	cu_twkb_in_iterator("MULTIPOLYGON(((0 0,0 1,1 1,1 0,0 0)),((-1 -1,-1 2,2 2,2 -1,-1 -1),(0 0,0 1,1 1,1 0,0 0)),EMPTY)", idlist, 0);
+	cu_twkb_in_iterator("GEOMETRYCOLLECTION(POINT(1 2),LINESTRING(0 0,5 5),MULTIPOINT(1 1,2 2))", idlist, 0);
+	cu_twkb_in_iterator("GEOMETRYCOLLECTION(POINT(1 2),LINESTRING(0 0,5 5),MULTIPOINT(1 1,2 2))", idlist, TWKB_SIZE);
+	cu_twkb_in_iterator("MULTILINESTRING((0 0 1,1 1 2),(2 2 3,4 4 5),(7 7 7,8 8 8))", idlist, TWKB_BBOX);
+	cu_twkb_in_iterator("GEOMETRYCOLLECTION(POINT M (1 2 3),MULTIPOINT M (4 5 6,7 8 9),POINT M EMPTY)", idlist, TWKB_BBOX);
+}
 
 /*
 ** Used by test harness to register the tests in this file.
@@ -241,4 +335,5 @@ void twkb_in_suite_setup(void)
 	PG_ADD_TEST(suite, test_twkb_in_multipolygon);
 	PG_ADD_TEST(suite, test_twkb_in_collection);
 	PG_ADD_TEST(suite, test_twkb_in_precision);
+	PG_ADD_TEST(suite, test_twkb_in_iterator);
 }
@@ -211,6 +211,73 @@ static void test_wkb_in_multicurve(void) {}
 
 static void test_wkb_in_multisurface(void) {}
 
+/*
+** Reading straight into the serialized form must give the same
+** bytes as serializing what lwgeom_from_wkb() reads.
+*/
+static void cu_wkb_in_gserialized(char *wkt, uint8_t variant, int handled)
+{
+	LWGEOM *g = lwgeom_from_wkt(wkt, LW_PARSER_CHECK_NONE);
+	LWGEOM *g_b;
+	GSERIALIZED *gser_a, *gser_b;
+	uint8_t *wkb;
+	size_t wkb_size, size_a, size_b;
+
+	wkb = lwgeom_to_wkb(g, variant, &wkb_size);
+	gser_b = gserialized_from_wkb(wkb, wkb_size, LW_PARSER_CHECK_ALL, &size_b);
+
+	if ( ! handled )
+	{
+		CU_ASSERT_PTR_NULL(gser_b);
+		lwfree(wkb);
+		lwgeom_free(g);
+		return;
+	}
+
+	CU_ASSERT_PTR_NOT_NULL_FATAL(gser_b);
+	g_b = lwgeom_from_wkb(wkb, wkb_size, LW_PARSER_CHECK_ALL);
+	gser_a = gserialized_from_lwgeom(g_b, 0, &size_a);
+
+	CU_ASSERT_EQUAL(size_a, size_b);
+	if ( size_a == size_b )
+		CU_ASSERT_EQUAL(memcmp(gser_a, gser_b, size_a), 0);
+
+	lwfree(gser_a);
+	lwfree(gser_b);
+	lwfree(wkb);
+	lwgeom_free(g_b);
+	lwgeom_free(g);
+}
+
+static void test_wkb_in_gserialized(void)
+{
+	uint8_t variants[] = { WKB_ISO | WKB_NDR, WKB_ISO | WKB_XDR, WKB_EXTENDED | WKB_XDR, 0 };
+	uint8_t truncated[] = { 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+	int i;
+
+	for ( i = 0; variants[i]; i++ )
+	{
+		cu_wkb_in_gserialized("SRID=4326;POINT(1 2)", variants[i], 1);
+		cu_wkb_in_gserialized("POINT EMPTY", variants[i], 1);
+		cu_wkb_in_gserialized("LINESTRING ZM (0 0 1 2,1 1 3 4)", variants[i], 1);
+		cu_wkb_in_gserialized("LINESTRING(0 0,1 1,5 -2)", variants[i], 1);
+		cu_wkb_in_gserialized("SRID=4;POLYGON((0 0,10 0,10 10,0 0),(1 1,2 1,2 2,1 1))", variants[i], 1);
+		cu_wkb_in_gserialized("MULTIPOINT(1 2)", variants[i], 1);
+		cu_wkb_in_gserialized("MULTILINESTRING((0 0,1 1))", variants[i], 1);
+		cu_wkb_in_gserialized("MULTIPOLYGON(((0 0,10 0,10 10,0 0)),((20 20,30 20,30 30,20 20)))", variants[i], 1);
+		cu_wkb_in_gserialized("GEOMETRYCOLLECTION(POINT(1 2),GEOMETRYCOLLECTION(LINESTRING(0 0,1 1)),POLYGON EMPTY)", variants[i], 1);
+		cu_wkb_in_gserialized("GEOMETRYCOLLECTION EMPTY", variants[i], 1);
+
+		/* Left to lwgeom_from_wkb() */
+		cu_wkb_in_gserialized("CIRCULARSTRING(0 0,1 1,2 0)", variants[i], 0);
+		cu_wkb_in_gserialized("TRIANGLE((0 0,1 0,1 1,0 0))", variants[i], 0);
+		cu_wkb_in_gserialized("POLYGON((0 0,10 0,10 10,0 1))", variants[i], 0);
+		cu_wkb_in_gserialized("LINESTRING(0 0)", variants[i], 0);
+	}
+
+	CU_ASSERT_PTR_NULL(gserialized_from_wkb(truncated, sizeof(truncated), LW_PARSER_CHECK_ALL, NULL));
+}
+
 static void test_wkb_in_malformed(void)
 {
 	/* See http://trac.osgeo.org/postgis/ticket/1445 */
@@ -243,5 +310,6 @@ void wkb_in_suite_setup(void)
 	PG_ADD_TEST(suite, test_wkb_in_curvpolygon);
 	PG_ADD_TEST(suite, test_wkb_in_multicurve);
 	PG_ADD_TEST(suite, test_wkb_in_multisurface);
+	PG_ADD_TEST(suite, test_wkb_in_gserialized);
 	PG_ADD_TEST(suite, test_wkb_in_malformed);
 }
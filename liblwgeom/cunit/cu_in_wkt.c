@@ -15,6 +15,7 @@
 #include "CUnit/Basic.h"
 
 #include "liblwgeom_internal.h"
+#include "lwin_wkt.h"
 #include "cu_tester.h"
 
 /*
@@ -327,6 +328,65 @@ static void test_wkt_in_polyhedralsurface(void)
 
 }
 
+/*
+* The hand written parser must take the common cases and give the
+* same answers as the grammar, and leave it everything else.
+*/
+static void cu_wkt_in_fast(char *wkt, int handled)
+{
+	int rv = wkt_parse_fast(wkt, LW_PARSER_CHECK_ALL);
+	CU_ASSERT_EQUAL(rv, handled ? LW_SUCCESS : LW_FAILURE);
+	if ( rv == LW_SUCCESS )
+		lwgeom_free(global_parser_result.geom);
+	lwgeom_parser_result_init(&global_parser_result);
+}
+
+static void test_wkt_in_fast(void)
+{
+	LWGEOM *g;
+
+	cu_wkt_in_fast("POINT(1 2)", 1);
+	cu_wkt_in_fast(" point z ( 1 2 3 ) ", 1);
+	cu_wkt_in_fast("POINTM(1 2 3)", 1);
+	cu_wkt_in_fast("SRID=4326;MULTIPOINT((1 2),3 4,EMPTY)", 1);
+	cu_wkt_in_fast("MULTIPOLYGON(((0 0,1 0,1 1,0 0)),EMPTY)", 1);
+	cu_wkt_in_fast("GEOMETRYCOLLECTION(POINT(1 2),GEOMETRYCOLLECTION(LINESTRING(0 0,1 1)))", 1);
+
+	/* Curves, odd tokens and errors go to the grammar */
+	cu_wkt_in_fast("CIRCULARSTRING(0 0,1 1,2 0)", 0);
+	cu_wkt_in_fast("GEOMETRYCOLLECTION(POINT(1 2),CIRCULARSTRING(0 0,1 1,2 0))", 0);
+	cu_wkt_in_fast("POINT(1.5.3 2)", 0);
+	cu_wkt_in_fast("POINT(1 2,3 4)", 0);
+	cu_wkt_in_fast("POLYGON((0 0,1 0,1 1,0 1))", 0);
+
+	/* Same answers as the grammar */
+	s = "POINTM(1 2 3)";
+	r = cu_wkt_in(s, WKT_ISO);
+	CU_ASSERT_STRING_EQUAL(r, "POINT M (1 2 3)");
+	lwfree(r);
+
+	s = "MULTIPOINT((1 2),3 4,EMPTY)";
+	r = cu_wkt_in(s, WKT_ISO);
+	CU_ASSERT_STRING_EQUAL(r, "MULTIPOINT(1 2,3 4,EMPTY)");
+	lwfree(r);
+
+	s = "POINT(1.5.3 2)";
+	r = cu_wkt_in(s, WKT_EXTENDED);
+	CU_ASSERT_STRING_EQUAL(r, "POINT(1.5 0.3 2)");
+	lwfree(r);
+
+	/* Numbers are rounded like strtod() does */
+	g = lwgeom_from_wkt("POINT(0.1 -2.2250738585072014e-308)", LW_PARSER_CHECK_ALL);
+	CU_ASSERT_EQUAL(lwpoint_get_x((LWPOINT*)g), strtod("0.1", NULL));
+	CU_ASSERT_EQUAL(lwpoint_get_y((LWPOINT*)g), strtod("-2.2250738585072014e-308", NULL));
+	lwgeom_free(g);
+
+	g = lwgeom_from_wkt("POINT(9007199254740993 123456789012345678901234567890)", LW_PARSER_CHECK_ALL);
+	CU_ASSERT_EQUAL(lwpoint_get_x((LWPOINT*)g), strtod("9007199254740993", NULL));
+	CU_ASSERT_EQUAL(lwpoint_get_y((LWPOINT*)g), strtod("123456789012345678901234567890", NULL));
+	lwgeom_free(g);
+}
+
 static void test_wkt_in_errlocation(void)
 {
 	LWGEOM_PARSER_RESULT p;
@@ -367,5 +427,6 @@ void wkt_in_suite_setup(void)
 	PG_ADD_TEST(suite, test_wkt_in_multisurface);
 	PG_ADD_TEST(suite, test_wkt_in_tin);
 	PG_ADD_TEST(suite, test_wkt_in_polyhedralsurface);
+	PG_ADD_TEST(suite, test_wkt_in_fast);
 	PG_ADD_TEST(suite, test_wkt_in_errlocation);
 }
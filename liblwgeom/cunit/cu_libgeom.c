@@ -1072,6 +1072,221 @@ void test_gbox_same_2d(void)
     lwfree(s3);
 }
 
+static void test_gbox_get_sortable_hash(void)
+{
+	GBOX b1, b2, b3, b4;
+	gbox_init(&b1); gbox_init(&b2); gbox_init(&b3); gbox_init(&b4);
+
+	/* The curve visits the four quadrants in a U */
+	b1.xmin = b1.xmax = -1; b1.ymin = b1.ymax = -1;
+	b2.xmin = b2.xmax = -1; b2.ymin = b2.ymax = 1;
+	b3.xmin = b3.xmax = 1;  b3.ymin = b3.ymax = 1;
+	b4.xmin = b4.xmax = 1;  b4.ymin = b4.ymax = -1;
+	CU_ASSERT(gbox_get_sortable_hash(&b1) < gbox_get_sortable_hash(&b2));
+	CU_ASSERT(gbox_get_sortable_hash(&b2) < gbox_get_sortable_hash(&b3));
+	CU_ASSERT(gbox_get_sortable_hash(&b3) < gbox_get_sortable_hash(&b4));
+
+	/* Only the center matters */
+	b1.xmin = 0; b1.xmax = 2; b1.ymin = 0; b1.ymax = 2;
+	b2.xmin = b2.xmax = 1; b2.ymin = b2.ymax = 1;
+	CU_ASSERT_EQUAL(gbox_get_sortable_hash(&b1), gbox_get_sortable_hash(&b2));
+}
+
+static void test_gbox_get_sortable_morton(void)
+{
+	GBOX b1, b2, b3, b4;
+	gbox_init(&b1); gbox_init(&b2); gbox_init(&b3); gbox_init(&b4);
+
+	/* The curve visits the four quadrants in a Z */
+	b1.xmin = b1.xmax = -1; b1.ymin = b1.ymax = -1;
+	b2.xmin = b2.xmax = -1; b2.ymin = b2.ymax = 1;
+	b3.xmin = b3.xmax = 1;  b3.ymin = b3.ymax = -1;
+	b4.xmin = b4.xmax = 1;  b4.ymin = b4.ymax = 1;
+	CU_ASSERT(gbox_get_sortable_morton(&b1) < gbox_get_sortable_morton(&b2));
+	CU_ASSERT(gbox_get_sortable_morton(&b2) < gbox_get_sortable_morton(&b3));
+	CU_ASSERT(gbox_get_sortable_morton(&b3) < gbox_get_sortable_morton(&b4));
+
+	/* Only the center matters */
+	b1.xmin = 0; b1.xmax = 2; b1.ymin = 0; b1.ymax = 2;
+	b2.xmin = b2.xmax = 1; b2.ymin = b2.ymax = 1;
+	CU_ASSERT_EQUAL(gbox_get_sortable_morton(&b1), gbox_get_sortable_morton(&b2));
+}
+
+static void test_gserialized_check(void)
+{
+	int i = 0;
+	const char *wkt[] = {
+		"POINT EMPTY",
+		"POINT(1 1)",
+		"LINESTRING ZM (0 0 0 0,1 1 1 1)",
+		"POLYGON((0 0,1 0,1 1,0 0))",
+		"POLYGON((0 0,9 0,9 9,0 0),(1 1,2 1,2 2,1 1))",
+		"MULTIPOLYGON(((0 0,1 0,1 1,0 0)),EMPTY)",
+		"CURVEPOLYGON(COMPOUNDCURVE(CIRCULARSTRING(0 0,1 1,2 0),(2 0,0 0)))",
+		"TIN(((0 0,1 0,1 1,0 0)))",
+		"GEOMETRYCOLLECTION(POINT(1 1),GEOMETRYCOLLECTION(LINESTRING(0 0,1 1)))",
+		NULL
+	};
+
+	while ( wkt[i] )
+	{
+		LWGEOM *lw = lwgeom_from_wkt(wkt[i], LW_PARSER_CHECK_NONE);
+		GSERIALIZED *g;
+		uint8_t *buf;
+		size_t size, cut;
+
+		lwgeom_add_bbox(lw);
+		g = gserialized_from_lwgeom(lw, 0, &size);
+		CU_ASSERT_EQUAL(gserialized_check(g, size), LW_SUCCESS);
+
+		/* Short by any number of bytes */
+		for ( cut = 1; cut <= size; cut++ )
+			CU_ASSERT_EQUAL(gserialized_check(g, size - cut), LW_FAILURE);
+
+		/* Anything trailing */
+		buf = lwalloc(size + 8);
+		memcpy(buf, g, size);
+		memset(buf + size, 0, 8);
+		CU_ASSERT_EQUAL(gserialized_check((GSERIALIZED*)buf, size + 8), LW_FAILURE);
+		lwfree(buf);
+
+		/* A count running past the end */
+		{
+			uint8_t *count_ptr = g->data + 4;
+			uint32_t count;
+			if ( FLAGS_GET_BBOX(g->flags) )
+				count_ptr += gbox_serialized_size(g->flags);
+			memcpy(&count, count_ptr, 4);
+			count += 1000;
+			memcpy(count_ptr, &count, 4);
+			CU_ASSERT_EQUAL(gserialized_check(g, size), LW_FAILURE);
+		}
+
+		lwfree(g);
+		lwgeom_free(lw);
+		i++;
+	}
+}
+
+static void test_gserialized_set_gbox(void)
+{
+	LWGEOM *lw = lwgeom_from_wkt("LINESTRING(0 0,5 5)", LW_PARSER_CHECK_NONE);
+	GSERIALIZED *g, *g_box;
+	GBOX gbox, gbox_read;
+	size_t size;
+
+	/* Without a slot, a copy with one */
+	lwgeom_add_bbox(lw);
+	g = gserialized_from_lwgeom(lw, 0, &size);
+	CU_ASSERT(gserialized_has_bbox(g));
+	g = gserialized_drop_gbox(g);
+	CU_ASSERT(! gserialized_has_bbox(g));
+	CU_ASSERT_EQUAL(gserialized_check(g, size - 16), LW_SUCCESS);
+
+	gbox.flags = 0;
+	gbox.xmin = gbox.ymin = -1;
+	gbox.xmax = gbox.ymax = 1;
+	g_box = gserialized_set_gbox(g, &gbox);
+	CU_ASSERT(g_box != g);
+	CU_ASSERT_EQUAL(gserialized_check(g_box, size), LW_SUCCESS);
+	CU_ASSERT_EQUAL(gserialized_read_gbox_p(g_box, &gbox_read), LW_SUCCESS);
+	CU_ASSERT_DOUBLE_EQUAL(gbox_read.xmin, -1, 0.0);
+	CU_ASSERT_DOUBLE_EQUAL(gbox_read.ymax, 1, 0.0);
+	lwfree(g);
+
+	/* With a slot, in place */
+	gbox.xmin = gbox.ymin = 2;
+	gbox.xmax = gbox.ymax = 3;
+	g = gserialized_set_gbox(g_box, &gbox);
+	CU_ASSERT(g == g_box);
+	CU_ASSERT_EQUAL(gserialized_read_gbox_p(g, &gbox_read), LW_SUCCESS);
+	CU_ASSERT_DOUBLE_EQUAL(gbox_read.xmin, 2, 0.0);
+	CU_ASSERT_DOUBLE_EQUAL(gbox_read.ymax, 3, 0.0);
+
+	lwfree(g);
+	lwgeom_free(lw);
+}
+
+static void test_gserialized_peek(void)
+{
+	int i = 0, n, offset, npoints;
+	POINT4D p, q;
+	const char *wkt[] = {
+		"POINT EMPTY",
+		"POINT(1 2)",
+		"POINT ZM (1 2 3 4)",
+		"LINESTRING EMPTY",
+		"LINESTRING M (0 0 1,1 1 2,2 2 3)",
+		"CIRCULARSTRING(0 0,1 1,2 0)",
+		"TRIANGLE((0 0,1 0,1 1,0 0))",
+		"POLYGON EMPTY",
+		"POLYGON Z ((0 0 1,9 0 1,9 9 1,0 0 1),(1 1 2,2 1 2,2 2 2,1 1 2),(3 3 3,4 3 3,4 4 3,3 3 3))",
+		"MULTIPOLYGON(((0 0,1 0,1 1,0 0)),EMPTY,((5 5,6 5,6 6,5 5),(5.1 5.1,5.2 5.1,5.2 5.2,5.1 5.1)))",
+		"CURVEPOLYGON(COMPOUNDCURVE(CIRCULARSTRING(0 0,1 1,2 0),(2 0,0 0)))",
+		"CURVEPOLYGON EMPTY",
+		"MULTICURVE((0 0,1 1),CIRCULARSTRING(0 0,1 1,2 0))",
+		"TIN(((0 0,1 0,1 1,0 0)),((0 0,1 1,0 1,0 0)))",
+		"GEOMETRYCOLLECTION(POINT(1 1),POLYGON((0 0,1 0,1 1,0 0)),GEOMETRYCOLLECTION(LINESTRING(0 0,1 1)))",
+		"GEOMETRYCOLLECTION(POLYGON EMPTY,LINESTRING EMPTY)",
+		NULL
+	};
+
+	while ( wkt[i] )
+	{
+		LWGEOM *lw = lwgeom_from_wkt(wkt[i], LW_PARSER_CHECK_NONE);
+		GSERIALIZED *g;
+		size_t size;
+
+		/* With and without a cached box in front */
+		for ( n = 0; n < 2; n++ )
+		{
+			if ( n ) lwgeom_add_bbox(lw);
+			g = gserialized_from_lwgeom(lw, 0, &size);
+
+			CU_ASSERT_EQUAL(gserialized_peek_npoints(g), lwgeom_count_vertices(lw));
+			CU_ASSERT_EQUAL(gserialized_peek_nrings(g), lwgeom_count_rings(lw));
+
+			if ( lw->type == LINETYPE || lw->type == POINTTYPE )
+			{
+				POINTARRAY *pa = lw->type == POINTTYPE ? ((LWPOINT*)lw)->point : ((LWLINE*)lw)->points;
+				CU_ASSERT_EQUAL(gserialized_peek_count(g), pa->npoints);
+				for ( offset = 0; offset < pa->npoints; offset++ )
+				{
+					getPoint4d_p(pa, offset, &q);
+					CU_ASSERT_EQUAL(gserialized_peek_point(g, offset, &p), LW_SUCCESS);
+					CU_ASSERT(p.x == q.x && p.y == q.y && p.z == q.z && p.m == q.m);
+				}
+				CU_ASSERT_EQUAL(gserialized_peek_point(g, offset, &p), LW_FAILURE);
+			}
+			else if ( lw->type == POLYGONTYPE )
+			{
+				LWPOLY *poly = (LWPOLY*)lw;
+				int r;
+				CU_ASSERT_EQUAL(gserialized_peek_count(g), poly->nrings);
+				for ( r = 0; r < poly->nrings; r++ )
+				{
+					CU_ASSERT_EQUAL(gserialized_peek_ring_offset(g, r, &offset, &npoints), LW_SUCCESS);
+					CU_ASSERT_EQUAL(npoints, poly->rings[r]->npoints);
+					getPoint4d_p(poly->rings[r], npoints - 1, &q);
+					CU_ASSERT_EQUAL(gserialized_peek_point(g, offset + npoints - 1, &p), LW_SUCCESS);
+					CU_ASSERT(p.x == q.x && p.y == q.y && p.z == q.z && p.m == q.m);
+				}
+				CU_ASSERT_EQUAL(gserialized_peek_ring_offset(g, r, &offset, &npoints), LW_FAILURE);
+			}
+			else if ( lwgeom_is_collection(lw) )
+			{
+				CU_ASSERT_EQUAL(gserialized_peek_point(g, 0, &p), LW_FAILURE);
+				CU_ASSERT_EQUAL(gserialized_peek_ring_offset(g, 0, &offset, &npoints), LW_FAILURE);
+			}
+
+			lwfree(g);
+		}
+
+		lwgeom_free(lw);
+		i++;
+	}
+}
+
 /*
 ** Used by test harness to register the tests in this file.
 */
@@ -1101,5 +1316,10 @@ void libgeom_suite_setup(void)
 	PG_ADD_TEST(suite, test_lwgeom_as_curve);
 	PG_ADD_TEST(suite, test_lwgeom_scale);
 	PG_ADD_TEST(suite, test_gserialized_is_empty);
+	PG_ADD_TEST(suite, test_gserialized_check);
+	PG_ADD_TEST(suite, test_gserialized_peek);
+	PG_ADD_TEST(suite, test_gserialized_set_gbox);
     PG_ADD_TEST(suite, test_gbox_same_2d);
+	PG_ADD_TEST(suite, test_gbox_get_sortable_hash);
+	PG_ADD_TEST(suite, test_gbox_get_sortable_morton);
 }
@@ -400,6 +400,269 @@ static void test_rect_tree_intersects_tree(void)
 
 }
 
+#define TREEDISTTEST(str1, str2, expected_res) do_test_rect_tree_distance(str1, str2, expected_res, __LINE__)
+
+/* Measure through the trees and check against the brute force answer */
+static void do_test_rect_tree_distance(char *in1, char *in2, double expected_res, int line)
+{
+	LWGEOM *lw1 = lwgeom_from_wkt(in1, LW_PARSER_CHECK_NONE);
+	LWGEOM *lw2 = lwgeom_from_wkt(in2, LW_PARSER_CHECK_NONE);
+	LWGEOM *p1, *p2;
+	DISTPTS tree_dl, brute_dl;
+
+	lw_dist2d_distpts_init(&tree_dl, DIST_MIN);
+	lw_dist2d_distpts_init(&brute_dl, DIST_MIN);
+	CU_ASSERT_EQUAL(lw_dist2d_tree(lw1, NULL, lw2, NULL, &tree_dl), LW_SUCCESS);
+	lw_dist2d_recursive(lw1, lw2, &brute_dl);
+
+	if ( fabs(tree_dl.distance - brute_dl.distance) > 1e-12 ||
+	     ( expected_res >= 0 && fabs(tree_dl.distance - expected_res) > 0.00001 ) )
+	{
+		printf("test_rect_tree_distance failed (got %g, brute force %g, expected %g) at line %d\n",
+		       tree_dl.distance, brute_dl.distance, expected_res, line);
+		CU_FAIL();
+	}
+
+	/* The points are on their own geometries, the distance apart */
+	p1 = lwpoint_as_lwgeom(lwpoint_make2d(SRID_UNKNOWN, tree_dl.p1.x, tree_dl.p1.y));
+	p2 = lwpoint_as_lwgeom(lwpoint_make2d(SRID_UNKNOWN, tree_dl.p2.x, tree_dl.p2.y));
+	CU_ASSERT_DOUBLE_EQUAL(lwgeom_mindistance2d(p1, lw1), 0.0, 1e-9);
+	CU_ASSERT_DOUBLE_EQUAL(lwgeom_mindistance2d(p2, lw2), 0.0, 1e-9);
+	CU_ASSERT_DOUBLE_EQUAL(lwgeom_mindistance2d(p1, p2), tree_dl.distance, 1e-9);
+
+	lwgeom_free(p1);
+	lwgeom_free(p2);
+	lwgeom_free(lw1);
+	lwgeom_free(lw2);
+}
+
+/* Two wavy lines of n vertices, winding through each other */
+static LWGEOM* rect_tree_wave(int n, double phase, double offset)
+{
+	POINTARRAY *pa = ptarray_construct_empty(0, 0, n);
+	POINT4D pt;
+	int i;
+
+	pt.z = pt.m = 0.0;
+	for ( i = 0; i < n; i++ )
+	{
+		pt.x = i + phase;
+		pt.y = offset + 10 * sin(i * 0.37 + phase);
+		ptarray_append_point(pa, &pt, LW_TRUE);
+	}
+	return lwline_as_lwgeom(lwline_construct(SRID_UNKNOWN, NULL, pa));
+}
+
+static void assert_distpts_equal(const DISTPTS *dl, const DISTPTS *ref)
+{
+	CU_ASSERT_EQUAL(dl->distance, ref->distance);
+	CU_ASSERT_EQUAL(dl->p1.x, ref->p1.x);
+	CU_ASSERT_EQUAL(dl->p1.y, ref->p1.y);
+	CU_ASSERT_EQUAL(dl->p2.x, ref->p2.x);
+	CU_ASSERT_EQUAL(dl->p2.y, ref->p2.y);
+}
+
+/*
+* The loops over point arrays skip runs of segments in blocks, make sure
+* nothing is skipped whatever the kernel, the stride and the length of
+* the tail. The scalar kernels take every segment and give the answers
+* the others have to match.
+*/
+static void test_lw_dist2d_ptarray_kernels(void)
+{
+	int kernels[] = {DIST_KERNELS_SSE2, DIST_KERNELS_AVX};
+	double offsets[] = {0.0, 1e6};
+	LWGEOM *lw1, *lw2, *lw3;
+	POINTARRAY *pa1, *pa2, *pa3;
+	POINT4D p4;
+	POINT2D p, a, b;
+	DISTPTS dl, ref, refp;
+	double brute;
+	int i, k, o, n;
+
+	for ( o = 0; o < 2; o++ )
+	{
+		for ( n = 2; n < 40; n += 7 )
+		{
+			lw1 = rect_tree_wave(n, 0.0, offsets[o]);
+			lw2 = rect_tree_wave(n + 3, 0.5, offsets[o] + 20.5);
+			lw3 = lwgeom_force_4d(lw2);
+			pa1 = lwgeom_as_lwline(lw1)->points;
+			pa2 = lwgeom_as_lwline(lw2)->points;
+			pa3 = lwgeom_as_lwline(lw3)->points;
+			getPoint4d_p(pa1, n / 2, &p4);
+			p.x = p4.x;
+			p.y = p4.y + 3.0;
+
+			CU_ASSERT_EQUAL(lw_dist2d_set_kernels(DIST_KERNELS_SCALAR), LW_SUCCESS);
+			lw_dist2d_distpts_init(&ref, DIST_MIN);
+			lw_dist2d_ptarray_ptarray(pa1, pa2, &ref);
+			lw_dist2d_distpts_init(&refp, DIST_MIN);
+			lw_dist2d_pt_ptarray(&p, pa3, &refp);
+
+			/* Against every segment, one at a time */
+			brute = FLT_MAX;
+			for ( i = 1; i < pa3->npoints; i++ )
+			{
+				getPoint2d_p(pa3, i - 1, &a);
+				getPoint2d_p(pa3, i, &b);
+				brute = FP_MIN(brute, distance2d_pt_seg(&p, &a, &b));
+			}
+			CU_ASSERT_DOUBLE_EQUAL(refp.distance, brute, 1e-12 * (1.0 + offsets[o]));
+
+			for ( k = 0; k < 2; k++ )
+			{
+				/* Not built in or not supported by this CPU */
+				if ( lw_dist2d_set_kernels(kernels[k]) != LW_SUCCESS )
+					continue;
+
+				lw_dist2d_distpts_init(&dl, DIST_MIN);
+				lw_dist2d_ptarray_ptarray(pa1, pa2, &dl);
+				assert_distpts_equal(&dl, &ref);
+
+				/* 4D strides */
+				lw_dist2d_distpts_init(&dl, DIST_MIN);
+				lw_dist2d_ptarray_ptarray(pa1, pa3, &dl);
+				assert_distpts_equal(&dl, &ref);
+
+				lw_dist2d_distpts_init(&dl, DIST_MIN);
+				lw_dist2d_pt_ptarray(&p, pa3, &dl);
+				assert_distpts_equal(&dl, &refp);
+			}
+
+			lwgeom_free(lw1);
+			lwgeom_free(lw2);
+			lwgeom_free(lw3);
+		}
+	}
+
+	CU_ASSERT_EQUAL(lw_dist2d_set_kernels(DIST_KERNELS_AUTO), LW_SUCCESS);
+}
+
+#define DWITHINTEST(str1, str2, tolerance, expected) do_test_dwithin2d(str1, str2, tolerance, expected, __LINE__)
+
+static void do_test_dwithin2d(char *in1, char *in2, double tolerance, int expected, int line)
+{
+	LWGEOM *lw1 = lwgeom_from_wkt(in1, LW_PARSER_CHECK_NONE);
+	LWGEOM *lw2 = lwgeom_from_wkt(in2, LW_PARSER_CHECK_NONE);
+	int dwithin = lwgeom_dwithin2d(lw1, lw2, tolerance);
+
+	if ( dwithin != expected )
+	{
+		printf("test_lwgeom_dwithin2d failed (got %d expected %d) at line %d\n", dwithin, expected, line);
+		CU_FAIL();
+	}
+	else
+	{
+		CU_PASS();
+	}
+
+	lwgeom_free(lw1);
+	lwgeom_free(lw2);
+}
+
+static void test_lwgeom_dwithin2d(void)
+{
+	LWGEOM *lw1, *lw2;
+	double dist;
+
+	DWITHINTEST("POINT(0 0)", "LINESTRING(3 -1, 3 1)", 3.0, LW_TRUE);
+	DWITHINTEST("POINT(0 0)", "LINESTRING(3 -1, 3 1)", 2.999, LW_FALSE);
+	DWITHINTEST("LINESTRING(0 0, 10 10)", "LINESTRING(0 10, 10 0)", 0.0, LW_TRUE);
+	/* inside, far from the boundary */
+	DWITHINTEST("POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))", "POINT(5 5)", 0.0, LW_TRUE);
+	DWITHINTEST("LINESTRING(4 4, 5 5)", "POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))", 0.0, LW_TRUE);
+	/* in a hole */
+	DWITHINTEST("POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(2 2, 2 8, 8 8, 8 2, 2 2))", "POINT(5 5)", 3.0, LW_TRUE);
+	DWITHINTEST("POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(2 2, 2 8, 8 8, 8 2, 2 2))", "POINT(5 5)", 2.9, LW_FALSE);
+	/* only one part close enough */
+	DWITHINTEST("MULTILINESTRING((100 100, 200 200),(0 1, 1 1))", "POINT(0 0)", 1.0, LW_TRUE);
+	DWITHINTEST("MULTILINESTRING((100 100, 200 200),(0 1, 1 1))", "POINT(0 0)", 0.5, LW_FALSE);
+	DWITHINTEST("POINT(0 0)", "GEOMETRYCOLLECTION(MULTIPOINT(50 50, 60 60), LINESTRING(0 2, 2 0))", 1.5, LW_TRUE);
+	/* curves */
+	DWITHINTEST("CIRCULARSTRING(-1 0, 0 1, 1 0)", "POINT(0 3)", 2.0001, LW_TRUE);
+	DWITHINTEST("CIRCULARSTRING(-1 0, 0 1, 1 0)", "POINT(0 3)", 1.9999, LW_FALSE);
+	DWITHINTEST("CURVEPOLYGON(CIRCULARSTRING(-5 0, 0 5, 5 0, 0 -5, -5 0))", "MULTIPOINT(20 20, 1 1)", 0.0, LW_TRUE);
+	/* empties, alone and as parts */
+	DWITHINTEST("POINT EMPTY", "POINT(0 0)", 1e10, LW_FALSE);
+	DWITHINTEST("GEOMETRYCOLLECTION(POINT EMPTY, POINT(0 0))", "POINT(0 1)", 1.0, LW_TRUE);
+
+	/* Right at the distance, where the expanded box rounds short of the other one */
+	lw1 = lwgeom_from_wkt("POINT(465302.19747931801 0)", LW_PARSER_CHECK_NONE);
+	lw2 = lwgeom_from_wkt("POINT(1847817.2094783827 0)", LW_PARSER_CHECK_NONE);
+	lwgeom_add_bbox(lw1);
+	lwgeom_add_bbox(lw2);
+	CU_ASSERT_EQUAL(lwgeom_dwithin2d(lw1, lw2, lwgeom_mindistance2d(lw1, lw2)), LW_TRUE);
+	lwgeom_free(lw1);
+	lwgeom_free(lw2);
+	lw1 = lwgeom_from_wkt("LINESTRING(465302.19747931801 5, 465302.19747931801 -5)", LW_PARSER_CHECK_NONE);
+	lw2 = lwgeom_from_wkt("POLYGON((1847817.2094783827 0, 1847818 1, 1847818 -1, 1847817.2094783827 0))", LW_PARSER_CHECK_NONE);
+	lwgeom_add_bbox(lw1);
+	lwgeom_add_bbox(lw2);
+	CU_ASSERT_EQUAL(lwgeom_dwithin2d(lw1, lw2, lwgeom_mindistance2d(lw1, lw2)), LW_TRUE);
+	lwgeom_free(lw1);
+	lwgeom_free(lw2);
+
+	/* Big enough for the trees, right at the minimum distance */
+	lw1 = rect_tree_wave(500, 0.0, 0.0);
+	lw2 = rect_tree_wave(400, 0.5, 20.5);
+	dist = lwgeom_mindistance2d(lw1, lw2);
+	CU_ASSERT_EQUAL(lwgeom_dwithin2d(lw1, lw2, dist), LW_TRUE);
+	CU_ASSERT_EQUAL(lwgeom_dwithin2d(lw1, lw2, dist * (1 - 1e-9)), LW_FALSE);
+	CU_ASSERT_EQUAL(lwgeom_dwithin2d(lw1, lw2, dist * 10), LW_TRUE);
+	lwgeom_free(lw1);
+	lwgeom_free(lw2);
+}
+
+static void test_rect_tree_distance(void)
+{
+	LWGEOM *lw1, *lw2;
+	DISTPTS dl;
+	double tree_dist, brute_dist;
+
+	/* hiding between the tines of the comb */
+	TREEDISTTEST("POLYGON((0 0, 3 1, 0 2, 3 3, 0 4, 3 5, 0 6, 5 6, 5 0, 0 0))", "POLYGON((0.3 0.7, 0.3 0.8, 0.4 0.8, 0.4 0.7, 0.3 0.7))", -1);
+	/* crossing */
+	TREEDISTTEST("LINESTRING(0 0, 10 10)", "LINESTRING(0 10, 10 0)", 0.0);
+	/* inside, without touching */
+	TREEDISTTEST("POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))", "LINESTRING(2 2, 3 3)", 0.0);
+	TREEDISTTEST("POINT(5 5)", "MULTIPOLYGON(((20 20, 20 30, 30 30, 20 20)),((0 0, 0 10, 10 10, 10 0, 0 0)))", 0.0);
+	TREEDISTTEST("POLYGON((4 4, 4 6, 6 6, 6 4, 4 4))", "POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))", 0.0);
+	/* in a hole */
+	TREEDISTTEST("POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(2 2, 2 8, 8 8, 8 2, 2 2))", "POLYGON((4 4, 4 6, 6 6, 6 4, 4 4))", 2.0);
+	/* lone points, and a line that doesn't go anywhere */
+	TREEDISTTEST("MULTIPOINT(0 0, 10 0)", "MULTILINESTRING((5 5, 5 5),(20 0, 30 0))", sqrt(50));
+	TREEDISTTEST("GEOMETRYCOLLECTION(POINT(0 0), LINESTRING(0 10, 10 10))", "GEOMETRYCOLLECTION(POINT(5 8), LINESTRING(20 20, 30 30))", 2.0);
+	/* empty parts add nothing to the tree, nor to the brute force answer */
+	TREEDISTTEST("GEOMETRYCOLLECTION(POINT EMPTY, POINT(0 0), LINESTRING(0 10, 10 10))", "GEOMETRYCOLLECTION(LINESTRING EMPTY, POINT(5 8))", 2.0);
+
+	/* Big enough for lwgeom_mindistance2d to take the trees itself */
+	lw1 = rect_tree_wave(500, 0.0, 0.0);
+	lw2 = rect_tree_wave(400, 0.5, 20.5);
+	tree_dist = lwgeom_mindistance2d(lw1, lw2);
+	lw_dist2d_distpts_init(&dl, DIST_MIN);
+	lw_dist2d_recursive(lw1, lw2, &dl);
+	brute_dist = dl.distance;
+	CU_ASSERT(brute_dist > 0.0);
+	CU_ASSERT_DOUBLE_EQUAL(tree_dist, brute_dist, 1e-12);
+
+	/* Stop as soon as the tolerance is met */
+	CU_ASSERT(lwgeom_mindistance2d_tolerance(lw1, lw2, brute_dist + 1) <= brute_dist + 1);
+	CU_ASSERT_DOUBLE_EQUAL(lwgeom_mindistance2d_tolerance(lw1, lw2, brute_dist - 0.1), brute_dist, 1e-12);
+	lwgeom_free(lw1);
+	lwgeom_free(lw2);
+
+	/* Nothing to build a tree on */
+	lw1 = lwgeom_from_wkt("CIRCULARSTRING(0 0, 1 1, 2 0)", LW_PARSER_CHECK_NONE);
+	lw2 = lwgeom_from_wkt("LINESTRING EMPTY", LW_PARSER_CHECK_NONE);
+	lw_dist2d_distpts_init(&dl, DIST_MIN);
+	CU_ASSERT_EQUAL(lw_dist2d_tree(lw1, NULL, lw1, NULL, &dl), LW_FAILURE);
+	CU_ASSERT_EQUAL(lw_dist2d_tree(lw2, NULL, lw2, NULL, &dl), LW_FAILURE);
+	CU_ASSERT_EQUAL(dl.distance, FLT_MAX);
+	lwgeom_free(lw1);
+	lwgeom_free(lw2);
+}
+
 static void
 test_lwgeom_segmentize2d(void)
 {
@@ -1169,6 +1432,9 @@ void measures_suite_setup(void)
 	PG_ADD_TEST(suite, test_mindistance2d_tolerance);
 	PG_ADD_TEST(suite, test_rect_tree_contains_point);
 	PG_ADD_TEST(suite, test_rect_tree_intersects_tree);
+	PG_ADD_TEST(suite, test_rect_tree_distance);
+	PG_ADD_TEST(suite, test_lw_dist2d_ptarray_kernels);
+	PG_ADD_TEST(suite, test_lwgeom_dwithin2d);
 	PG_ADD_TEST(suite, test_lwgeom_segmentize2d);
 	PG_ADD_TEST(suite, test_lwgeom_locate_along);
 	PG_ADD_TEST(suite, test_lw_dist2d_pt_arc);
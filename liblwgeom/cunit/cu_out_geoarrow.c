@@ -0,0 +1,235 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CUnit/Basic.h"
+
+#include "liblwgeom_internal.h"
+#include "cu_tester.h"
+
+/* Buffers, in the order of the header */
+#define GA_VALIDITY 0
+#define GA_GEOMS 1
+#define GA_PARTS 2
+#define GA_RINGS 3
+#define GA_COORDS 4
+
+static uint8_t *blob = NULL;
+
+/* Build a column from WKT, NULL for a null row, and write it into blob */
+static void do_geoarrow(char **wkt, int n)
+{
+	LWGEOARROW *ga = lwgeoarrow_create();
+	LWGEOM *g;
+	int i;
+
+	for ( i = 0; i < n; i++ )
+	{
+		g = wkt[i] ? lwgeom_from_wkt(wkt[i], LW_PARSER_CHECK_NONE) : NULL;
+		lwgeoarrow_append(ga, g);
+		if ( g ) lwgeom_free(g);
+	}
+
+	if ( blob ) lwfree(blob);
+	blob = lwalloc(lwgeoarrow_size(ga));
+	lwgeoarrow_write(ga, blob);
+	lwgeoarrow_free(ga);
+}
+
+static int64_t ga_int64(size_t offset)
+{
+	int64_t val;
+	memcpy(&val, blob + offset, sizeof(int64_t));
+	return val;
+}
+
+/* Length of a buffer, in units of size */
+static int ga_count(int buffer, size_t size)
+{
+	return ga_int64(40 + 16 * buffer) / size;
+}
+
+static int32_t *ga_int32s(int buffer)
+{
+	CU_ASSERT_EQUAL(ga_int64(32 + 16 * buffer) % 64, 0);
+	return (int32_t*)(blob + ga_int64(32 + 16 * buffer));
+}
+
+static double *ga_doubles(void)
+{
+	return (double*)(blob + ga_int64(32 + 16 * GA_COORDS));
+}
+
+static void test_geoarrow_line(void)
+{
+	char *wkt[] = {"LINESTRING(0 0,1 1)", NULL, "LINESTRING(2 2,3 3,4 4)"};
+	int32_t *geoms;
+	double *coords;
+
+	do_geoarrow(wkt, 3);
+	CU_ASSERT(memcmp(blob, "GAR1", 4) == 0);
+	CU_ASSERT_EQUAL(blob[4], LINETYPE);
+	CU_ASSERT_EQUAL(blob[5], 2);
+	CU_ASSERT_EQUAL(ga_int64(16), 3);
+	CU_ASSERT_EQUAL(ga_int64(24), 1);
+
+	CU_ASSERT_EQUAL(ga_count(GA_VALIDITY, 1), 1);
+	CU_ASSERT_EQUAL(blob[ga_int64(32)], 5);
+
+	CU_ASSERT_EQUAL(ga_count(GA_GEOMS, 4), 4);
+	geoms = ga_int32s(GA_GEOMS);
+	CU_ASSERT_EQUAL(geoms[0], 0);
+	CU_ASSERT_EQUAL(geoms[1], 2);
+	CU_ASSERT_EQUAL(geoms[2], 2);
+	CU_ASSERT_EQUAL(geoms[3], 5);
+
+	CU_ASSERT_EQUAL(ga_count(GA_PARTS, 4), 0);
+	CU_ASSERT_EQUAL(ga_count(GA_RINGS, 4), 0);
+	CU_ASSERT_EQUAL(ga_count(GA_COORDS, 8), 10);
+	coords = ga_doubles();
+	CU_ASSERT_EQUAL(coords[3], 1);
+	CU_ASSERT_EQUAL(coords[9], 4);
+}
+
+static void test_geoarrow_point(void)
+{
+	char *wkt[] = {"POINT(1 2 3)", "POINT EMPTY", "POINT(4 5 6)"};
+	char *multi[] = {"POINT(1 2)", "MULTIPOINT(3 4,5 6)", "POINT EMPTY", NULL};
+	double *coords;
+	int32_t *geoms;
+
+	/* One coordinate a row */
+	wkt[1] = "POINT Z EMPTY";
+	do_geoarrow(wkt, 3);
+	CU_ASSERT_EQUAL(blob[4], POINTTYPE);
+	CU_ASSERT_EQUAL(blob[5], 3);
+	CU_ASSERT_EQUAL(blob[6], 1);
+	CU_ASSERT_EQUAL(blob[7], 0);
+	CU_ASSERT_EQUAL(ga_count(GA_VALIDITY, 1), 0);
+	CU_ASSERT_EQUAL(ga_count(GA_GEOMS, 4), 0);
+	CU_ASSERT_EQUAL(ga_count(GA_COORDS, 8), 9);
+	coords = ga_doubles();
+	CU_ASSERT_EQUAL(coords[2], 3);
+	CU_ASSERT(isnan(coords[3]));
+	CU_ASSERT(isnan(coords[5]));
+	CU_ASSERT_EQUAL(coords[6], 4);
+
+	/* Points with multipoints make multipoints */
+	do_geoarrow(multi, 4);
+	CU_ASSERT_EQUAL(blob[4], MULTIPOINTTYPE);
+	CU_ASSERT_EQUAL(ga_int64(24), 1);
+	CU_ASSERT_EQUAL(ga_count(GA_GEOMS, 4), 5);
+	geoms = ga_int32s(GA_GEOMS);
+	CU_ASSERT_EQUAL(geoms[1], 1);
+	CU_ASSERT_EQUAL(geoms[2], 3);
+	CU_ASSERT_EQUAL(geoms[3], 3);
+	CU_ASSERT_EQUAL(geoms[4], 3);
+	CU_ASSERT_EQUAL(ga_count(GA_COORDS, 8), 6);
+}
+
+static void test_geoarrow_polygon(void)
+{
+	char *poly[] = {"POLYGON((0 0,0 10,10 10,0 0),(1 1,1 2,2 2,1 1))", "POLYGON EMPTY", "POLYGON((0 0,0 1,1 1,1 0,0 0))"};
+	char *multi[] = {"POLYGON((0 0,0 1,1 1,0 0))", "MULTIPOLYGON(((0 0,0 1,1 1,0 0)),((2 2,2 3,3 3,2 2),(2 2,2 3,3 3,2 2)))"};
+	int32_t *geoms, *parts, *rings;
+
+	do_geoarrow(poly, 3);
+	CU_ASSERT_EQUAL(blob[4], POLYGONTYPE);
+	CU_ASSERT_EQUAL(ga_count(GA_GEOMS, 4), 4);
+	CU_ASSERT_EQUAL(ga_count(GA_PARTS, 4), 0);
+	CU_ASSERT_EQUAL(ga_count(GA_RINGS, 4), 4);
+	geoms = ga_int32s(GA_GEOMS);
+	rings = ga_int32s(GA_RINGS);
+	CU_ASSERT_EQUAL(geoms[1], 2);
+	CU_ASSERT_EQUAL(geoms[2], 2);
+	CU_ASSERT_EQUAL(geoms[3], 3);
+	CU_ASSERT_EQUAL(rings[1], 4);
+	CU_ASSERT_EQUAL(rings[2], 8);
+	CU_ASSERT_EQUAL(rings[3], 13);
+
+	do_geoarrow(multi, 2);
+	CU_ASSERT_EQUAL(blob[4], MULTIPOLYGONTYPE);
+	CU_ASSERT_EQUAL(ga_count(GA_GEOMS, 4), 3);
+	CU_ASSERT_EQUAL(ga_count(GA_PARTS, 4), 4);
+	CU_ASSERT_EQUAL(ga_count(GA_RINGS, 4), 5);
+	geoms = ga_int32s(GA_GEOMS);
+	parts = ga_int32s(GA_PARTS);
+	rings = ga_int32s(GA_RINGS);
+	CU_ASSERT_EQUAL(geoms[1], 1);
+	CU_ASSERT_EQUAL(geoms[2], 3);
+	CU_ASSERT_EQUAL(parts[1], 1);
+	CU_ASSERT_EQUAL(parts[2], 2);
+	CU_ASSERT_EQUAL(parts[3], 4);
+	CU_ASSERT_EQUAL(rings[4], 16);
+	CU_ASSERT_EQUAL(ga_count(GA_COORDS, 8), 32);
+}
+
+static void test_geoarrow_multiline(void)
+{
+	char *wkt[] = {"MULTILINESTRING((0 0,1 1),(2 2,3 3,4 4))", "LINESTRING(5 5,6 6)"};
+	int32_t *geoms, *parts;
+
+	do_geoarrow(wkt, 2);
+	CU_ASSERT_EQUAL(blob[4], MULTILINETYPE);
+	CU_ASSERT_EQUAL(ga_count(GA_RINGS, 4), 0);
+	geoms = ga_int32s(GA_GEOMS);
+	parts = ga_int32s(GA_PARTS);
+	CU_ASSERT_EQUAL(geoms[1], 2);
+	CU_ASSERT_EQUAL(geoms[2], 3);
+	CU_ASSERT_EQUAL(parts[1], 2);
+	CU_ASSERT_EQUAL(parts[2], 5);
+	CU_ASSERT_EQUAL(parts[3], 7);
+}
+
+static void test_geoarrow_errors(void)
+{
+	char *types[] = {"POINT(0 0)", "LINESTRING(0 0,1 1)"};
+	char *dims[] = {"POINT(0 0)", "POINT(0 0 0)"};
+	char *collection[] = {"GEOMETRYCOLLECTION(POINT(0 0))"};
+
+	cu_error_msg_reset();
+	do_geoarrow(types, 2);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "lwgeoarrow_append: cannot mix Point and LineString geometries");
+
+	cu_error_msg_reset();
+	do_geoarrow(dims, 2);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "lwgeoarrow_append: cannot mix geometries of different dimensions");
+
+	cu_error_msg_reset();
+	do_geoarrow(collection, 1);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "lwgeoarrow_append: unsupported geometry type: GeometryCollection");
+
+	/* Nothing but nulls */
+	collection[0] = NULL;
+	do_geoarrow(collection, 1);
+	CU_ASSERT_EQUAL(blob[4], 0);
+	CU_ASSERT_EQUAL(ga_int64(16), 1);
+	CU_ASSERT_EQUAL(ga_int64(24), 1);
+	CU_ASSERT_EQUAL(ga_count(GA_COORDS, 8), 0);
+
+	lwfree(blob);
+	blob = NULL;
+}
+
+/*
+** Used by test harness to register the tests in this file.
+*/
+void out_geoarrow_suite_setup(void);
+void out_geoarrow_suite_setup(void)
+{
+	CU_pSuite suite = CU_add_suite("geoarrow_output", NULL, NULL);
+	PG_ADD_TEST(suite, test_geoarrow_line);
+	PG_ADD_TEST(suite, test_geoarrow_point);
+	PG_ADD_TEST(suite, test_geoarrow_polygon);
+	PG_ADD_TEST(suite, test_geoarrow_multiline);
+	PG_ADD_TEST(suite, test_geoarrow_errors);
+}
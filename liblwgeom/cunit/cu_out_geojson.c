@@ -294,6 +294,42 @@ static void out_geojson_test_geoms(void)
 	    "lwgeom_to_geojson: 'MultiSurface' geometry type not supported");
 }
 
+static void out_geojson_test_stringbuffer(void)
+{
+	const char *wkt[] = {
+		"POINT(1.123456 2.123456)",
+		"POLYGON((0 1,2 3,4 5,0 1),(1 1,2 2,3 1,1 1))",
+		"GEOMETRYCOLLECTION(POINT(0 1),LINESTRING(0 0,1 1))",
+		"MULTIPOINT EMPTY"
+	};
+	stringbuffer_t *sb = stringbuffer_create_with_size(4);
+	stringbuffer_t *expected = stringbuffer_create();
+	LWGEOM *g;
+	char *h;
+	int i;
+
+	/* Appended back to back, as the output functions would write them */
+	for ( i = 0; i < 4; i++ )
+	{
+		g = lwgeom_from_wkt(wkt[i], LW_PARSER_CHECK_NONE);
+		if ( i ) stringbuffer_append(sb, ",");
+		lwgeom_to_geojson_sb(g, sb, 3);
+
+		h = lwgeom_to_geojson(g, NULL, 3, 0);
+		if ( i ) stringbuffer_append(expected, ",");
+		stringbuffer_append(expected, h);
+
+		lwfree(h);
+		lwgeom_free(g);
+	}
+
+	CU_ASSERT_STRING_EQUAL(stringbuffer_getstring(sb), stringbuffer_getstring(expected));
+	CU_ASSERT_EQUAL(stringbuffer_getlength(sb), stringbuffer_getlength(expected));
+
+	stringbuffer_destroy(expected);
+	stringbuffer_destroy(sb);
+}
+
 /*
 ** Used by test harness to register the tests in this file.
 */
@@ -306,4 +342,5 @@ void out_geojson_suite_setup(void)
 	PG_ADD_TEST(suite, out_geojson_test_srid);
 	PG_ADD_TEST(suite, out_geojson_test_bbox);
 	PG_ADD_TEST(suite, out_geojson_test_geoms);
+	PG_ADD_TEST(suite, out_geojson_test_stringbuffer);
 }
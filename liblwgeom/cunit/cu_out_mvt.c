@@ -0,0 +1,144 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CUnit/Basic.h"
+
+#include "liblwgeom_internal.h"
+#include "cu_tester.h"
+
+static void do_mvt_geom_test(char *in, double xmin, double ymin, double xmax, double ymax, uint32_t extent, uint32_t buffer, int clip, char *out)
+{
+	LWGEOM *g, *t;
+	GBOX bounds;
+	char *w;
+
+	bounds.flags = 0;
+	bounds.xmin = xmin;
+	bounds.ymin = ymin;
+	bounds.xmax = xmax;
+	bounds.ymax = ymax;
+
+	g = lwgeom_from_wkt(in, LW_PARSER_CHECK_NONE);
+	t = lwgeom_to_mvt_geom(g, &bounds, extent, buffer, clip);
+
+	if ( ! out )
+	{
+		CU_ASSERT_PTR_NULL(t);
+		lwgeom_free(g);
+		if ( t ) lwgeom_free(t);
+		return;
+	}
+
+	CU_ASSERT_PTR_NOT_NULL_FATAL(t);
+	w = lwgeom_to_wkt(t, WKT_ISO, 8, NULL);
+	if ( strcmp(w, out) )
+		fprintf(stderr, "\nIn:   %s\nOut:  %s\nTheo: %s\n", in, w, out);
+	CU_ASSERT_STRING_EQUAL(w, out);
+
+	lwfree(w);
+	lwgeom_free(t);
+	lwgeom_free(g);
+}
+
+static void do_mvt_geometry_test(char *in, uint8_t type, char *out)
+{
+	LWGEOM *g = lwgeom_from_wkt(in, LW_PARSER_CHECK_NONE);
+	uint8_t *mvt, mvt_type;
+	size_t size, i;
+	char *h;
+
+	mvt = lwgeom_to_mvt_geometry(g, &mvt_type, &size);
+	CU_ASSERT_EQUAL(mvt_type, type);
+
+	h = lwalloc(2 * size + 1);
+	for ( i = 0; i < size; i++ )
+		sprintf(h + 2 * i, "%02x", mvt[i]);
+	h[2 * size] = '\0';
+
+	if ( strcmp(h, out) )
+		fprintf(stderr, "\nIn:   %s\nOut:  %s\nTheo: %s\n", in, h, out);
+	CU_ASSERT_STRING_EQUAL(h, out);
+
+	lwfree(h);
+	if ( mvt ) lwfree(mvt);
+	lwgeom_free(g);
+}
+
+static void test_mvt_geom(void)
+{
+	/* Origin at the upper left corner */
+	do_mvt_geom_test("POINT(25 17)", 0, 0, 4096, 4096, 4096, 0, 1, "POINT(25 4079)");
+	do_mvt_geom_test("LINESTRING(0 0,10 10)", 0, 0, 10, 10, 10, 0, 1, "LINESTRING(0 10,10 0)");
+	do_mvt_geom_test("POINT(15 15)", 10, 10, 20, 20, 4096, 0, 1, "POINT(2048 2048)");
+
+	/* Snapped, dropping the repeated points and the dimensions above 2 */
+	do_mvt_geom_test("LINESTRING Z (0 0 1,0.2 0.2 2,5 5 3)", 0, 0, 10, 10, 10, 0, 1, "LINESTRING(0 10,5 5)");
+	do_mvt_geom_test("POLYGON((0 0,10 0,10 10,0.1 10,0 10,0 0))", 0, 0, 10, 10, 10, 0, 1,
+	                 "POLYGON((0 10,10 10,10 0,0 0,0 10))");
+	do_mvt_geom_test("MULTIPOINT(1 1,1 1,2 2)", 0, 0, 10, 10, 10, 0, 0, "MULTIPOINT(1 9,2 8)");
+	do_mvt_geom_test("MULTIPOINT(1 1,1.2 1.2,2 2)", 0, 0, 10, 10, 10, 0, 0, "MULTIPOINT(1 9,2 8)");
+
+	/* Too small to be seen */
+	do_mvt_geom_test("POLYGON((0 0,0.1 0,0.1 0.1,0 0.1,0 0))", 0, 0, 10, 10, 10, 0, 1, NULL);
+
+	/* Outside of the tile and its buffer */
+	do_mvt_geom_test("POINT(-1 5)", 0, 0, 10, 10, 10, 0, 1, NULL);
+	do_mvt_geom_test("POINT(-1 5)", 0, 0, 10, 10, 10, 2, 1, "POINT(-1 5)");
+	do_mvt_geom_test("POINT(-1 5)", 0, 0, 10, 10, 10, 0, 0, "POINT(-1 5)");
+
+	/* Clipped to the tile */
+	do_mvt_geom_test("LINESTRING(-100 100,100 100)", 0, 0, 4096, 4096, 4096, 0, 1, "LINESTRING(0 3996,100 3996)");
+
+	/* Collections keep the parts of highest dimension */
+	do_mvt_geom_test("GEOMETRYCOLLECTION(POINT(1 1),LINESTRING(0 0,10 10))", 0, 0, 10, 10, 10, 0, 1,
+	                 "MULTILINESTRING((0 10,10 0))");
+
+	/* Empty */
+	do_mvt_geom_test("POINT EMPTY", 0, 0, 10, 10, 10, 0, 1, NULL);
+}
+
+/*
+** Examples from the vector tile specification, section 4.3.5
+*/
+static void test_mvt_geometry(void)
+{
+	do_mvt_geometry_test("POINT(25 17)", 1, "093222");
+	do_mvt_geometry_test("MULTIPOINT(5 7,3 2)", 1, "110a0e0309");
+	do_mvt_geometry_test("LINESTRING(2 2,2 10,10 10)", 2, "0904041200101000");
+	do_mvt_geometry_test("MULTILINESTRING((2 2,2 10,10 10),(1 1,3 5))", 2,
+	                     "09040412001010000911110a0408");
+	do_mvt_geometry_test("POLYGON((3 6,8 12,20 34,3 6))", 3, "09060c120a0c182c0f");
+
+	/* Rings are oriented, exterior clockwise on screen */
+	do_mvt_geometry_test("POLYGON((3 6,20 34,8 12,3 6))", 3, "09060c120a0c182c0f");
+	do_mvt_geometry_test("MULTIPOLYGON(((0 0,10 0,10 10,0 10,0 0)),((11 11,20 11,20 20,11 20,11 11),(13 13,13 17,17 17,17 13,13 13)))", 3,
+	                     "0900001a1400001413000f0916021a1200001211000f09040d1a0008080000070f");
+
+	/* Repeated points are skipped */
+	do_mvt_geometry_test("LINESTRING(2 2,2 2,2 10,10 10)", 2, "0904041200101000");
+
+	/* Nothing to draw */
+	do_mvt_geometry_test("LINESTRING(2 2,2 2)", 0, "");
+	do_mvt_geometry_test("POLYGON EMPTY", 0, "");
+}
+
+/*
+** Used by test harness to register the tests in this file.
+*/
+void out_mvt_suite_setup(void);
+void out_mvt_suite_setup(void)
+{
+	CU_pSuite suite = CU_add_suite("mvt_output", NULL, NULL);
+	PG_ADD_TEST(suite, test_mvt_geom);
+	PG_ADD_TEST(suite, test_mvt_geometry);
+}
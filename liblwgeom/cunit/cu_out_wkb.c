@@ -198,6 +198,60 @@ static void test_wkb_out_polyhedralsurface(void)
 //	printf("\nnew: %s\nold: %s\n",s,t);
 }
 
+/*
+** Writing from the serialized form must give the same bytes
+** as writing from the deserialized geometry.
+*/
+static void cu_wkb_gserialized(char *wkt, uint8_t variant)
+{
+	LWGEOM *g = lwgeom_from_wkt(wkt, LW_PARSER_CHECK_NONE);
+	GSERIALIZED *gser = gserialized_from_lwgeom(g, 0, NULL);
+	uint8_t *wkb_a, *wkb_b;
+	size_t size_a, size_b;
+
+	wkb_a = lwgeom_to_wkb(g, variant, &size_a);
+	wkb_b = gserialized_to_wkb(gser, variant, &size_b);
+
+	CU_ASSERT_EQUAL(size_a, size_b);
+	if ( size_a == size_b )
+		CU_ASSERT_EQUAL(memcmp(wkb_a, wkb_b, size_a), 0);
+
+	lwfree(wkb_a);
+	lwfree(wkb_b);
+	lwfree(gser);
+	lwgeom_free(g);
+}
+
+static void test_wkb_out_gserialized(void)
+{
+	char *wkt[] = {
+		"SRID=4326;POINT(0 0 0 0)",
+		"POINT EMPTY",
+		"LINESTRING M (0 0 1,1 1 2)",
+		"SRID=4;POLYGON((0 0,10 0,10 10,0 10,0 0),(1 1,2 1,2 2,1 1))",
+		"POLYGON EMPTY",
+		"MULTIPOINT(EMPTY,1 2)",
+		"SRID=4326;MULTIPOLYGON(((0 0,10 0,10 10,0 0)),((20 20,30 20,30 30,20 20)))",
+		"GEOMETRYCOLLECTION(POINT(1 2),GEOMETRYCOLLECTION(LINESTRING(0 0,1 1)),POLYGON EMPTY)",
+		"GEOMETRYCOLLECTION EMPTY",
+		"TRIANGLE((0 0,1 0,1 1,0 0))",
+		"SRID=4326;COMPOUNDCURVE(CIRCULARSTRING(0 0,1 1,2 0),(2 0,3 0))",
+		"POLYHEDRALSURFACE(((0 0 0,0 0 1,0 1 1,0 0 0)))",
+		NULL
+	};
+	uint8_t variants[] = {
+		WKB_ISO | WKB_NDR, WKB_ISO | WKB_XDR,
+		WKB_EXTENDED | WKB_NDR, WKB_EXTENDED | WKB_XDR,
+		WKB_SFSQL, WKB_EXTENDED | WKB_HEX,
+		0
+	};
+	int i, j;
+
+	for ( i = 0; wkt[i]; i++ )
+		for ( j = 0; variants[j]; j++ )
+			cu_wkb_gserialized(wkt[i], variants[j]);
+}
+
 /*
 ** Used by test harness to register the tests in this file.
 */
@@ -218,4 +272,5 @@ void wkb_out_suite_setup(void)
 	PG_ADD_TEST(suite, test_wkb_out_multicurve);
 	PG_ADD_TEST(suite, test_wkb_out_multisurface);
 	PG_ADD_TEST(suite, test_wkb_out_polyhedralsurface);
+	PG_ADD_TEST(suite, test_wkb_out_gserialized);
 }
@@ -157,6 +157,84 @@ static void test_lwprint_bad_formats(void)
 	test_lwprint_assert_error("POINT(1.23456 7.89012)", "DD.DDD jjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjj");
 }
 
+static void test_lwprint_double_fixed(double d, int precision, const char *expected)
+{
+	char buf[OUT_DOUBLE_BUFFER_SIZE];
+	int len = lwprint_double_fixed(d, precision, buf, sizeof(buf));
+
+	if ( strcmp(buf, expected) )
+		fprintf(stderr, "\nIn:   %.17g\nOut:  %s\nTheo: %s\n", d, buf, expected);
+	CU_ASSERT_STRING_EQUAL(buf, expected);
+	CU_ASSERT_EQUAL(len, strlen(expected));
+}
+
+static void test_lwprint_double_g(double d, int precision, const char *expected)
+{
+	char buf[OUT_DOUBLE_BUFFER_SIZE];
+	int len = lwprint_double_g(d, precision, buf, sizeof(buf));
+
+	if ( strcmp(buf, expected) )
+		fprintf(stderr, "\nIn:   %.17g\nOut:  %s\nTheo: %s\n", d, buf, expected);
+	CU_ASSERT_STRING_EQUAL(buf, expected);
+	CU_ASSERT_EQUAL(len, strlen(expected));
+}
+
+static void test_lwprint_double(void)
+{
+	char buf[OUT_DOUBLE_BUFFER_SIZE];
+	double d;
+	int i, p;
+
+	/* Fixed decimals, trailing zeros trimmed */
+	test_lwprint_double_fixed(0, 15, "0");
+	test_lwprint_double_fixed(-0.0, 15, "-0");
+	test_lwprint_double_fixed(-0.0004, 3, "-0");
+	test_lwprint_double_fixed(1.5, 0, "2");
+	test_lwprint_double_fixed(2.5, 0, "2");
+	test_lwprint_double_fixed(0.125, 2, "0.12");
+	test_lwprint_double_fixed(0.375, 2, "0.38");
+	test_lwprint_double_fixed(0.1, 15, "0.1");
+	test_lwprint_double_fixed(0.1, 17, "0.10000000000000001");
+	test_lwprint_double_fixed(-71.0603, 6, "-71.0603");
+	test_lwprint_double_fixed(-71.0603, 15, "-71.060299999999998");
+	test_lwprint_double_fixed(999999999999999.9, 0, "1000000000000000");
+	test_lwprint_double_fixed(1e15, 15, "1e+15");
+	test_lwprint_double_fixed(-1e20, 15, "-1e+20");
+
+	/* Significant digits */
+	test_lwprint_double_g(0, 15, "0");
+	test_lwprint_double_g(-0.0, 15, "-0");
+	test_lwprint_double_g(1, 0, "1");
+	test_lwprint_double_g(0.1, 15, "0.1");
+	test_lwprint_double_g(0.1, 17, "0.10000000000000001");
+	test_lwprint_double_g(-71.0603, 15, "-71.0603");
+	test_lwprint_double_g(9.9999999, 6, "10");
+	test_lwprint_double_g(123456, 6, "123456");
+	test_lwprint_double_g(1234567, 6, "1.23457e+06");
+	test_lwprint_double_g(0.0001, 15, "0.0001");
+	test_lwprint_double_g(0.00001234, 15, "1.234e-05");
+	test_lwprint_double_g(5e-324, 15, "4.94065645841247e-324");
+	test_lwprint_double_g(1e300, 15, "1e+300");
+
+	/* Agrees with printf all along */
+	srand(1);
+	for ( i = 0; i < 10000; i++ )
+	{
+		char expected[OUT_DOUBLE_BUFFER_SIZE];
+		d = (rand() - RAND_MAX / 2) / (double)(1 + rand() % 100000);
+		p = rand() % (OUT_MAX_DOUBLE_PRECISION + 1);
+
+		lwprint_double_fixed(d, p, buf, sizeof(buf));
+		snprintf(expected, sizeof(expected), "%.*f", p, d);
+		trim_trailing_zeros(expected);
+		CU_ASSERT_STRING_EQUAL(buf, expected);
+
+		lwprint_double_g(d, p, buf, sizeof(buf));
+		snprintf(expected, sizeof(expected), "%.*g", p, d);
+		CU_ASSERT_STRING_EQUAL(buf, expected);
+	}
+}
+
 /*
 ** Callback used by the test harness to register the tests in this file.
 */
@@ -169,5 +247,6 @@ void print_suite_setup(void)
 	PG_ADD_TEST(suite, test_lwprint_optional_format);
 	PG_ADD_TEST(suite, test_lwprint_oddball_formats);
 	PG_ADD_TEST(suite, test_lwprint_bad_formats);
+	PG_ADD_TEST(suite, test_lwprint_double);
 }
 
@@ -48,6 +48,8 @@ extern void out_encoded_polyline_suite_setup(void);
 extern void out_geojson_suite_setup(void);
 extern void out_gml_suite_setup(void);
 extern void out_kml_suite_setup(void);
+extern void out_mvt_suite_setup(void);
+extern void out_geoarrow_suite_setup(void);
 extern void out_svg_suite_setup(void);
 extern void twkb_out_suite_setup(void);
 extern void out_x3d_suite_setup(void);
@@ -92,6 +94,8 @@ PG_SuiteSetup setupfuncs[] =
 	out_geojson_suite_setup,
 	out_gml_suite_setup,
 	out_kml_suite_setup,
+	out_mvt_suite_setup,
+	out_geoarrow_suite_setup,
 	out_svg_suite_setup,
 	out_x3d_suite_setup,
 	ptarray_suite_setup,
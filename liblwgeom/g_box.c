@@ -700,3 +700,80 @@ void gbox_float_round(GBOX *gbox)
 	}
 }
 
+/**
+* Map a float onto an unsigned integer with the same ordering:
+* negatives have all their bits flipped, positives just the sign.
+*/
+static uint32_t float_to_sortable_uint32(float f)
+{
+	union { float f; uint32_t u; } v;
+	v.f = f;
+	return (v.u & 0x80000000) ? ~v.u : (v.u | 0x80000000);
+}
+
+/**
+* Distance of the cell (x, y) along the order 32 Hilbert curve.
+*/
+static uint64_t uint32_hilbert(uint32_t x, uint32_t y)
+{
+	uint64_t d = 0;
+	uint32_t s, t;
+
+	for ( s = 0x80000000; s > 0; s >>= 1 )
+	{
+		uint32_t rx = (x & s) ? 1 : 0;
+		uint32_t ry = (y & s) ? 1 : 0;
+		d += (uint64_t)s * (uint64_t)s * ((3 * rx) ^ ry);
+
+		/* Rotate the quadrant so the curve stays continuous */
+		if ( ! ry )
+		{
+			if ( rx )
+			{
+				x = ~x;
+				y = ~y;
+			}
+			t = x;
+			x = y;
+			y = t;
+		}
+	}
+	return d;
+}
+
+uint64_t gbox_get_sortable_hash(const GBOX *g)
+{
+	float x = (float)((g->xmin + g->xmax) / 2.0);
+	float y = (float)((g->ymin + g->ymax) / 2.0);
+	return uint32_hilbert(float_to_sortable_uint32(x), float_to_sortable_uint32(y));
+}
+
+/**
+* Interleave the bits of x and y, x taking the odd positions.
+*/
+static uint64_t uint32_interleave_2(uint32_t u1, uint32_t u2)
+{
+	uint64_t x = u1;
+	uint64_t y = u2;
+
+	x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+	x = (x | (x << 8))  & 0x00FF00FF00FF00FFULL;
+	x = (x | (x << 4))  & 0x0F0F0F0F0F0F0F0FULL;
+	x = (x | (x << 2))  & 0x3333333333333333ULL;
+	x = (x | (x << 1))  & 0x5555555555555555ULL;
+
+	y = (y | (y << 16)) & 0x0000FFFF0000FFFFULL;
+	y = (y | (y << 8))  & 0x00FF00FF00FF00FFULL;
+	y = (y | (y << 4))  & 0x0F0F0F0F0F0F0F0FULL;
+	y = (y | (y << 2))  & 0x3333333333333333ULL;
+	y = (y | (y << 1))  & 0x5555555555555555ULL;
+
+	return (x << 1) | y;
+}
+
+uint64_t gbox_get_sortable_morton(const GBOX *g)
+{
+	float x = (float)((g->xmin + g->xmax) / 2.0);
+	float y = (float)((g->ymin + g->ymax) / 2.0);
+	return uint32_interleave_2(float_to_sortable_uint32(x), float_to_sortable_uint32(y));
+}
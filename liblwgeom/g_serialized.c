@@ -969,6 +969,47 @@ GSERIALIZED* gserialized_from_lwgeom(LWGEOM *geom, int is_geodetic, size_t *size
 	return g;
 }
 
+GSERIALIZED* gserialized_set_gbox(GSERIALIZED *g, GBOX *gbox)
+{
+	size_t box_size = gbox_serialized_size(g->flags);
+	size_t g_size = SIZE_GET(g->size);
+	GSERIALIZED *g_out;
+	GBOX box = *gbox;
+
+	/* The slot layout follows the serialization */
+	box.flags = g->flags;
+
+	/* A box slot is already there, overwrite it */
+	if ( FLAGS_GET_BBOX(g->flags) )
+	{
+		gserialized_from_gbox(&box, g->data);
+		return g;
+	}
+
+	/* Make room for the box between the header and the geometry */
+	g_out = lwalloc(g_size + box_size);
+	memcpy(g_out, g, 8);
+	gserialized_from_gbox(&box, g_out->data);
+	memcpy(g_out->data + box_size, g->data, g_size - 8);
+	g_out->size = SIZE_SET(g_out->size, g_size + box_size);
+	FLAGS_SET_BBOX(g_out->flags, 1);
+	return g_out;
+}
+
+GSERIALIZED* gserialized_drop_gbox(GSERIALIZED *g)
+{
+	size_t box_size = gbox_serialized_size(g->flags);
+	size_t g_size = SIZE_GET(g->size);
+
+	if ( ! FLAGS_GET_BBOX(g->flags) )
+		return g;
+
+	memmove(g->data, g->data + box_size, g_size - 8 - box_size);
+	g->size = SIZE_SET(g->size, g_size - box_size);
+	FLAGS_SET_BBOX(g->flags, 0);
+	return g;
+}
+
 /***********************************************************************
 * De-serialize GSERIALIZED into an LWGEOM.
 */
@@ -1294,3 +1335,306 @@ LWGEOM* lwgeom_from_gserialized(const GSERIALIZED *g)
 	return lwgeom;
 }
 
+
+/***********************************************************************
+* Check a serialization of untrusted origin.
+*/
+
+/* Deeper nesting than this is refused rather than recursed into */
+#define GSERIALIZED_CHECK_MAX_DEPTH 256
+
+static int gserialized_check_buffer(const uint8_t *data_ptr, const uint8_t *end_ptr, uint8_t g_flags, int depth, size_t *g_size)
+{
+	const uint8_t *start_ptr = data_ptr;
+	uint64_t ordinates_size;
+	uint32_t type, count, i;
+
+	if ( end_ptr - data_ptr < 8 )
+		return LW_FAILURE;
+
+	type = lw_get_uint32_t(data_ptr);
+	count = lw_get_uint32_t(data_ptr + 4); /* npoints, nrings or ngeoms */
+	data_ptr += 8;
+
+	switch (type)
+	{
+	case POINTTYPE:
+	case LINETYPE:
+	case CIRCSTRINGTYPE:
+	case TRIANGLETYPE:
+		if ( type == POINTTYPE && count > 1 )
+			return LW_FAILURE;
+		ordinates_size = (uint64_t)count * FLAGS_NDIMS(g_flags) * sizeof(double);
+		if ( ordinates_size > (uint64_t)(end_ptr - data_ptr) )
+			return LW_FAILURE;
+		data_ptr += ordinates_size;
+		break;
+
+	case POLYGONTYPE:
+	{
+		/* Ring sizes, padded to a double boundary, then the ordinates */
+		uint64_t header_size = 4 * ((uint64_t)count + (count % 2));
+		const uint8_t *ring_ptr = data_ptr;
+
+		if ( header_size > (uint64_t)(end_ptr - data_ptr) )
+			return LW_FAILURE;
+		data_ptr += header_size;
+
+		for ( i = 0; i < count; i++ )
+		{
+			ordinates_size = (uint64_t)lw_get_uint32_t(ring_ptr + 4 * i) * FLAGS_NDIMS(g_flags) * sizeof(double);
+			if ( ordinates_size > (uint64_t)(end_ptr - data_ptr) )
+				return LW_FAILURE;
+			data_ptr += ordinates_size;
+		}
+		break;
+	}
+
+	case MULTIPOINTTYPE:
+	case MULTILINETYPE:
+	case MULTIPOLYGONTYPE:
+	case COMPOUNDTYPE:
+	case CURVEPOLYTYPE:
+	case MULTICURVETYPE:
+	case MULTISURFACETYPE:
+	case POLYHEDRALSURFACETYPE:
+	case TINTYPE:
+	case COLLECTIONTYPE:
+		if ( depth >= GSERIALIZED_CHECK_MAX_DEPTH )
+			return LW_FAILURE;
+
+		/* Every sub-geometry takes at least its type and count */
+		if ( (uint64_t)count * 8 > (uint64_t)(end_ptr - data_ptr) )
+			return LW_FAILURE;
+
+		for ( i = 0; i < count; i++ )
+		{
+			size_t subsize = 0;
+
+			if ( end_ptr - data_ptr < 4 ||
+			     ! lwcollection_allows_subtype(type, lw_get_uint32_t(data_ptr)) )
+				return LW_FAILURE;
+			if ( gserialized_check_buffer(data_ptr, end_ptr, g_flags, depth + 1, &subsize) == LW_FAILURE )
+				return LW_FAILURE;
+			data_ptr += subsize;
+		}
+		break;
+
+	default:
+		return LW_FAILURE;
+	}
+
+	*g_size = data_ptr - start_ptr;
+	return LW_SUCCESS;
+}
+
+int gserialized_check(const GSERIALIZED *g, size_t size)
+{
+	const uint8_t *data_ptr = g->data;
+	const uint8_t *end_ptr = (const uint8_t*)g + size;
+	size_t g_size = 0;
+
+	assert(g);
+
+	/* Size, SRID and flags */
+	if ( size < 8 )
+		return LW_FAILURE;
+
+	if ( FLAGS_GET_BBOX(g->flags) )
+	{
+		if ( size - 8 < gbox_serialized_size(g->flags) )
+			return LW_FAILURE;
+		data_ptr += gbox_serialized_size(g->flags);
+	}
+
+	if ( gserialized_check_buffer(data_ptr, end_ptr, g->flags, 0, &g_size) == LW_FAILURE )
+		return LW_FAILURE;
+
+	/* Nothing may trail the geometry */
+	return ( data_ptr + g_size == end_ptr ) ? LW_SUCCESS : LW_FAILURE;
+}
+
+/***********************************************************************
+* Read counts and coordinates straight out of a serialization, without
+* building an LWGEOM.
+*/
+
+static const uint8_t* gserialized_geom_ptr(const GSERIALIZED *g)
+{
+	const uint8_t *data_ptr = g->data;
+	if ( FLAGS_GET_BBOX(g->flags) )
+		data_ptr += gbox_serialized_size(g->flags);
+	return data_ptr;
+}
+
+/*
+* Walk one geometry, adding its vertices and rings to the totals with
+* the same rules as lwgeom_count_vertices and lwgeom_count_rings, and
+* return the number of bytes it takes.
+*/
+static size_t gserialized_peek_counts_buffer(const uint8_t *data_ptr, uint8_t g_flags, uint32_t *npoints, uint32_t *nrings)
+{
+	const uint8_t *start_ptr = data_ptr;
+	size_t point_size = FLAGS_NDIMS(g_flags) * sizeof(double);
+	uint32_t type = lw_get_uint32_t(data_ptr);
+	uint32_t count = lw_get_uint32_t(data_ptr + 4);
+	uint32_t i;
+
+	data_ptr += 8;
+
+	switch (type)
+	{
+	case POINTTYPE:
+	case LINETYPE:
+	case CIRCSTRINGTYPE:
+		*npoints += count;
+		data_ptr += count * point_size;
+		break;
+
+	case TRIANGLETYPE:
+		*npoints += count;
+		*nrings += (count ? 1 : 0);
+		data_ptr += count * point_size;
+		break;
+
+	case POLYGONTYPE:
+	{
+		const uint8_t *ring_ptr = data_ptr;
+		uint32_t total = 0;
+
+		/* Ring sizes, padded to a double boundary */
+		data_ptr += 4 * (count + (count % 2));
+		for ( i = 0; i < count; i++ )
+			total += lw_get_uint32_t(ring_ptr + 4 * i);
+
+		/* A polygon with an empty shell is empty */
+		if ( count && lw_get_uint32_t(ring_ptr) )
+			*nrings += count;
+		*npoints += total;
+		data_ptr += total * point_size;
+		break;
+	}
+
+	case CURVEPOLYTYPE:
+	{
+		uint32_t sub_points = 0, sub_rings = 0;
+
+		for ( i = 0; i < count; i++ )
+			data_ptr += gserialized_peek_counts_buffer(data_ptr, g_flags, &sub_points, &sub_rings);
+
+		/* Every ring counts, unless they are all empty */
+		if ( sub_points )
+			*nrings += count;
+		*npoints += sub_points;
+		break;
+	}
+
+	case COMPOUNDTYPE:
+	case MULTICURVETYPE:
+	case MULTIPOINTTYPE:
+	case MULTILINETYPE:
+	case MULTIPOLYGONTYPE:
+	case MULTISURFACETYPE:
+	case POLYHEDRALSURFACETYPE:
+	case TINTYPE:
+	case COLLECTIONTYPE:
+		for ( i = 0; i < count; i++ )
+			data_ptr += gserialized_peek_counts_buffer(data_ptr, g_flags, npoints, nrings);
+		break;
+
+	default:
+		lwerror("%s: unsupported geometry type: %s", __func__, lwtype_name(type));
+		break;
+	}
+
+	return data_ptr - start_ptr;
+}
+
+uint32_t gserialized_peek_count(const GSERIALIZED *g)
+{
+	assert(g);
+	return lw_get_uint32_t(gserialized_geom_ptr(g) + 4);
+}
+
+int gserialized_peek_npoints(const GSERIALIZED *g)
+{
+	uint32_t npoints = 0, nrings = 0;
+	assert(g);
+	gserialized_peek_counts_buffer(gserialized_geom_ptr(g), g->flags, &npoints, &nrings);
+	return npoints;
+}
+
+int gserialized_peek_nrings(const GSERIALIZED *g)
+{
+	uint32_t npoints = 0, nrings = 0;
+	assert(g);
+	gserialized_peek_counts_buffer(gserialized_geom_ptr(g), g->flags, &npoints, &nrings);
+	return nrings;
+}
+
+int gserialized_peek_ring_offset(const GSERIALIZED *g, int ring, int *offset, int *npoints)
+{
+	const uint8_t *data_ptr;
+	uint32_t nrings;
+	int i, first = 0;
+
+	assert(g);
+	data_ptr = gserialized_geom_ptr(g);
+	if ( lw_get_uint32_t(data_ptr) != POLYGONTYPE )
+		return LW_FAILURE;
+
+	nrings = lw_get_uint32_t(data_ptr + 4);
+	if ( ring < 0 || (uint32_t)ring >= nrings )
+		return LW_FAILURE;
+
+	data_ptr += 8;
+	for ( i = 0; i < ring; i++ )
+		first += lw_get_uint32_t(data_ptr + 4 * i);
+
+	if ( offset ) *offset = first;
+	if ( npoints ) *npoints = lw_get_uint32_t(data_ptr + 4 * ring);
+	return LW_SUCCESS;
+}
+
+int gserialized_peek_point(const GSERIALIZED *g, int n, POINT4D *point)
+{
+	const uint8_t *data_ptr;
+	uint32_t type, count, npoints, i;
+	int ndims = FLAGS_NDIMS(g->flags);
+	double ord[4];
+
+	assert(g);
+	data_ptr = gserialized_geom_ptr(g);
+	type = lw_get_uint32_t(data_ptr);
+	count = lw_get_uint32_t(data_ptr + 4);
+	data_ptr += 8;
+
+	switch (type)
+	{
+	case POINTTYPE:
+	case LINETYPE:
+	case CIRCSTRINGTYPE:
+	case TRIANGLETYPE:
+		npoints = count;
+		break;
+	case POLYGONTYPE:
+		/* The rings follow each other, so index through all of them */
+		npoints = 0;
+		for ( i = 0; i < count; i++ )
+			npoints += lw_get_uint32_t(data_ptr + 4 * i);
+		data_ptr += 4 * (count + (count % 2));
+		break;
+	default:
+		return LW_FAILURE;
+	}
+
+	if ( n < 0 || (uint32_t)n >= npoints )
+		return LW_FAILURE;
+
+	memcpy(ord, data_ptr + (size_t)n * ndims * sizeof(double), ndims * sizeof(double));
+	point->x = ord[0];
+	point->y = ord[1];
+	point->z = FLAGS_GET_Z(g->flags) ? ord[2] : 0.0;
+	point->m = FLAGS_GET_M(g->flags) ? ord[ndims - 1] : 0.0;
+	return LW_SUCCESS;
+}
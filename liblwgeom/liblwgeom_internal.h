@@ -33,6 +33,7 @@
 #include <float.h>
 
 #include "liblwgeom.h"
+#include "stringbuffer.h"
 
 /**
 * Floating point comparators.
@@ -120,6 +121,8 @@
 #define OUT_SHOW_DIGS_DOUBLE 20
 #define OUT_MAX_DOUBLE_PRECISION 15
 #define OUT_MAX_DIGS_DOUBLE (OUT_SHOW_DIGS_DOUBLE + 2) /* +2 mean add dot and sign */
+#define OUT_MAX_DOUBLE_G_PRECISION 17 /* enough for any double to round trip */
+#define OUT_DOUBLE_BUFFER_SIZE (OUT_MAX_DIGS_DOUBLE + OUT_MAX_DOUBLE_PRECISION + 1)
 
 
 /**
@@ -435,6 +438,14 @@ int gbox_centroid(const GBOX* gbox, POINT2D* out);
 /* Utilities */
 extern void trim_trailing_zeros(char *num);
 
+/*
+* Ordinate formatting for the text writers, printf compatible. buf must
+* hold OUT_DOUBLE_BUFFER_SIZE bytes for the precisions they use, up to
+* OUT_MAX_DOUBLE_PRECISION for _fixed and OUT_MAX_DOUBLE_G_PRECISION for _g.
+*/
+extern int lwprint_double_fixed(double d, int precision, char *buf, size_t bufsize);
+extern int lwprint_double_g(double d, int precision, char *buf, size_t bufsize);
+
 extern uint8_t MULTITYPE[NUMTYPES];
 
 extern lwinterrupt_callback *_lwgeom_interrupt_callback;
@@ -454,4 +465,10 @@ int ptarray_npoints_in_rect(const POINTARRAY *pa, const GBOX *gbox);
 int gbox_contains_point2d(const GBOX *g, const POINT2D *p);
 int lwpoly_contains_point(const LWPOLY *poly, const POINT2D *pt);
 
+/**
+* Append the GeoJson of a geometry, without crs nor bbox members,
+* to the end of a string buffer.
+*/
+void lwgeom_to_geojson_sb(const LWGEOM *geom, stringbuffer_t *sb, int precision);
+
 #endif /* _LIBLWGEOM_INTERNAL_H */
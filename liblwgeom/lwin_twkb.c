@@ -584,7 +584,7 @@ LWGEOM* lwgeom_from_twkb_state(twkb_parse_state *s)
 			bbox.zmax = bbox.zmin + twkb_parse_state_double(s, s->factor_z);
 		}
 		/* M */
-		if ( s->has_z )
+		if ( s->has_m )
 		{
 			bbox.mmin = twkb_parse_state_double(s, s->factor_m);
 			bbox.mmax = bbox.mmin + twkb_parse_state_double(s, s->factor_m);
@@ -666,3 +666,413 @@ LWGEOM* lwgeom_from_twkb(uint8_t *twkb, size_t twkb_size, char check)
 	/* Read the rest of the geometry */
 	return lwgeom_from_twkb_state(&s);
 }
+
+
+/**********************************************************************
+* Batch reading. An iterator hands out the members of TWKB collections
+* with an idlist one at a time, with their ids, reusing one parse state
+* and one buffer throughout. Any other TWKB geometry comes out whole.
+* The bytes can be given all at once, or appended in chunks as they
+* arrive, in which case a geometry is only decoded once it is complete.
+*/
+
+struct LWTWKB_ITERATOR_T
+{
+	twkb_parse_state s;
+	int64_t coords[TWKB_IN_MAXCOORDS];
+
+	/* Bytes appended so far, when streaming */
+	uint8_t *buf;
+	size_t buf_size;
+	int streaming; /* Geometries may still be incomplete */
+
+	/* The collection being handed out */
+	uint32_t coltype;
+	uint32_t ngeoms;
+	uint32_t igeom;
+	int64_t *ids;
+	uint32_t ids_size;
+};
+
+/**
+* Read positions for checking that a geometry is complete, without
+* decoding it. Running out of bytes is not an error here.
+*/
+typedef struct
+{
+	const uint8_t *pos;
+	const uint8_t *end;
+} twkb_measure_state;
+
+static int twkb_measure_uvarint(twkb_measure_state *m, uint64_t *val)
+{
+	size_t size = varint_size(m->pos, m->end);
+
+	if ( ! size )
+		return LW_FAILURE;
+
+	*val = varint_u64_decode(m->pos, m->end, &size);
+	m->pos += size;
+	return LW_SUCCESS;
+}
+
+static int twkb_measure_varints(twkb_measure_state *m, uint64_t n)
+{
+	uint64_t i;
+
+	for ( i = 0; i < n; i++ )
+	{
+		size_t size = varint_size(m->pos, m->end);
+		if ( ! size )
+			return LW_FAILURE;
+		m->pos += size;
+	}
+	return LW_SUCCESS;
+}
+
+static int twkb_measure_geom(twkb_measure_state *m);
+
+/* Type of the members of a multi-geometry, which have no header of their own */
+static uint32_t twkb_member_type(uint32_t lwtype)
+{
+	switch ( lwtype )
+	{
+		case MULTIPOINTTYPE:
+			return POINTTYPE;
+		case MULTILINETYPE:
+			return LINETYPE;
+		case MULTIPOLYGONTYPE:
+			return POLYGONTYPE;
+		default:
+			return lwtype;
+	}
+}
+
+/**
+* Walk over the body of a geometry of the given type, the part
+* after the header and bounding box.
+*/
+static int twkb_measure_body(twkb_measure_state *m, uint32_t lwtype, int ndims, int has_idlist)
+{
+	uint64_t n, nrings, i, j;
+
+	switch ( lwtype )
+	{
+		case POINTTYPE:
+			return twkb_measure_varints(m, ndims);
+		case LINETYPE:
+			if ( ! twkb_measure_uvarint(m, &n) )
+				return LW_FAILURE;
+			return twkb_measure_varints(m, n * ndims);
+		case POLYGONTYPE:
+			if ( ! twkb_measure_uvarint(m, &nrings) )
+				return LW_FAILURE;
+			for ( i = 0; i < nrings; i++ )
+			{
+				if ( ! twkb_measure_uvarint(m, &n) ||
+				     ! twkb_measure_varints(m, n * ndims) )
+					return LW_FAILURE;
+			}
+			return LW_SUCCESS;
+		case MULTIPOINTTYPE:
+		case MULTILINETYPE:
+		case MULTIPOLYGONTYPE:
+		case COLLECTIONTYPE:
+			if ( ! twkb_measure_uvarint(m, &n) )
+				return LW_FAILURE;
+			if ( has_idlist && ! twkb_measure_varints(m, n) )
+				return LW_FAILURE;
+			for ( j = 0; j < n; j++ )
+			{
+				if ( lwtype == COLLECTIONTYPE ?
+				     ! twkb_measure_geom(m) :
+				     ! twkb_measure_body(m, twkb_member_type(lwtype), ndims, LW_FALSE) )
+					return LW_FAILURE;
+			}
+			return LW_SUCCESS;
+		default:
+			lwerror("Unknown WKB type");
+	}
+	return LW_FAILURE;
+}
+
+/**
+* Walk over the type, metadata, extended dimensions and size of a
+* geometry, stopping before the bounding box.
+*/
+static int twkb_measure_header(twkb_measure_state *m, uint8_t *metadata, int *ndims, uint64_t *size)
+{
+	uint8_t extended_dims;
+
+	if ( m->end - m->pos < 2 )
+		return LW_FAILURE;
+	*metadata = m->pos[1];
+	m->pos += 2;
+
+	*ndims = 2;
+	if ( *metadata & 0x08 )
+	{
+		if ( m->pos >= m->end )
+			return LW_FAILURE;
+		extended_dims = *(m->pos++);
+		*ndims += (extended_dims & 0x01) + ((extended_dims & 0x02) >> 1);
+	}
+
+	*size = 0;
+	if ( (*metadata & 0x02) && ! twkb_measure_uvarint(m, size) )
+		return LW_FAILURE;
+
+	return LW_SUCCESS;
+}
+
+/**
+* Walk over a whole geometry. Geometries that carry their size are
+* stepped over in one go.
+*/
+static int twkb_measure_geom(twkb_measure_state *m)
+{
+	uint8_t type, metadata;
+	uint64_t size;
+	int ndims;
+
+	if ( m->pos >= m->end )
+		return LW_FAILURE;
+	type = *(m->pos) & 0x0F;
+
+	if ( ! twkb_measure_header(m, &metadata, &ndims, &size) )
+		return LW_FAILURE;
+
+	if ( metadata & 0x02 )
+	{
+		if ( (uint64_t)(m->end - m->pos) < size )
+			return LW_FAILURE;
+		m->pos += size;
+		return LW_SUCCESS;
+	}
+
+	/* Bounding box */
+	if ( (metadata & 0x01) && ! twkb_measure_varints(m, 2 * ndims) )
+		return LW_FAILURE;
+
+	/* Empty */
+	if ( metadata & 0x10 )
+		return LW_SUCCESS;
+
+	return twkb_measure_body(m, lwtype_from_twkb_type(type), ndims, (metadata & 0x04) >> 2);
+}
+
+/**
+* Check the next geometry, or the front of the next collection up
+* to the end of its idlist, is all there.
+*/
+static int twkb_measure_front(const twkb_parse_state *s, int whole)
+{
+	twkb_measure_state m;
+	uint8_t metadata;
+	uint64_t size, ngeoms;
+	int ndims;
+
+	m.pos = s->pos;
+	m.end = s->twkb_end;
+
+	if ( whole )
+		return twkb_measure_geom(&m);
+
+	if ( ! twkb_measure_header(&m, &metadata, &ndims, &size) )
+		return LW_FAILURE;
+	if ( (metadata & 0x01) && ! twkb_measure_varints(&m, 2 * ndims) )
+		return LW_FAILURE;
+	if ( metadata & 0x10 )
+		return LW_SUCCESS;
+	if ( ! twkb_measure_uvarint(&m, &ngeoms) )
+		return LW_FAILURE;
+	return twkb_measure_varints(&m, ngeoms);
+}
+
+/**
+* Check the next member of the current collection is all there.
+*/
+static int twkb_measure_member(const LWTWKB_ITERATOR *it)
+{
+	twkb_measure_state m;
+
+	m.pos = it->s.pos;
+	m.end = it->s.twkb_end;
+
+	if ( it->coltype == COLLECTIONTYPE )
+		return twkb_measure_geom(&m);
+
+	return twkb_measure_body(&m, twkb_member_type(it->coltype), it->s.ndims, LW_FALSE);
+}
+
+/**
+* Read the front of a collection with an idlist, leaving the parse
+* state on its first member.
+*/
+static void lwtwkb_iterator_read_front(LWTWKB_ITERATOR *it)
+{
+	twkb_parse_state *s = &it->s;
+	int i;
+
+	header_from_twkb_state(s);
+	it->coltype = s->lwtype;
+
+	/* Multi-geometry members carry on from the same deltas */
+	for ( i = 0; i < TWKB_IN_MAXCOORDS; i++ )
+		s->coords[i] = 0;
+
+	/* The members come out without the collection box */
+	if ( s->has_bbox )
+	{
+		for ( i = 0; i < 2 * s->ndims; i++ )
+			twkb_parse_state_varint_skip(s);
+	}
+
+	it->igeom = it->ngeoms = 0;
+	if ( s->is_empty )
+		return;
+
+	it->ngeoms = twkb_parse_state_uvarint(s);
+	LWDEBUGF(4,"Number of geometries %d", it->ngeoms);
+
+	/* Keep the largest idlist seen so far */
+	if ( it->ngeoms > it->ids_size )
+	{
+		if ( it->ids )
+			lwfree(it->ids);
+		it->ids_size = it->ngeoms;
+		it->ids = lwalloc(sizeof(int64_t) * it->ids_size);
+	}
+
+	for ( i = 0; i < it->ngeoms; i++ )
+		it->ids[i] = twkb_parse_state_varint(s);
+}
+
+static LWTWKB_ITERATOR* lwtwkb_iterator_new(char check)
+{
+	LWTWKB_ITERATOR *it = lwalloc(sizeof(LWTWKB_ITERATOR));
+	memset(it, 0, sizeof(LWTWKB_ITERATOR));
+	it->s.coords = it->coords;
+
+	/* Handle the check catch-all values */
+	if ( check & LW_PARSER_CHECK_NONE )
+		it->s.check = 0;
+	else
+		it->s.check = check;
+
+	return it;
+}
+
+LWTWKB_ITERATOR* lwtwkb_iterator_create(uint8_t *twkb, size_t twkb_size, char check)
+{
+	LWTWKB_ITERATOR *it = lwtwkb_iterator_new(check);
+
+	it->s.twkb = it->s.pos = twkb;
+	it->s.twkb_end = twkb + twkb_size;
+
+	return it;
+}
+
+LWTWKB_ITERATOR* lwtwkb_iterator_create_stream(char check)
+{
+	LWTWKB_ITERATOR *it = lwtwkb_iterator_new(check);
+	it->streaming = LW_TRUE;
+	return it;
+}
+
+void lwtwkb_iterator_append(LWTWKB_ITERATOR *it, const uint8_t *bytes, size_t size)
+{
+	twkb_parse_state *s = &it->s;
+	size_t unread = it->buf ? s->twkb_end - s->pos : 0;
+
+	if ( ! it->streaming )
+	{
+		lwerror("%s: the iterator takes no more bytes", __func__);
+		return;
+	}
+
+	/* What the last chunk left over goes to the front */
+	if ( unread && s->pos != it->buf )
+		memmove(it->buf, s->pos, unread);
+
+	if ( unread + size > it->buf_size )
+	{
+		it->buf_size = FP_MAX(unread + size, 2 * it->buf_size);
+		if ( it->buf )
+			it->buf = lwrealloc(it->buf, it->buf_size);
+		else
+			it->buf = lwalloc(it->buf_size);
+	}
+
+	memcpy(it->buf + unread, bytes, size);
+	s->twkb = s->pos = it->buf;
+	s->twkb_end = it->buf + unread + size;
+}
+
+void lwtwkb_iterator_end(LWTWKB_ITERATOR *it)
+{
+	it->streaming = LW_FALSE;
+}
+
+LWGEOM* lwtwkb_iterator_next(LWTWKB_ITERATOR *it, int64_t *id, int *has_id)
+{
+	twkb_parse_state *s = &it->s;
+	LWGEOM *geom = NULL;
+
+	*has_id = LW_FALSE;
+
+	/* Done with the collection, look at what follows */
+	while ( it->igeom >= it->ngeoms )
+	{
+		uint32_t lwtype;
+		int whole;
+
+		if ( ! s->pos || s->pos >= s->twkb_end )
+			return NULL;
+
+		/* Anything but a collection with ids comes out whole */
+		lwtype = lwtype_from_twkb_type(*(s->pos) & 0x0F);
+		whole = ! lwtype_is_collection(lwtype) ||
+		        s->pos + 1 >= s->twkb_end || ! (s->pos[1] & 0x04);
+
+		if ( it->streaming && ! twkb_measure_front(s, whole) )
+			return NULL;
+
+		if ( whole )
+			return lwgeom_from_twkb_state(s);
+
+		lwtwkb_iterator_read_front(it);
+	}
+
+	if ( it->streaming && ! twkb_measure_member(it) )
+		return NULL;
+
+	switch ( it->coltype )
+	{
+		case MULTIPOINTTYPE:
+			geom = lwpoint_as_lwgeom(lwpoint_from_twkb_state(s));
+			break;
+		case MULTILINETYPE:
+			geom = lwline_as_lwgeom(lwline_from_twkb_state(s));
+			break;
+		case MULTIPOLYGONTYPE:
+			geom = lwpoly_as_lwgeom(lwpoly_from_twkb_state(s));
+			break;
+		default:
+			geom = lwgeom_from_twkb_state(s);
+			break;
+	}
+
+	*id = it->ids[it->igeom++];
+	*has_id = LW_TRUE;
+	return geom;
+}
+
+void lwtwkb_iterator_destroy(LWTWKB_ITERATOR *it)
+{
+	if ( it->buf )
+		lwfree(it->buf);
+	if ( it->ids )
+		lwfree(it->ids);
+	lwfree(it);
+}
@@ -787,3 +787,385 @@ LWGEOM* lwgeom_from_hexwkb(const char *hexwkb, const char check)
 	lwfree(wkb);
 	return lwgeom;	
 }
+
+
+/**********************************************************************/
+
+/*
+* GSERIALIZED
+* Read WKB straight into the serialized form, without building an
+* LWGEOM. A first walk over the WKB sizes the output, a second one
+* copies the coordinate runs and grows the box. Only the simple
+* features types are handled. Anything else, including input that
+* the checks reject, is left to lwgeom_from_wkb(), which knows how
+* to report it.
+*/
+typedef struct
+{
+	wkb_parse_state s;
+	uint8_t *out; /* Write position, NULL while sizing */
+	size_t size; /* Size of the geometry data */
+	int32_t srid; /* SRID of the top level geometry */
+	int has_z; /* Dimensions of the top level geometry */
+	int has_m;
+	uint32_t lwtype; /* Type of the top level geometry */
+	uint32_t ngeoms; /* Number of parts of the top level geometry */
+	uint32_t nvertices; /* Number of points */
+	uint32_t nboxed; /* Number of points in the box */
+	GBOX box;
+} wkb_gser_state;
+
+static void gser_wkb_state_init(wkb_gser_state *g, const uint8_t *wkb, size_t wkb_size, char check, uint8_t *out)
+{
+	memset(g, 0, sizeof(wkb_gser_state));
+	g->s.wkb = wkb;
+	g->s.wkb_size = wkb_size;
+	g->s.check = check;
+	g->s.srid = SRID_UNKNOWN;
+	g->s.pos = wkb;
+	g->srid = SRID_UNKNOWN;
+	g->out = out;
+}
+
+/* Can the next bytes be read? */
+static inline int gser_wkb_has(const wkb_parse_state *s, size_t next)
+{
+	return (s->pos + next) <= (s->wkb + s->wkb_size);
+}
+
+static void gser_put_uint32(wkb_gser_state *g, uint32_t i)
+{
+	if ( g->out )
+	{
+		memcpy(g->out, &i, sizeof(uint32_t));
+		g->out += sizeof(uint32_t);
+	}
+	g->size += sizeof(uint32_t);
+}
+
+/*
+* Grow the box with written coordinates. NaN would not compare the
+* way the box calculation of the general path expects, so it fails.
+*/
+static int gser_box_add(wkb_gser_state *g, const double *dlist, uint32_t npoints, int ndims)
+{
+	uint32_t i;
+	int j;
+
+	for ( i = 0; i < npoints; i++, dlist += ndims )
+	{
+		double z = g->has_z ? dlist[2] : 0.0;
+		double m = g->has_m ? dlist[ndims-1] : 0.0;
+
+		for ( j = 0; j < ndims; j++ )
+		{
+			if ( isnan(dlist[j]) )
+				return LW_FAILURE;
+		}
+
+		if ( g->nboxed++ == 0 )
+		{
+			g->box.xmin = g->box.xmax = dlist[0];
+			g->box.ymin = g->box.ymax = dlist[1];
+			g->box.zmin = g->box.zmax = z;
+			g->box.mmin = g->box.mmax = m;
+			continue;
+		}
+
+		g->box.xmin = FP_MIN(g->box.xmin, dlist[0]);
+		g->box.xmax = FP_MAX(g->box.xmax, dlist[0]);
+		g->box.ymin = FP_MIN(g->box.ymin, dlist[1]);
+		g->box.ymax = FP_MAX(g->box.ymax, dlist[1]);
+		g->box.zmin = FP_MIN(g->box.zmin, z);
+		g->box.zmax = FP_MAX(g->box.zmax, z);
+		g->box.mmin = FP_MIN(g->box.mmin, m);
+		g->box.mmax = FP_MAX(g->box.mmax, m);
+	}
+	return LW_SUCCESS;
+}
+
+/*
+* Copy a run of points, flipping the bytes of each double if the
+* WKB endianness is not the machine one.
+*/
+static int gser_ptarray_from_wkb(wkb_gser_state *g, uint32_t npoints, int in_box)
+{
+	wkb_parse_state *s = &(g->s);
+	int ndims = 2 + (g->has_z ? 1 : 0) + (g->has_m ? 1 : 0);
+	size_t size = (size_t)npoints * ndims * WKB_DOUBLE_SIZE;
+
+	if ( ! gser_wkb_has(s, size) )
+		return LW_FAILURE;
+
+	if ( g->out )
+	{
+		if ( ! s->swap_bytes )
+		{
+			memcpy(g->out, s->pos, size);
+		}
+		else
+		{
+			size_t i;
+			int j;
+			for ( i = 0; i < size; i += WKB_DOUBLE_SIZE )
+			{
+				for ( j = 0; j < WKB_DOUBLE_SIZE; j++ )
+					g->out[i + j] = s->pos[i + WKB_DOUBLE_SIZE - 1 - j];
+			}
+		}
+
+		if ( in_box && gser_box_add(g, (double*)(g->out), npoints, ndims) == LW_FAILURE )
+			return LW_FAILURE;
+
+		g->out += size;
+	}
+	else if ( in_box )
+	{
+		g->nboxed += npoints;
+	}
+
+	s->pos += size;
+	g->size += size;
+	g->nvertices += npoints;
+	return LW_SUCCESS;
+}
+
+static int gser_from_wkb_state(wkb_gser_state *g, uint32_t parent_type)
+{
+	wkb_parse_state *s = &(g->s);
+	char wkb_little_endian;
+	uint32_t lwtype, n, i, npoints;
+	uint8_t *counts;
+	size_t counts_size, ptsize;
+	double x, y;
+
+	if ( ! gser_wkb_has(s, WKB_BYTE_SIZE + WKB_INT_SIZE) )
+		return LW_FAILURE;
+
+	wkb_little_endian = byte_from_wkb_state(s);
+	if ( wkb_little_endian != 1 && wkb_little_endian != 0 )
+		return LW_FAILURE;
+	s->swap_bytes = ( (getMachineEndian() == NDR) != (wkb_little_endian == 1) );
+
+	s->lwtype = 0;
+	lwtype_from_wkb_state(s, integer_from_wkb_state(s));
+	lwtype = s->lwtype;
+
+	if ( s->has_srid )
+	{
+		if ( ! gser_wkb_has(s, WKB_INT_SIZE) )
+			return LW_FAILURE;
+		s->srid = clamp_srid(integer_from_wkb_state(s));
+	}
+
+	/* Sub-geometries must have the dimensions of their parent, and a type it allows */
+	if ( ! parent_type )
+	{
+		g->srid = s->srid;
+		g->has_z = s->has_z;
+		g->has_m = s->has_m;
+		g->lwtype = lwtype;
+	}
+	else if ( s->has_z != g->has_z || s->has_m != g->has_m ||
+	          ! lwcollection_allows_subtype(parent_type, lwtype) )
+	{
+		return LW_FAILURE;
+	}
+
+	ptsize = (2 + (g->has_z ? 1 : 0) + (g->has_m ? 1 : 0)) * WKB_DOUBLE_SIZE;
+
+	switch ( lwtype )
+	{
+		case POINTTYPE:
+			if ( ! gser_wkb_has(s, ptsize) )
+				return LW_FAILURE;
+			gser_put_uint32(g, POINTTYPE);
+
+			/* Check for POINT(NaN NaN) ==> POINT EMPTY */
+			x = double_from_wkb_state(s);
+			y = double_from_wkb_state(s);
+			s->pos -= 2 * WKB_DOUBLE_SIZE;
+			if ( isnan(x) && isnan(y) )
+			{
+				s->pos += ptsize;
+				gser_put_uint32(g, 0);
+				return LW_SUCCESS;
+			}
+
+			gser_put_uint32(g, 1);
+			return gser_ptarray_from_wkb(g, 1, LW_TRUE);
+
+		case LINETYPE:
+			if ( ! gser_wkb_has(s, WKB_INT_SIZE) )
+				return LW_FAILURE;
+			n = integer_from_wkb_state(s);
+			if ( n && (s->check & LW_PARSER_CHECK_MINPOINTS) && n < 2 )
+				return LW_FAILURE;
+
+			gser_put_uint32(g, LINETYPE);
+			gser_put_uint32(g, n);
+			return gser_ptarray_from_wkb(g, n, LW_TRUE);
+
+		/* Ring counts, padded to keep the doubles aligned, then the rings */
+		case POLYGONTYPE:
+			if ( ! gser_wkb_has(s, WKB_INT_SIZE) )
+				return LW_FAILURE;
+			n = integer_from_wkb_state(s);
+
+			gser_put_uint32(g, POLYGONTYPE);
+			gser_put_uint32(g, n);
+
+			counts = g->out;
+			counts_size = (size_t)n * sizeof(uint32_t) + (n % 2 ? sizeof(uint32_t) : 0);
+			if ( g->out )
+			{
+				memset(g->out, 0, counts_size);
+				g->out += counts_size;
+			}
+			g->size += counts_size;
+
+			for ( i = 0; i < n; i++ )
+			{
+				if ( ! gser_wkb_has(s, WKB_INT_SIZE) )
+					return LW_FAILURE;
+				npoints = integer_from_wkb_state(s);
+
+				if ( (s->check & LW_PARSER_CHECK_MINPOINTS) && npoints < 4 )
+					return LW_FAILURE;
+
+				/* Same test as ptarray_is_closed_2d, on the raw bytes */
+				if ( s->check & LW_PARSER_CHECK_CLOSURE )
+				{
+					if ( ! npoints || ! gser_wkb_has(s, npoints * ptsize) ||
+					     memcmp(s->pos, s->pos + (npoints - 1) * ptsize, 2 * WKB_DOUBLE_SIZE) )
+						return LW_FAILURE;
+				}
+
+				if ( counts )
+					memcpy(counts + i * sizeof(uint32_t), &npoints, sizeof(uint32_t));
+
+				/* Only the shell counts in the box */
+				if ( gser_ptarray_from_wkb(g, npoints, i == 0) == LW_FAILURE )
+					return LW_FAILURE;
+			}
+			return LW_SUCCESS;
+
+		case MULTIPOINTTYPE:
+		case MULTILINETYPE:
+		case MULTIPOLYGONTYPE:
+		case COLLECTIONTYPE:
+			if ( ! gser_wkb_has(s, WKB_INT_SIZE) )
+				return LW_FAILURE;
+			n = integer_from_wkb_state(s);
+			if ( ! parent_type )
+				g->ngeoms = n;
+
+			gser_put_uint32(g, lwtype);
+			gser_put_uint32(g, n);
+			for ( i = 0; i < n; i++ )
+			{
+				if ( gser_from_wkb_state(g, lwtype) == LW_FAILURE )
+					return LW_FAILURE;
+			}
+			return LW_SUCCESS;
+
+		/* Curves and surfaces take the general path */
+		default:
+			return LW_FAILURE;
+	}
+}
+
+/* Same rules as lwgeom_needs_bbox() */
+static int gser_wkb_needs_bbox(const wkb_gser_state *g)
+{
+	switch ( g->lwtype )
+	{
+		case POINTTYPE:
+			return LW_FALSE;
+		case LINETYPE:
+			return g->nvertices > 2;
+		case MULTIPOINTTYPE:
+			return g->ngeoms != 1;
+		case MULTILINETYPE:
+			return ! (g->ngeoms == 1 && g->nvertices <= 2);
+		default:
+			return LW_TRUE;
+	}
+}
+
+/**
+* Read WKB into a GSERIALIZED without building an LWGEOM. The result
+* is the one of gserialized_from_lwgeom() on lwgeom_from_wkb() output,
+* with a box when that would add one. Returns NULL for the geometries
+* it does not handle, which must go through lwgeom_from_wkb().
+*/
+GSERIALIZED* gserialized_from_wkb(const uint8_t *wkb, const size_t wkb_size, const char check, size_t *size)
+{
+	wkb_gser_state g;
+	GSERIALIZED *gser;
+	uint8_t *buf, *loc;
+	size_t box_size = 0, expected_size;
+	uint8_t flags;
+	float f[8];
+	int nf = 4;
+
+	/* Size the output, checking the structure on the way */
+	gser_wkb_state_init(&g, wkb, wkb_size, check, NULL);
+	if ( gser_from_wkb_state(&g, 0) == LW_FAILURE )
+		return NULL;
+
+	flags = gflags(g.has_z, g.has_m, 0);
+	if ( g.nboxed && gser_wkb_needs_bbox(&g) )
+	{
+		FLAGS_SET_BBOX(flags, 1);
+		box_size = gbox_serialized_size(flags);
+	}
+	expected_size = 8 + box_size + g.size;
+	buf = lwalloc(expected_size);
+
+	/* Write the geometry data behind the header and the box */
+	gser_wkb_state_init(&g, wkb, wkb_size, check, buf + 8 + box_size);
+	if ( gser_from_wkb_state(&g, 0) == LW_FAILURE )
+	{
+		lwfree(buf);
+		return NULL;
+	}
+
+	if ( g.out != buf + expected_size )
+	{
+		lwerror("Return size (%d) not equal to expected size (%d)!", g.out - buf, expected_size);
+		lwfree(buf);
+		return NULL;
+	}
+
+	/* Rounded outwards to floats, as gserialized_from_gbox() does */
+	if ( FLAGS_GET_BBOX(flags) )
+	{
+		f[0] = next_float_down(g.box.xmin);
+		f[1] = next_float_up(g.box.xmax);
+		f[2] = next_float_down(g.box.ymin);
+		f[3] = next_float_up(g.box.ymax);
+		if ( g.has_z )
+		{
+			f[nf++] = next_float_down(g.box.zmin);
+			f[nf++] = next_float_up(g.box.zmax);
+		}
+		if ( g.has_m )
+		{
+			f[nf++] = next_float_down(g.box.mmin);
+			f[nf++] = next_float_up(g.box.mmax);
+		}
+		loc = buf + 8;
+		memcpy(loc, f, nf * sizeof(float));
+	}
+
+	gser = (GSERIALIZED*)buf;
+	gser->size = expected_size << 2;
+	gserialized_set_srid(gser, g.srid);
+	gser->flags = flags;
+
+	if ( size )
+		*size = expected_size;
+
+	return gser;
+}
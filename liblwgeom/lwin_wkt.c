@@ -901,3 +901,474 @@ LWGEOM *lwgeom_from_wkt(const char *wkt, const char check)
 }
 
 
+/*
+* Hand written reader for the simple features subset of WKT (points,
+* lines, polygons, their multi versions and collections of those).
+* It reads a token at a time with no lexer state, sizes each point
+* array before filling it, and builds the geometries with the same
+* wkt_parser_* functions as the grammar, so the results are the same.
+* Anything else, including every error, is left to the grammar,
+* which knows how to report it.
+*/
+
+/* Powers of ten that a double holds exactly */
+static const double wkt_fast_pow10[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define WKT_FAST_ISSPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+#define WKT_FAST_ISDIGIT(c) ((c) >= '0' && (c) <= '9')
+#define WKT_FAST_ISALPHA(c) (((c) >= 'A' && (c) <= 'Z') || ((c) >= 'a' && (c) <= 'z'))
+/* What may follow a number for the lexer to have stopped where we do */
+#define WKT_FAST_ISNUMEND(c) (WKT_FAST_ISSPACE(c) || (c) == ',' || (c) == ')')
+
+static inline void wkt_fast_skip(const char **c)
+{
+	while ( WKT_FAST_ISSPACE(**c) )
+		(*c)++;
+}
+
+/*
+* Match an upper case keyword, in any case as the lexer does. A letter
+* right after it would be read differently by the lexer, so does not
+* match, except for the Z and M that may be glued to a type name.
+*/
+static int wkt_fast_keyword(const char **c, const char *kw, int typename)
+{
+	const char *p = *c;
+	int next;
+
+	while ( *kw )
+	{
+		if ( toupper((unsigned char)*p) != *kw )
+			return LW_FALSE;
+		p++; kw++;
+	}
+
+	next = toupper((unsigned char)*p);
+	if ( WKT_FAST_ISALPHA(next) && ! (typename && (next == 'Z' || next == 'M')) )
+		return LW_FALSE;
+
+	*c = p;
+	return LW_TRUE;
+}
+
+/*
+* Read a number matching the lexer DOUBLE rule. Values that are exact
+* products or quotients of two doubles are computed directly, which
+* gives the correctly rounded result; the others go through strtod().
+*/
+static int wkt_fast_double(const char **c, double *d)
+{
+	const char *p = *c;
+	const char *start = p;
+	uint64_t mantissa = 0;
+	int ndigits = 0, nint = 0, nfrac = 0, exp10 = 0, expval = 0;
+	int negative = 0, expnegative = 0, exact = LW_TRUE;
+
+	if ( *p == '-' )
+	{
+		negative = 1;
+		p++;
+	}
+
+	for ( ; WKT_FAST_ISDIGIT(*p); p++, nint++ )
+	{
+		if ( ndigits < 19 )
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			if ( mantissa ) ndigits++;
+		}
+		else
+		{
+			exp10++;
+			exact = LW_FALSE;
+		}
+	}
+
+	if ( *p == '.' )
+	{
+		p++;
+		for ( ; WKT_FAST_ISDIGIT(*p); p++, nfrac++ )
+		{
+			if ( ndigits < 19 )
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				if ( mantissa ) ndigits++;
+				exp10--;
+			}
+			else
+			{
+				exact = LW_FALSE;
+			}
+		}
+	}
+
+	if ( ! (nint || nfrac) )
+		return LW_FAILURE;
+
+	/* The lexer only takes an exponent after digits */
+	if ( (*p == 'e' || *p == 'E') && (nfrac || *(p-1) != '.') )
+	{
+		const char *e = p + 1;
+		if ( *e == '-' || *e == '+' )
+			expnegative = (*e++ == '-');
+		if ( WKT_FAST_ISDIGIT(*e) )
+		{
+			for ( ; WKT_FAST_ISDIGIT(*e); e++ )
+			{
+				if ( expval < 10000 )
+					expval = expval * 10 + (*e - '0');
+			}
+			exp10 += expnegative ? -expval : expval;
+			p = e;
+		}
+	}
+
+	if ( ! WKT_FAST_ISNUMEND(*p) )
+		return LW_FAILURE;
+
+	if ( exact && mantissa == 0 )
+	{
+		*d = negative ? -0.0 : 0.0;
+	}
+	else if ( exact && mantissa <= ((uint64_t)1 << 53) && exp10 >= -22 && exp10 <= 22 )
+	{
+		*d = exp10 < 0 ? (double)mantissa / wkt_fast_pow10[-exp10] : (double)mantissa * wkt_fast_pow10[exp10];
+		if ( negative ) *d = -(*d);
+	}
+	else
+	{
+		*d = strtod(start, NULL);
+	}
+
+	*c = p;
+	return LW_SUCCESS;
+}
+
+/* Read the two to four ordinates of a coordinate, return how many */
+static int wkt_fast_coord(const char **c, double *ord)
+{
+	int n = 0;
+
+	wkt_fast_skip(c);
+	while ( n < 4 )
+	{
+		if ( ! wkt_fast_double(c, ord + n) )
+			return 0;
+		n++;
+		wkt_fast_skip(c);
+		if ( **c == ',' || **c == ')' )
+			return n < 2 ? 0 : n;
+	}
+	return 0;
+}
+
+static int wkt_fast_expect(const char **c, char ch)
+{
+	wkt_fast_skip(c);
+	if ( **c != ch )
+		return LW_FALSE;
+	(*c)++;
+	return LW_TRUE;
+}
+
+/*
+* Read "(x y, x y, ...)" into an array sized from the number of commas
+* before the closing bracket.
+*/
+static POINTARRAY* wkt_fast_ptarray(const char **c)
+{
+	double ord[4];
+	const char *p;
+	POINTARRAY *pa;
+	uint32_t npoints = 1, i;
+	int ndims;
+	size_t ptsize;
+
+	if ( ! wkt_fast_expect(c, '(') )
+		return NULL;
+
+	ndims = wkt_fast_coord(c, ord);
+	if ( ! ndims )
+		return NULL;
+
+	for ( p = *c; *p && *p != ')'; p++ )
+	{
+		if ( *p == ',' ) npoints++;
+	}
+
+	pa = ptarray_construct(ndims > 2, ndims > 3, npoints);
+	ptsize = ndims * sizeof(double);
+	memcpy(getPoint_internal(pa, 0), ord, ptsize);
+
+	for ( i = 1; i < npoints; i++ )
+	{
+		if ( *((*c)++) != ',' || wkt_fast_coord(c, ord) != ndims )
+		{
+			ptarray_free(pa);
+			return NULL;
+		}
+		memcpy(getPoint_internal(pa, i), ord, ptsize);
+	}
+
+	if ( ! wkt_fast_expect(c, ')') )
+	{
+		ptarray_free(pa);
+		return NULL;
+	}
+	return pa;
+}
+
+/*
+* Read an optional Z, M or ZM tag. Fails on a tag the lexer would read
+* differently, leaves *dims NULL if there is none.
+*/
+static int wkt_fast_dims(const char **c, char **dims)
+{
+	wkt_fast_skip(c);
+	*dims = NULL;
+
+	if ( wkt_fast_keyword(c, "ZM", LW_FALSE) )
+		*dims = "ZM";
+	else if ( wkt_fast_keyword(c, "Z", LW_FALSE) )
+		*dims = "Z";
+	else if ( wkt_fast_keyword(c, "M", LW_FALSE) )
+		*dims = "M";
+	else if ( WKT_FAST_ISALPHA(**c) && toupper((unsigned char)**c) != 'E' )
+		return LW_FAILURE;
+
+	wkt_fast_skip(c);
+	return LW_SUCCESS;
+}
+
+/* Any error from the wkt_parser_* functions sends us back to the grammar */
+#define WKT_FAST_ERROR() (global_parser_result.errcode != 0)
+
+static LWGEOM* wkt_fast_ring_list(const char **c)
+{
+	LWGEOM *poly;
+	POINTARRAY *pa;
+
+	if ( ! wkt_fast_expect(c, '(') )
+		return NULL;
+
+	if ( ! (pa = wkt_fast_ptarray(c)) )
+		return NULL;
+	poly = wkt_parser_polygon_new(pa, '2');
+	if ( WKT_FAST_ERROR() )
+		return NULL;
+
+	while ( wkt_fast_expect(c, ',') )
+	{
+		if ( ! (pa = wkt_fast_ptarray(c)) )
+		{
+			lwgeom_free(poly);
+			return NULL;
+		}
+		poly = wkt_parser_polygon_add_ring(poly, pa, '2');
+		if ( WKT_FAST_ERROR() )
+			return NULL;
+	}
+
+	if ( ! wkt_fast_expect(c, ')') )
+	{
+		lwgeom_free(poly);
+		return NULL;
+	}
+	return poly;
+}
+
+/* The elements of a multi geometry, without their type name */
+static LWGEOM* wkt_fast_untagged(const char **c, int lwtype)
+{
+	POINTARRAY *pa;
+	double ord[4];
+	int ndims;
+
+	wkt_fast_skip(c);
+	switch ( lwtype )
+	{
+		case MULTIPOINTTYPE:
+			if ( wkt_fast_keyword(c, "EMPTY", LW_FALSE) )
+				return wkt_parser_point_new(NULL, NULL);
+			if ( **c == '(' )
+			{
+				(*c)++;
+				if ( ! (ndims = wkt_fast_coord(c, ord)) || ! wkt_fast_expect(c, ')') )
+					return NULL;
+			}
+			else if ( ! (ndims = wkt_fast_coord(c, ord)) )
+			{
+				return NULL;
+			}
+			pa = ptarray_construct(ndims > 2, ndims > 3, 1);
+			memcpy(getPoint_internal(pa, 0), ord, ndims * sizeof(double));
+			return wkt_parser_point_new(pa, NULL);
+
+		case MULTILINETYPE:
+			if ( wkt_fast_keyword(c, "EMPTY", LW_FALSE) )
+				return wkt_parser_linestring_new(NULL, NULL);
+			if ( ! (pa = wkt_fast_ptarray(c)) )
+				return NULL;
+			return wkt_parser_linestring_new(pa, NULL);
+
+		case MULTIPOLYGONTYPE:
+			if ( wkt_fast_keyword(c, "EMPTY", LW_FALSE) )
+				return wkt_parser_polygon_finalize(NULL, NULL);
+			return wkt_fast_ring_list(c);
+	}
+	return NULL;
+}
+
+static LWGEOM* wkt_fast_geometry(const char **c)
+{
+	LWGEOM *geom = NULL, *col, *sub;
+	POINTARRAY *pa;
+	char *dims;
+	int lwtype;
+
+	wkt_fast_skip(c);
+
+	if ( wkt_fast_keyword(c, "POINT", LW_TRUE) )
+		lwtype = POINTTYPE;
+	else if ( wkt_fast_keyword(c, "LINESTRING", LW_TRUE) )
+		lwtype = LINETYPE;
+	else if ( wkt_fast_keyword(c, "POLYGON", LW_TRUE) )
+		lwtype = POLYGONTYPE;
+	else if ( wkt_fast_keyword(c, "MULTIPOINT", LW_TRUE) )
+		lwtype = MULTIPOINTTYPE;
+	else if ( wkt_fast_keyword(c, "MULTILINESTRING", LW_TRUE) )
+		lwtype = MULTILINETYPE;
+	else if ( wkt_fast_keyword(c, "MULTIPOLYGON", LW_TRUE) )
+		lwtype = MULTIPOLYGONTYPE;
+	else if ( wkt_fast_keyword(c, "GEOMETRYCOLLECTION", LW_TRUE) )
+		lwtype = COLLECTIONTYPE;
+	else
+		return NULL;
+
+	if ( wkt_fast_dims(c, &dims) == LW_FAILURE )
+		return NULL;
+
+	/* Same constructors as the EMPTY rules of the grammar */
+	if ( wkt_fast_keyword(c, "EMPTY", LW_FALSE) )
+	{
+		switch ( lwtype )
+		{
+			case POINTTYPE:
+				return wkt_parser_point_new(NULL, dims);
+			case LINETYPE:
+				return wkt_parser_linestring_new(NULL, dims);
+			case POLYGONTYPE:
+				return wkt_parser_polygon_finalize(NULL, dims);
+			default:
+				return wkt_parser_collection_finalize(lwtype, NULL, dims);
+		}
+	}
+
+	switch ( lwtype )
+	{
+		case POINTTYPE:
+			if ( ! (pa = wkt_fast_ptarray(c)) )
+				return NULL;
+			geom = wkt_parser_point_new(pa, dims);
+			break;
+
+		case LINETYPE:
+			if ( ! (pa = wkt_fast_ptarray(c)) )
+				return NULL;
+			geom = wkt_parser_linestring_new(pa, dims);
+			break;
+
+		case POLYGONTYPE:
+			if ( ! (geom = wkt_fast_ring_list(c)) )
+				return NULL;
+			geom = wkt_parser_polygon_finalize(geom, dims);
+			break;
+
+		default:
+			if ( ! wkt_fast_expect(c, '(') )
+				return NULL;
+
+			col = NULL;
+			do
+			{
+				if ( lwtype == COLLECTIONTYPE )
+					sub = wkt_fast_geometry(c);
+				else
+					sub = wkt_fast_untagged(c, lwtype);
+
+				if ( ! sub || WKT_FAST_ERROR() )
+				{
+					if ( sub ) lwgeom_free(sub);
+					if ( col ) lwgeom_free(col);
+					return NULL;
+				}
+
+				col = col ? wkt_parser_collection_add_geom(col, sub) : wkt_parser_collection_new(sub);
+				if ( WKT_FAST_ERROR() )
+					return NULL;
+			}
+			while ( wkt_fast_expect(c, ',') );
+
+			if ( ! wkt_fast_expect(c, ')') )
+			{
+				lwgeom_free(col);
+				return NULL;
+			}
+			geom = wkt_parser_collection_finalize(lwtype, col, dims);
+			break;
+	}
+
+	if ( WKT_FAST_ERROR() )
+		return NULL;
+	return geom;
+}
+
+/**
+* Parse the simple features subset of WKT into global_parser_result.
+* Returns LW_FAILURE for anything it does not handle, leaving the
+* input to the grammar.
+*/
+int wkt_parse_fast(char *wktstr, int parser_check_flags)
+{
+	const char *c = wktstr;
+	char *srid = NULL;
+	LWGEOM *geom;
+
+	lwgeom_parser_result_init(&global_parser_result);
+	global_parser_result.wkinput = wktstr;
+	global_parser_result.parser_check_flags = parser_check_flags;
+
+	wkt_fast_skip(&c);
+
+	/* SRID=<number>; */
+	if ( toupper((unsigned char)c[0]) == 'S' && toupper((unsigned char)c[1]) == 'R' &&
+	     toupper((unsigned char)c[2]) == 'I' && toupper((unsigned char)c[3]) == 'D' && c[4] == '=' )
+	{
+		srid = (char*)c;
+		c += 5;
+		if ( *c == '-' ) c++;
+		if ( ! WKT_FAST_ISDIGIT(*c) )
+			return LW_FAILURE;
+		while ( WKT_FAST_ISDIGIT(*c) ) c++;
+		if ( ! wkt_fast_expect(&c, ';') )
+			return LW_FAILURE;
+	}
+
+	geom = wkt_fast_geometry(&c);
+	if ( ! geom )
+		return LW_FAILURE;
+
+	wkt_fast_skip(&c);
+	if ( *c )
+	{
+		lwgeom_free(geom);
+		return LW_FAILURE;
+	}
+
+	wkt_parser_geometry_new(geom, srid ? wkt_lexer_read_srid(srid) : SRID_UNKNOWN);
+	return LW_SUCCESS;
+}
@@ -54,3 +54,8 @@ LWGEOM* wkt_parser_collection_add_geom(LWGEOM *col, LWGEOM *geom);
 LWGEOM* wkt_parser_collection_finalize(int lwtype, LWGEOM *col, char *dimensionality);
 void    wkt_parser_geometry_new(LWGEOM *geom, int srid);
 
+/*
+* Hand written parser for the common geometry types, tried before the grammar.
+*/
+int wkt_parse_fast(char *wktstr, int parser_check_flags);
+
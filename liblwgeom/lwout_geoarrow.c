@@ -0,0 +1,423 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+/*
+** Columnar output in the GeoArrow memory layout, see
+** https://github.com/geoarrow/geoarrow
+**
+** Geometries are appended one at a time to a builder, which keeps
+** the coordinates of all of them in one interleaved buffer, copied
+** straight from the point arrays, and offsets into it for the parts
+** and rings. The whole column is then written as a single blob:
+**
+**   0   "GAR1"
+**   4   geometry type, as in WKB, 1 point to 6 multipolygon, 0 if none
+**   5   number of dimensions
+**   6   has z
+**   7   has m
+**   8   srid, int32
+**   12  padding
+**   16  number of rows, int64
+**   24  number of null rows, int64
+**   32  offset and length in bytes, int64 each, of the validity bitmap,
+**       the geometry, part and ring offsets and the coordinates
+**   112 the buffers present, each starting on a 64 byte boundary
+**
+** Buffers follow the Arrow conventions, in the byte order of the
+** machine. The validity bitmap is absent when no row is null. The
+** offsets are int32 and have one more entry than the array they
+** cut up. Only the offsets the geometry type needs are present:
+**
+**   point        coordinates
+**   linestring   geometry offsets into the coordinates
+**   polygon      geometry offsets into the rings, ring offsets
+**   multipoint   geometry offsets into the coordinates
+**   multiline    geometry offsets into the parts, part offsets
+**   multipolygon geometry, part and ring offsets
+**
+** Single geometries are written as multi-geometries of their type
+** when the column holds both. Empty points get NaN coordinates.
+*/
+
+#include "liblwgeom_internal.h"
+#include "lwgeom_log.h"
+#include "bytebuffer.h"
+
+#define GEOARROW_HEADER_SIZE 112
+#define GEOARROW_ALIGN(size) (((size) + 63) & ~((size_t) 63))
+#define GEOARROW_NBUFFERS 5
+
+struct LWGEOARROW_T
+{
+	/* Set by the first geometry that is not null */
+	uint8_t type; /* POINTTYPE, LINETYPE or POLYGONTYPE */
+	int is_multi;
+	int has_z;
+	int has_m;
+	int32_t srid;
+
+	uint64_t length;
+	uint64_t null_count;
+	bytebuffer_t *validity;
+
+	/* Every geometry as parts made of rings, whatever its type */
+	bytebuffer_t *geom_parts;
+	bytebuffer_t *part_rings;
+	bytebuffer_t *ring_coords;
+	bytebuffer_t *coords;
+	int32_t nparts;
+	int32_t nrings;
+	int32_t ncoords;
+};
+
+static void
+geoarrow_append_int32(bytebuffer_t *b, int32_t val)
+{
+	bytebuffer_append_bulk(b, &val, sizeof(int32_t));
+}
+
+static int32_t *
+geoarrow_int32s(const bytebuffer_t *b)
+{
+	return (int32_t *) b->buf_start;
+}
+
+LWGEOARROW *
+lwgeoarrow_create(void)
+{
+	LWGEOARROW *ga = lwalloc(sizeof(LWGEOARROW));
+	memset(ga, 0, sizeof(LWGEOARROW));
+
+	ga->validity = bytebuffer_create();
+	ga->geom_parts = bytebuffer_create();
+	ga->part_rings = bytebuffer_create();
+	ga->ring_coords = bytebuffer_create();
+	ga->coords = bytebuffer_create_with_size(8192);
+
+	geoarrow_append_int32(ga->geom_parts, 0);
+	geoarrow_append_int32(ga->part_rings, 0);
+	geoarrow_append_int32(ga->ring_coords, 0);
+
+	return ga;
+}
+
+void
+lwgeoarrow_free(LWGEOARROW *ga)
+{
+	bytebuffer_destroy(ga->validity);
+	bytebuffer_destroy(ga->geom_parts);
+	bytebuffer_destroy(ga->part_rings);
+	bytebuffer_destroy(ga->ring_coords);
+	bytebuffer_destroy(ga->coords);
+	lwfree(ga);
+}
+
+/* Add a ring, the coordinates are copied as they are laid out */
+static void
+geoarrow_add_ring(LWGEOARROW *ga, const POINTARRAY *pa)
+{
+	if ( (int64_t) ga->ncoords + pa->npoints > INT32_MAX )
+		lwerror("%s: more than %d coordinates", __func__, INT32_MAX);
+
+	if ( pa->npoints )
+		bytebuffer_append_bulk(ga->coords, getPoint_internal(pa, 0), (size_t) pa->npoints * ptarray_point_size(pa));
+
+	ga->ncoords += pa->npoints;
+	geoarrow_append_int32(ga->ring_coords, ga->ncoords);
+	ga->nrings++;
+}
+
+/* Close a part made of the rings added since the last one */
+static void
+geoarrow_end_part(LWGEOARROW *ga)
+{
+	geoarrow_append_int32(ga->part_rings, ga->nrings);
+	ga->nparts++;
+}
+
+static void
+geoarrow_add_part(LWGEOARROW *ga, const LWGEOM *geom)
+{
+	uint32_t i;
+
+	if ( lwgeom_is_empty(geom) )
+		return;
+
+	switch ( geom->type )
+	{
+		case POINTTYPE:
+			geoarrow_add_ring(ga, ((LWPOINT*) geom)->point);
+			break;
+		case LINETYPE:
+			geoarrow_add_ring(ga, ((LWLINE*) geom)->points);
+			break;
+		case POLYGONTYPE:
+			for ( i = 0; i < ((LWPOLY*) geom)->nrings; i++ )
+				geoarrow_add_ring(ga, ((LWPOLY*) geom)->rings[i]);
+			break;
+	}
+	geoarrow_end_part(ga);
+}
+
+static void
+geoarrow_set_valid(LWGEOARROW *ga, int valid)
+{
+	if ( ga->length % 8 == 0 )
+		bytebuffer_append_byte(ga->validity, 0);
+
+	if ( valid )
+		ga->validity->buf_start[ga->length / 8] |= 1 << (ga->length % 8);
+	else
+		ga->null_count++;
+
+	ga->length++;
+}
+
+void
+lwgeoarrow_append(LWGEOARROW *ga, const LWGEOM *geom)
+{
+	uint8_t type;
+	uint32_t i;
+
+	if ( ! geom )
+	{
+		geoarrow_set_valid(ga, LW_FALSE);
+		geoarrow_append_int32(ga->geom_parts, ga->nparts);
+		return;
+	}
+
+	switch ( geom->type )
+	{
+		case POINTTYPE:
+		case LINETYPE:
+		case POLYGONTYPE:
+			type = geom->type;
+			break;
+		case MULTIPOINTTYPE:
+		case MULTILINETYPE:
+		case MULTIPOLYGONTYPE:
+			type = geom->type - 3;
+			break;
+		default:
+			lwerror("%s: unsupported geometry type: %s", __func__, lwtype_name(geom->type));
+			return;
+	}
+
+	/* A column holds one type, with the same dimensions and srid */
+	if ( ! ga->type )
+	{
+		ga->type = type;
+		ga->has_z = FLAGS_GET_Z(geom->flags);
+		ga->has_m = FLAGS_GET_M(geom->flags);
+		ga->srid = geom->srid;
+	}
+	else if ( type != ga->type )
+	{
+		lwerror("%s: cannot mix %s and %s geometries", __func__,
+		        lwtype_name(ga->type), lwtype_name(type));
+		return;
+	}
+	else if ( FLAGS_GET_Z(geom->flags) != ga->has_z || FLAGS_GET_M(geom->flags) != ga->has_m )
+	{
+		lwerror("%s: cannot mix geometries of different dimensions", __func__);
+		return;
+	}
+	else if ( geom->srid != ga->srid )
+	{
+		lwerror("%s: cannot mix geometries of different srid", __func__);
+		return;
+	}
+
+	if ( type != geom->type )
+	{
+		const LWCOLLECTION *col = (const LWCOLLECTION*) geom;
+		ga->is_multi = LW_TRUE;
+		for ( i = 0; i < col->ngeoms; i++ )
+			geoarrow_add_part(ga, col->geoms[i]);
+	}
+	else
+	{
+		geoarrow_add_part(ga, geom);
+	}
+
+	geoarrow_set_valid(ga, LW_TRUE);
+	geoarrow_append_int32(ga->geom_parts, ga->nparts);
+}
+
+static uint8_t
+geoarrow_type(const LWGEOARROW *ga)
+{
+	if ( ! ga->type )
+		return 0;
+	return ga->is_multi ? ga->type + 3 : ga->type;
+}
+
+/* Lengths of the buffers in the order of the header */
+static void
+geoarrow_buffer_sizes(const LWGEOARROW *ga, size_t *sizes)
+{
+	size_t offsets = sizeof(int32_t) * (ga->length + 1);
+	int ndims = 2 + ga->has_z + ga->has_m;
+
+	sizes[0] = ga->null_count ? bytebuffer_getlength(ga->validity) : 0;
+	sizes[1] = sizes[2] = sizes[3] = 0;
+	sizes[4] = sizeof(double) * ndims * ga->ncoords;
+
+	switch ( geoarrow_type(ga) )
+	{
+		case POINTTYPE:
+			sizes[4] = sizeof(double) * ndims * ga->length;
+			break;
+		case LINETYPE:
+		case MULTIPOINTTYPE:
+			sizes[1] = offsets;
+			break;
+		case POLYGONTYPE:
+			sizes[1] = offsets;
+			sizes[3] = sizeof(int32_t) * (ga->nrings + 1);
+			break;
+		case MULTILINETYPE:
+			sizes[1] = offsets;
+			sizes[2] = sizeof(int32_t) * (ga->nparts + 1);
+			break;
+		case MULTIPOLYGONTYPE:
+			sizes[1] = offsets;
+			sizes[2] = sizeof(int32_t) * (ga->nparts + 1);
+			sizes[3] = sizeof(int32_t) * (ga->nrings + 1);
+			break;
+	}
+}
+
+size_t
+lwgeoarrow_size(const LWGEOARROW *ga)
+{
+	size_t sizes[GEOARROW_NBUFFERS];
+	size_t size = GEOARROW_HEADER_SIZE;
+	int i;
+
+	geoarrow_buffer_sizes(ga, sizes);
+	for ( i = 0; i < GEOARROW_NBUFFERS; i++ )
+	{
+		if ( sizes[i] )
+			size = GEOARROW_ALIGN(size) + sizes[i];
+	}
+
+	return size;
+}
+
+void
+lwgeoarrow_write(const LWGEOARROW *ga, uint8_t *buf)
+{
+	const int32_t *gp = geoarrow_int32s(ga->geom_parts);
+	const int32_t *pr = geoarrow_int32s(ga->part_rings);
+	const int32_t *rc = geoarrow_int32s(ga->ring_coords);
+	size_t sizes[GEOARROW_NBUFFERS];
+	size_t offsets[GEOARROW_NBUFFERS];
+	size_t pos = GEOARROW_HEADER_SIZE;
+	int ndims = 2 + ga->has_z + ga->has_m;
+	uint8_t type = geoarrow_type(ga);
+	int32_t *out;
+	double *pt;
+	uint64_t i, n;
+	int j;
+
+	geoarrow_buffer_sizes(ga, sizes);
+	for ( i = 0; i < GEOARROW_NBUFFERS; i++ )
+	{
+		offsets[i] = 0;
+		if ( sizes[i] )
+		{
+			pos = GEOARROW_ALIGN(pos);
+			offsets[i] = pos;
+			pos += sizes[i];
+		}
+	}
+	memset(buf, 0, pos);
+
+	/* Header */
+	memcpy(buf, "GAR1", 4);
+	buf[4] = type;
+	buf[5] = ndims;
+	buf[6] = ga->has_z;
+	buf[7] = ga->has_m;
+	memcpy(buf + 8, &ga->srid, sizeof(int32_t));
+	memcpy(buf + 16, &ga->length, sizeof(uint64_t));
+	memcpy(buf + 24, &ga->null_count, sizeof(uint64_t));
+	for ( i = 0; i < GEOARROW_NBUFFERS; i++ )
+	{
+		uint64_t offset = offsets[i];
+		uint64_t size = sizes[i];
+		memcpy(buf + 32 + 16 * i, &offset, sizeof(uint64_t));
+		memcpy(buf + 40 + 16 * i, &size, sizeof(uint64_t));
+	}
+
+	/* Validity */
+	if ( sizes[0] )
+		memcpy(buf + offsets[0], ga->validity->buf_start, sizes[0]);
+
+	/* Points are one coordinate a row, NaN when empty or null */
+	if ( type == POINTTYPE )
+	{
+		pt = (double*)(buf + offsets[4]);
+		for ( i = 0; i < ga->length; i++ )
+		{
+			if ( gp[i + 1] > gp[i] )
+			{
+				memcpy(pt, ga->coords->buf_start + sizeof(double) * ndims * rc[pr[gp[i]]], sizeof(double) * ndims);
+			}
+			else
+			{
+				for ( j = 0; j < ndims; j++ )
+					pt[j] = NAN;
+			}
+			pt += ndims;
+		}
+		return;
+	}
+
+	/*
+	** Geometry offsets, into whatever the level below the geometry
+	** is for the type, then the part and ring offsets as needed
+	*/
+	if ( sizes[1] )
+	{
+		out = (int32_t*)(buf + offsets[1]);
+		for ( i = 0; i <= ga->length; i++ )
+		{
+			switch ( type )
+			{
+				case LINETYPE:
+				case MULTIPOINTTYPE:
+					out[i] = rc[pr[gp[i]]];
+					break;
+				case POLYGONTYPE:
+					out[i] = pr[gp[i]];
+					break;
+				default:
+					out[i] = gp[i];
+					break;
+			}
+		}
+	}
+
+	if ( sizes[2] )
+	{
+		out = (int32_t*)(buf + offsets[2]);
+		n = ga->nparts;
+		for ( i = 0; i <= n; i++ )
+			out[i] = type == MULTILINETYPE ? rc[pr[i]] : pr[i];
+	}
+
+	if ( sizes[3] )
+		memcpy(buf + offsets[3], rc, sizes[3]);
+
+	if ( sizes[4] )
+		memcpy(buf + offsets[4], ga->coords->buf_start, sizes[4]);
+}
@@ -21,6 +21,8 @@ static char * asgeojson_multipoint(const LWMPOINT *mpoint, char *srs, GBOX *bbox
 static char * asgeojson_multiline(const LWMLINE *mline, char *srs, GBOX *bbox, int precision);
 static char * asgeojson_multipolygon(const LWMPOLY *mpoly, char *srs, GBOX *bbox, int precision);
 static char * asgeojson_collection(const LWCOLLECTION *col, char *srs, GBOX *bbox, int precision);
+static size_t asgeojson_collection_size(const LWCOLLECTION *col, char *srs, GBOX *bbox, int precision);
+static size_t asgeojson_collection_buf(const LWCOLLECTION *col, char *srs, char *output, GBOX *bbox, int precision);
 static size_t asgeojson_geom_size(const LWGEOM *geom, GBOX *bbox, int precision);
 static size_t asgeojson_geom_buf(const LWGEOM *geom, char *output, GBOX *bbox, int precision);
 
@@ -72,6 +74,33 @@ lwgeom_to_geojson(const LWGEOM *geom, char *srs, int precision, int has_bbox)
 	return NULL;
 }
 
+/**
+ * Appends the GeoJson representation of a GEOMETRY to a string buffer,
+ * writing in place so that no intermediate string is allocated
+ */
+void
+lwgeom_to_geojson_sb(const LWGEOM *geom, stringbuffer_t *sb, int precision)
+{
+	size_t size;
+
+	if ( precision > OUT_MAX_DOUBLE_PRECISION ) precision = OUT_MAX_DOUBLE_PRECISION;
+
+	/* The sizes are upper bounds and count the terminating NULL */
+	if ( geom->type == COLLECTIONTYPE )
+	{
+		size = asgeojson_collection_size((LWCOLLECTION*)geom, NULL, NULL, precision);
+		stringbuffer_makeroom(sb, size);
+		sb->str_end += asgeojson_collection_buf((LWCOLLECTION*)geom, NULL, sb->str_end, NULL, precision);
+	}
+	else
+	{
+		size = asgeojson_geom_size(geom, NULL, precision);
+		stringbuffer_makeroom(sb, size);
+		sb->str_end += asgeojson_geom_buf(geom, sb->str_end, NULL, precision);
+	}
+	*(sb->str_end) = '\0';
+}
+
 
 
 /**
@@ -666,31 +695,18 @@ asgeojson_geom_buf(const LWGEOM *geom, char *output, GBOX *bbox, int precision)
  * Print an ordinate value using at most the given number of decimal digits
  *
  * The actual number of printed decimal digits may be less than the
- * requested ones if out of significant digits.
- *
- * The function will not write more than maxsize bytes, including the
- * terminating NULL. Returns the number of bytes that would have been
- * written if there was enough space (excluding terminating NULL).
- * So a return of ``bufsize'' or more means that the string was
- * truncated and misses a terminating NULL.
- *
- * TODO: export ?
- *
+ * requested ones if out of significant digits. Trailing zeros are
+ * trimmed. buf must hold OUT_DOUBLE_BUFFER_SIZE bytes.
+ * Returns the number of bytes written, excluding the terminating NULL.
  */
 static int
-lwprint_double(double d, int maxdd, char *buf, size_t bufsize)
+lwprint_double(double d, int maxdd, char *buf)
 {
-  double ad = fabs(d);
-  int ndd = ad < 1 ? 0 : floor(log10(ad))+1; /* non-decimal digits */
-  if (fabs(d) < OUT_MAX_DOUBLE)
-  {
-    if ( maxdd > (OUT_MAX_DOUBLE_PRECISION - ndd) )  maxdd -= ndd;
-    return snprintf(buf, bufsize, "%.*f", maxdd, d);
-  }
-  else
-  {
-    return snprintf(buf, bufsize, "%g", d);
-  }
+	double ad = fabs(d);
+	int ndd = ad < 1 ? 0 : floor(log10(ad))+1; /* non-decimal digits */
+	if ( ad < OUT_MAX_DOUBLE && maxdd > (OUT_MAX_DOUBLE_PRECISION - ndd) )
+		maxdd -= ndd;
+	return lwprint_double_fixed(d, maxdd, buf, OUT_DOUBLE_BUFFER_SIZE);
 }
 
 
@@ -698,59 +714,30 @@ lwprint_double(double d, int maxdd, char *buf, size_t bufsize)
 static size_t
 pointArray_to_geojson(POINTARRAY *pa, char *output, int precision)
 {
-	int i;
-	char *ptr;
-#define BUFSIZE OUT_MAX_DIGS_DOUBLE+OUT_MAX_DOUBLE_PRECISION
-	char x[BUFSIZE+1];
-	char y[BUFSIZE+1];
-	char z[BUFSIZE+1];
+	int i, j;
+	int dims = FLAGS_GET_Z(pa->flags) ? 3 : 2;
+	char *ptr = output;
 
 	assert ( precision <= OUT_MAX_DOUBLE_PRECISION );
 
-  /* Ensure a terminating NULL at the end of buffers
-   * so that we don't need to check for truncation
-   * inprint_double */
-  x[BUFSIZE] = '\0';
-  y[BUFSIZE] = '\0';
-  z[BUFSIZE] = '\0';
-
-	ptr = output;
-
-  /* TODO: rewrite this loop to be simpler and possibly quicker */
-	if (!FLAGS_GET_Z(pa->flags))
+	/*
+	 * Ordinates are printed straight into the output, which
+	 * pointArray_geojson_size() sized for the longest of them
+	 */
+	for (i=0; i<pa->npoints; i++)
 	{
-		for (i=0; i<pa->npoints; i++)
-		{
-			const POINT2D *pt;
-			pt = getPoint2d_cp(pa, i);
+		const double *pt = (const double*)getPoint_internal(pa, i);
 
-			lwprint_double(pt->x, precision, x, BUFSIZE);
-			trim_trailing_zeros(x);
-			lwprint_double(pt->y, precision, y, BUFSIZE);
-			trim_trailing_zeros(y);
-
-			if ( i ) ptr += sprintf(ptr, ",");
-			ptr += sprintf(ptr, "[%s,%s]", x, y);
-		}
-	}
-	else
-	{
-		for (i=0; i<pa->npoints; i++)
+		if ( i ) *ptr++ = ',';
+		*ptr++ = '[';
+		for (j=0; j<dims; j++)
 		{
-			const POINT3DZ *pt;
-			pt = getPoint3dz_cp(pa, i);
-
-			lwprint_double(pt->x, precision, x, BUFSIZE);
-			trim_trailing_zeros(x);
-			lwprint_double(pt->y, precision, y, BUFSIZE);
-			trim_trailing_zeros(y);
-			lwprint_double(pt->z, precision, z, BUFSIZE);
-			trim_trailing_zeros(z);
-
-			if ( i ) ptr += sprintf(ptr, ",");
-			ptr += sprintf(ptr, "[%s,%s,%s]", x, y, z);
+			if ( j ) *ptr++ = ',';
+			ptr += lwprint_double(pt[j], precision, ptr);
 		}
+		*ptr++ = ']';
 	}
+	*ptr = '\0';
 
 	return (ptr-output);
 }
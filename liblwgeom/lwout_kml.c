@@ -83,6 +83,7 @@ ptarray_to_kml2_sb(const POINTARRAY *pa, int precision, stringbuffer_t *sb)
 {
 	int i, j;
 	int dims = FLAGS_GET_Z(pa->flags) ? 3 : 2;
+	size_t room = OUT_DOUBLE_BUFFER_SIZE + (precision > 0 ? precision : 0);
 	POINT4D pt;
 	double *d;
 	
@@ -96,13 +97,15 @@ ptarray_to_kml2_sb(const POINTARRAY *pa, int precision, stringbuffer_t *sb)
 			if ( j ) stringbuffer_append(sb,",");
 			if( fabs(d[j]) < OUT_MAX_DOUBLE )
 			{
-				if ( stringbuffer_aprintf(sb, "%.*f", precision, d[j]) < 0 ) return LW_FAILURE;
+				/* Printed and trimmed in place */
+				stringbuffer_makeroom(sb, room);
+				sb->str_end += lwprint_double_fixed(d[j], precision, sb->str_end, room);
 			}
 			else 
 			{
 				if ( stringbuffer_aprintf(sb, "%g", d[j]) < 0 ) return LW_FAILURE;
+				stringbuffer_trim_trailing_zeroes(sb);
 			}
-			stringbuffer_trim_trailing_zeroes(sb);
 		}
 	}
 	return LW_SUCCESS;
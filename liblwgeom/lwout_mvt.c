@@ -0,0 +1,460 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+/*
+** Mapbox Vector Tile geometry support.
+**
+** lwgeom_to_mvt_geom() brings a geometry into the integer coordinate
+** space of a tile, and lwgeom_to_mvt_geometry() writes the packed
+** command stream of the "geometry" field of a tile feature, see
+** https://github.com/mapbox/vector-tile-spec/tree/master/2.1
+*/
+
+#include "liblwgeom_internal.h"
+#include "lwgeom_log.h"
+#include "bytebuffer.h"
+
+/* Feature geometry types */
+#define MVT_UNKNOWN 0
+#define MVT_POINT 1
+#define MVT_LINESTRING 2
+#define MVT_POLYGON 3
+
+/* Geometry commands */
+#define MVT_MOVETO 1
+#define MVT_LINETO 2
+#define MVT_CLOSEPATH 7
+
+#define MVT_COMMAND(id, count) (((id) & 0x7) | ((count) << 3))
+
+/*
+** The simple type a geometry is written as, points, lines or
+** polygons, taken from its dimension for collections and curves.
+*/
+static int
+mvt_basic_type(const LWGEOM *geom)
+{
+	switch ( geom->type )
+	{
+		case TRIANGLETYPE:
+		case TINTYPE:
+		case POLYHEDRALSURFACETYPE:
+			lwerror("%s: unsupported geometry type: %s",
+			        __func__, lwtype_name(geom->type));
+			return 0;
+	}
+
+	switch ( lwgeom_dimension(geom) )
+	{
+		case 0:
+			return POINTTYPE;
+		case 1:
+			return LINETYPE;
+		default:
+			return POLYGONTYPE;
+	}
+}
+
+/*
+** Clip without GEOSClipByRect, intersecting with the rectangle
+** as a polygon.
+*/
+#if POSTGIS_GEOS_VERSION < 35
+static LWGEOM *
+mvt_clip_by_box(const LWGEOM *geom, const GBOX *box)
+{
+	POINTARRAY *pa = ptarray_construct_empty(0, 0, 5);
+	POINTARRAY **rings = lwalloc(sizeof(POINTARRAY*));
+	POINT4D pt = {0.0, 0.0, 0.0, 0.0};
+	LWGEOM *envelope, *result;
+
+	pt.x = box->xmin; pt.y = box->ymin;
+	ptarray_append_point(pa, &pt, LW_TRUE);
+	pt.x = box->xmin; pt.y = box->ymax;
+	ptarray_append_point(pa, &pt, LW_TRUE);
+	pt.x = box->xmax; pt.y = box->ymax;
+	ptarray_append_point(pa, &pt, LW_TRUE);
+	pt.x = box->xmax; pt.y = box->ymin;
+	ptarray_append_point(pa, &pt, LW_TRUE);
+	pt.x = box->xmin; pt.y = box->ymin;
+	ptarray_append_point(pa, &pt, LW_TRUE);
+	rings[0] = pa;
+
+	envelope = lwpoly_as_lwgeom(lwpoly_construct(geom->srid, NULL, 1, rings));
+	result = lwgeom_intersection(geom, envelope);
+	lwgeom_free(envelope);
+	return result;
+}
+#else
+static LWGEOM *
+mvt_clip_by_box(const LWGEOM *geom, const GBOX *box)
+{
+	return lwgeom_clip_by_rect(geom, box->xmin, box->ymin, box->xmax, box->ymax);
+}
+#endif
+
+/**
+* Transform a geometry into the coordinate space of a tile covering
+* the bounds, with the origin at the upper left corner and extent
+* units per side. Coordinates are snapped to the integer grid, and
+* unless clip_geom is false the geometry is clipped to the tile
+* grown by buffer units on all sides. Points, lines and polygons come
+* out as themselves or their multi version, curves are stroked and
+* collections reduced to their parts of highest dimension.
+*
+* Returns NULL when nothing of the geometry is left in the tile.
+*/
+LWGEOM *
+lwgeom_to_mvt_geom(const LWGEOM *geom, const GBOX *bounds, uint32_t extent, uint32_t buffer, int clip_geom)
+{
+	double width = bounds->xmax - bounds->xmin;
+	double height = bounds->ymax - bounds->ymin;
+	double bufwidth, bufheight;
+	int basic_type;
+	const GBOX *gbox;
+	GBOX clipbox;
+	LWGEOM *lwgeom, *tmp;
+	AFFINE affine;
+	gridspec grid;
+
+	if ( width <= 0 || height <= 0 )
+	{
+		lwerror("%s: bounds must have a positive width and height", __func__);
+		return NULL;
+	}
+	if ( extent == 0 )
+	{
+		lwerror("%s: extent must be greater than zero", __func__);
+		return NULL;
+	}
+
+	if ( lwgeom_is_empty(geom) )
+		return NULL;
+
+	basic_type = mvt_basic_type(geom);
+
+	if ( lwgeom_has_arc(geom) )
+		lwgeom = lwgeom_stroke(geom, 32);
+	else
+		lwgeom = lwgeom_clone_deep(geom);
+
+	if ( FLAGS_GET_Z(lwgeom->flags) || FLAGS_GET_M(lwgeom->flags) )
+	{
+		tmp = lwgeom_force_2d(lwgeom);
+		lwgeom_free(lwgeom);
+		lwgeom = tmp;
+	}
+
+	/* Skip geometries too small to show in the tile */
+	gbox = lwgeom_get_bbox(lwgeom);
+	if ( basic_type != POINTTYPE &&
+	     (gbox->xmax - gbox->xmin) < width / extent / 2 &&
+	     (gbox->ymax - gbox->ymin) < height / extent / 2 )
+	{
+		lwgeom_free(lwgeom);
+		return NULL;
+	}
+
+	if ( clip_geom )
+	{
+		bufwidth = width * buffer / extent;
+		bufheight = height * buffer / extent;
+		clipbox.flags = 0;
+		clipbox.xmin = bounds->xmin - bufwidth;
+		clipbox.xmax = bounds->xmax + bufwidth;
+		clipbox.ymin = bounds->ymin - bufheight;
+		clipbox.ymax = bounds->ymax + bufheight;
+
+		if ( ! gbox_overlaps_2d(gbox, &clipbox) )
+		{
+			lwgeom_free(lwgeom);
+			return NULL;
+		}
+
+		/* Only call out to GEOS for the geometries crossing the edges */
+		if ( ! gbox_contains_2d(&clipbox, gbox) )
+		{
+			tmp = mvt_clip_by_box(lwgeom, &clipbox);
+			lwgeom_free(lwgeom);
+			lwgeom = tmp;
+			if ( ! lwgeom || lwgeom_is_empty(lwgeom) )
+			{
+				if ( lwgeom ) lwgeom_free(lwgeom);
+				return NULL;
+			}
+		}
+	}
+
+	/* Scale to the extent, flipping the y axis to point down */
+	memset(&affine, 0, sizeof(AFFINE));
+	affine.afac = extent / width;
+	affine.efac = -(extent / height);
+	affine.ifac = 1;
+	affine.xoff = -bounds->xmin * affine.afac;
+	affine.yoff = bounds->ymax * extent / height;
+	lwgeom_affine(lwgeom, &affine);
+
+	/* Snapping also drops the repeated vertices of lines and rings */
+	memset(&grid, 0, sizeof(gridspec));
+	grid.xsize = 1;
+	grid.ysize = 1;
+	tmp = lwgeom_grid(lwgeom, &grid);
+	lwgeom_free(lwgeom);
+	lwgeom = tmp;
+
+	if ( ! lwgeom || lwgeom_is_empty(lwgeom) )
+	{
+		if ( lwgeom ) lwgeom_free(lwgeom);
+		return NULL;
+	}
+
+	/* Clipping may have left parts of lower dimension */
+	if ( lwgeom->type == COLLECTIONTYPE )
+	{
+		/* The extracted parts share their points with the collection */
+		LWGEOM *parts = lwcollection_as_lwgeom(lwcollection_extract((LWCOLLECTION*)lwgeom, basic_type));
+		tmp = lwgeom_clone_deep(parts);
+		lwgeom_free(parts);
+		lwgeom_free(lwgeom);
+		lwgeom = tmp;
+	}
+	else if ( mvt_basic_type(lwgeom) != basic_type )
+	{
+		lwgeom_free(lwgeom);
+		return NULL;
+	}
+
+	/* Multipoint members snapped to the same cell are all kept by the grid */
+	if ( lwgeom->type == MULTIPOINTTYPE )
+	{
+		/* The remaining members share their points with the multipoint */
+		LWGEOM *points = lwmpoint_remove_repeated_points((LWMPOINT*)lwgeom, 0.0);
+		tmp = lwgeom_clone_deep(points);
+		lwgeom_free(points);
+		lwgeom_free(lwgeom);
+		lwgeom = tmp;
+	}
+
+	if ( lwgeom_is_empty(lwgeom) )
+	{
+		lwgeom_free(lwgeom);
+		return NULL;
+	}
+
+	lwgeom_add_bbox(lwgeom);
+	return lwgeom;
+}
+
+/*
+** Writer state, the cursor is the position reached by the
+** previous command, from which the next parameters are deltas.
+*/
+typedef struct
+{
+	bytebuffer_t *buf;
+	int32_t x;
+	int32_t y;
+} mvt_writer;
+
+static void
+mvt_write_point(mvt_writer *w, const POINT2D *pt)
+{
+	int32_t x = (int32_t) pt->x;
+	int32_t y = (int32_t) pt->y;
+	bytebuffer_append_uvarint(w->buf, zigzag32(x - w->x));
+	bytebuffer_append_uvarint(w->buf, zigzag32(y - w->y));
+	w->x = x;
+	w->y = y;
+}
+
+static int
+mvt_same_point(const mvt_writer *w, const POINT2D *pt)
+{
+	return (int32_t) pt->x == w->x && (int32_t) pt->y == w->y;
+}
+
+static void
+mvt_write_points(mvt_writer *w, const LWGEOM *geom)
+{
+	const LWMPOINT *mpoint = (LWMPOINT*)geom;
+	uint32_t i, count = 0;
+
+	if ( geom->type == POINTTYPE )
+	{
+		bytebuffer_append_uvarint(w->buf, MVT_COMMAND(MVT_MOVETO, 1));
+		mvt_write_point(w, getPoint2d_cp(((LWPOINT*)geom)->point, 0));
+		return;
+	}
+
+	for ( i = 0; i < mpoint->ngeoms; i++ )
+	{
+		if ( ! lwpoint_is_empty(mpoint->geoms[i]) )
+			count++;
+	}
+
+	bytebuffer_append_uvarint(w->buf, MVT_COMMAND(MVT_MOVETO, count));
+	for ( i = 0; i < mpoint->ngeoms; i++ )
+	{
+		if ( ! lwpoint_is_empty(mpoint->geoms[i]) )
+			mvt_write_point(w, getPoint2d_cp(mpoint->geoms[i]->point, 0));
+	}
+}
+
+/*
+** Write a path through the first npoints points of the array, in
+** reverse order if asked, still starting from the first point.
+** Steps that do not move the cursor are skipped, and paths left with
+** less than minpoints points are not written at all. Returns whether
+** the path was written.
+*/
+#define MVT_PATH_INDEX(i) (reverse && (i) ? npoints - (i) : (i))
+
+static int
+mvt_write_path(mvt_writer *w, const POINTARRAY *pa, uint32_t npoints, int reverse, uint32_t minpoints)
+{
+	const POINT2D *pt, *prev;
+	uint32_t i, count = 1;
+
+	if ( npoints < minpoints )
+		return LW_FALSE;
+
+	/* Count the distinct steps first, the command leads the parameters */
+	prev = getPoint2d_cp(pa, 0);
+	for ( i = 1; i < npoints; i++ )
+	{
+		pt = getPoint2d_cp(pa, MVT_PATH_INDEX(i));
+		if ( (int32_t) pt->x != (int32_t) prev->x || (int32_t) pt->y != (int32_t) prev->y )
+			count++;
+		prev = pt;
+	}
+	if ( count < minpoints )
+		return LW_FALSE;
+
+	bytebuffer_append_uvarint(w->buf, MVT_COMMAND(MVT_MOVETO, 1));
+	mvt_write_point(w, getPoint2d_cp(pa, 0));
+
+	bytebuffer_append_uvarint(w->buf, MVT_COMMAND(MVT_LINETO, count - 1));
+	for ( i = 1; i < npoints; i++ )
+	{
+		pt = getPoint2d_cp(pa, MVT_PATH_INDEX(i));
+		if ( ! mvt_same_point(w, pt) )
+			mvt_write_point(w, pt);
+	}
+
+	return LW_TRUE;
+}
+
+#undef MVT_PATH_INDEX
+
+static void
+mvt_write_line(mvt_writer *w, const LWLINE *line)
+{
+	mvt_write_path(w, line->points, line->points->npoints, LW_FALSE, 2);
+}
+
+/*
+** Exterior rings have a positive area by the shoelace formula in
+** tile coordinates, clockwise on screen with the y axis pointing
+** down, and interior rings a negative one. The ring is written
+** without its closing point, which ClosePath stands for.
+*/
+static void
+mvt_write_polygon(mvt_writer *w, const LWPOLY *poly)
+{
+	uint32_t i;
+	double area;
+	int reverse;
+
+	for ( i = 0; i < poly->nrings; i++ )
+	{
+		/* ptarray_signed_area() is positive for clockwise rings with y up */
+		area = ptarray_signed_area(poly->rings[i]);
+		if ( area == 0.0 )
+		{
+			if ( i == 0 ) return;
+			continue;
+		}
+		reverse = i == 0 ? area > 0 : area < 0;
+
+		if ( mvt_write_path(w, poly->rings[i], poly->rings[i]->npoints - 1, reverse, 3) )
+			bytebuffer_append_uvarint(w->buf, MVT_COMMAND(MVT_CLOSEPATH, 1));
+		else if ( i == 0 )
+			return;
+	}
+}
+
+/**
+* Write the geometry of a tile feature, for a geometry already in
+* tile coordinates, see lwgeom_to_mvt_geom(). The feature type is
+* returned in type, 1 for points, 2 for lines and 3 for polygons.
+*
+* Returns NULL when there is nothing to write, otherwise the packed
+* commands and their size.
+*/
+uint8_t *
+lwgeom_to_mvt_geometry(const LWGEOM *geom, uint8_t *type, size_t *size)
+{
+	mvt_writer w;
+	uint8_t *result;
+	uint32_t i;
+
+	*type = MVT_UNKNOWN;
+	*size = 0;
+
+	if ( lwgeom_is_empty(geom) )
+		return NULL;
+
+	w.buf = bytebuffer_create();
+	w.x = w.y = 0;
+
+	switch ( geom->type )
+	{
+		case POINTTYPE:
+		case MULTIPOINTTYPE:
+			*type = MVT_POINT;
+			mvt_write_points(&w, geom);
+			break;
+		case LINETYPE:
+			*type = MVT_LINESTRING;
+			mvt_write_line(&w, (LWLINE*)geom);
+			break;
+		case MULTILINETYPE:
+			*type = MVT_LINESTRING;
+			for ( i = 0; i < ((LWMLINE*)geom)->ngeoms; i++ )
+				mvt_write_line(&w, ((LWMLINE*)geom)->geoms[i]);
+			break;
+		case POLYGONTYPE:
+			*type = MVT_POLYGON;
+			mvt_write_polygon(&w, (LWPOLY*)geom);
+			break;
+		case MULTIPOLYGONTYPE:
+			*type = MVT_POLYGON;
+			for ( i = 0; i < ((LWMPOLY*)geom)->ngeoms; i++ )
+				mvt_write_polygon(&w, ((LWMPOLY*)geom)->geoms[i]);
+			break;
+		default:
+			bytebuffer_destroy(w.buf);
+			lwerror("%s: unsupported geometry type: %s",
+			        __func__, lwtype_name(geom->type));
+			return NULL;
+	}
+
+	*size = bytebuffer_getlength(w.buf);
+	if ( ! *size )
+	{
+		*type = MVT_UNKNOWN;
+		bytebuffer_destroy(w.buf);
+		return NULL;
+	}
+
+	result = w.buf->buf_start;
+	lwfree(w.buf);
+	return result;
+}
@@ -65,11 +65,11 @@ static int lwgeom_wkb_needs_srid(const LWGEOM *geom, uint8_t variant)
 /*
 * GeometryType
 */
-static uint32_t lwgeom_wkb_type(const LWGEOM *geom, uint8_t variant)
+static uint32_t lwtype_wkb_type(uint8_t type, uint8_t flags, int needs_srid, uint8_t variant)
 {
 	uint32_t wkb_type = 0;
 
-	switch ( geom->type )
+	switch ( type )
 	{
 	case POINTTYPE:
 		wkb_type = WKB_POINT_TYPE;
@@ -118,32 +118,36 @@ static uint32_t lwgeom_wkb_type(const LWGEOM *geom, uint8_t variant)
 		break;
 	default:
 		lwerror("Unsupported geometry type: %s [%d]",
-			lwtype_name(geom->type), geom->type);
+			lwtype_name(type), type);
 	}
 
 	if ( variant & WKB_EXTENDED )
 	{
-		if ( FLAGS_GET_Z(geom->flags) )
+		if ( FLAGS_GET_Z(flags) )
 			wkb_type |= WKBZOFFSET;
-		if ( FLAGS_GET_M(geom->flags) )
+		if ( FLAGS_GET_M(flags) )
 			wkb_type |= WKBMOFFSET;
-/*		if ( geom->srid != SRID_UNKNOWN && ! (variant & WKB_NO_SRID) ) */
-		if ( lwgeom_wkb_needs_srid(geom, variant) )
+		if ( needs_srid )
 			wkb_type |= WKBSRIDFLAG;
 	}
 	else if ( variant & WKB_ISO )
 	{
 		/* Z types are in the 1000 range */
-		if ( FLAGS_GET_Z(geom->flags) )
+		if ( FLAGS_GET_Z(flags) )
 			wkb_type += 1000;
 		/* M types are in the 2000 range */
-		if ( FLAGS_GET_M(geom->flags) )
+		if ( FLAGS_GET_M(flags) )
 			wkb_type += 2000;
 		/* ZM types are in the 1000 + 2000 = 3000 range, see above */
 	}
 	return wkb_type;
 }
 
+static uint32_t lwgeom_wkb_type(const LWGEOM *geom, uint8_t variant)
+{
+	return lwtype_wkb_type(geom->type, geom->flags, lwgeom_wkb_needs_srid(geom, variant), variant);
+}
+
 /*
 * Endian
 */
@@ -274,20 +278,19 @@ static uint8_t* double_to_wkb_buf(const double d, uint8_t *buf, uint8_t variant)
 /*
 * Empty
 */
-static size_t empty_to_wkb_size(const LWGEOM *geom, uint8_t variant)
+static size_t lwtype_empty_to_wkb_size(uint8_t type, uint8_t flags, int needs_srid)
 {
 	/* endian byte + type integer */
 	size_t size = WKB_BYTE_SIZE + WKB_INT_SIZE;
 
 	/* optional srid integer */
-	if ( lwgeom_wkb_needs_srid(geom, variant) )
+	if ( needs_srid )
 		size += WKB_INT_SIZE;
 
 	/* Represent POINT EMPTY as POINT(NaN NaN) */
-	if ( geom->type == POINTTYPE )
+	if ( type == POINTTYPE )
 	{
-		const LWPOINT *pt = (LWPOINT*)geom;
-		size += WKB_DOUBLE_SIZE * FLAGS_NDIMS(pt->point->flags);		
+		size += WKB_DOUBLE_SIZE * FLAGS_NDIMS(flags);
 	}
 	/* num-elements */
 	else
@@ -298,9 +301,9 @@ static size_t empty_to_wkb_size(const LWGEOM *geom, uint8_t variant)
 	return size;
 }
 
-static uint8_t* empty_to_wkb_buf(const LWGEOM *geom, uint8_t *buf, uint8_t variant)
+static uint8_t* lwtype_empty_to_wkb_buf(uint8_t type, uint8_t flags, int32_t srid, int needs_srid, uint8_t *buf, uint8_t variant)
 {
-	uint32_t wkb_type = lwgeom_wkb_type(geom, variant);
+	uint32_t wkb_type = lwtype_wkb_type(type, flags, needs_srid, variant);
 
 	/* Set the endian flag */
 	buf = endian_to_wkb_buf(buf, variant);
@@ -309,16 +312,15 @@ static uint8_t* empty_to_wkb_buf(const LWGEOM *geom, uint8_t *buf, uint8_t varia
 	buf = integer_to_wkb_buf(wkb_type, buf, variant);
 
 	/* Set the SRID if necessary */
-	if ( lwgeom_wkb_needs_srid(geom, variant) )
-		buf = integer_to_wkb_buf(geom->srid, buf, variant);
+	if ( needs_srid )
+		buf = integer_to_wkb_buf(srid, buf, variant);
 
 	/* Represent POINT EMPTY as POINT(NaN NaN) */
-	if ( geom->type == POINTTYPE )
+	if ( type == POINTTYPE )
 	{
-		const LWPOINT *pt = (LWPOINT*)geom;
 		static double nn = NAN;
 		int i;
-		for ( i = 0; i < FLAGS_NDIMS(pt->point->flags); i++ )
+		for ( i = 0; i < FLAGS_NDIMS(flags); i++ )
 		{
 			buf = double_to_wkb_buf(nn, buf, variant);
 		}
@@ -333,6 +335,16 @@ static uint8_t* empty_to_wkb_buf(const LWGEOM *geom, uint8_t *buf, uint8_t varia
 	return buf;
 }
 
+static size_t empty_to_wkb_size(const LWGEOM *geom, uint8_t variant)
+{
+	return lwtype_empty_to_wkb_size(geom->type, geom->flags, lwgeom_wkb_needs_srid(geom, variant));
+}
+
+static uint8_t* empty_to_wkb_buf(const LWGEOM *geom, uint8_t *buf, uint8_t variant)
+{
+	return lwtype_empty_to_wkb_buf(geom->type, geom->flags, geom->srid, lwgeom_wkb_needs_srid(geom, variant), buf, variant);
+}
+
 /*
 * POINTARRAY
 */
@@ -354,36 +366,34 @@ static size_t ptarray_to_wkb_size(const POINTARRAY *pa, uint8_t variant)
 	return size;
 }
 
-static uint8_t* ptarray_to_wkb_buf(const POINTARRAY *pa, uint8_t *buf, uint8_t variant)
+/*
+* Coordinates, as laid out in a POINTARRAY or a GSERIALIZED
+*/
+static uint8_t* coords_to_wkb_buf(const uint8_t *coords, uint32_t npoints, int pa_dims, uint8_t *buf, uint8_t variant)
 {
 	int dims = 2;
-	int pa_dims = FLAGS_NDIMS(pa->flags);
 	int i, j;
-	double *dbl_ptr;
+	const double *dbl_ptr;
 
 	/* SFSQL is always 2-d. Extended and ISO use all available dimensions */
 	if ( (variant & WKB_ISO) || (variant & WKB_EXTENDED) )
 		dims = pa_dims;
 
-	/* Set the number of points (if it's not a POINT type) */
-	if ( ! ( variant & WKB_NO_NPOINTS ) )
-		buf = integer_to_wkb_buf(pa->npoints, buf, variant);
-
 	/* Bulk copy the coordinates when: dimensionality matches, output format */
 	/* is not hex, and output endian matches internal endian. */
-	if ( pa->npoints && (dims == pa_dims) && ! wkb_swap_bytes(variant) && ! (variant & WKB_HEX)  )
+	if ( npoints && (dims == pa_dims) && ! wkb_swap_bytes(variant) && ! (variant & WKB_HEX)  )
 	{
-		size_t size = pa->npoints * dims * WKB_DOUBLE_SIZE;
-		memcpy(buf, getPoint_internal(pa, 0), size);
+		size_t size = npoints * dims * WKB_DOUBLE_SIZE;
+		memcpy(buf, coords, size);
 		buf += size;
 	}
 	/* Copy coordinates one-by-one otherwise */
 	else 
 	{
-		for ( i = 0; i < pa->npoints; i++ )
+		for ( i = 0; i < npoints; i++ )
 		{
 			LWDEBUGF(4, "Writing point #%d", i);
-			dbl_ptr = (double*)getPoint_internal(pa, i);
+			dbl_ptr = (const double*)(coords + i * pa_dims * sizeof(double));
 			for ( j = 0; j < dims; j++ )
 			{
 				LWDEBUGF(4, "Writing dimension #%d (buf = %p)", j, buf);
@@ -395,6 +405,18 @@ static uint8_t* ptarray_to_wkb_buf(const POINTARRAY *pa, uint8_t *buf, uint8_t v
 	return buf;
 }
 
+static uint8_t* ptarray_to_wkb_buf(const POINTARRAY *pa, uint8_t *buf, uint8_t variant)
+{
+	/* Set the number of points (if it's not a POINT type) */
+	if ( ! ( variant & WKB_NO_NPOINTS ) )
+		buf = integer_to_wkb_buf(pa->npoints, buf, variant);
+
+	if ( pa->npoints )
+		buf = coords_to_wkb_buf(getPoint_internal(pa, 0), pa->npoints, FLAGS_NDIMS(pa->flags), buf, variant);
+
+	return buf;
+}
+
 /*
 * POINT
 */
@@ -836,3 +858,242 @@ char* lwgeom_to_hexwkb(const LWGEOM *geom, uint8_t variant, size_t *size_out)
 	return (char*)lwgeom_to_wkb(geom, variant | WKB_HEX, size_out);
 }
 
+
+/*
+* GSERIALIZED
+* Write the WKB straight from the serialized form, without building
+* an LWGEOM. Coordinates are copied in runs, the output is the same as
+* lwgeom_to_wkb() would give for the deserialized geometry.
+*/
+
+/* Number of coordinate bytes of a serialized geometry in WKB */
+#define GSER_WKB_COORDS_SIZE(npoints, ndims, variant) \
+	((npoints) * (((variant) & (WKB_ISO | WKB_EXTENDED)) ? (ndims) : 2) * WKB_DOUBLE_SIZE)
+
+/*
+* Size of a serialized geometry, and whether it is empty
+* in the sense of lwgeom_is_empty().
+*/
+static size_t gserialized_buffer_wkb_info(const uint8_t *p, int ndims, int *isempty)
+{
+	uint32_t type, num, npoints, i;
+	size_t size = 8; /* type + count */
+	int subempty;
+
+	memcpy(&type, p, sizeof(uint32_t));
+	memcpy(&num, p + 4, sizeof(uint32_t));
+
+	switch ( type )
+	{
+		case POINTTYPE:
+		case LINETYPE:
+		case CIRCSTRINGTYPE:
+		case TRIANGLETYPE:
+			*isempty = (num == 0);
+			return size + num * ndims * sizeof(double);
+
+		/* Ring counts, padded to keep the doubles aligned, then the rings */
+		case POLYGONTYPE:
+			*isempty = LW_TRUE;
+			size += num * sizeof(uint32_t) + (num % 2 ? sizeof(uint32_t) : 0);
+			for ( i = 0; i < num; i++ )
+			{
+				memcpy(&npoints, p + 8 + i * sizeof(uint32_t), sizeof(uint32_t));
+				if ( i == 0 && npoints )
+					*isempty = LW_FALSE;
+				size += npoints * ndims * sizeof(double);
+			}
+			return size;
+
+		default:
+			if ( ! lwtype_is_collection(type) )
+			{
+				lwerror("Unsupported geometry type: %s [%d]", lwtype_name(type), type);
+				return 0;
+			}
+			*isempty = LW_TRUE;
+			for ( i = 0; i < num; i++ )
+			{
+				size += gserialized_buffer_wkb_info(p + size, ndims, &subempty);
+				if ( ! subempty )
+					*isempty = LW_FALSE;
+			}
+			return size;
+	}
+}
+
+static size_t gserialized_buffer_to_wkb_size(const uint8_t *p, uint8_t flags, int32_t srid, uint8_t variant, size_t *g_size)
+{
+	int ndims = FLAGS_NDIMS(flags);
+	int needs_srid = (variant & WKB_EXTENDED) && ! (variant & WKB_NO_SRID) && srid != SRID_UNKNOWN;
+	uint32_t type, num, npoints, i;
+	const uint8_t *loc = p + 8;
+	size_t size, subsize;
+	int isempty;
+
+	memcpy(&type, p, sizeof(uint32_t));
+	memcpy(&num, p + 4, sizeof(uint32_t));
+	*g_size = gserialized_buffer_wkb_info(p, ndims, &isempty);
+
+	/* Collections only get the empty form outside the EXTENDED case */
+	if ( isempty && ( ! (variant & WKB_EXTENDED) || ! lwtype_is_collection(type) ) )
+		return lwtype_empty_to_wkb_size(type, flags, needs_srid);
+
+	/* Endian flag + type number + optional SRID */
+	size = WKB_BYTE_SIZE + WKB_INT_SIZE;
+	if ( needs_srid )
+		size += WKB_INT_SIZE;
+
+	switch ( type )
+	{
+		case POINTTYPE:
+			return size + GSER_WKB_COORDS_SIZE(1, ndims, variant);
+
+		case TRIANGLETYPE:
+			size += WKB_INT_SIZE; /* number of rings */
+			/* Fall through */
+		case LINETYPE:
+		case CIRCSTRINGTYPE:
+			return size + WKB_INT_SIZE + GSER_WKB_COORDS_SIZE(num, ndims, variant);
+
+		case POLYGONTYPE:
+			size += WKB_INT_SIZE;
+			for ( i = 0; i < num; i++ )
+			{
+				memcpy(&npoints, loc + i * sizeof(uint32_t), sizeof(uint32_t));
+				size += WKB_INT_SIZE + GSER_WKB_COORDS_SIZE(npoints, ndims, variant);
+			}
+			return size;
+
+		/* Sub-geometries inherit the SRID of their parent */
+		default:
+			size += WKB_INT_SIZE;
+			for ( i = 0; i < num; i++ )
+			{
+				size += gserialized_buffer_to_wkb_size(loc, flags, srid, variant | WKB_NO_SRID, &subsize);
+				loc += subsize;
+			}
+			return size;
+	}
+}
+
+static uint8_t* gserialized_buffer_to_wkb_buf(const uint8_t *p, uint8_t flags, int32_t srid, uint8_t *buf, uint8_t variant, size_t *g_size)
+{
+	int ndims = FLAGS_NDIMS(flags);
+	int needs_srid = (variant & WKB_EXTENDED) && ! (variant & WKB_NO_SRID) && srid != SRID_UNKNOWN;
+	uint32_t type, num, npoints, i;
+	const uint8_t *loc = p + 8;
+	const uint8_t *coords;
+	size_t subsize;
+	int isempty;
+
+	memcpy(&type, p, sizeof(uint32_t));
+	memcpy(&num, p + 4, sizeof(uint32_t));
+	*g_size = gserialized_buffer_wkb_info(p, ndims, &isempty);
+
+	/* Collections only get the empty form outside the EXTENDED case */
+	if ( isempty && ( ! (variant & WKB_EXTENDED) || ! lwtype_is_collection(type) ) )
+		return lwtype_empty_to_wkb_buf(type, flags, srid, needs_srid, buf, variant);
+
+	/* Set the endian flag, the geometry type and the optional SRID */
+	buf = endian_to_wkb_buf(buf, variant);
+	buf = integer_to_wkb_buf(lwtype_wkb_type(type, flags, needs_srid, variant), buf, variant);
+	if ( needs_srid )
+		buf = integer_to_wkb_buf(srid, buf, variant);
+
+	switch ( type )
+	{
+		case POINTTYPE:
+			return coords_to_wkb_buf(loc, 1, ndims, buf, variant);
+
+		/* Triangles are polygons of one ring in WKB */
+		case TRIANGLETYPE:
+			buf = integer_to_wkb_buf(1, buf, variant);
+			/* Fall through */
+		case LINETYPE:
+		case CIRCSTRINGTYPE:
+			buf = integer_to_wkb_buf(num, buf, variant);
+			return coords_to_wkb_buf(loc, num, ndims, buf, variant);
+
+		case POLYGONTYPE:
+			coords = loc + num * sizeof(uint32_t) + (num % 2 ? sizeof(uint32_t) : 0);
+			buf = integer_to_wkb_buf(num, buf, variant);
+			for ( i = 0; i < num; i++ )
+			{
+				memcpy(&npoints, loc + i * sizeof(uint32_t), sizeof(uint32_t));
+				buf = integer_to_wkb_buf(npoints, buf, variant);
+				buf = coords_to_wkb_buf(coords, npoints, ndims, buf, variant);
+				coords += npoints * ndims * sizeof(double);
+			}
+			return buf;
+
+		/* Sub-geometries inherit the SRID of their parent */
+		default:
+			buf = integer_to_wkb_buf(num, buf, variant);
+			for ( i = 0; i < num; i++ )
+			{
+				buf = gserialized_buffer_to_wkb_buf(loc, flags, srid, buf, variant | WKB_NO_SRID, &subsize);
+				loc += subsize;
+			}
+			return buf;
+	}
+}
+
+/**
+* Convert GSERIALIZED to a char* in WKB format, without deserializing it.
+* Variants and output are the same as for lwgeom_to_wkb().
+*/
+uint8_t* gserialized_to_wkb(const GSERIALIZED *g, uint8_t variant, size_t *size_out)
+{
+	const uint8_t *data = (const uint8_t*)g->data;
+	int32_t srid = gserialized_get_srid(g);
+	size_t buf_size, g_size;
+	uint8_t *buf, *wkb_out;
+
+	/* Initialize output size */
+	if ( size_out ) *size_out = 0;
+
+	/* Skip the box */
+	if ( FLAGS_GET_BBOX(g->flags) )
+		data += gbox_serialized_size(g->flags);
+
+	/* Calculate the required size of the output buffer */
+	buf_size = gserialized_buffer_to_wkb_size(data, g->flags, srid, variant, &g_size);
+	LWDEBUGF(4, "WKB output size: %d", buf_size);
+
+	/* Hex string takes twice as much space as binary + a null character */
+	if ( variant & WKB_HEX )
+		buf_size = 2 * buf_size + 1;
+
+	/* If neither or both variants are specified, choose the native order */
+	if ( ! (variant & WKB_NDR || variant & WKB_XDR) ||
+	       (variant & WKB_NDR && variant & WKB_XDR) )
+	{
+		if ( getMachineEndian() == NDR )
+			variant = variant | WKB_NDR;
+		else
+			variant = variant | WKB_XDR;
+	}
+
+	buf = wkb_out = lwalloc(buf_size);
+
+	/* Write the WKB into the output buffer */
+	buf = gserialized_buffer_to_wkb_buf(data, g->flags, srid, buf, variant, &g_size);
+
+	/* Null the last byte if this is a hex output */
+	if ( variant & WKB_HEX )
+		*buf++ = '\0';
+
+	/* The buffer pointer should now land at the end of the allocated buffer space. Let's check. */
+	if ( buf_size != (buf - wkb_out) )
+	{
+		lwerror("Output WKB is not the same size as the allocated buffer.");
+		lwfree(wkb_out);
+		return NULL;
+	}
+
+	/* Report output size */
+	if ( size_out ) *size_out = buf_size;
+
+	return wkb_out;
+}
@@ -71,6 +71,7 @@ static void ptarray_to_wkt_sb(const POINTARRAY *ptarray, stringbuffer_t *sb, int
 	/* OGC only includes X/Y */
 	int dimensions = 2;
 	int i, j;
+	size_t room = OUT_DOUBLE_BUFFER_SIZE + (precision > 0 ? precision : 0);
 
 	/* ISO and extended formats include all dimensions */
 	if ( variant & ( WKT_ISO | WKT_EXTENDED ) )
@@ -94,7 +95,9 @@ static void ptarray_to_wkt_sb(const POINTARRAY *ptarray, stringbuffer_t *sb, int
 			/* Spaces before every ordinate but the first */
 			if ( j > 0 )
 				stringbuffer_append(sb, " ");
-			stringbuffer_aprintf(sb, "%.*g", precision, dbl_ptr[j]);
+			/* Printed in place, as "%.*g" would */
+			stringbuffer_makeroom(sb, room);
+			sb->str_end += lwprint_double_g(dbl_ptr[j], precision, sb->str_end, room);
 		}
 	}
 
@@ -7,6 +7,8 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
+#include <float.h>
 #include "liblwgeom_internal.h"
 
 /* Ensures the given lat and lon are in the "normal" range:
@@ -401,3 +403,291 @@ char* lwpoint_to_latlon(const LWPOINT * pt, const char *format)
 	p = getPoint2d_cp(pt->point, 0);
 	return lwdoubles_to_latlon(p->y, p->x, format);
 }
+
+/*
+** Ordinate formatting for the text writers.
+**
+** lwprint_double_fixed() and lwprint_double_g() write exactly what
+** printf would, but round in integer arithmetic instead of going
+** through the locale aware printf machinery, which dominates the cost
+** of WKT, GeoJSON, GML, KML, SVG and X3D output. A double is m * 2^e
+** with m below 2^53, so value * 10^k is the exact fraction
+** (m * 10^k) / 2^-e, which fits 128 bits for every precision these
+** writers use. Rounding is half to even on the exact remainder, as
+** glibc does. Anything outside that range goes to snprintf.
+*/
+
+#ifdef __SIZEOF_INT128__
+
+typedef unsigned __int128 lwprint_uint128;
+
+/* 10^19 is the largest power of ten in 64 bits */
+#define LWPRINT_POW10_19 10000000000000000000ULL
+
+static const uint64_t lwprint_pow10_64[20] =
+{
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+	10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+	100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+	100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+	100000000000000000ULL, 1000000000000000000ULL, LWPRINT_POW10_19
+};
+
+static lwprint_uint128
+lwprint_pow10(int n)
+{
+	if ( n < 20 )
+		return lwprint_pow10_64[n];
+	return (lwprint_uint128) lwprint_pow10_64[n - 19] * LWPRINT_POW10_19;
+}
+
+/*
+* Round |d| * 10^k to the nearest integer into q. Returns LW_FAILURE
+* when the intermediate values would not fit 128 bits.
+*/
+static int
+lwprint_round(double d, int k, lwprint_uint128 *q)
+{
+	lwprint_uint128 num, den, r;
+	uint64_t m;
+	int e;
+
+	m = (uint64_t) ldexp(frexp(fabs(d), &e), 53);
+	e -= 53;
+
+	/* Too small to reach the last printed digit */
+	if ( e < -126 && k <= 20 )
+	{
+		*q = 0;
+		return LW_SUCCESS;
+	}
+
+	/* 10^k takes at most 10k/3 + 1 bits, m at most 53 */
+	if ( 53 + (k > 0 ? 10 * k / 3 + 1 : 0) + (e > 0 ? e : 0) > 127 ||
+	     (k < 0 ? -10 * k / 3 + 1 : 0) + (e < 0 ? -e : 0) > 126 )
+		return LW_FAILURE;
+
+	num = m;
+	if ( k >= 0 ) num *= lwprint_pow10(k);
+	if ( e >= 0 ) num <<= e;
+
+	if ( k >= 0 && e < 0 )
+	{
+		/* The usual case, dividing by a power of two */
+		den = (lwprint_uint128) 1 << -e;
+		*q = num >> -e;
+		r = num & (den - 1);
+	}
+	else
+	{
+		den = k >= 0 ? 1 : lwprint_pow10(-k);
+		if ( e < 0 ) den <<= -e;
+		*q = num / den;
+		r = num - *q * den;
+	}
+	if ( 2 * r > den || ( 2 * r == den && (*q & 1) ) )
+		(*q)++;
+
+	return LW_SUCCESS;
+}
+
+/* Decimal digits of n, at least mindigits of them, zero padded */
+static int
+lwprint_uint64(uint64_t n, int mindigits, char *buf)
+{
+	char tmp[20];
+	int len = 0, i;
+
+	do
+	{
+		tmp[len++] = '0' + (n % 10);
+		n /= 10;
+	}
+	while ( n );
+	while ( len < mindigits )
+		tmp[len++] = '0';
+
+	for ( i = 0; i < len; i++ )
+		buf[i] = tmp[len - 1 - i];
+	return len;
+}
+
+static int
+lwprint_uint128_digits(lwprint_uint128 n, int mindigits, char *buf)
+{
+	int len;
+
+	if ( n <= UINT64_MAX )
+		return lwprint_uint64((uint64_t) n, mindigits, buf);
+
+	/* Anything the callers round stays below 10^38 */
+	len = lwprint_uint128_digits(n / LWPRINT_POW10_19, mindigits - 19, buf);
+	return len + lwprint_uint64((uint64_t)(n % LWPRINT_POW10_19), 19, buf + len);
+}
+
+/* Drop the zeros ending the fraction, and the dot if nothing is left */
+static int
+lwprint_trim_fraction(char *buf, int len, int dot)
+{
+	while ( len > dot + 1 && buf[len - 1] == '0' )
+		len--;
+	if ( len == dot + 1 )
+		len = dot;
+	return len;
+}
+
+static int
+lwprint_fixed_fast(double d, int precision, char *buf)
+{
+	lwprint_uint128 q;
+	int len = 0, ndigits;
+
+	if ( lwprint_round(d, precision, &q) == LW_FAILURE )
+		return -1;
+
+	if ( signbit(d) )
+		buf[len++] = '-';
+
+	/* At least one digit before the dot */
+	ndigits = lwprint_uint128_digits(q, precision + 1, buf + len);
+	if ( precision > 0 )
+	{
+		int dot = len + ndigits - precision;
+		memmove(buf + dot + 1, buf + dot, precision);
+		buf[dot] = '.';
+		len = lwprint_trim_fraction(buf, len + ndigits + 1, dot);
+	}
+	else
+	{
+		len += ndigits;
+	}
+
+	buf[len] = '\0';
+	return len;
+}
+
+static int
+lwprint_g_fast(double d, int precision, char *buf)
+{
+	lwprint_uint128 q, lo, hi;
+	char digits[20];
+	int len = 0, exp, i, e;
+
+	if ( signbit(d) )
+		buf[len++] = '-';
+
+	if ( d == 0.0 )
+	{
+		buf[len++] = '0';
+		buf[len] = '\0';
+		return len;
+	}
+
+	/* Estimate the decimal exponent from the binary one, then fix it up */
+	frexp(d, &e);
+	exp = (int) floor((e - 1) * 0.30102999566398120);
+	lo = lwprint_pow10(precision - 1);
+	hi = lo * 10;
+	for (;;)
+	{
+		if ( lwprint_round(d, precision - 1 - exp, &q) == LW_FAILURE )
+			return -1;
+		if ( q == hi )
+		{
+			/* Rounded up to the next power of ten */
+			q = lo;
+			exp++;
+			break;
+		}
+		if ( q > hi ) exp++;
+		else if ( q < lo ) exp--;
+		else break;
+	}
+
+	lwprint_uint64((uint64_t) q, precision, digits);
+
+	if ( exp < -4 || exp >= precision )
+	{
+		/* d.ddde+XX */
+		buf[len++] = digits[0];
+		buf[len++] = '.';
+		memcpy(buf + len, digits + 1, precision - 1);
+		len = lwprint_trim_fraction(buf, len + precision - 1, len - 1);
+		buf[len++] = 'e';
+		buf[len++] = exp < 0 ? '-' : '+';
+		len += lwprint_uint64(exp < 0 ? -exp : exp, 2, buf + len);
+	}
+	else if ( exp >= 0 )
+	{
+		/* ddd.ddd */
+		memcpy(buf + len, digits, exp + 1);
+		len += exp + 1;
+		buf[len++] = '.';
+		memcpy(buf + len, digits + exp + 1, precision - exp - 1);
+		len = lwprint_trim_fraction(buf, len + precision - exp - 1, len - 1);
+	}
+	else
+	{
+		/* 0.000ddd */
+		buf[len++] = '0';
+		buf[len++] = '.';
+		for ( i = -1; i > exp; i-- )
+			buf[len++] = '0';
+		memcpy(buf + len, digits, precision);
+		len = lwprint_trim_fraction(buf, len + precision, len + exp);
+	}
+
+	buf[len] = '\0';
+	return len;
+}
+
+#endif /* __SIZEOF_INT128__ */
+
+/*
+* Writes d as sprintf("%.*f") followed by trim_trailing_zeros() would,
+* or as sprintf("%g") from OUT_MAX_DOUBLE up. Returns the length written.
+*/
+int
+lwprint_double_fixed(double d, int precision, char *buf, size_t bufsize)
+{
+	int len;
+
+#ifdef __SIZEOF_INT128__
+	if ( fabs(d) < OUT_MAX_DOUBLE && precision >= 0 &&
+	     precision <= OUT_MAX_DOUBLE_PRECISION && bufsize >= OUT_DOUBLE_BUFFER_SIZE )
+	{
+		len = lwprint_fixed_fast(d, precision, buf);
+		if ( len >= 0 ) return len;
+	}
+#endif
+
+	if ( fabs(d) < OUT_MAX_DOUBLE )
+		snprintf(buf, bufsize, "%.*f", precision, d);
+	else
+		snprintf(buf, bufsize, "%g", d);
+	trim_trailing_zeros(buf);
+	return strlen(buf);
+}
+
+/*
+* Writes d as sprintf("%.*g") would. Returns the length written.
+*/
+int
+lwprint_double_g(double d, int precision, char *buf, size_t bufsize)
+{
+	/* As printf, a precision of zero means one digit */
+	if ( precision == 0 )
+		precision = 1;
+
+#ifdef __SIZEOF_INT128__
+	if ( fabs(d) <= DBL_MAX && precision > 0 &&
+	     precision <= OUT_MAX_DOUBLE_G_PRECISION && bufsize >= OUT_DOUBLE_BUFFER_SIZE )
+	{
+		int len = lwprint_g_fast(d, precision, buf);
+		if ( len >= 0 ) return len;
+	}
+#endif
+
+	snprintf(buf, bufsize, "%.*g", precision, d);
+	return strlen(buf);
+}
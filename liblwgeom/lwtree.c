@@ -143,6 +143,67 @@ RECT_NODE* rect_node_internal_new(RECT_NODE *left_node, RECT_NODE *right_node)
 	return node;
 }
 
+/**
+* Create a new leaf node for a lone point, with both point
+* references set to the same vertex.
+*/
+static RECT_NODE* rect_node_point_new(const POINTARRAY *pa, int i)
+{
+	POINT2D *p;
+	RECT_NODE *node;
+
+	p = (POINT2D*)getPoint_internal(pa, i);
+
+	node = lwalloc(sizeof(RECT_NODE));
+	node->p1 = p;
+	node->p2 = p;
+	node->xmin = node->xmax = p->x;
+	node->ymin = node->ymax = p->y;
+	node->left_node = NULL;
+	node->right_node = NULL;
+	return node;
+}
+
+/**
+* Join a flat list of nodes into a tree, pairing up neighbours
+* one level at a time. Returns NULL for an empty list.
+*/
+static RECT_NODE* rect_tree_from_nodes(RECT_NODE **nodes, int num_children)
+{
+	int num_parents;
+	int j;
+
+	if ( num_children < 1 )
+		return NULL;
+
+	num_parents = num_children / 2;
+	while ( num_parents > 0 )
+	{
+		j = 0;
+		while ( j < num_parents )
+		{
+			/*
+			** Each new parent includes pointers to the children, so even though
+			** we are over-writing their place in the list, we still have references
+			** to them via the tree.
+			*/
+			nodes[j] = rect_node_internal_new(nodes[2*j], nodes[(2*j)+1]);
+			j++;
+		}
+		/* Odd number of children, just copy the last node up a level */
+		if ( num_children % 2 )
+		{
+			nodes[j] = nodes[num_children - 1];
+			num_parents++;
+		}
+		num_children = num_parents;
+		num_parents = num_children / 2;
+	}
+
+	/* Take a reference to the head of the tree*/
+	return nodes[0];
+}
+
 /**
 * Build a tree of nodes from a point array, one node per edge, and each
 * with an associated measure range along a one-dimensional space. We
@@ -150,7 +211,7 @@ RECT_NODE* rect_node_internal_new(RECT_NODE *left_node, RECT_NODE *right_node)
 */
 RECT_NODE* rect_tree_new(const POINTARRAY *pa)
 {
-	int num_edges, num_children, num_parents;
+	int num_edges;
 	int i, j;
 	RECT_NODE **nodes;
 	RECT_NODE *node;
@@ -186,39 +247,120 @@ RECT_NODE* rect_tree_new(const POINTARRAY *pa)
 	** build the tree knowing that point arrays tend to have a
 	** reasonable amount of sorting already.
 	*/
+	tree = rect_tree_from_nodes(nodes, j);
 
-	num_children = j;
-	num_parents = num_children / 2;
-	while ( num_parents > 0 )
+	/* Free the old list structure, leaving the tree in place */
+	lwfree(nodes);
+
+	return tree;
+
+}
+
+/*
+* Growing list of the leaves of a geometry, while we walk it
+*/
+typedef struct
+{
+	RECT_NODE **nodes;
+	int num_nodes;
+	int max_nodes;
+} RECT_NODE_LIST;
+
+static void rect_node_list_add(RECT_NODE_LIST *list, RECT_NODE *node)
+{
+	if ( list->num_nodes == list->max_nodes )
 	{
-		j = 0;
-		while ( j < num_parents )
+		list->max_nodes *= 2;
+		list->nodes = lwrealloc(list->nodes, sizeof(RECT_NODE*) * list->max_nodes);
+	}
+	list->nodes[list->num_nodes++] = node;
+}
+
+/**
+* Add a leaf for each edge of the point array, or a single
+* point leaf if the array has no edge of any length.
+*/
+static void rect_node_list_add_ptarray(RECT_NODE_LIST *list, const POINTARRAY *pa)
+{
+	RECT_NODE *node;
+	int num_nodes = list->num_nodes;
+	int i;
+
+	for ( i = 0; i < pa->npoints - 1; i++ )
+	{
+		node = rect_node_leaf_new(pa, i);
+		if ( node )
+			rect_node_list_add(list, node);
+	}
+
+	if ( pa->npoints > 0 && list->num_nodes == num_nodes )
+		rect_node_list_add(list, rect_node_point_new(pa, 0));
+}
+
+static int rect_node_list_add_lwgeom(RECT_NODE_LIST *list, const LWGEOM *geom)
+{
+	int i;
+
+	switch ( geom->type )
+	{
+		case POINTTYPE:
+			rect_node_list_add_ptarray(list, ((const LWPOINT*)geom)->point);
+			return LW_SUCCESS;
+		case LINETYPE:
+			rect_node_list_add_ptarray(list, ((const LWLINE*)geom)->points);
+			return LW_SUCCESS;
+		case POLYGONTYPE:
 		{
-			/*
-			** Each new parent includes pointers to the children, so even though
-			** we are over-writing their place in the list, we still have references
-			** to them via the tree.
-			*/
-			nodes[j] = rect_node_internal_new(nodes[2*j], nodes[(2*j)+1]);
-			j++;
+			const LWPOLY *poly = (const LWPOLY*)geom;
+			for ( i = 0; i < poly->nrings; i++ )
+				rect_node_list_add_ptarray(list, poly->rings[i]);
+			return LW_SUCCESS;
 		}
-		/* Odd number of children, just copy the last node up a level */
-		if ( num_children % 2 )
+		case MULTIPOINTTYPE:
+		case MULTILINETYPE:
+		case MULTIPOLYGONTYPE:
+		case COLLECTIONTYPE:
+		case POLYHEDRALSURFACETYPE:
 		{
-			nodes[j] = nodes[num_children - 1];
-			num_parents++;
+			const LWCOLLECTION *col = (const LWCOLLECTION*)geom;
+			for ( i = 0; i < col->ngeoms; i++ )
+			{
+				if ( ! rect_node_list_add_lwgeom(list, col->geoms[i]) )
+					return LW_FAILURE;
+			}
+			return LW_SUCCESS;
 		}
-		num_children = num_parents;
-		num_parents = num_children / 2;
+		default:
+			return LW_FAILURE;
 	}
+}
 
-	/* Take a reference to the head of the tree*/
-	tree = nodes[0];
+/**
+* Build a tree over all the edges (and lone points) of a geometry,
+* the parts of a collection sharing the one tree. Returns NULL for
+* an empty geometry, and for curved and other types we can't
+* measure with straight edges.
+*/
+RECT_NODE* rect_tree_from_lwgeom(const LWGEOM *geom)
+{
+	RECT_NODE_LIST list;
+	RECT_NODE *tree = NULL;
+	int i;
 
-	/* Free the old list structure, leaving the tree in place */
-	lwfree(nodes);
+	list.num_nodes = 0;
+	list.max_nodes = 64;
+	list.nodes = lwalloc(sizeof(RECT_NODE*) * list.max_nodes);
 
-	return tree;
+	if ( rect_node_list_add_lwgeom(&list, geom) )
+	{
+		tree = rect_tree_from_nodes(list.nodes, list.num_nodes);
+	}
+	else
+	{
+		for ( i = 0; i < list.num_nodes; i++ )
+			rect_tree_free(list.nodes[i]);
+	}
 
+	lwfree(list.nodes);
+	return tree;
 }
-
@@ -1,3 +1,6 @@
+#ifndef _LWTREE_H
+#define _LWTREE_H 1
+
 /**
 * Note that p1 and p2 are pointers into an independent POINTARRAY, do not free them.
 */
@@ -19,3 +22,6 @@ void rect_tree_free(RECT_NODE *node);
 RECT_NODE* rect_node_leaf_new(const POINTARRAY *pa, int i);
 RECT_NODE* rect_node_internal_new(RECT_NODE *left_node, RECT_NODE *right_node);
 RECT_NODE* rect_tree_new(const POINTARRAY *pa);
+RECT_NODE* rect_tree_from_lwgeom(const LWGEOM *geom);
+
+#endif /* _LWTREE_H */
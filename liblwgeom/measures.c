@@ -17,6 +17,11 @@
 #include "measures.h"
 #include "lwgeom_log.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DIST_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
 
 
 /*------------------------------------------------------------------------------------------------------------
@@ -63,6 +68,21 @@ lw_dist2d_distpts_init(DISTPTS *dl, int mode)
 		dl->distance = -1 * FLT_MAX;
 }
 
+/**
+Set up a minimum distance search that only has to tell whether there is
+a distance within the tolerance. The search starts just above the
+tolerance, so everything further away is passed over as if a closer
+distance had been found already, and it stops at the first distance
+within the tolerance.
+*/
+void
+lw_dist2d_distpts_init_within(DISTPTS *dl, double tolerance)
+{
+	lw_dist2d_distpts_init(dl, DIST_MIN);
+	dl->tolerance = tolerance;
+	dl->distance = nextafter(tolerance, DBL_MAX);
+}
+
 /**
 Function initializing shortestline and longestline calculations.
 */
@@ -212,6 +232,59 @@ lwgeom_mindistance2d_tolerance(const LWGEOM *lw1, const LWGEOM *lw2, double tole
 	return FLT_MAX;
 }
 
+/**
+	The boxes are further apart than the tolerance. The gaps between
+	the boxes are compared with the tolerance rather than expanding a
+	box, whose sides may round below the other one, and with some slack
+	for the rounding of the measured distances, so that a pair exactly
+	at the tolerance is always measured.
+*/
+static int
+lw_dist2d_box_beyond(const GBOX *box1, const GBOX *box2, double tolerance)
+{
+	double scale = FP_MAX(FP_MAX(fabs(box1->xmin), fabs(box1->xmax)), FP_MAX(fabs(box1->ymin), fabs(box1->ymax)));
+	double limit;
+
+	scale = FP_MAX(scale, FP_MAX(FP_MAX(fabs(box2->xmin), fabs(box2->xmax)), FP_MAX(fabs(box2->ymin), fabs(box2->ymax))));
+	limit = tolerance + FP_TOLERANCE * (1.0 + scale);
+
+	return box2->xmin - box1->xmax > limit || box1->xmin - box2->xmax > limit ||
+	       box2->ymin - box1->ymax > limit || box1->ymin - box2->ymax > limit;
+}
+
+/**
+	Function handling dwithin calculations. Rather than measuring the
+	minimum distance and comparing it with the tolerance, the search
+	stops at the first pair of segments within the tolerance and skips
+	the parts whose boxes are too far apart to hold one. Empty parts
+	are passed over.
+*/
+int
+lwgeom_dwithin2d(const LWGEOM *lw1, const LWGEOM *lw2, double tolerance)
+{
+	DISTPTS thedl;
+	LWDEBUG(2, "lwgeom_dwithin2d is called");
+
+	/* Too far apart, whatever the parts */
+	if ( lw1->bbox && lw2->bbox && lw_dist2d_box_beyond(lw1->bbox, lw2->bbox, tolerance) )
+		return LW_FALSE;
+
+	lw_dist2d_distpts_init_within(&thedl, tolerance);
+
+	/* Big geometries are searched through their edge trees */
+	if ( lw_dist2d_tree_worthwhile(lw1, lw2) &&
+	     lw_dist2d_tree(lw1, NULL, lw2, NULL, &thedl) == LW_SUCCESS )
+		return thedl.distance <= tolerance;
+
+	if ( ! lw_dist2d_within(lw1, lw2, &thedl) )
+	{
+		/*should never get here. all cases ought to be error handled earlier*/
+		lwerror("Some unspecified error.");
+		return LW_FALSE;
+	}
+	return thedl.distance <= tolerance;
+}
+
 
 /*------------------------------------------------------------------------------------------------------------
 End of Initializing functions
@@ -232,6 +305,13 @@ lw_dist2d_comp(const LWGEOM *lw1,const LWGEOM *lw2, DISTPTS *dl)
 {
 	LWDEBUG(2, "lw_dist2d_comp is called");
 
+	/* Big geometries are searched through their edge trees */
+	if ( dl->mode == DIST_MIN && lw_dist2d_tree_worthwhile(lw1, lw2) )
+	{
+		if ( lw_dist2d_tree(lw1, NULL, lw2, NULL, dl) == LW_SUCCESS )
+			return LW_TRUE;
+	}
+
 	return lw_dist2d_recursive(lw1, lw2, dl);
 }
 
@@ -297,7 +377,8 @@ int lw_dist2d_recursive(const LWGEOM *lwg1, const LWGEOM *lwg2, DISTPTS *dl)
 			g1 = (LWGEOM*)lwg1;
 		}
 
-		if (lwgeom_is_empty(g1)) return LW_TRUE;
+		/* Empty parts have no distance to give, the other parts still do */
+		if (lwgeom_is_empty(g1)) continue;
 
 		if (lw_dist2d_is_collection(g1))
 		{
@@ -331,8 +412,8 @@ int lw_dist2d_recursive(const LWGEOM *lwg1, const LWGEOM *lwg2, DISTPTS *dl)
 				lwgeom_add_bbox(g2);
 			}
 
-			/*If one of geometries is empty, return. True here only means continue searching. False would have stoped the process*/
-			if (lwgeom_is_empty(g1)||lwgeom_is_empty(g2)) return LW_TRUE;
+			/* Skip empty parts, as lw_dist2d_within does */
+			if (lwgeom_is_empty(g1)||lwgeom_is_empty(g2)) continue;
 
 			if ( (dl->mode != DIST_MAX) && 
 				 (! lw_dist2d_check_overlap(g1, g2)) && 
@@ -541,6 +622,68 @@ lw_dist2d_distribute_fast(LWGEOM *lwg1, LWGEOM *lwg2, DISTPTS *dl)
 	return lw_dist2d_fast_ptarray_ptarray(pa1, pa2, dl, lwg1->bbox, lwg2->bbox);
 }
 
+/**
+Look through the pairs of parts for one within dl->tolerance, with dl
+set up by lw_dist2d_distpts_init_within. Empty parts are passed over,
+as in lw_dist2d_recursive. Unlike there, pairs of parts whose boxes are
+further apart than the tolerance are skipped, and the search stops as
+soon as any pair is found within the tolerance.
+*/
+int
+lw_dist2d_within(const LWGEOM *lwg1, const LWGEOM *lwg2, DISTPTS *dl)
+{
+	LWGEOM *g1 = (LWGEOM*)lwg1;
+	LWGEOM *g2 = (LWGEOM*)lwg2;
+	LWCOLLECTION *col;
+	int i;
+
+	LWDEBUGF(2, "lw_dist2d_within is called with type1=%d, type2=%d", lwg1->type, lwg2->type);
+
+	if ( lw_dist2d_is_collection(g1) )
+	{
+		col = lwgeom_as_lwcollection(g1);
+		for ( i = 0; i < col->ngeoms; i++ )
+		{
+			if ( ! lw_dist2d_within(col->geoms[i], g2, dl) ) return LW_FALSE;
+			if ( dl->distance <= dl->tolerance ) return LW_TRUE;
+		}
+		return LW_TRUE;
+	}
+
+	if ( lw_dist2d_is_collection(g2) )
+	{
+		col = lwgeom_as_lwcollection(g2);
+		for ( i = 0; i < col->ngeoms; i++ )
+		{
+			if ( ! lw_dist2d_within(g1, col->geoms[i], dl) ) return LW_FALSE;
+			if ( dl->distance <= dl->tolerance ) return LW_TRUE;
+		}
+		return LW_TRUE;
+	}
+
+	if ( lwgeom_is_empty(g1) || lwgeom_is_empty(g2) )
+		return LW_TRUE;
+
+	if ( ! g1->bbox )
+		lwgeom_add_bbox(g1);
+	if ( ! g2->bbox )
+		lwgeom_add_bbox(g2);
+
+	if ( lw_dist2d_box_beyond(g1->bbox, g2->bbox, dl->tolerance) )
+	{
+		LWDEBUG(3, "bboxes further apart than the tolerance");
+		return LW_TRUE;
+	}
+
+	if ( (! lw_dist2d_check_overlap(g1, g2)) &&
+	     (g1->type == LINETYPE || g1->type == POLYGONTYPE) &&
+	     (g2->type == LINETYPE || g2->type == POLYGONTYPE) )
+	{
+		return lw_dist2d_distribute_fast(g1, g2, dl);
+	}
+	return lw_dist2d_distribute_bruteforce(g1, g2, dl);
+}
+
 /*------------------------------------------------------------------------------------------------------------
 End of Preprocessing functions
 --------------------------------------------------------------------------------------------------------------*/
@@ -1027,6 +1170,386 @@ lw_dist2d_curvepoly_curvepoly(LWCURVEPOLY *poly1, LWCURVEPOLY *poly2, DISTPTS *d
 
 
 
+/*
+ * Segment run kernels.
+ *
+ * The brute force loops below measure a point or a segment against each
+ * segment of a point array in turn. The kernels run ahead of them, over
+ * four (AVX) or two (SSE2) segments at once, and return the next segment
+ * that can bring the distance under the best one found so far, so that
+ * lw_dist2d_pt_seg() and lw_dist2d_seg_seg() only run where they change
+ * something. The kernels repeat the operations of lw_dist2d_pt_seg() in
+ * the same order and compare squared distances with some slack for the
+ * rounding of sqrt(), so they never skip a segment the scalar code would
+ * have taken and the answers don't depend on the CPU. Segments with NaN
+ * in them are always handed over. The scalar kernels take every segment,
+ * which is the plain loop.
+ */
+typedef int (*lw_dist2d_pt_segs_kernel)(const POINT2D *p, const POINTARRAY *pa, int from, double best);
+typedef int (*lw_dist2d_seg_segs_kernel)(const POINT2D *A, const POINT2D *B, const POINTARRAY *pa, int from, double best);
+
+/* Relative slack on squared distance comparisons */
+#define DIST_KERNEL_SLACK (1.0 + 1e-12)
+
+/*
+* Before measuring, the kernels drop the runs whose segment boxes are
+* all out of reach. The reach has a margin, relative to the size of
+* the coordinates, well over the rounding error of the scalar code.
+*/
+#define DIST_KERNEL_MARGIN 1e-9
+
+static double
+lw_dist2d_kernel_reach(const POINT2D *A, const POINT2D *B, double best)
+{
+	double size = FP_MAX(FP_MAX(fabs(A->x), fabs(A->y)), FP_MAX(fabs(B->x), fabs(B->y)));
+	double reach = best + DIST_KERNEL_MARGIN * (size + best);
+	return reach * reach;
+}
+
+static int
+lw_dist2d_pt_segs_scalar(const POINT2D *p, const POINTARRAY *pa, int from, double best)
+{
+	return from;
+}
+
+static int
+lw_dist2d_seg_segs_scalar(const POINT2D *A, const POINT2D *B, const POINTARRAY *pa, int from, double best)
+{
+	return from;
+}
+
+#ifdef DIST_X86_KERNELS
+
+/**
+* Squared distance from the points p to the segments AB, as measured by
+* lw_dist2d_pt_seg(), zero when p lies exactly on the segment. SSE2, two
+* lanes.
+*/
+__attribute__((target("sse2")))
+static inline __m128d
+lw_dist2d_pt_seg_sse2(__m128d px, __m128d py, __m128d ax, __m128d ay, __m128d bx, __m128d by)
+{
+	const __m128d zero = _mm_setzero_pd();
+	const __m128d one = _mm_set1_pd(1.0);
+	__m128d dx = _mm_sub_pd(bx, ax);
+	__m128d dy = _mm_sub_pd(by, ay);
+	__m128d r = _mm_div_pd(_mm_add_pd(_mm_mul_pd(_mm_sub_pd(px, ax), dx), _mm_mul_pd(_mm_sub_pd(py, ay), dy)),
+	                       _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)));
+	__m128d same = _mm_and_pd(_mm_cmpeq_pd(ax, bx), _mm_cmpeq_pd(ay, by));
+	__m128d at_a = _mm_or_pd(_mm_cmplt_pd(r, zero), same);
+	__m128d at_b = _mm_andnot_pd(at_a, _mm_cmpge_pd(r, one));
+	__m128d between = _mm_andnot_pd(_mm_or_pd(at_a, at_b), _mm_castsi128_pd(_mm_set1_epi32(-1)));
+	__m128d on, tx, ty, hx, hy;
+
+	/* Closest point of the segment: an end or the projection */
+	tx = _mm_or_pd(_mm_or_pd(_mm_and_pd(at_a, ax), _mm_and_pd(at_b, bx)),
+	               _mm_and_pd(between, _mm_add_pd(ax, _mm_mul_pd(r, dx))));
+	ty = _mm_or_pd(_mm_or_pd(_mm_and_pd(at_a, ay), _mm_and_pd(at_b, by)),
+	               _mm_and_pd(between, _mm_add_pd(ay, _mm_mul_pd(r, dy))));
+
+	on = _mm_cmpeq_pd(_mm_mul_pd(_mm_sub_pd(ay, py), dx), _mm_mul_pd(_mm_sub_pd(ax, px), dy));
+	on = _mm_and_pd(on, between);
+
+	hx = _mm_sub_pd(tx, px);
+	hy = _mm_sub_pd(ty, py);
+	return _mm_andnot_pd(on, _mm_add_pd(_mm_mul_pd(hx, hx), _mm_mul_pd(hy, hy)));
+}
+
+/**
+* Lanes where the boxes of the segments AB and CD are closer than the
+* reach (squared), SSE2.
+*/
+__attribute__((target("sse2")))
+static inline __m128d
+lw_dist2d_box_near_sse2(__m128d ax, __m128d ay, __m128d bx, __m128d by, __m128d cx, __m128d cy, __m128d dx, __m128d dy, __m128d reach)
+{
+	const __m128d zero = _mm_setzero_pd();
+	__m128d gx = _mm_max_pd(_mm_max_pd(_mm_sub_pd(_mm_min_pd(cx, dx), _mm_max_pd(ax, bx)),
+	                                   _mm_sub_pd(_mm_min_pd(ax, bx), _mm_max_pd(cx, dx))), zero);
+	__m128d gy = _mm_max_pd(_mm_max_pd(_mm_sub_pd(_mm_min_pd(cy, dy), _mm_max_pd(ay, by)),
+	                                   _mm_sub_pd(_mm_min_pd(ay, by), _mm_max_pd(cy, dy))), zero);
+	return _mm_cmpnge_pd(_mm_add_pd(_mm_mul_pd(gx, gx), _mm_mul_pd(gy, gy)), reach);
+}
+
+/**
+* Point against a run of segments, SSE2 kernel.
+*/
+__attribute__((target("sse2")))
+static int
+lw_dist2d_pt_segs_sse2(const POINT2D *p, const POINTARRAY *pa, int from, double best)
+{
+	const double *pts = (const double*)pa->serialized_pointlist;
+	const int n = FLAGS_NDIMS(pa->flags);
+	const __m128d px = _mm_set1_pd(p->x);
+	const __m128d py = _mm_set1_pd(p->y);
+	const __m128d bound = _mm_set1_pd(best * best * DIST_KERNEL_SLACK);
+	const __m128d reach = _mm_set1_pd(lw_dist2d_kernel_reach(p, p, best));
+	int u;
+
+	for ( u = from; u + 2 <= pa->npoints; u += 2 )
+	{
+		const double *a = pts + (u - 1) * n;
+		__m128d ax = _mm_set_pd(a[n], a[0]);
+		__m128d ay = _mm_set_pd(a[n+1], a[1]);
+		__m128d bx = _mm_set_pd(a[2*n], a[n]);
+		__m128d by = _mm_set_pd(a[2*n+1], a[n+1]);
+		int mask;
+
+		if ( ! _mm_movemask_pd(lw_dist2d_box_near_sse2(px, py, px, py, ax, ay, bx, by, reach)) )
+			continue;
+
+		mask = _mm_movemask_pd(_mm_cmpnge_pd(lw_dist2d_pt_seg_sse2(px, py, ax, ay, bx, by), bound));
+		if ( mask )
+			return u + __builtin_ctz(mask);
+	}
+	return u;
+}
+
+/**
+* Segment against a run of segments, SSE2 kernel. Takes the segments
+* that intersect AB, or have an end closer than best to the other
+* segment.
+*/
+__attribute__((target("sse2")))
+static int
+lw_dist2d_seg_segs_sse2(const POINT2D *A, const POINT2D *B, const POINTARRAY *pa, int from, double best)
+{
+	const double *pts = (const double*)pa->serialized_pointlist;
+	const int n = FLAGS_NDIMS(pa->flags);
+	const __m128d zero = _mm_setzero_pd();
+	const __m128d one = _mm_set1_pd(1.0);
+	const __m128d ax = _mm_set1_pd(A->x);
+	const __m128d ay = _mm_set1_pd(A->y);
+	const __m128d bx = _mm_set1_pd(B->x);
+	const __m128d by = _mm_set1_pd(B->y);
+	const __m128d bound = _mm_set1_pd(best * best * DIST_KERNEL_SLACK);
+	const __m128d reach = _mm_set1_pd(lw_dist2d_kernel_reach(A, B, best));
+	int u;
+
+	for ( u = from; u + 2 <= pa->npoints; u += 2 )
+	{
+		const double *c = pts + (u - 1) * n;
+		__m128d cx = _mm_set_pd(c[n], c[0]);
+		__m128d cy = _mm_set_pd(c[n+1], c[1]);
+		__m128d dx = _mm_set_pd(c[2*n], c[n]);
+		__m128d dy = _mm_set_pd(c[2*n+1], c[n+1]);
+		__m128d r_top, r_bot, s_top, r, s, hit;
+
+		if ( ! _mm_movemask_pd(lw_dist2d_box_near_sse2(ax, ay, bx, by, cx, cy, dx, dy, reach)) )
+			continue;
+
+		/* Crossing, as lw_dist2d_seg_seg() decides it */
+		r_top = _mm_sub_pd(_mm_mul_pd(_mm_sub_pd(ay, cy), _mm_sub_pd(dx, cx)), _mm_mul_pd(_mm_sub_pd(ax, cx), _mm_sub_pd(dy, cy)));
+		r_bot = _mm_sub_pd(_mm_mul_pd(_mm_sub_pd(bx, ax), _mm_sub_pd(dy, cy)), _mm_mul_pd(_mm_sub_pd(by, ay), _mm_sub_pd(dx, cx)));
+		s_top = _mm_sub_pd(_mm_mul_pd(_mm_sub_pd(ay, cy), _mm_sub_pd(bx, ax)), _mm_mul_pd(_mm_sub_pd(ax, cx), _mm_sub_pd(by, ay)));
+		r = _mm_div_pd(r_top, r_bot);
+		s = _mm_div_pd(s_top, r_bot);
+		hit = _mm_and_pd(_mm_cmpneq_pd(r_bot, zero), _mm_and_pd(_mm_cmpnlt_pd(r, zero), _mm_cmpngt_pd(r, one)));
+		hit = _mm_and_pd(hit, _mm_and_pd(_mm_cmpnlt_pd(s, zero), _mm_cmpngt_pd(s, one)));
+
+		/* Otherwise the closest end */
+		hit = _mm_or_pd(hit, _mm_cmpnge_pd(lw_dist2d_pt_seg_sse2(ax, ay, cx, cy, dx, dy), bound));
+		hit = _mm_or_pd(hit, _mm_cmpnge_pd(lw_dist2d_pt_seg_sse2(bx, by, cx, cy, dx, dy), bound));
+		hit = _mm_or_pd(hit, _mm_cmpnge_pd(lw_dist2d_pt_seg_sse2(cx, cy, ax, ay, bx, by), bound));
+		hit = _mm_or_pd(hit, _mm_cmpnge_pd(lw_dist2d_pt_seg_sse2(dx, dy, ax, ay, bx, by), bound));
+
+		if ( _mm_movemask_pd(hit) )
+			return u + __builtin_ctz(_mm_movemask_pd(hit));
+	}
+	return u;
+}
+
+/**
+* Squared distance from the points p to the segments AB, as measured by
+* lw_dist2d_pt_seg(), zero when p lies exactly on the segment. AVX, four
+* lanes.
+*/
+__attribute__((target("avx")))
+static inline __m256d
+lw_dist2d_pt_seg_avx(__m256d px, __m256d py, __m256d ax, __m256d ay, __m256d bx, __m256d by)
+{
+	const __m256d zero = _mm256_setzero_pd();
+	const __m256d one = _mm256_set1_pd(1.0);
+	__m256d dx = _mm256_sub_pd(bx, ax);
+	__m256d dy = _mm256_sub_pd(by, ay);
+	__m256d r = _mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(px, ax), dx), _mm256_mul_pd(_mm256_sub_pd(py, ay), dy)),
+	                          _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)));
+	__m256d same = _mm256_and_pd(_mm256_cmp_pd(ax, bx, _CMP_EQ_OQ), _mm256_cmp_pd(ay, by, _CMP_EQ_OQ));
+	__m256d at_a = _mm256_or_pd(_mm256_cmp_pd(r, zero, _CMP_LT_OQ), same);
+	__m256d at_b = _mm256_andnot_pd(at_a, _mm256_cmp_pd(r, one, _CMP_GE_OQ));
+	__m256d on, tx, ty, hx, hy;
+
+	/* Closest point of the segment: an end or the projection */
+	tx = _mm256_add_pd(ax, _mm256_mul_pd(r, dx));
+	ty = _mm256_add_pd(ay, _mm256_mul_pd(r, dy));
+	tx = _mm256_blendv_pd(_mm256_blendv_pd(tx, bx, at_b), ax, at_a);
+	ty = _mm256_blendv_pd(_mm256_blendv_pd(ty, by, at_b), ay, at_a);
+
+	on = _mm256_cmp_pd(_mm256_mul_pd(_mm256_sub_pd(ay, py), dx), _mm256_mul_pd(_mm256_sub_pd(ax, px), dy), _CMP_EQ_OQ);
+	on = _mm256_andnot_pd(_mm256_or_pd(at_a, at_b), on);
+
+	hx = _mm256_sub_pd(tx, px);
+	hy = _mm256_sub_pd(ty, py);
+	return _mm256_andnot_pd(on, _mm256_add_pd(_mm256_mul_pd(hx, hx), _mm256_mul_pd(hy, hy)));
+}
+
+/**
+* Lanes where the boxes of the segments AB and CD are closer than the
+* reach (squared), AVX.
+*/
+__attribute__((target("avx")))
+static inline __m256d
+lw_dist2d_box_near_avx(__m256d ax, __m256d ay, __m256d bx, __m256d by, __m256d cx, __m256d cy, __m256d dx, __m256d dy, __m256d reach)
+{
+	const __m256d zero = _mm256_setzero_pd();
+	__m256d gx = _mm256_max_pd(_mm256_max_pd(_mm256_sub_pd(_mm256_min_pd(cx, dx), _mm256_max_pd(ax, bx)),
+	                                         _mm256_sub_pd(_mm256_min_pd(ax, bx), _mm256_max_pd(cx, dx))), zero);
+	__m256d gy = _mm256_max_pd(_mm256_max_pd(_mm256_sub_pd(_mm256_min_pd(cy, dy), _mm256_max_pd(ay, by)),
+	                                         _mm256_sub_pd(_mm256_min_pd(ay, by), _mm256_max_pd(cy, dy))), zero);
+	return _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(gx, gx), _mm256_mul_pd(gy, gy)), reach, _CMP_NGE_UQ);
+}
+
+/**
+* Point against a run of segments, AVX kernel.
+*/
+__attribute__((target("avx")))
+static int
+lw_dist2d_pt_segs_avx(const POINT2D *p, const POINTARRAY *pa, int from, double best)
+{
+	const double reach2 = lw_dist2d_kernel_reach(p, p, best);
+	const double *pts = (const double*)pa->serialized_pointlist;
+	const int n = FLAGS_NDIMS(pa->flags);
+	const __m256d px = _mm256_set1_pd(p->x);
+	const __m256d py = _mm256_set1_pd(p->y);
+	const __m256d bound = _mm256_set1_pd(best * best * DIST_KERNEL_SLACK);
+	const __m256d reach = _mm256_set1_pd(reach2);
+	int u, mask = 0;
+
+	for ( u = from; u + 4 <= pa->npoints; u += 4 )
+	{
+		const double *a = pts + (u - 1) * n;
+		__m256d ax = _mm256_set_pd(a[3*n], a[2*n], a[n], a[0]);
+		__m256d ay = _mm256_set_pd(a[3*n+1], a[2*n+1], a[n+1], a[1]);
+		__m256d bx = _mm256_set_pd(a[4*n], a[3*n], a[2*n], a[n]);
+		__m256d by = _mm256_set_pd(a[4*n+1], a[3*n+1], a[2*n+1], a[n+1]);
+
+		if ( ! _mm256_movemask_pd(lw_dist2d_box_near_avx(px, py, px, py, ax, ay, bx, by, reach)) )
+			continue;
+
+		mask = _mm256_movemask_pd(_mm256_cmp_pd(lw_dist2d_pt_seg_avx(px, py, ax, ay, bx, by), bound, _CMP_NGE_UQ));
+		if ( mask )
+			break;
+	}
+
+	/* Leave no dirty upper halves behind for the SSE code of the caller,
+	 * which is also why the reach is worked out before anything else */
+	_mm256_zeroupper();
+	return mask ? u + __builtin_ctz(mask) : u;
+}
+
+/**
+* Segment against a run of segments, AVX kernel. Takes the segments
+* that intersect AB, or have an end closer than best to the other
+* segment.
+*/
+__attribute__((target("avx")))
+static int
+lw_dist2d_seg_segs_avx(const POINT2D *A, const POINT2D *B, const POINTARRAY *pa, int from, double best)
+{
+	const double reach2 = lw_dist2d_kernel_reach(A, B, best);
+	const double *pts = (const double*)pa->serialized_pointlist;
+	const int n = FLAGS_NDIMS(pa->flags);
+	const __m256d zero = _mm256_setzero_pd();
+	const __m256d one = _mm256_set1_pd(1.0);
+	const __m256d ax = _mm256_set1_pd(A->x);
+	const __m256d ay = _mm256_set1_pd(A->y);
+	const __m256d bx = _mm256_set1_pd(B->x);
+	const __m256d by = _mm256_set1_pd(B->y);
+	const __m256d bound = _mm256_set1_pd(best * best * DIST_KERNEL_SLACK);
+	const __m256d reach = _mm256_set1_pd(reach2);
+	int u, mask = 0;
+
+	for ( u = from; u + 4 <= pa->npoints; u += 4 )
+	{
+		const double *c = pts + (u - 1) * n;
+		__m256d cx = _mm256_set_pd(c[3*n], c[2*n], c[n], c[0]);
+		__m256d cy = _mm256_set_pd(c[3*n+1], c[2*n+1], c[n+1], c[1]);
+		__m256d dx = _mm256_set_pd(c[4*n], c[3*n], c[2*n], c[n]);
+		__m256d dy = _mm256_set_pd(c[4*n+1], c[3*n+1], c[2*n+1], c[n+1]);
+		__m256d r_top, r_bot, s_top, r, s, hit;
+
+		if ( ! _mm256_movemask_pd(lw_dist2d_box_near_avx(ax, ay, bx, by, cx, cy, dx, dy, reach)) )
+			continue;
+
+		/* Crossing, as lw_dist2d_seg_seg() decides it */
+		r_top = _mm256_sub_pd(_mm256_mul_pd(_mm256_sub_pd(ay, cy), _mm256_sub_pd(dx, cx)), _mm256_mul_pd(_mm256_sub_pd(ax, cx), _mm256_sub_pd(dy, cy)));
+		r_bot = _mm256_sub_pd(_mm256_mul_pd(_mm256_sub_pd(bx, ax), _mm256_sub_pd(dy, cy)), _mm256_mul_pd(_mm256_sub_pd(by, ay), _mm256_sub_pd(dx, cx)));
+		s_top = _mm256_sub_pd(_mm256_mul_pd(_mm256_sub_pd(ay, cy), _mm256_sub_pd(bx, ax)), _mm256_mul_pd(_mm256_sub_pd(ax, cx), _mm256_sub_pd(by, ay)));
+		r = _mm256_div_pd(r_top, r_bot);
+		s = _mm256_div_pd(s_top, r_bot);
+		hit = _mm256_and_pd(_mm256_cmp_pd(r_bot, zero, _CMP_NEQ_UQ),
+		                    _mm256_and_pd(_mm256_cmp_pd(r, zero, _CMP_NLT_UQ), _mm256_cmp_pd(r, one, _CMP_NGT_UQ)));
+		hit = _mm256_and_pd(hit, _mm256_and_pd(_mm256_cmp_pd(s, zero, _CMP_NLT_UQ), _mm256_cmp_pd(s, one, _CMP_NGT_UQ)));
+
+		/* Otherwise the closest end */
+		hit = _mm256_or_pd(hit, _mm256_cmp_pd(lw_dist2d_pt_seg_avx(ax, ay, cx, cy, dx, dy), bound, _CMP_NGE_UQ));
+		hit = _mm256_or_pd(hit, _mm256_cmp_pd(lw_dist2d_pt_seg_avx(bx, by, cx, cy, dx, dy), bound, _CMP_NGE_UQ));
+		hit = _mm256_or_pd(hit, _mm256_cmp_pd(lw_dist2d_pt_seg_avx(cx, cy, ax, ay, bx, by), bound, _CMP_NGE_UQ));
+		hit = _mm256_or_pd(hit, _mm256_cmp_pd(lw_dist2d_pt_seg_avx(dx, dy, ax, ay, bx, by), bound, _CMP_NGE_UQ));
+
+		mask = _mm256_movemask_pd(hit);
+		if ( mask )
+			break;
+	}
+
+	/* Leave no dirty upper halves behind for the SSE code of the caller */
+	_mm256_zeroupper();
+	return mask ? u + __builtin_ctz(mask) : u;
+}
+
+#endif /* DIST_X86_KERNELS */
+
+static lw_dist2d_pt_segs_kernel lw_dist2d_pt_segs = NULL;
+static lw_dist2d_seg_segs_kernel lw_dist2d_seg_segs = NULL;
+
+int
+lw_dist2d_set_kernels(int kernels)
+{
+	switch ( kernels )
+	{
+	case DIST_KERNELS_AUTO:
+		if ( lw_dist2d_set_kernels(DIST_KERNELS_AVX) == LW_SUCCESS )
+			return LW_SUCCESS;
+		if ( lw_dist2d_set_kernels(DIST_KERNELS_SSE2) == LW_SUCCESS )
+			return LW_SUCCESS;
+		return lw_dist2d_set_kernels(DIST_KERNELS_SCALAR);
+	case DIST_KERNELS_SCALAR:
+		LWDEBUG(3, "lw_dist2d_set_kernels: using scalar segment kernels");
+		lw_dist2d_seg_segs = lw_dist2d_seg_segs_scalar;
+		lw_dist2d_pt_segs = lw_dist2d_pt_segs_scalar;
+		return LW_SUCCESS;
+#ifdef DIST_X86_KERNELS
+	case DIST_KERNELS_SSE2:
+		__builtin_cpu_init();
+		if ( ! __builtin_cpu_supports("sse2") )
+			return LW_FAILURE;
+		LWDEBUG(3, "lw_dist2d_set_kernels: using SSE2 segment kernels");
+		lw_dist2d_seg_segs = lw_dist2d_seg_segs_sse2;
+		lw_dist2d_pt_segs = lw_dist2d_pt_segs_sse2;
+		return LW_SUCCESS;
+	case DIST_KERNELS_AVX:
+		__builtin_cpu_init();
+		if ( ! __builtin_cpu_supports("avx") )
+			return LW_FAILURE;
+		LWDEBUG(3, "lw_dist2d_set_kernels: using AVX segment kernels");
+		lw_dist2d_seg_segs = lw_dist2d_seg_segs_avx;
+		lw_dist2d_pt_segs = lw_dist2d_pt_segs_avx;
+		return LW_SUCCESS;
+#endif
+	}
+	return LW_FAILURE;
+}
+
 /**
  * search all the segments of pointarray to see which one is closest to p1
  * Returns minimum distance between point and pointarray
@@ -1044,14 +1567,22 @@ lw_dist2d_pt_ptarray(const POINT2D *p, POINTARRAY *pa,DISTPTS *dl)
 
 	if ( !lw_dist2d_pt_pt(p, start, dl) ) return LW_FALSE;
 
+	if ( ! lw_dist2d_pt_segs ) lw_dist2d_set_kernels(DIST_KERNELS_AUTO);
+
 	for (t=1; t<pa->npoints; t++)
 	{
+		/* Skip the segments that can't get any closer */
+		if ( dl->mode == DIST_MIN )
+		{
+			t = lw_dist2d_pt_segs(p, pa, t, dl->distance);
+			if ( t >= pa->npoints ) break;
+		}
 		dl->twisted=twist;
+		start = getPoint2d_cp(pa, t-1);
 		end = getPoint2d_cp(pa, t);
 		if (!lw_dist2d_pt_seg(p, start, end, dl)) return LW_FALSE;
 
 		if (dl->distance<=dl->tolerance && dl->mode == DIST_MIN) return LW_TRUE; /*just a check if  the answer is already given*/
-		start = end;
 	}
 
 	return LW_TRUE;
@@ -1140,13 +1671,18 @@ lw_dist2d_ptarray_ptarray(POINTARRAY *l1, POINTARRAY *l2,DISTPTS *dl)
 	}
 	else
 	{
+		if ( ! lw_dist2d_seg_segs ) lw_dist2d_set_kernels(DIST_KERNELS_AUTO);
+
 		start = getPoint2d_cp(l1, 0);
 		for (t=1; t<l1->npoints; t++) /*for each segment in L1 */
 		{
 			end = getPoint2d_cp(l1, t);
-			start2 = getPoint2d_cp(l2, 0);
 			for (u=1; u<l2->npoints; u++) /*for each segment in L2 */
 			{
+				/* Skip the segments that can't get any closer */
+				u = lw_dist2d_seg_segs(start, end, l2, u, dl->distance);
+				if ( u >= l2->npoints ) break;
+				start2 = getPoint2d_cp(l2, u-1);
 				end2 = getPoint2d_cp(l2, u);
 				dl->twisted=twist;
 				lw_dist2d_seg_seg(start, end, start2, end2, dl);
@@ -1154,7 +1690,6 @@ lw_dist2d_ptarray_ptarray(POINTARRAY *l1, POINTARRAY *l2,DISTPTS *dl)
 				LWDEBUGF(3, " seg%d-seg%d dist: %f, mindist: %f",
 				         t, u, dl->distance, dl->tolerance);
 				if (dl->distance<=dl->tolerance && dl->mode == DIST_MIN) return LW_TRUE; /*just a check if  the answer is already given*/
-				start2 = end2;
 			}
 			start = end;
 		}
@@ -2022,6 +2557,245 @@ End of New faster distance calculations
 --------------------------------------------------------------------------------------------------------------*/
 
 
+/*------------------------------------------------------------------------------------------------------------
+Tree based distance calculations
+Both geometries are indexed with a tree of edge boxes (lwtree.c) and the pairs
+of nodes are searched nearest first, skipping every pair whose boxes are further
+apart than the best distance found so far
+--------------------------------------------------------------------------------------------------------------*/
+
+/**
+Smallest distance there can be between anything in the two nodes,
+zero when the boxes overlap
+*/
+static double
+lw_dist2d_node_node(const RECT_NODE *n1, const RECT_NODE *n2)
+{
+	double dx = 0.0;
+	double dy = 0.0;
+
+	if ( n1->xmax < n2->xmin )
+		dx = n2->xmin - n1->xmax;
+	else if ( n2->xmax < n1->xmin )
+		dx = n1->xmin - n2->xmax;
+
+	if ( n1->ymax < n2->ymin )
+		dy = n2->ymin - n1->ymax;
+	else if ( n2->ymax < n1->ymin )
+		dy = n1->ymin - n2->ymax;
+
+	return sqrt(dx*dx + dy*dy);
+}
+
+/**
+Branch and bound search of the minimum distance between two edge trees.
+The node that is not a leaf, or the wider one, is split and the closer
+child pair is searched first, so that the later pair is more likely to
+be skipped.
+*/
+int
+lw_dist2d_tree_tree(const RECT_NODE *n1, const RECT_NODE *n2, DISTPTS *dl)
+{
+	const RECT_NODE *first1, *first2, *second1, *second2;
+	double d1, d2;
+
+	if (dl->distance<=dl->tolerance) return LW_TRUE; /*just a check if  the answer is already given*/
+
+	if ( lw_dist2d_node_node(n1, n2) > dl->distance )
+		return LW_TRUE;
+
+	/* Leaves have their point references set, lone points have p1 == p2 */
+	if ( n1->p1 && n2->p1 )
+	{
+		dl->twisted = 1;
+		return lw_dist2d_seg_seg(n1->p1, n1->p2, n2->p1, n2->p2, dl);
+	}
+
+	if ( n2->p1 || ( ! n1->p1 &&
+	     FP_MAX(n1->xmax - n1->xmin, n1->ymax - n1->ymin) >= FP_MAX(n2->xmax - n2->xmin, n2->ymax - n2->ymin) ) )
+	{
+		first1 = n1->left_node;
+		second1 = n1->right_node;
+		first2 = second2 = n2;
+	}
+	else
+	{
+		first1 = second1 = n1;
+		first2 = n2->left_node;
+		second2 = n2->right_node;
+	}
+
+	d1 = lw_dist2d_node_node(first1, first2);
+	d2 = lw_dist2d_node_node(second1, second2);
+	if ( d2 < d1 )
+	{
+		if ( ! lw_dist2d_tree_tree(second1, second2, dl) ) return LW_FALSE;
+		return lw_dist2d_tree_tree(first1, first2, dl);
+	}
+	if ( ! lw_dist2d_tree_tree(first1, first2, dl) ) return LW_FALSE;
+	return lw_dist2d_tree_tree(second1, second2, dl);
+}
+
+/**
+Inside the polygon, and neither on its boundary nor in one of its holes
+*/
+static int
+lw_dist2d_poly_contains_point(const LWPOLY *poly, const POINT2D *p)
+{
+	int i;
+
+	if ( ptarray_contains_point(poly->rings[0], p) != LW_INSIDE )
+		return LW_FALSE;
+
+	for ( i = 1; i < poly->nrings; i++ )
+	{
+		if ( ptarray_contains_point(poly->rings[i], p) != LW_OUTSIDE )
+			return LW_FALSE;
+	}
+	return LW_TRUE;
+}
+
+/**
+Check the first vertex of each part of lwg against the polygon. A part
+with a vertex inside is either wholly inside, or crosses the boundary,
+which the tree search finds anyway.
+*/
+static int
+lw_dist2d_poly_contains_part(const LWPOLY *poly, const GBOX *box, const LWGEOM *lwg, DISTPTS *dl)
+{
+	const POINT2D *p;
+	int i;
+
+	if ( lw_dist2d_is_collection(lwg) )
+	{
+		const LWCOLLECTION *col = lwgeom_as_lwcollection(lwg);
+		for ( i = 0; i < col->ngeoms; i++ )
+		{
+			if ( lw_dist2d_poly_contains_part(poly, box, col->geoms[i], dl) )
+				return LW_TRUE;
+		}
+		return LW_FALSE;
+	}
+
+	if ( lwgeom_is_empty(lwg) )
+		return LW_FALSE;
+
+	switch ( lwg->type )
+	{
+		case POINTTYPE:
+			p = getPoint2d_cp(((LWPOINT*)lwg)->point, 0);
+			break;
+		case LINETYPE:
+			p = getPoint2d_cp(((LWLINE*)lwg)->points, 0);
+			break;
+		case POLYGONTYPE:
+			p = getPoint2d_cp(((LWPOLY*)lwg)->rings[0], 0);
+			break;
+		default:
+			return LW_FALSE;
+	}
+
+	if ( p->x < box->xmin || p->x > box->xmax || p->y < box->ymin || p->y > box->ymax )
+		return LW_FALSE;
+
+	if ( ! lw_dist2d_poly_contains_point(poly, p) )
+		return LW_FALSE;
+
+	dl->distance = 0.0;
+	dl->p1 = *p;
+	dl->p2 = *p;
+	return LW_TRUE;
+}
+
+/**
+Look for a part of lwg2 lying inside one of the polygons of lwg1, without
+touching its boundary. The edge trees alone would measure the distance to
+the boundary instead of zero.
+*/
+static int
+lw_dist2d_polys_contain(const LWGEOM *lwg1, const LWGEOM *lwg2, DISTPTS *dl)
+{
+	GBOX box;
+	int i;
+
+	if ( lw_dist2d_is_collection(lwg1) )
+	{
+		const LWCOLLECTION *col = lwgeom_as_lwcollection(lwg1);
+		for ( i = 0; i < col->ngeoms; i++ )
+		{
+			if ( lw_dist2d_polys_contain(col->geoms[i], lwg2, dl) )
+				return LW_TRUE;
+		}
+		return LW_FALSE;
+	}
+
+	if ( lwg1->type != POLYGONTYPE || lwgeom_is_empty(lwg1) )
+		return LW_FALSE;
+
+	if ( lwg1->bbox )
+		box = *(lwg1->bbox);
+	else
+		lwgeom_calculate_gbox_cartesian(lwg1, &box);
+
+	return lw_dist2d_poly_contains_part((LWPOLY*)lwg1, &box, lwg2, dl);
+}
+
+/**
+Minimum distance between two geometries using their edge trees. A tree
+passed in is used as it is, so that callers can keep the tree of a
+geometry they measure again and again, a missing one is built (and
+freed) here. Returns LW_FAILURE without measuring anything for
+geometries that can't be put into a tree (empty, curved or
+triangulated ones) or when not looking for the minimum distance.
+*/
+int
+lw_dist2d_tree(const LWGEOM *lwg1, const RECT_NODE *tree1, const LWGEOM *lwg2, const RECT_NODE *tree2, DISTPTS *dl)
+{
+	RECT_NODE *built1 = NULL;
+	RECT_NODE *built2 = NULL;
+	int rv = LW_FAILURE;
+
+	LWDEBUG(2, "lw_dist2d_tree is called");
+
+	if ( dl->mode != DIST_MIN )
+		return LW_FAILURE;
+
+	if ( ! tree1 )
+		tree1 = built1 = rect_tree_from_lwgeom(lwg1);
+	if ( tree1 && ! tree2 )
+		tree2 = built2 = rect_tree_from_lwgeom(lwg2);
+
+	if ( tree1 && tree2 )
+	{
+		if ( lw_dist2d_polys_contain(lwg1, lwg2, dl) || lw_dist2d_polys_contain(lwg2, lwg1, dl) )
+			rv = LW_SUCCESS;
+		else if ( lw_dist2d_tree_tree(tree1, tree2, dl) )
+			rv = LW_SUCCESS;
+		else
+			lwerror("lw_dist2d_tree: unable to measure between the trees");
+	}
+
+	if ( built1 ) rect_tree_free(built1);
+	if ( built2 ) rect_tree_free(built2);
+	return rv;
+}
+
+/**
+The trees only pay for themselves when both geometries are big enough
+for the brute force pairing of their segments to be slow
+*/
+int
+lw_dist2d_tree_worthwhile(const LWGEOM *lwg1, const LWGEOM *lwg2)
+{
+	return lwgeom_count_vertices(lwg1) >= DIST_TREE_MIN_VERTICES &&
+	       lwgeom_count_vertices(lwg2) >= DIST_TREE_MIN_VERTICES;
+}
+
+/*------------------------------------------------------------------------------------------------------------
+End of Tree based distance calculations
+--------------------------------------------------------------------------------------------------------------*/
+
+
 /*------------------------------------------------------------------------------------------------------------
 Functions in common for Brute force and new calculation
 --------------------------------------------------------------------------------------------------------------*/
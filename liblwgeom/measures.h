@@ -11,11 +11,21 @@
  **********************************************************************/
 
 #include "liblwgeom_internal.h"
+#include "lwtree.h"
 
 /* for the measure functions*/
 #define DIST_MAX		-1
 #define DIST_MIN		1
 
+/* Smallest geometries, in vertices, worth searching through their edge trees */
+#define DIST_TREE_MIN_VERTICES 64
+
+/* Segment run kernels, for lw_dist2d_set_kernels */
+#define DIST_KERNELS_AUTO	0
+#define DIST_KERNELS_SCALAR	1
+#define DIST_KERNELS_SSE2	2
+#define DIST_KERNELS_AVX	3
+
 /** 
 * Structure used in distance-calculations
 */
@@ -44,6 +54,7 @@ int lw_dist2d_distribute_bruteforce(const LWGEOM *lwg1, const LWGEOM *lwg2, DIST
 int lw_dist2d_recursive(const LWGEOM *lwg1, const LWGEOM *lwg2, DISTPTS *dl);
 int lw_dist2d_check_overlap(LWGEOM *lwg1, LWGEOM *lwg2);
 int lw_dist2d_distribute_fast(LWGEOM *lwg1, LWGEOM *lwg2, DISTPTS *dl);
+int lw_dist2d_within(const LWGEOM *lwg1, const LWGEOM *lwg2, DISTPTS *dl);
 
 /*
 * Brute force functions
@@ -78,6 +89,20 @@ int lw_dist2d_selected_seg_seg(const POINT2D *A, const POINT2D *B, const POINT2D
 int struct_cmp_by_measure(const void *a, const void *b);
 int lw_dist2d_fast_ptarray_ptarray(POINTARRAY *l1,POINTARRAY *l2, DISTPTS *dl,  GBOX *box1, GBOX *box2);
 
+/*
+* Tree based distance calculations
+*/
+int lw_dist2d_tree(const LWGEOM *lwg1, const RECT_NODE *tree1, const LWGEOM *lwg2, const RECT_NODE *tree2, DISTPTS *dl);
+int lw_dist2d_tree_tree(const RECT_NODE *n1, const RECT_NODE *n2, DISTPTS *dl);
+int lw_dist2d_tree_worthwhile(const LWGEOM *lwg1, const LWGEOM *lwg2);
+
+/*
+* Use the given segment run kernels from now on, DIST_KERNELS_AUTO going
+* back to the widest ones the CPU supports. Returns LW_FAILURE, changing
+* nothing, when the build or the CPU lacks them. For the tests.
+*/
+int lw_dist2d_set_kernels(int kernels);
+
 /*
 * Distance calculation primitives. 
 */
@@ -88,6 +113,7 @@ int lw_dist2d_seg_seg(const POINT2D *A1, const POINT2D *A2, const POINT2D *B1, c
 int lw_dist2d_seg_arc(const POINT2D *A1, const POINT2D *A2, const POINT2D *B1, const POINT2D *B2, const POINT2D *B3, DISTPTS *dl);
 int lw_dist2d_arc_arc(const POINT2D *A1, const POINT2D *A2, const POINT2D *A3, const POINT2D *B1, const POINT2D *B2, const POINT2D* B3, DISTPTS *dl);
 void lw_dist2d_distpts_init(DISTPTS *dl, int mode);
+void lw_dist2d_distpts_init_within(DISTPTS *dl, double tolerance);
 
 /*
 * Length primitives
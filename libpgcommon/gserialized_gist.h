@@ -84,6 +84,9 @@ typedef float _gidx_float_array[sizeof(float) * 2 * 4];
 /* Pull out the #GIDX bounding box with a absolute minimum system overhead */
 int gserialized_datum_get_gidx_p(Datum gserialized_datum, GIDX *gidx);
 
+/* Pull out the #BOX2DF bounding box, defined with the 2D GiST support */
+int gserialized_datum_get_box2df_p(Datum gsdatum, BOX2DF *box2df);
+
 /* Pull out the gidx bounding box from an already de-toasted geography */
 int gserialized_get_gidx_p(GSERIALIZED *g, GIDX *gidx);
 /* Copy a new bounding box into an existing gserialized */
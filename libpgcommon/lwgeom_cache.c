@@ -12,10 +12,18 @@
 
 #include "postgres.h"
 #include "fmgr.h"
+#include "access/hash.h"
+#include "portability/instr_time.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
 
 #include "../postgis_config.h"
 #include "lwgeom_cache.h"
 
+#if defined(HAVE_MALLINFO2) || defined(HAVE_MALLINFO)
+#include <malloc.h>
+#endif
+
 /* 
 * Generic statement caching infrastructure. We cache 
 * the following kinds of objects:
@@ -114,114 +122,693 @@ GetPROJ4SRSCache(FunctionCallInfoData* fcinfo)
 	return cache;
 }
 
-/**
-* Get an appropriate (based on the entry type number) 
-* GeomCache entry from the generic cache if one exists.
-* Returns a cache pointer if there is a cache hit and we have an
-* index built and ready to use. Returns NULL otherwise.
+/*
+* Per-backend counters for each kind of geometry cache,
+* reported by postgis_cache_stats().
 */
-GeomCache*            
-GetGeomCache(FunctionCallInfoData* fcinfo, const GeomCacheMethods* cache_methods, const GSERIALIZED* g1, const GSERIALIZED* g2)
+static GeomCacheStats GeomCacheStatistics[NUM_CACHE_ENTRIES];
+
+const GeomCacheStats*
+GetGeomCacheStats(int entry_number)
 {
-	GeomCache* cache;
-	int cache_hit = 0;
-	MemoryContext old_context;
-	const GSERIALIZED *geom;
-	GenericCacheCollection* generic_cache = GetGenericCacheCollection(fcinfo);
-	int entry_number = cache_methods->entry_number;
-	
 	Assert(entry_number >= 0);
 	Assert(entry_number < NUM_CACHE_ENTRIES);
-	
-	cache = (GeomCache*)(generic_cache->entry[entry_number]);
-	
-	if ( ! cache )
+	return &(GeomCacheStatistics[entry_number]);
+}
+
+void
+ResetGeomCacheStats(void)
+{
+	memset(GeomCacheStatistics, 0, sizeof(GeomCacheStatistics));
+}
+
+/**
+* Run the index builder, keeping track of how many builds
+* we do and how long they take.
+*/
+static int
+GeomCacheBuildIndex(const GeomCacheMethods* cache_methods, const LWGEOM* lwgeom, GeomCache* cache)
+{
+	GeomCacheStats *stats = &(GeomCacheStatistics[cache_methods->entry_number]);
+	instr_time start, duration;
+	int rv;
+
+	INSTR_TIME_SET_CURRENT(start);
+	rv = cache_methods->GeomIndexBuilder(lwgeom, cache);
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start);
+
+	stats->builds++;
+	stats->build_time += INSTR_TIME_GET_MILLISEC(duration);
+	return rv;
+}
+
+/*
+* Backend-level geometry cache. The statement caches below
+* only live as long as fn_extra, so every new statement has
+* to rebuild the indexes on the same (usually large) geometries.
+* This second level keeps built GeomCache objects around for
+* the life of the backend, keyed by a hash of the serialized
+* geometry, and evicts the least recently used ones once the
+* postgis.geometry_cache_size budget is exceeded.
+*
+* The statement caches come first. Geometries they have no
+* index for are remembered here by a small "ghost" entry (no
+* GeomCache), and an index is only built here when a later
+* statement brings the same geometry back. Geometries repeated
+* within one statement are left to that statement's cache.
+*/
+int postgis_geometry_cache_size = GEOMETRY_CACHE_SIZE_DEFAULT;
+
+#define SHARED_CACHE_HASH_SIZE 256
+
+/*
+* Built entries are charged what malloc handed out during the
+* build, which covers both the entry memory context and what
+* GEOS allocates on its own. GEOS prepared geometries grow some
+* more on their first predicate calls, which is not charged.
+* Without mallinfo, charge a multiple of the serialized size.
+* The older mallinfo() counters are ints that wrap past 4GB,
+* differences of the unsigned values are still right.
+*/
+#if defined(HAVE_MALLINFO2)
+typedef size_t SharedGeomCacheMallocCount;
+static SharedGeomCacheMallocCount
+SharedGeomCacheMallocated(void)
+{
+	struct mallinfo2 mi = mallinfo2();
+	return mi.uordblks + mi.hblkhd;
+}
+#elif defined(HAVE_MALLINFO)
+typedef unsigned int SharedGeomCacheMallocCount;
+static SharedGeomCacheMallocCount
+SharedGeomCacheMallocated(void)
+{
+	struct mallinfo mi = mallinfo();
+	return (unsigned int) mi.uordblks + (unsigned int) mi.hblkhd;
+}
+#else
+#define SHARED_CACHE_COST_FACTOR 4
+#endif
+
+typedef struct
+{
+	uint32 hash;
+	uint32 size;
+	int32 type;
+} SharedGeomCacheKey;
+
+typedef struct SharedGeomCacheEntry
+{
+	SharedGeomCacheKey key;       /* must be first */
+	struct SharedGeomCacheEntry *prev; /* LRU list, most recent first */
+	struct SharedGeomCacheEntry *next;
+	MemoryContext context;        /* owns the cache and its index, NULL for ghosts */
+	GeomCache *cache;             /* built entry, NULL for ghosts */
+	bool failed;                  /* index build failed or too large, don't retry */
+	uint32 statement;             /* statement cache that first saw the geometry */
+	Size cost;
+} SharedGeomCacheEntry;
+
+/* Key of the argument of the last call, by argument position */
+typedef struct
+{
+	const GSERIALIZED *geom;
+	SharedGeomCacheKey key;
+} SharedGeomCacheRecentArg;
+
+static SharedGeomCacheRecentArg SharedGeomCacheRecent[2];
+
+static HTAB *SharedGeomCacheHash = NULL;
+static MemoryContext SharedGeomCacheContext = NULL;
+static SharedGeomCacheEntry *SharedGeomCacheHead = NULL;
+static SharedGeomCacheEntry *SharedGeomCacheTail = NULL;
+static Size SharedGeomCacheUsed = 0;
+
+static Size
+SharedGeomCacheBudget(void)
+{
+	return (Size)postgis_geometry_cache_size * 1024;
+}
+
+static void
+SharedGeomCacheUnlink(SharedGeomCacheEntry *entry)
+{
+	if ( entry->prev ) entry->prev->next = entry->next;
+	else SharedGeomCacheHead = entry->next;
+	if ( entry->next ) entry->next->prev = entry->prev;
+	else SharedGeomCacheTail = entry->prev;
+	entry->prev = entry->next = NULL;
+}
+
+static void
+SharedGeomCachePushFront(SharedGeomCacheEntry *entry)
+{
+	entry->prev = NULL;
+	entry->next = SharedGeomCacheHead;
+	if ( SharedGeomCacheHead ) SharedGeomCacheHead->prev = entry;
+	SharedGeomCacheHead = entry;
+	if ( ! SharedGeomCacheTail ) SharedGeomCacheTail = entry;
+}
+
+static void
+SharedGeomCacheEvict(SharedGeomCacheEntry *entry, const GeomCacheMethods *cache_methods)
+{
+	SharedGeomCacheUnlink(entry);
+	SharedGeomCacheUsed -= entry->cost;
+	if ( entry->cache )
+		GeomCacheStatistics[entry->key.type].evictions++;
+
+	/*
+	* Deleting the context also fires any callbacks hung off it
+	* (the prepared geometry cache frees its GEOS objects that way),
+	* but give the owner a chance to release things explicitly.
+	*/
+	if ( entry->cache && cache_methods && entry->key.type == cache_methods->entry_number )
+		cache_methods->GeomIndexFreer(entry->cache);
+	if ( entry->context )
+		MemoryContextDelete(entry->context);
+
+	hash_search(SharedGeomCacheHash, &(entry->key), HASH_REMOVE, NULL);
+}
+
+/**
+* Evict least recently used entries until "needed" more bytes fit
+* into the budget. Returns false if they never can.
+*/
+static bool
+SharedGeomCacheReserve(Size needed, const SharedGeomCacheEntry *keep, const GeomCacheMethods *cache_methods)
+{
+	Size budget = SharedGeomCacheBudget();
+	SharedGeomCacheEntry *victim = SharedGeomCacheTail;
+
+	if ( needed > budget )
+		return false;
+
+	while ( victim && SharedGeomCacheUsed + needed > budget )
 	{
-		old_context = MemoryContextSwitchTo(FIContext(fcinfo));
+		SharedGeomCacheEntry *prev = victim->prev;
+		if ( victim != keep )
+			SharedGeomCacheEvict(victim, cache_methods);
+		victim = prev;
+	}
+	return SharedGeomCacheUsed + needed <= budget;
+}
+
+static void
+SharedGeomCacheInit(void)
+{
+	HASHCTL ctl;
+
+	SharedGeomCacheContext = AllocSetContextCreate(TopMemoryContext,
+	                                 "PostGIS Geometry Cache",
+	                                 ALLOCSET_DEFAULT_MINSIZE,
+	                                 ALLOCSET_DEFAULT_INITSIZE,
+	                                 ALLOCSET_DEFAULT_MAXSIZE);
+
+	memset(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(SharedGeomCacheKey);
+	ctl.entrysize = sizeof(SharedGeomCacheEntry);
+	ctl.hash = tag_hash;
+	ctl.hcxt = SharedGeomCacheContext;
+
+	SharedGeomCacheHash = hash_create("PostGIS Geometry Cache Hash", SHARED_CACHE_HASH_SIZE, &ctl, (HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT));
+}
+
+static void
+SharedGeomCacheKeyFor(SharedGeomCacheKey *key, int type, const GSERIALIZED *g, int argnum)
+{
+	memset(key, 0, sizeof(SharedGeomCacheKey));
+	key->hash = DatumGetUInt32(hash_any((const unsigned char *)g, VARSIZE(g)));
+	key->size = VARSIZE(g);
+	key->type = type;
+	SharedGeomCacheRecent[argnum].geom = g;
+	SharedGeomCacheRecent[argnum].key = *key;
+}
+
+/**
+* Hashing a large geometry costs as much as reading all of it, so when
+* an argument comes back at the same address with the same size, try
+* the key it had on the last call first. The bytes may have changed
+* under the same address, so a key found that way only counts once the
+* built entry it leads to compares equal.
+*/
+static bool
+SharedGeomCacheRecentKey(SharedGeomCacheKey *key, int type, const GSERIALIZED *g, int argnum)
+{
+	const SharedGeomCacheRecentArg *recent = &(SharedGeomCacheRecent[argnum]);
+
+	if ( recent->geom != g || recent->key.size != VARSIZE(g) || recent->key.type != type )
+		return false;
+	*key = recent->key;
+	return true;
+}
+
+/**
+* Build the index for a ghost entry, in a context of its own.
+* The context hangs off the current one until the build succeeds,
+* so an error thrown half way through can't leak into the backend
+* (PgSQL 9.1 lacks MemoryContextSetParent, so there it may).
+* Indexes that turn out not to fit in the budget are dropped.
+*/
+static GeomCache*
+SharedGeomCacheBuild(SharedGeomCacheEntry *entry, const GeomCacheMethods *cache_methods, const GSERIALIZED *g)
+{
+	MemoryContext old_context;
+	MemoryContext context;
+	GeomCache *cache;
+	LWGEOM *lwgeom;
+	Size cost;
+	int rv;
+#ifndef SHARED_CACHE_COST_FACTOR
+	SharedGeomCacheMallocCount allocated = SharedGeomCacheMallocated();
+#endif
+
+#if POSTGIS_PGSQL_VERSION >= 92
+	context = AllocSetContextCreate(CurrentMemoryContext,
+#else
+	context = AllocSetContextCreate(SharedGeomCacheContext,
+#endif
+	                                "PostGIS Geometry Cache Entry",
+	                                ALLOCSET_SMALL_MINSIZE,
+	                                ALLOCSET_SMALL_INITSIZE,
+	                                ALLOCSET_DEFAULT_MAXSIZE);
+	old_context = MemoryContextSwitchTo(context);
+	cache = cache_methods->GeomCacheAllocator();
+	cache->type = cache_methods->entry_number;
+	cache->geom1_size = VARSIZE(g);
+	cache->geom1 = palloc(cache->geom1_size);
+	memcpy(cache->geom1, g, cache->geom1_size);
+	/* Trees may point into the serialized coordinates, so read our own copy */
+	lwgeom = lwgeom_from_gserialized(cache->geom1);
+	rv = GeomCacheBuildIndex(cache_methods, lwgeom, cache);
+	MemoryContextSwitchTo(old_context);
+
+	if ( ! rv )
+	{
+		MemoryContextDelete(context);
+		entry->failed = true;
+		return NULL;
+	}
+
+	/* Ghosts are charged their entry alone */
+#ifdef SHARED_CACHE_COST_FACTOR
+	cost = entry->cost + VARSIZE(g) * SHARED_CACHE_COST_FACTOR;
+#else
+	cost = entry->cost + (Size)(SharedGeomCacheMallocCount)(SharedGeomCacheMallocated() - allocated);
+#endif
+	if ( ! SharedGeomCacheReserve(cost - entry->cost, entry, cache_methods) )
+	{
+		cache_methods->GeomIndexFreer(cache);
+		MemoryContextDelete(context);
+		entry->failed = true;
+		return NULL;
+	}
+
+#if POSTGIS_PGSQL_VERSION >= 92
+	MemoryContextSetParent(context, SharedGeomCacheContext);
+#endif
+	entry->context = context;
+	entry->cache = cache;
+	SharedGeomCacheUsed += cost - entry->cost;
+	entry->cost = cost;
+	return cache;
+}
+
+/**
+* Look the arguments up in the backend-level cache, on behalf of
+* the statement cache numbered "statement". Returns a built cache
+* with argnum pointing at the matching argument, or NULL.
+*/
+static GeomCache*
+GetSharedGeomCache(const GeomCacheMethods *cache_methods, const GSERIALIZED *g1, const GSERIALIZED *g2, uint32 statement)
+{
+	const GSERIALIZED *geoms[2];
+	SharedGeomCacheKey keys[2];
+	SharedGeomCacheEntry *entries[2];
+	Size budget = SharedGeomCacheBudget();
+	int i;
+
+	geoms[0] = g1;
+	geoms[1] = g2;
+
+	/* Budget turned down since the last call? Trim. */
+	if ( SharedGeomCacheHash && SharedGeomCacheUsed > budget )
+		SharedGeomCacheReserve(0, NULL, NULL);
+
+	if ( ! budget )
+		return NULL;
+
+	/* An index holds its own copy of the geometry, at the least */
+	for ( i = 0; i < 2; i++ )
+	{
+		if ( geoms[i] && VARSIZE(geoms[i]) > budget )
+			return NULL;
+	}
+
+	if ( ! SharedGeomCacheHash )
+		SharedGeomCacheInit();
+
+	/* Any argument with an index already built? */
+	for ( i = 0; i < 2; i++ )
+	{
+		SharedGeomCacheEntry *entry;
+		entries[i] = NULL;
+		if ( ! geoms[i] || gserialized_is_empty(geoms[i]) )
+			continue;
+
+		entry = NULL;
+		if ( SharedGeomCacheRecentKey(&keys[i], cache_methods->entry_number, geoms[i], i) )
+		{
+			entry = hash_search(SharedGeomCacheHash, &keys[i], HASH_FIND, NULL);
+			if ( ! entry || ! entry->cache ||
+			     memcmp(entry->cache->geom1, geoms[i], entry->key.size) != 0 )
+				entry = NULL;
+		}
+
+		/* Not the geometry of the last call, or no index for it, hash it */
+		if ( ! entry )
+		{
+			SharedGeomCacheKeyFor(&keys[i], cache_methods->entry_number, geoms[i], i);
+			entry = hash_search(SharedGeomCacheHash, &keys[i], HASH_FIND, NULL);
+			entries[i] = entry;
+			if ( ! entry || ! entry->cache )
+				continue;
+
+			/* Guard against hash collisions */
+			if ( memcmp(entry->cache->geom1, geoms[i], entry->key.size) != 0 )
+				continue;
+		}
+
+		SharedGeomCacheUnlink(entry);
+		SharedGeomCachePushFront(entry);
+		entry->cache->argnum = i + 1;
+		return entry->cache;
+	}
+
+	/*
+	* Any argument seen by another statement before? Build it now.
+	* Only try one, making room for it may have evicted the entry of
+	* the other argument.
+	*/
+	for ( i = 0; i < 2; i++ )
+	{
+		GeomCache *cache;
+		if ( ! entries[i] || entries[i]->cache || entries[i]->failed ||
+		     entries[i]->statement == statement )
+			continue;
+
+		SharedGeomCacheUnlink(entries[i]);
+		SharedGeomCachePushFront(entries[i]);
+		cache = SharedGeomCacheBuild(entries[i], cache_methods, geoms[i]);
+		if ( cache )
+			cache->argnum = i + 1;
+		return cache;
+	}
+
+	/* First sighting, remember the arguments for next time */
+	for ( i = 0; i < 2; i++ )
+	{
+		SharedGeomCacheEntry *entry;
+		bool found;
+		if ( entries[i] || ! geoms[i] || gserialized_is_empty(geoms[i]) )
+			continue;
+		if ( ! SharedGeomCacheReserve(sizeof(SharedGeomCacheEntry), NULL, cache_methods) )
+			continue;
+
+		entry = hash_search(SharedGeomCacheHash, &keys[i], HASH_ENTER, &found);
+		if ( found )
+			continue;
+		entry->context = NULL;
+		entry->cache = NULL;
+		entry->failed = false;
+		entry->statement = statement;
+		entry->cost = sizeof(SharedGeomCacheEntry);
+		SharedGeomCacheUsed += entry->cost;
+		SharedGeomCachePushFront(entry);
+	}
+
+	return NULL;
+}
+
+/*
+* The statement cache for one kind of tree holds a few geometries
+* at once, so that a join where the repeated argument alternates
+* between a handful of values still gets to use its trees. Each
+* way keeps one geometry (in geom1) and, once that geometry has
+* been seen a second time, its tree. Replacement is by clock
+* sweep, ways that keep getting used survive longer.
+*/
+#define GEOM_CACHE_WAYS 4
+#define GEOM_CACHE_MAX_USAGE 8
+
+typedef struct {
+	int type;
+	uint32 statement; /* number of this statement cache, for the backend cache */
+	int hand;
+	GeomCache* way[GEOM_CACHE_WAYS];
+	bool built[GEOM_CACHE_WAYS];
+	int usage[GEOM_CACHE_WAYS];
+} GeomCacheSet;
+
+static int
+GeomCacheSetFind(const GeomCacheSet* set, const GSERIALIZED* g)
+{
+	int i;
+	size_t size = VARSIZE(g);
+
+	for ( i = 0; i < GEOM_CACHE_WAYS; i++ )
+	{
+		GeomCache* cache = set->way[i];
+		if ( cache && cache->geom1 &&
+		     cache->geom1_size == size &&
+		     memcmp(cache->geom1, g, size) == 0 )
+			return i;
+	}
+	return -1;
+}
+
+/**
+* Make room for a new geometry, freeing the tree of the way
+* we pick if it has one. Ways used since the hand last passed
+* get another round.
+*/
+static int
+GeomCacheSetVictim(GeomCacheSet* set, const GeomCacheMethods* cache_methods, int keep)
+{
+	for (;;)
+	{
+		int i = set->hand;
+		set->hand = (set->hand + 1) % GEOM_CACHE_WAYS;
+
+		if ( i == keep )
+			continue;
+		if ( set->usage[i] > 0 )
+		{
+			set->usage[i]--;
+			continue;
+		}
+		if ( set->built[i] )
+		{
+			GeomCacheStatistics[set->type].flips++;
+			cache_methods->GeomIndexFreer(set->way[i]);
+			set->way[i]->argnum = 0;
+			set->built[i] = false;
+		}
+		return i;
+	}
+}
+
+static int
+GeomCacheSetRemember(FunctionCallInfoData* fcinfo, GeomCacheSet* set, const GeomCacheMethods* cache_methods, const GSERIALIZED* g, int keep)
+{
+	GeomCache* cache;
+	int i = GeomCacheSetVictim(set, cache_methods, keep);
+
+	if ( ! set->way[i] )
+	{
+		MemoryContext old_context = MemoryContextSwitchTo(FIContext(fcinfo));
 		/* Allocate in the upper context */
 		cache = cache_methods->GeomCacheAllocator();
 		MemoryContextSwitchTo(old_context);
-		/* Store the pointer in GenericCache */
-		cache->type = entry_number;
-		generic_cache->entry[entry_number] = (GenericCache*)cache;
-	}	
+		cache->type = set->type;
+		set->way[i] = cache;
+	}
+	cache = set->way[i];
+
+	if ( cache->geom1 ) pfree(cache->geom1);
+	cache->geom1_size = VARSIZE(g);
+	cache->geom1 = MemoryContextAlloc(FIContext(fcinfo), cache->geom1_size);
+	memcpy(cache->geom1, g, cache->geom1_size);
+	set->usage[i] = 0;
+	return i;
+}
+
+/* Statement caches created by the backend so far */
+static uint32 GeomCacheSetCount = 0;
+
+/**
+* Get the statement cache for one kind of tree off the generic
+* cache, allocate a new one if we don't have one already.
+*/
+static GeomCacheSet*
+GetGeomCacheSet(FunctionCallInfoData* fcinfo, const GeomCacheMethods* cache_methods)
+{
+	GenericCacheCollection* generic_cache = GetGenericCacheCollection(fcinfo);
+	int entry_number = cache_methods->entry_number;
+	GeomCacheSet* set = (GeomCacheSet*)(generic_cache->entry[entry_number]);
 
-	/* Cache hit on the first argument */
-	if ( g1 &&
-	     cache->argnum != 2 &&
-	     cache->geom1_size == VARSIZE(g1) &&
-	     memcmp(cache->geom1, g1, cache->geom1_size) == 0 )
+	if ( ! set )
 	{
-		cache_hit = 1;
-		geom = cache->geom1;
+		set = MemoryContextAlloc(FIContext(fcinfo), sizeof(GeomCacheSet));
+		memset(set, 0, sizeof(GeomCacheSet));
+		set->type = entry_number;
+		set->statement = ++GeomCacheSetCount;
+		/* Store the pointer in GenericCache */
+		generic_cache->entry[entry_number] = (GenericCache*)set;
+	}
+	return set;
+}
 
+/**
+* Statement level lookup. Fills found[] with the ways holding the
+* arguments, and returns the cache of one of them if it has an
+* index built and ready to use. Returns NULL otherwise.
+*/
+static GeomCache*
+GeomCacheSetLookup(GeomCacheSet* set, const GSERIALIZED** geoms, int* found)
+{
+	int best = -1;
+	int i;
+
+	for ( i = 0; i < 2; i++ )
+		found[i] = geoms[i] ? GeomCacheSetFind(set, geoms[i]) : -1;
+
+	/*
+	* Use a tree we already have, the one on the larger
+	* geometry if both arguments have one.
+	*/
+	for ( i = 0; i < 2; i++ )
+	{
+		if ( found[i] < 0 || ! set->built[found[i]] )
+			continue;
+		if ( best < 0 || VARSIZE(geoms[i]) > VARSIZE(geoms[best]) )
+			best = i;
 	}
-	/* Cache hit on second argument */
-	else if ( g2 &&
-	          cache->argnum != 1 &&
-	          cache->geom2_size == VARSIZE(g2) &&
-	          memcmp(cache->geom2, g2, cache->geom2_size) == 0 )
+	if ( best >= 0 )
 	{
-		cache_hit = 2;
-		geom = cache->geom2;
+		int w = found[best];
+		if ( set->usage[w] < GEOM_CACHE_MAX_USAGE )
+			set->usage[w]++;
+		set->way[w]->argnum = best + 1;
+		return set->way[w];
 	}
-	/* No cache hit. If we have a tree, free it. */
-	else
+
+	return NULL;
+}
+
+/**
+* Statement level update after a lookup that found no index:
+* remember new arguments, and build the index of an argument seen
+* a second time. Returns the cache if an index got built.
+*/
+static GeomCache*
+GeomCacheSetUpdate(FunctionCallInfoData* fcinfo, GeomCacheSet* set, const GeomCacheMethods* cache_methods, const GSERIALIZED** geoms, const int* found)
+{
+	int best = -1;
+	int i;
+
+	/*
+	* Remember arguments we haven't seen before, without
+	* pushing out the other argument to make room.
+	*/
+	if ( geoms[0] && found[0] < 0 )
 	{
-		cache_hit = 0;
-		if ( cache->argnum )
-		{
-			cache_methods->GeomIndexFreer(cache);
-			cache->argnum = 0;
-		}
+		int w = GeomCacheSetRemember(fcinfo, set, cache_methods, geoms[0], found[1]);
+		if ( geoms[1] && found[1] < 0 )
+			GeomCacheSetRemember(fcinfo, set, cache_methods, geoms[1], w);
+	}
+	else if ( geoms[1] && found[1] < 0 )
+	{
+		GeomCacheSetRemember(fcinfo, set, cache_methods, geoms[1], found[0]);
 	}
 
-	/* Cache hit, but no tree built yet, build it! */
-	if ( cache_hit && ! cache->argnum )
+	/*
+	* Second sighting of an argument, build its tree. If both
+	* qualify, the larger geometry is the better investment.
+	*/
+	for ( i = 0; i < 2; i++ )
+	{
+		if ( found[i] < 0 )
+			continue;
+		if ( best < 0 || VARSIZE(geoms[i]) > VARSIZE(geoms[best]) )
+			best = i;
+	}
+	if ( best >= 0 )
 	{
 		int rv;
-		LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
+		int w = found[best];
+		GeomCache* cache = set->way[w];
+		MemoryContext old_context;
+		LWGEOM *lwgeom = lwgeom_from_gserialized(cache->geom1);
 
 		/* Can't build a tree on a NULL or empty */
 		if ( (!lwgeom) || lwgeom_is_empty(lwgeom) )
 			return NULL;
 
 		old_context = MemoryContextSwitchTo(FIContext(fcinfo));
-		rv = cache_methods->GeomIndexBuilder(lwgeom, cache);
+		rv = GeomCacheBuildIndex(cache_methods, lwgeom, cache);
 		MemoryContextSwitchTo(old_context);
-		cache->argnum = cache_hit;
 
 		/* Something went awry in the tree build phase */
 		if ( ! rv )
-		{
-			cache->argnum = 0;
 			return NULL;
-		}
 
-	}
-
-	/* We have a hit and a calculated tree, we're done */
-	if ( cache_hit && cache->argnum )
+		set->built[w] = true;
+		set->usage[w] = 1;
+		cache->argnum = best + 1;
 		return cache;
-
-	/* Argument one didn't match, so copy the new value in. */
-	if ( g1 && cache_hit != 1 )
-	{
-		if ( cache->geom1 ) pfree(cache->geom1);
-		cache->geom1_size = VARSIZE(g1);
-		cache->geom1 = MemoryContextAlloc(FIContext(fcinfo), cache->geom1_size);
-		memcpy(cache->geom1, g1, cache->geom1_size);
-	}
-	/* Argument two didn't match, so copy the new value in. */
-	if ( g2 && cache_hit != 2 )
-	{
-		if ( cache->geom2 ) pfree(cache->geom2);
-		cache->geom2_size = VARSIZE(g2);
-		cache->geom2 = MemoryContextAlloc(FIContext(fcinfo), cache->geom2_size);
-		memcpy(cache->geom2, g2, cache->geom2_size);
 	}
 
 	return NULL;
 }
 
+/**
+* Get an appropriate (based on the entry type number) 
+* GeomCache entry from the generic cache if one exists.
+* Returns a cache pointer if there is a cache hit and we have an
+* index built and ready to use. Returns NULL otherwise.
+*
+* The statement cache is asked first, then the backend-level
+* cache, and the statement cache gets to remember the arguments
+* or build an index only when neither had one.
+*/
+GeomCache*            
+GetGeomCache(FunctionCallInfoData* fcinfo, const GeomCacheMethods* cache_methods, const GSERIALIZED* g1, const GSERIALIZED* g2)
+{
+	GeomCache* cache;
+	GeomCacheSet* set;
+	const GSERIALIZED* geoms[2];
+	int found[2];
+	int entry_number = cache_methods->entry_number;
+	
+	Assert(entry_number >= 0);
+	Assert(entry_number < NUM_CACHE_ENTRIES);
+
+	geoms[0] = g1;
+	geoms[1] = g2;
+	set = GetGeomCacheSet(fcinfo, cache_methods);
 
+	cache = GeomCacheSetLookup(set, geoms, found);
+	if ( ! cache )
+		cache = GetSharedGeomCache(cache_methods, g1, g2, set->statement);
+	if ( ! cache )
+		cache = GeomCacheSetUpdate(fcinfo, set, cache_methods, geoms, found);
+
+	if ( cache )
+		GeomCacheStatistics[entry_number].hits++;
+	else
+		GeomCacheStatistics[entry_number].misses++;
+
+	return cache;
+}
@@ -34,7 +34,8 @@
 * A generic GeomCache just needs space for the cache type,
 * the cache keys (GSERIALIZED geometries), the key sizes, 
 * and the argument number the cached index/tree is going
-* to refer to.
+* to refer to. Each cached tree is keyed on geom1 alone,
+* geom2 is no longer used.
 */
 typedef struct {
 	int                         type;
@@ -98,10 +99,34 @@ typedef struct
 	GeomCache* (*GeomCacheAllocator)(void); /* Allocate the kind of cache object you use (GeomCache+some extra space) */
 } GeomCacheMethods;
 
+/*
+* Per-backend usage counters of one kind of geometry cache.
+* A hit is a call answered with a built index, a flip is an
+* index thrown away to make room for other arguments.
+*/
+typedef struct
+{
+	uint64 hits;
+	uint64 misses;
+	uint64 builds;
+	uint64 flips;
+	uint64 evictions;
+	double build_time; /* milliseconds spent in GeomIndexBuilder */
+} GeomCacheStats;
+
+/*
+* Memory budget of the backend-level geometry cache, in kilobytes.
+* Exposed as the postgis.geometry_cache_size GUC, zero disables it.
+*/
+#define GEOMETRY_CACHE_SIZE_DEFAULT 8192
+extern int postgis_geometry_cache_size;
+
 /* 
 * Cache retrieval functions
 */
 PROJ4PortalCache*  GetPROJ4SRSCache(FunctionCallInfoData *fcinfo);
 GeomCache*         GetGeomCache(FunctionCallInfoData *fcinfo, const GeomCacheMethods* cache_methods, const GSERIALIZED* g1, const GSERIALIZED* g2);
+const GeomCacheStats* GetGeomCacheStats(int entry_number);
+void               ResetGeomCacheStats(void);
 
 #endif /* LWGEOM_CACHE_H_ */
@@ -18,6 +18,7 @@
 #include <fmgr.h>
 #include <executor/spi.h>
 #include <miscadmin.h>
+#include <access/tuptoaster.h>
 
 #include "../postgis_config.h"
 #include "liblwgeom.h"
@@ -244,6 +245,173 @@ GSERIALIZED* geometry_serialize(LWGEOM *lwgeom)
 	return g;
 }
 
+/* What the send functions write, set by postgis.binary_format */
+int postgis_binary_format = POSTGIS_BINARY_FORMAT_EWKB;
+
+#define GSERIALIZED_BINARY_VERSION 1
+#define GSERIALIZED_BINARY_HEADER_SIZE 4
+
+#ifdef WORDS_BIGENDIAN
+#define GSERIALIZED_BINARY_BYTEORDER 0
+#else
+#define GSERIALIZED_BINARY_BYTEORDER 1
+#endif
+
+bytea* gserialized_binary_send(const GSERIALIZED *g)
+{
+	size_t size = VARSIZE(g) - VARHDRSZ;
+	bytea *result = palloc(VARHDRSZ + GSERIALIZED_BINARY_HEADER_SIZE + size);
+	uint8_t *ptr = (uint8_t*)VARDATA(result);
+
+	SET_VARSIZE(result, VARHDRSZ + GSERIALIZED_BINARY_HEADER_SIZE + size);
+	ptr[0] = 'G';
+	ptr[1] = 'S';
+	ptr[2] = GSERIALIZED_BINARY_VERSION;
+	ptr[3] = GSERIALIZED_BINARY_BYTEORDER;
+	memcpy(ptr + GSERIALIZED_BINARY_HEADER_SIZE, (uint8_t*)g + VARHDRSZ, size);
+
+	return result;
+}
+
+GSERIALIZED* gserialized_binary_recv(StringInfo buf)
+{
+	const uint8_t *ptr = (uint8_t*)buf->data + buf->cursor;
+	int len = buf->len - buf->cursor;
+	size_t size;
+	GSERIALIZED *g;
+
+	if ( len < GSERIALIZED_BINARY_HEADER_SIZE || ptr[0] != 'G' || ptr[1] != 'S' )
+		return NULL;
+
+	if ( ptr[2] != GSERIALIZED_BINARY_VERSION )
+		elog(ERROR, "Unsupported serialized geometry version %d", ptr[2]);
+
+	/* The serialization is in the byte order of the machine that wrote it */
+	if ( ptr[3] != GSERIALIZED_BINARY_BYTEORDER )
+		ereport(ERROR, (errmsg("Serialized geometry was sent with another byte order"),
+		                errhint("Send EWKB instead, with postgis.binary_format set to 'ewkb'.")));
+
+	size = VARHDRSZ + len - GSERIALIZED_BINARY_HEADER_SIZE;
+	g = palloc(size);
+	SET_VARSIZE(g, size);
+	memcpy((uint8_t*)g + VARHDRSZ, ptr + GSERIALIZED_BINARY_HEADER_SIZE, size - VARHDRSZ);
+
+	/* Never trust the counts of bytes from the wire */
+	if ( gserialized_check(g, size) == LW_FAILURE )
+		elog(ERROR, "Invalid serialized geometry");
+
+	buf->cursor = buf->len;
+	return g;
+}
+
+/* Private to tuptoaster.c before 9.4 */
+#ifndef VARATT_EXTERNAL_GET_POINTER
+#define VARATT_EXTERNAL_GET_POINTER(toast_pointer, attr) \
+	memcpy(&(toast_pointer), VARDATA_EXTERNAL(attr), sizeof(toast_pointer))
+#endif
+#ifndef VARATT_EXTERNAL_IS_COMPRESSED
+#define VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer) \
+	((toast_pointer).va_extsize < (toast_pointer).va_rawsize - VARHDRSZ)
+#endif
+#ifndef VARATT_IS_EXTERNAL_ONDISK
+#define VARATT_IS_EXTERNAL_ONDISK(attr) VARATT_IS_EXTERNAL(attr)
+#endif
+
+/*
+* Only values stored out of line without compression are sliced. A
+* compressed value is fetched and inflated whole even for a slice, so
+* it is detoasted once and the header read from that copy, rather than
+* inflated again when a predicate goes on to the coordinates.
+*/
+static int
+gserialized_datum_is_sliced(Datum datum)
+{
+	struct varlena *attr = (struct varlena*)DatumGetPointer(datum);
+	struct varatt_external toast_pointer;
+
+	if ( ! VARATT_IS_EXTERNAL_ONDISK(attr) )
+		return LW_FALSE;
+
+	VARATT_EXTERNAL_GET_POINTER(toast_pointer, attr);
+	return ! VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer);
+}
+#define GSERIALIZED_DATUM_IS_SLICED(datum) gserialized_datum_is_sliced(datum)
+
+GSERIALIZED* gserialized_datum_get_header(Datum datum)
+{
+	if ( GSERIALIZED_DATUM_IS_SLICED(datum) )
+		return (GSERIALIZED*)PG_DETOAST_DATUM_SLICE(datum, 0, GSERIALIZED_HEADER_SLICE_SIZE);
+	return (GSERIALIZED*)PG_DETOAST_DATUM(datum);
+}
+
+GSERIALIZED* gserialized_header_detoast(GSERIALIZED *header, Datum datum)
+{
+	if ( GSERIALIZED_DATUM_IS_SLICED(datum) )
+		return (GSERIALIZED*)PG_DETOAST_DATUM(datum);
+	return header;
+}
+
+int gserialized_header_is_empty(GSERIALIZED *header, Datum datum)
+{
+	const uint8_t *ptr = header->data;
+	uint32_t type, count;
+
+	if ( ! GSERIALIZED_DATUM_IS_SLICED(datum) )
+		return gserialized_is_empty(header);
+
+	if ( FLAGS_GET_BBOX(header->flags) )
+		ptr += gbox_serialized_size(header->flags);
+	memcpy(&type, ptr, sizeof(uint32_t));
+	memcpy(&count, ptr + 4, sizeof(uint32_t));
+
+	if ( count == 0 )
+		return LW_TRUE;
+	if ( ! lwtype_is_collection(type) )
+		return LW_FALSE;
+
+	/* A first member with something in it settles it for a collection */
+	memcpy(&type, ptr + 8, sizeof(uint32_t));
+	memcpy(&count, ptr + 12, sizeof(uint32_t));
+	if ( count > 0 && ! lwtype_is_collection(type) )
+		return LW_FALSE;
+
+	return gserialized_is_empty(gserialized_header_detoast(header, datum));
+}
+
+int gserialized_header_get_gbox_p(GSERIALIZED *header, Datum datum, GBOX *gbox)
+{
+	/* A cached box is read without going past it */
+	if ( FLAGS_GET_BBOX(header->flags) )
+		return gserialized_get_gbox_p(header, gbox);
+	return gserialized_get_gbox_p(gserialized_header_detoast(header, datum), gbox);
+}
+
+int gserialized_datum_peek_first_point(Datum datum, POINT4D *point)
+{
+	GSERIALIZED *g = gserialized_datum_get_header(datum);
+	size_t size = 8;
+	uint32_t type = gserialized_get_type(g);
+
+	if ( ! GSERIALIZED_DATUM_IS_SLICED(datum) )
+		return gserialized_peek_point(g, 0, point);
+
+	/* Header, box, type and count, ring sizes for a polygon, one point */
+	if ( FLAGS_GET_BBOX(g->flags) )
+		size += gbox_serialized_size(g->flags);
+	size += 8;
+	if ( type == POLYGONTYPE )
+	{
+		uint32_t nrings = gserialized_peek_count(g);
+		size += 4 * (nrings + (nrings % 2));
+	}
+	size += FLAGS_NDIMS(g->flags) * sizeof(double);
+
+	if ( size > GSERIALIZED_HEADER_SLICE_SIZE )
+		g = (GSERIALIZED*)PG_DETOAST_DATUM_SLICE(datum, 0, size);
+
+	return gserialized_peek_point(g, 0, point);
+}
+
 void
 lwpgnotice(const char *fmt, ...)
 {
@@ -18,6 +18,7 @@
 #include "postgres.h"
 #include "utils/geo_decls.h"
 #include "fmgr.h"
+#include "lib/stringinfo.h"
 
 #include "liblwgeom.h"
 #include "pgsql_compat.h"
@@ -108,6 +109,70 @@ GSERIALIZED *geometry_serialize(LWGEOM *lwgeom);
 */
 GSERIALIZED* geography_serialize(LWGEOM *lwgeom);
 
+/**
+* Values of postgis.binary_format, what the send functions of geometry
+* and geography write. EWKB by default, which any client can read.
+*/
+#define POSTGIS_BINARY_FORMAT_EWKB 0
+#define POSTGIS_BINARY_FORMAT_NATIVE 1
+extern int postgis_binary_format;
+
+/**
+* Native binary format: a four byte header, "GS", the version of the
+* layout and the byte order of the sender (1 little endian, 0 big, as
+* in WKB), then the serialization without its varlena header. Receiving
+* it reads the serialization directly, where EWKB has to be parsed.
+*/
+bytea* gserialized_binary_send(const GSERIALIZED *g);
+
+/**
+* Read the native binary format from the buffer and advance its cursor.
+* Returns NULL, leaving the buffer alone, when it holds something else:
+* EWKB starts with its byte order, a 0 or a 1. Errors out on a version
+* or byte order other than ours or on a malformed serialization.
+*/
+GSERIALIZED* gserialized_binary_recv(StringInfo buf);
+
+/**
+* Bytes at the front of a serialization that hold its header, the
+* widest cached box and the type and count of the geometry and of its
+* first member.
+*/
+#define GSERIALIZED_HEADER_SLICE_SIZE (8 + 8 * sizeof(float) + 16)
+
+/**
+* Fetch the front of a geometry or geography datum, without detoasting
+* the rest of a large one stored out of line uncompressed. The gserialized_get_type,
+* gserialized_get_srid and gserialized_has_* functions can read the
+* result; anything that looks at coordinates needs the whole value from
+* gserialized_header_detoast.
+*/
+GSERIALIZED* gserialized_datum_get_header(Datum datum);
+
+/**
+* The whole value of a datum whose header was fetched with
+* gserialized_datum_get_header, or the header itself when it is whole.
+*/
+GSERIALIZED* gserialized_header_detoast(GSERIALIZED *header, Datum datum);
+
+/**
+* Same as gserialized_is_empty, reading the rest of the datum only for
+* a collection that does not start with a non-empty member.
+*/
+int gserialized_header_is_empty(GSERIALIZED *header, Datum datum);
+
+/**
+* Same as gserialized_get_gbox_p: the cached box from the header, or
+* the box computed from the whole value when there is none.
+*/
+int gserialized_header_get_gbox_p(GSERIALIZED *header, Datum datum, GBOX *gbox);
+
+/**
+* Same as gserialized_peek_point for the first point, reading only the
+* bytes in front of it.
+*/
+int gserialized_datum_peek_first_point(Datum datum, POINT4D *point);
+
 /**
 * Pull out a gbox bounding box as fast as possible. 
 * Tries to read cached box from front of serialized vardata.
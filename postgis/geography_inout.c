@@ -657,7 +657,22 @@ Datum geography_recv(PG_FUNCTION_ARGS)
 		geog_typmod = PG_GETARG_INT32(2);
 	}
 
-	lwgeom = lwgeom_from_wkb((uint8_t*)buf->data, buf->len, LW_PARSER_CHECK_ALL);
+	/* Another PostGIS may send the serialized form itself */
+	g_ser = gserialized_binary_recv(buf);
+	if ( g_ser )
+	{
+		/*
+		* Geometry or geography, the coordinates and the box are not
+		* trusted: both get the range checks and the box computation
+		* of any other input.
+		*/
+		lwgeom = lwgeom_from_gserialized(g_ser);
+		lwgeom_drop_bbox(lwgeom);
+	}
+	else
+	{
+		lwgeom = lwgeom_from_wkb((uint8_t*)buf->data, buf->len, LW_PARSER_CHECK_ALL);
+	}
 
 	/* Error on any SRID != default */
 	srid_is_latlong(fcinfo, lwgeom->srid);
@@ -677,16 +692,17 @@ Datum geography_recv(PG_FUNCTION_ARGS)
 PG_FUNCTION_INFO_V1(geography_send);
 Datum geography_send(PG_FUNCTION_ARGS)
 {
-	LWGEOM *lwgeom = NULL;
 	GSERIALIZED *g = NULL;
 	size_t size_result;
 	uint8_t *wkb;
 	bytea *result;
 
 	g = PG_GETARG_GSERIALIZED_P(0);
-	lwgeom = lwgeom_from_gserialized(g);
-	wkb = lwgeom_to_wkb(lwgeom, WKB_EXTENDED, &size_result);
-	lwgeom_free(lwgeom);
+
+	if ( postgis_binary_format == POSTGIS_BINARY_FORMAT_NATIVE )
+		PG_RETURN_BYTEA_P(gserialized_binary_send(g));
+
+	wkb = gserialized_to_wkb(g, WKB_EXTENDED, &size_result);
 
 	result = palloc(size_result + VARHDRSZ);
 	SET_VARSIZE(result, size_result + VARHDRSZ);
@@ -34,6 +34,9 @@
 #define INVMINDIST 1.0e9
 #endif
 
+/* Spheroid distances can be a little shorter than the same arc on the mean sphere */
+#define GEOGRAPHY_DWITHIN_BOX_SLACK 1.05
+
 Datum geography_distance(PG_FUNCTION_ARGS);
 Datum geography_distance_uncached(PG_FUNCTION_ARGS);
 Datum geography_distance_knn(PG_FUNCTION_ARGS);
@@ -267,6 +270,7 @@ Datum geography_dwithin(PG_FUNCTION_ARGS)
 	double distance;
 	bool use_spheroid = true;
 	SPHEROID s;
+	GBOX gbox1, gbox2;
 	int dwithin = LW_FALSE;
 
 	/* Get our geometry objects loaded into memory. */
@@ -298,18 +302,50 @@ Datum geography_dwithin(PG_FUNCTION_ARGS)
 		PG_RETURN_BOOL(FALSE);
 	}
 
+	/* Return FALSE when the geocentric boxes are too far apart, once one */
+	/* is grown by the tolerance, as an angle on the unit sphere. The box */
+	/* is grown on all three axes, whatever the Z flag of the geography. */
+	if ( gserialized_get_gbox_p(g1, &gbox1) == LW_SUCCESS &&
+	     gserialized_get_gbox_p(g2, &gbox2) == LW_SUCCESS )
+	{
+		double unit_tolerance = GEOGRAPHY_DWITHIN_BOX_SLACK * (tolerance + FP_TOLERANCE) / s.radius;
+		gbox1.xmin -= unit_tolerance;
+		gbox1.xmax += unit_tolerance;
+		gbox1.ymin -= unit_tolerance;
+		gbox1.ymax += unit_tolerance;
+		gbox1.zmin -= unit_tolerance;
+		gbox1.zmax += unit_tolerance;
+		if ( ! gbox_overlaps(&gbox1, &gbox2) )
+		{
+			PG_FREE_IF_COPY(g1, 0);
+			PG_FREE_IF_COPY(g2, 1);
+			PG_RETURN_BOOL(FALSE);
+		}
+	}
+
 	/* Do the brute force calculation if the cached calculation doesn't tick over */
 	if ( LW_FAILURE == geography_dwithin_cache(fcinfo, g1, g2, &s, tolerance, &dwithin) )
 	{
-		LWGEOM* lwgeom1 = lwgeom_from_gserialized(g1);
-		LWGEOM* lwgeom2 = lwgeom_from_gserialized(g2);
-		distance = lwgeom_distance_spheroid(lwgeom1, lwgeom2, &s, tolerance);
-		/* Something went wrong... */
-		if ( distance < 0.0 )
-			elog(ERROR, "lwgeom_distance_spheroid returned negative!");
-		dwithin = (distance <= tolerance);
-		lwgeom_free(lwgeom1);
-		lwgeom_free(lwgeom2);
+		/* Big geographies are still quicker to search through trees of */
+		/* their edges, even with trees built for this one call */
+		if ( gserialized_peek_npoints(g1) >= CIRC_TREE_MIN_VERTICES &&
+		     gserialized_peek_npoints(g2) >= CIRC_TREE_MIN_VERTICES &&
+		     LW_SUCCESS == geography_tree_distance(g1, g2, &s, FP_TOLERANCE, &distance) )
+		{
+			dwithin = (distance <= (tolerance + FP_TOLERANCE));
+		}
+		else
+		{
+			LWGEOM* lwgeom1 = lwgeom_from_gserialized(g1);
+			LWGEOM* lwgeom2 = lwgeom_from_gserialized(g2);
+			distance = lwgeom_distance_spheroid(lwgeom1, lwgeom2, &s, tolerance);
+			lwgeom_free(lwgeom1);
+			lwgeom_free(lwgeom2);
+			/* Something went wrong... */
+			if ( distance < 0.0 )
+				elog(ERROR, "lwgeom_distance_spheroid returned negative!");
+			dwithin = (distance <= tolerance);
+		}
 	}
 
 	/* Clean up */
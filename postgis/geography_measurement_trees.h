@@ -2,6 +2,9 @@
 #include "lwgeodetic_tree.h"
 #include "lwgeom_cache.h"
 
+/* Below this many vertices on either side, building trees for one call costs more than it saves */
+#define CIRC_TREE_MIN_VERTICES 64
+
 int geography_dwithin_cache(FunctionCallInfoData* fcinfo, const GSERIALIZED* g1, const GSERIALIZED* g2, const SPHEROID* s, double tolerance, int* dwithin);
 int geography_distance_cache(FunctionCallInfoData* fcinfo, const GSERIALIZED* g1, const GSERIALIZED* g2, const SPHEROID* s, double* distance);
 int geography_tree_distance(const GSERIALIZED* g1, const GSERIALIZED* g2, const SPHEROID* s, double tolerance, double* distance);
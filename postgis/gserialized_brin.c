@@ -0,0 +1,250 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+/*
+** BRIN index support.
+**
+** Block ranges are summarised with the union of the boxes of their
+** geometries, a box2df for the 2D opclass and a gidx for the ND one.
+** Scans use the generic inclusion consistent and union functions from
+** PostgreSQL, with the box against geometry operators, so only the
+** value adding and merging need to know about our boxes.
+*/
+
+#include "postgres.h"
+
+#include "../postgis_config.h"
+
+#if POSTGIS_PGSQL_VERSION >= 95
+
+#include "access/brin_tuple.h" /* For BrinValues */
+
+#include "liblwgeom.h"         /* For standard geometry types. */
+#include "lwgeom_pg.h"         /* For debugging macros. */
+#include "gserialized_gist.h"  /* For BOX2DF, GIDX and box extraction. */
+
+#include <float.h> /* For FLT_MAX */
+
+/*
+** Positions of the summary values, as laid out by the inclusion
+** opclass support in PostgreSQL (brin_inclusion.c).
+*/
+#define INCLUSION_UNION 0
+#define INCLUSION_UNMERGEABLE 1
+#define INCLUSION_CONTAINS_EMPTY 2
+
+/*
+** BRIN index function prototypes
+*/
+Datum gserialized_brin_add_value_2d(PG_FUNCTION_ARGS);
+Datum gserialized_brin_merge_2d(PG_FUNCTION_ARGS);
+Datum gserialized_brin_add_value_nd(PG_FUNCTION_ARGS);
+Datum gserialized_brin_merge_nd(PG_FUNCTION_ARGS);
+
+/*
+** Shared handling of nulls and of the first value of a range. Returns
+** true when the caller is done, with *result set to the return value.
+*/
+static bool
+brin_add_value_prelude(BrinValues *column, bool isnull, Datum (*empty_union)(void), bool *isnew, bool *result)
+{
+	*isnew = false;
+
+	/* Nulls are tracked by the range itself */
+	if ( isnull )
+	{
+		*result = ! column->bv_hasnulls;
+		column->bv_hasnulls = true;
+		return true;
+	}
+
+	/* First value in the range, start from a union that matches nothing */
+	if ( column->bv_allnulls )
+	{
+		column->bv_values[INCLUSION_UNION] = empty_union();
+		column->bv_values[INCLUSION_UNMERGEABLE] = BoolGetDatum(false);
+		column->bv_values[INCLUSION_CONTAINS_EMPTY] = BoolGetDatum(false);
+		column->bv_allnulls = false;
+		*isnew = true;
+	}
+
+	return false;
+}
+
+/*
+** Empty geometries have no box, they only set the flag telling
+** scans for contained values that the range may hold one.
+*/
+static bool
+brin_add_empty(BrinValues *column, bool isnew)
+{
+	if ( DatumGetBool(column->bv_values[INCLUSION_CONTAINS_EMPTY]) )
+		return isnew;
+
+	column->bv_values[INCLUSION_CONTAINS_EMPTY] = BoolGetDatum(true);
+	return true;
+}
+
+/*
+** An inverted box, which overlaps and contains nothing and merges
+** into any other box without changing it.
+*/
+static Datum
+box2df_new_empty(void)
+{
+	BOX2DF *box = palloc(sizeof(BOX2DF));
+	box->xmin = box->ymin = FLT_MAX;
+	box->xmax = box->ymax = -FLT_MAX;
+	return PointerGetDatum(box);
+}
+
+/* Grow the union to cover the box, return true if it changed */
+static bool
+box2df_brin_merge(BOX2DF *b_union, const BOX2DF *b_new)
+{
+	bool changed = false;
+
+	if ( b_new->xmin < b_union->xmin ) { b_union->xmin = b_new->xmin; changed = true; }
+	if ( b_new->xmax > b_union->xmax ) { b_union->xmax = b_new->xmax; changed = true; }
+	if ( b_new->ymin < b_union->ymin ) { b_union->ymin = b_new->ymin; changed = true; }
+	if ( b_new->ymax > b_union->ymax ) { b_union->ymax = b_new->ymax; changed = true; }
+
+	return changed;
+}
+
+PG_FUNCTION_INFO_V1(gserialized_brin_add_value_2d);
+Datum gserialized_brin_add_value_2d(PG_FUNCTION_ARGS)
+{
+	BrinValues *column = (BrinValues*) PG_GETARG_POINTER(1);
+	Datum newval = PG_GETARG_DATUM(2);
+	bool isnull = PG_GETARG_BOOL(3);
+	BOX2DF box_geom;
+	bool isnew, result;
+
+	if ( brin_add_value_prelude(column, isnull, box2df_new_empty, &isnew, &result) )
+		PG_RETURN_BOOL(result);
+
+	if ( gserialized_datum_get_box2df_p(newval, &box_geom) == LW_FAILURE )
+		PG_RETURN_BOOL(brin_add_empty(column, isnew));
+
+	if ( box2df_brin_merge((BOX2DF*)DatumGetPointer(column->bv_values[INCLUSION_UNION]), &box_geom) )
+		PG_RETURN_BOOL(true);
+
+	PG_RETURN_BOOL(isnew);
+}
+
+PG_FUNCTION_INFO_V1(gserialized_brin_merge_2d);
+Datum gserialized_brin_merge_2d(PG_FUNCTION_ARGS)
+{
+	BOX2DF *a = (BOX2DF*) PG_GETARG_POINTER(0);
+	BOX2DF *b = (BOX2DF*) PG_GETARG_POINTER(1);
+	BOX2DF *result = palloc(sizeof(BOX2DF));
+
+	memcpy(result, a, sizeof(BOX2DF));
+	box2df_brin_merge(result, b);
+
+	PG_RETURN_POINTER(result);
+}
+
+/*
+** The ND union only keeps the dimensions that all the geometries of
+** the range have. A missing dimension always overlaps, so keeping
+** the extra ones of some geometries would wrongly exclude the others.
+*/
+static Datum
+gidx_new_empty(void)
+{
+	GIDX *gidx = palloc(VARHDRSZ);
+	SET_VARSIZE(gidx, VARHDRSZ);
+	return PointerGetDatum(gidx);
+}
+
+/* Grow the union to cover the box, return it, possibly reallocated */
+static GIDX *
+gidx_brin_merge(GIDX *b_union, GIDX *b_new, bool *changed)
+{
+	int i, ndims;
+
+	*changed = false;
+
+	/* An empty union takes the first box as it is */
+	if ( VARSIZE(b_union) <= VARHDRSZ )
+	{
+		if ( VARSIZE(b_new) <= VARHDRSZ )
+			return b_union;
+		b_union = palloc(VARSIZE(b_new));
+		memcpy(b_union, b_new, VARSIZE(b_new));
+		*changed = true;
+		return b_union;
+	}
+
+	if ( VARSIZE(b_new) <= VARHDRSZ )
+		return b_union;
+
+	ndims = Min(GIDX_NDIMS(b_union), GIDX_NDIMS(b_new));
+	if ( ndims < GIDX_NDIMS(b_union) )
+	{
+		SET_VARSIZE(b_union, GIDX_SIZE(ndims));
+		*changed = true;
+	}
+
+	for ( i = 0; i < ndims; i++ )
+	{
+		if ( GIDX_GET_MIN(b_new, i) < GIDX_GET_MIN(b_union, i) )
+		{
+			GIDX_SET_MIN(b_union, i, GIDX_GET_MIN(b_new, i));
+			*changed = true;
+		}
+		if ( GIDX_GET_MAX(b_new, i) > GIDX_GET_MAX(b_union, i) )
+		{
+			GIDX_SET_MAX(b_union, i, GIDX_GET_MAX(b_new, i));
+			*changed = true;
+		}
+	}
+
+	return b_union;
+}
+
+PG_FUNCTION_INFO_V1(gserialized_brin_add_value_nd);
+Datum gserialized_brin_add_value_nd(PG_FUNCTION_ARGS)
+{
+	BrinValues *column = (BrinValues*) PG_GETARG_POINTER(1);
+	Datum newval = PG_GETARG_DATUM(2);
+	bool isnull = PG_GETARG_BOOL(3);
+	char boxmem[GIDX_MAX_SIZE];
+	GIDX *gidx_geom = (GIDX*)boxmem;
+	GIDX *gidx_union;
+	bool isnew, result, changed;
+
+	if ( brin_add_value_prelude(column, isnull, gidx_new_empty, &isnew, &result) )
+		PG_RETURN_BOOL(result);
+
+	if ( gserialized_datum_get_gidx_p(newval, gidx_geom) == LW_FAILURE )
+		PG_RETURN_BOOL(brin_add_empty(column, isnew));
+
+	gidx_union = (GIDX*)DatumGetPointer(column->bv_values[INCLUSION_UNION]);
+	column->bv_values[INCLUSION_UNION] = PointerGetDatum(gidx_brin_merge(gidx_union, gidx_geom, &changed));
+
+	PG_RETURN_BOOL(changed || isnew);
+}
+
+PG_FUNCTION_INFO_V1(gserialized_brin_merge_nd);
+Datum gserialized_brin_merge_nd(PG_FUNCTION_ARGS)
+{
+	GIDX *a = (GIDX*) PG_GETARG_POINTER(0);
+	GIDX *b = (GIDX*) PG_GETARG_POINTER(1);
+	GIDX *result = palloc(VARSIZE(a));
+	bool changed;
+
+	memcpy(result, a, VARSIZE(a));
+	PG_RETURN_POINTER(gidx_brin_merge(result, b, &changed));
+}
+
+#endif /* POSTGIS_PGSQL_VERSION >= 95 */
@@ -100,6 +100,12 @@ Datum gserialized_overabove_2d(PG_FUNCTION_ARGS);
 Datum gserialized_overbelow_2d(PG_FUNCTION_ARGS);
 Datum gserialized_distance_box_2d(PG_FUNCTION_ARGS);
 Datum gserialized_distance_centroid_2d(PG_FUNCTION_ARGS);
+Datum gserialized_overlaps_box2df_geom_2d(PG_FUNCTION_ARGS);
+Datum gserialized_overlaps_geom_box2df_2d(PG_FUNCTION_ARGS);
+Datum gserialized_contains_box2df_geom_2d(PG_FUNCTION_ARGS);
+Datum gserialized_contains_geom_box2df_2d(PG_FUNCTION_ARGS);
+Datum gserialized_within_box2df_geom_2d(PG_FUNCTION_ARGS);
+Datum gserialized_within_geom_box2df_2d(PG_FUNCTION_ARGS);
 
 /*
 ** true/false test function type
@@ -526,7 +532,7 @@ static double box2df_distance(const BOX2DF *a, const BOX2DF *b)
 * full object and return the box based on that. If no box is available,
 * return #LW_FAILURE, otherwise #LW_SUCCESS.
 */
-static int 
+int 
 gserialized_datum_get_box2df_p(Datum gsdatum, BOX2DF *box2df)
 {
 	GSERIALIZED *gpart;
@@ -691,6 +697,78 @@ Datum gserialized_overlaps_2d(PG_FUNCTION_ARGS)
 	PG_RETURN_BOOL(FALSE);
 }
 
+/*
+** Box against geometry operators, used to test the box2df summaries
+** stored in BRIN indexes.
+*/
+
+static int
+gserialized_box2df_predicate_2d(const BOX2DF *box, Datum gs, box2df_predicate predicate)
+{
+	BOX2DF b;
+
+	if ( gserialized_datum_get_box2df_p(gs, &b) == LW_FAILURE )
+		return LW_FALSE;
+
+	return predicate(box, &b) ? LW_TRUE : LW_FALSE;
+}
+
+PG_FUNCTION_INFO_V1(gserialized_overlaps_box2df_geom_2d);
+Datum gserialized_overlaps_box2df_geom_2d(PG_FUNCTION_ARGS)
+{
+	if ( gserialized_box2df_predicate_2d((BOX2DF*)PG_GETARG_POINTER(0), PG_GETARG_DATUM(1), box2df_overlaps) == LW_TRUE )
+		PG_RETURN_BOOL(TRUE);
+
+	PG_RETURN_BOOL(FALSE);
+}
+
+PG_FUNCTION_INFO_V1(gserialized_overlaps_geom_box2df_2d);
+Datum gserialized_overlaps_geom_box2df_2d(PG_FUNCTION_ARGS)
+{
+	if ( gserialized_box2df_predicate_2d((BOX2DF*)PG_GETARG_POINTER(1), PG_GETARG_DATUM(0), box2df_overlaps) == LW_TRUE )
+		PG_RETURN_BOOL(TRUE);
+
+	PG_RETURN_BOOL(FALSE);
+}
+
+PG_FUNCTION_INFO_V1(gserialized_contains_box2df_geom_2d);
+Datum gserialized_contains_box2df_geom_2d(PG_FUNCTION_ARGS)
+{
+	if ( gserialized_box2df_predicate_2d((BOX2DF*)PG_GETARG_POINTER(0), PG_GETARG_DATUM(1), box2df_contains) == LW_TRUE )
+		PG_RETURN_BOOL(TRUE);
+
+	PG_RETURN_BOOL(FALSE);
+}
+
+PG_FUNCTION_INFO_V1(gserialized_contains_geom_box2df_2d);
+Datum gserialized_contains_geom_box2df_2d(PG_FUNCTION_ARGS)
+{
+	/* The geometry contains the box if the box is within it */
+	if ( gserialized_box2df_predicate_2d((BOX2DF*)PG_GETARG_POINTER(1), PG_GETARG_DATUM(0), box2df_within) == LW_TRUE )
+		PG_RETURN_BOOL(TRUE);
+
+	PG_RETURN_BOOL(FALSE);
+}
+
+PG_FUNCTION_INFO_V1(gserialized_within_box2df_geom_2d);
+Datum gserialized_within_box2df_geom_2d(PG_FUNCTION_ARGS)
+{
+	if ( gserialized_box2df_predicate_2d((BOX2DF*)PG_GETARG_POINTER(0), PG_GETARG_DATUM(1), box2df_within) == LW_TRUE )
+		PG_RETURN_BOOL(TRUE);
+
+	PG_RETURN_BOOL(FALSE);
+}
+
+PG_FUNCTION_INFO_V1(gserialized_within_geom_box2df_2d);
+Datum gserialized_within_geom_box2df_2d(PG_FUNCTION_ARGS)
+{
+	/* The geometry is within the box if the box contains it */
+	if ( gserialized_box2df_predicate_2d((BOX2DF*)PG_GETARG_POINTER(1), PG_GETARG_DATUM(0), box2df_contains) == LW_TRUE )
+		PG_RETURN_BOOL(TRUE);
+
+	PG_RETURN_BOOL(FALSE);
+}
+
 PG_FUNCTION_INFO_V1(gserialized_left_2d);
 Datum gserialized_left_2d(PG_FUNCTION_ARGS)
 {
@@ -87,6 +87,8 @@ Datum gserialized_overlaps(PG_FUNCTION_ARGS);
 Datum gserialized_contains(PG_FUNCTION_ARGS);
 Datum gserialized_within(PG_FUNCTION_ARGS);
 Datum gserialized_distance_nd(PG_FUNCTION_ARGS);
+Datum gserialized_overlaps_gidx_geom(PG_FUNCTION_ARGS);
+Datum gserialized_overlaps_geom_gidx(PG_FUNCTION_ARGS);
 
 /*
 ** GIDX true/false test function type
@@ -821,6 +823,46 @@ Datum gserialized_overlaps(PG_FUNCTION_ARGS)
 	PG_RETURN_BOOL(FALSE);
 }
 
+/*
+** '&&&' operator functions between a box and a serialized, used to
+** test the gidx summaries stored in BRIN indexes.
+*/
+static int
+gserialized_gidx_predicate(GIDX *gidx, Datum gs, gidx_predicate predicate)
+{
+	char boxmem[GIDX_MAX_SIZE];
+	GIDX *gidx_geom = (GIDX*)boxmem;
+
+	if ( (gserialized_datum_get_gidx_p(gs, gidx_geom) == LW_SUCCESS) &&
+	      predicate(gidx, gidx_geom) )
+	{
+		return LW_TRUE;
+	}
+	return LW_FALSE;
+}
+
+PG_FUNCTION_INFO_V1(gserialized_overlaps_gidx_geom);
+Datum gserialized_overlaps_gidx_geom(PG_FUNCTION_ARGS)
+{
+	if ( gserialized_gidx_predicate((GIDX*)PG_GETARG_POINTER(0), PG_GETARG_DATUM(1), gidx_overlaps) == LW_TRUE )
+	{
+		PG_RETURN_BOOL(TRUE);
+	}
+
+	PG_RETURN_BOOL(FALSE);
+}
+
+PG_FUNCTION_INFO_V1(gserialized_overlaps_geom_gidx);
+Datum gserialized_overlaps_geom_gidx(PG_FUNCTION_ARGS)
+{
+	if ( gserialized_gidx_predicate((GIDX*)PG_GETARG_POINTER(1), PG_GETARG_DATUM(0), gidx_overlaps) == LW_TRUE )
+	{
+		PG_RETURN_BOOL(TRUE);
+	}
+
+	PG_RETURN_BOOL(FALSE);
+}
+
 /***********************************************************************
 * GiST Index  Support Functions
 */
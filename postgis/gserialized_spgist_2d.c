@@ -0,0 +1,394 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+/*
+** SP-GiST 2D index support.
+**
+** The bounding box of every geometry is mapped to a point in 4D space
+** (xmin, xmax, ymin, ymax) and indexed in a quad-tree over that space.
+** Each inner tuple carries its centroid as prefix and has 16 nodes,
+** one for each side of the centroid the box falls on in each of the
+** four dimensions. Unlike an R-Tree, cells never overlap, so lookups
+** follow a single path per matching region and inserts never need to
+** choose between competing subtrees.
+**
+** Inner tuples only keep the centroid, not the bounds of their cell.
+** That is enough for pruning: a cell is the intersection of the half
+** spaces chosen by all its ancestors, so testing each level against
+** the query on its own rejects the same subtrees.
+**
+** Leaves only keep the box. Leaf tuples have to be of the indexed
+** type before PostgreSQL 11, so the box is carried by an empty point
+** with a serialized box, a fixed 32 bytes whatever the size of the
+** geometry. Points are stored as they are, they are no bigger.
+**
+** [1] H. Samet, "The Quadtree and Related Hierarchical Data Structures",
+**     ACM Computing Surveys 16(2), 1984.
+*/
+
+#include "postgres.h"
+#include "access/skey.h"
+
+#include "../postgis_config.h"
+
+#if POSTGIS_PGSQL_VERSION >= 92
+
+#include "access/spgist.h"     /* For SP-GiST */
+#include "catalog/pg_type.h"   /* For VOIDOID, BOXOID */
+#include "utils/geo_decls.h"   /* For BOX */
+
+#include "liblwgeom.h"         /* For standard geometry types. */
+#include "lwgeom_pg.h"         /* For debugging macros. */
+#include "gserialized_gist.h"  /* For BOX2DF and box extraction. */
+
+#include <stdlib.h> /* For qsort */
+
+/*
+** SP-GiST 2D index function prototypes
+*/
+Datum gserialized_spgist_config_2d(PG_FUNCTION_ARGS);
+Datum gserialized_spgist_choose_2d(PG_FUNCTION_ARGS);
+Datum gserialized_spgist_picksplit_2d(PG_FUNCTION_ARGS);
+Datum gserialized_spgist_inner_consistent_2d(PG_FUNCTION_ARGS);
+Datum gserialized_spgist_leaf_consistent_2d(PG_FUNCTION_ARGS);
+
+/* One node per combination of sides of the centroid in 4D */
+#define SPGIST_2D_NODES 16
+
+#define SPGIST_2D_XMIN 0x8
+#define SPGIST_2D_XMAX 0x4
+#define SPGIST_2D_YMIN 0x2
+#define SPGIST_2D_YMAX 0x1
+
+/*
+** The centroid is stored as a BOX, using low for the minimums and
+** high for the maximums. Box coordinates are floats, so the doubles
+** hold them exactly.
+*/
+static uint8
+spgist_2d_quadrant(const BOX *centroid, const BOX2DF *box)
+{
+	uint8 quadrant = 0;
+
+	if ( box->xmin > centroid->low.x )
+		quadrant |= SPGIST_2D_XMIN;
+	if ( box->xmax > centroid->high.x )
+		quadrant |= SPGIST_2D_XMAX;
+	if ( box->ymin > centroid->low.y )
+		quadrant |= SPGIST_2D_YMIN;
+	if ( box->ymax > centroid->high.y )
+		quadrant |= SPGIST_2D_YMAX;
+
+	return quadrant;
+}
+
+/*
+** Can a box in this quadrant of the centroid satisfy the strategy
+** for the query box? Empty geometries never satisfy any strategy,
+** so they are free to live anywhere.
+*/
+static bool
+spgist_2d_quadrant_consistent(const BOX *c, uint8 quadrant, const BOX2DF *q, StrategyNumber strategy)
+{
+	bool xmin_above = (quadrant & SPGIST_2D_XMIN) != 0;
+	bool xmax_above = (quadrant & SPGIST_2D_XMAX) != 0;
+	bool ymin_above = (quadrant & SPGIST_2D_YMIN) != 0;
+	bool ymax_above = (quadrant & SPGIST_2D_YMAX) != 0;
+
+	switch (strategy)
+	{
+		/* box.min <= q.max && box.max >= q.min */
+		case RTOverlapStrategyNumber:
+			if ( xmin_above && c->low.x >= q->xmax ) return FALSE;
+			if ( ! xmax_above && c->high.x < q->xmin ) return FALSE;
+			if ( ymin_above && c->low.y >= q->ymax ) return FALSE;
+			if ( ! ymax_above && c->high.y < q->ymin ) return FALSE;
+			return TRUE;
+
+		/* box.min <= q.min && box.max >= q.max */
+		case RTContainsStrategyNumber:
+			if ( xmin_above && c->low.x >= q->xmin ) return FALSE;
+			if ( ! xmax_above && c->high.x < q->xmax ) return FALSE;
+			if ( ymin_above && c->low.y >= q->ymin ) return FALSE;
+			if ( ! ymax_above && c->high.y < q->ymax ) return FALSE;
+			return TRUE;
+
+		/* box.min >= q.min && box.max <= q.max */
+		case RTContainedByStrategyNumber:
+			if ( ! xmin_above && c->low.x < q->xmin ) return FALSE;
+			if ( xmax_above && c->high.x >= q->xmax ) return FALSE;
+			if ( ! ymin_above && c->low.y < q->ymin ) return FALSE;
+			if ( ymax_above && c->high.y >= q->ymax ) return FALSE;
+			return TRUE;
+
+		default:
+			elog(ERROR, "unrecognized strategy number: %d", strategy);
+	}
+	return FALSE;
+}
+
+static bool
+spgist_2d_leaf_consistent(const BOX2DF *b, const BOX2DF *q, StrategyNumber strategy)
+{
+	switch (strategy)
+	{
+		case RTOverlapStrategyNumber:
+			return ! ( b->xmin > q->xmax || q->xmin > b->xmax ||
+			           b->ymin > q->ymax || q->ymin > b->ymax );
+
+		case RTContainsStrategyNumber:
+			return ! ( b->xmin > q->xmin || b->xmax < q->xmax ||
+			           b->ymin > q->ymin || b->ymax < q->ymax );
+
+		case RTContainedByStrategyNumber:
+			return ! ( q->xmin > b->xmin || q->xmax < b->xmax ||
+			           q->ymin > b->ymin || q->ymax < b->ymax );
+
+		default:
+			elog(ERROR, "unrecognized strategy number: %d", strategy);
+	}
+	return FALSE;
+}
+
+/*
+** The leaf form of a geometry: an empty point carrying the 2D box,
+** or a bare empty point for geometries without a box.
+*/
+static Datum
+spgist_2d_leaf_datum(Datum gsdatum)
+{
+	GSERIALIZED *g = (GSERIALIZED*) DatumGetPointer(gsdatum);
+	GSERIALIZED *leaf, *boxed;
+	LWGEOM *empty;
+	BOX2DF box;
+	char boxmem[GIDX_MAX_SIZE];
+	GIDX *gidx = (GIDX*) boxmem;
+
+	if ( gserialized_get_type(g) == POINTTYPE )
+		return gsdatum;
+
+	empty = lwpoint_as_lwgeom(lwpoint_construct_empty(SRID_UNKNOWN, LW_FALSE, LW_FALSE));
+	leaf = geometry_serialize(empty);
+	lwgeom_free(empty);
+
+	if ( gserialized_datum_get_box2df_p(gsdatum, &box) == LW_FAILURE )
+		return PointerGetDatum(leaf);
+
+	SET_VARSIZE(gidx, GIDX_SIZE(2));
+	GIDX_SET_MIN(gidx, 0, box.xmin);
+	GIDX_SET_MAX(gidx, 0, box.xmax);
+	GIDX_SET_MIN(gidx, 1, box.ymin);
+	GIDX_SET_MAX(gidx, 1, box.ymax);
+	boxed = gserialized_set_gidx(leaf, gidx);
+	if ( boxed != leaf )
+		pfree(leaf);
+
+	return PointerGetDatum(boxed);
+}
+
+static int
+spgist_2d_cmp_float(const void *a, const void *b)
+{
+	float fa = *(const float*)a;
+	float fb = *(const float*)b;
+
+	if ( fa < fb ) return -1;
+	if ( fa > fb ) return 1;
+	return 0;
+}
+
+
+PG_FUNCTION_INFO_V1(gserialized_spgist_config_2d);
+Datum gserialized_spgist_config_2d(PG_FUNCTION_ARGS)
+{
+	spgConfigOut *cfg = (spgConfigOut*) PG_GETARG_POINTER(1);
+
+	cfg->prefixType = BOXOID;
+	cfg->labelType = VOIDOID; /* Nodes are identified by their number */
+	cfg->canReturnData = false;
+	/* Long geometries are cut down to their box by choose and picksplit */
+	cfg->longValuesOK = true;
+
+	PG_RETURN_VOID();
+}
+
+PG_FUNCTION_INFO_V1(gserialized_spgist_choose_2d);
+Datum gserialized_spgist_choose_2d(PG_FUNCTION_ARGS)
+{
+	spgChooseIn *in = (spgChooseIn*) PG_GETARG_POINTER(0);
+	spgChooseOut *out = (spgChooseOut*) PG_GETARG_POINTER(1);
+	BOX *centroid = DatumGetBoxP(in->prefixDatum);
+	BOX2DF box;
+
+	out->resultType = spgMatchNode;
+	out->result.matchNode.levelAdd = 0;
+	out->result.matchNode.restDatum = spgist_2d_leaf_datum(in->leafDatum);
+
+	/* When all the nodes are the same the core picks one itself */
+	if ( in->allTheSame )
+		PG_RETURN_VOID();
+
+	/* Empty geometries have no box, park them in the first node */
+	if ( gserialized_datum_get_box2df_p(in->leafDatum, &box) == LW_FAILURE )
+		out->result.matchNode.nodeN = 0;
+	else
+		out->result.matchNode.nodeN = spgist_2d_quadrant(centroid, &box);
+
+	PG_RETURN_VOID();
+}
+
+/*
+** Split on the median of each of the four box coordinates, which
+** spreads the tuples over the nodes as evenly as the data allows.
+*/
+PG_FUNCTION_INFO_V1(gserialized_spgist_picksplit_2d);
+Datum gserialized_spgist_picksplit_2d(PG_FUNCTION_ARGS)
+{
+	spgPickSplitIn *in = (spgPickSplitIn*) PG_GETARG_POINTER(0);
+	spgPickSplitOut *out = (spgPickSplitOut*) PG_GETARG_POINTER(1);
+	BOX2DF *boxes = palloc(sizeof(BOX2DF) * in->nTuples);
+	bool *empty = palloc(sizeof(bool) * in->nTuples);
+	float *xmins = palloc(sizeof(float) * in->nTuples);
+	float *xmaxs = palloc(sizeof(float) * in->nTuples);
+	float *ymins = palloc(sizeof(float) * in->nTuples);
+	float *ymaxs = palloc(sizeof(float) * in->nTuples);
+	BOX *centroid = palloc0(sizeof(BOX));
+	int nboxes = 0;
+	int i;
+
+	for ( i = 0; i < in->nTuples; i++ )
+	{
+		empty[i] = (gserialized_datum_get_box2df_p(in->datums[i], &boxes[i]) == LW_FAILURE);
+		if ( empty[i] )
+			continue;
+
+		xmins[nboxes] = boxes[i].xmin;
+		xmaxs[nboxes] = boxes[i].xmax;
+		ymins[nboxes] = boxes[i].ymin;
+		ymaxs[nboxes] = boxes[i].ymax;
+		nboxes++;
+	}
+
+	if ( nboxes > 0 )
+	{
+		qsort(xmins, nboxes, sizeof(float), spgist_2d_cmp_float);
+		qsort(xmaxs, nboxes, sizeof(float), spgist_2d_cmp_float);
+		qsort(ymins, nboxes, sizeof(float), spgist_2d_cmp_float);
+		qsort(ymaxs, nboxes, sizeof(float), spgist_2d_cmp_float);
+
+		centroid->low.x = xmins[nboxes / 2];
+		centroid->high.x = xmaxs[nboxes / 2];
+		centroid->low.y = ymins[nboxes / 2];
+		centroid->high.y = ymaxs[nboxes / 2];
+	}
+
+	out->hasPrefix = true;
+	out->prefixDatum = BoxPGetDatum(centroid);
+
+	out->nNodes = SPGIST_2D_NODES;
+	out->nodeLabels = NULL;
+
+	out->mapTuplesToNodes = palloc(sizeof(int) * in->nTuples);
+	out->leafTupleDatums = palloc(sizeof(Datum) * in->nTuples);
+
+	for ( i = 0; i < in->nTuples; i++ )
+	{
+		out->leafTupleDatums[i] = spgist_2d_leaf_datum(in->datums[i]);
+		out->mapTuplesToNodes[i] = empty[i] ? 0 : spgist_2d_quadrant(centroid, &boxes[i]);
+	}
+
+	pfree(xmins);
+	pfree(xmaxs);
+	pfree(ymins);
+	pfree(ymaxs);
+	pfree(empty);
+	pfree(boxes);
+
+	PG_RETURN_VOID();
+}
+
+PG_FUNCTION_INFO_V1(gserialized_spgist_inner_consistent_2d);
+Datum gserialized_spgist_inner_consistent_2d(PG_FUNCTION_ARGS)
+{
+	spgInnerConsistentIn *in = (spgInnerConsistentIn*) PG_GETARG_POINTER(0);
+	spgInnerConsistentOut *out = (spgInnerConsistentOut*) PG_GETARG_POINTER(1);
+	BOX *centroid;
+	BOX2DF *queries;
+	int quadrant;
+	int i;
+
+	out->nNodes = 0;
+	out->nodeNumbers = palloc(sizeof(int) * in->nNodes);
+
+	/* Nothing to tell the nodes apart, visit them all */
+	if ( in->allTheSame )
+	{
+		for ( i = 0; i < in->nNodes; i++ )
+			out->nodeNumbers[out->nNodes++] = i;
+		PG_RETURN_VOID();
+	}
+
+	Assert(in->hasPrefix);
+	centroid = DatumGetBoxP(in->prefixDatum);
+
+	/* Empty queries match nothing */
+	queries = palloc(sizeof(BOX2DF) * in->nkeys);
+	for ( i = 0; i < in->nkeys; i++ )
+	{
+		if ( gserialized_datum_get_box2df_p(in->scankeys[i].sk_argument, &queries[i]) == LW_FAILURE )
+		{
+			pfree(queries);
+			PG_RETURN_VOID();
+		}
+	}
+
+	for ( quadrant = 0; quadrant < in->nNodes; quadrant++ )
+	{
+		bool match = true;
+
+		for ( i = 0; i < in->nkeys && match; i++ )
+			match = spgist_2d_quadrant_consistent(centroid, quadrant, &queries[i],
+			                                      in->scankeys[i].sk_strategy);
+
+		if ( match )
+			out->nodeNumbers[out->nNodes++] = quadrant;
+	}
+
+	pfree(queries);
+	PG_RETURN_VOID();
+}
+
+PG_FUNCTION_INFO_V1(gserialized_spgist_leaf_consistent_2d);
+Datum gserialized_spgist_leaf_consistent_2d(PG_FUNCTION_ARGS)
+{
+	spgLeafConsistentIn *in = (spgLeafConsistentIn*) PG_GETARG_POINTER(0);
+	spgLeafConsistentOut *out = (spgLeafConsistentOut*) PG_GETARG_POINTER(1);
+	BOX2DF box, query;
+	int i;
+
+	/* Leaves hold the box only, the heap tuple has the geometry */
+	out->recheck = true;
+
+	if ( gserialized_datum_get_box2df_p(in->leafDatum, &box) == LW_FAILURE )
+		PG_RETURN_BOOL(FALSE);
+
+	for ( i = 0; i < in->nkeys; i++ )
+	{
+		if ( gserialized_datum_get_box2df_p(in->scankeys[i].sk_argument, &query) == LW_FAILURE )
+			PG_RETURN_BOOL(FALSE);
+
+		if ( ! spgist_2d_leaf_consistent(&box, &query, in->scankeys[i].sk_strategy) )
+			PG_RETURN_BOOL(FALSE);
+	}
+
+	PG_RETURN_BOOL(TRUE);
+}
+
+#endif /* POSTGIS_PGSQL_VERSION >= 92 */
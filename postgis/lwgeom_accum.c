@@ -13,6 +13,7 @@
 #include "fmgr.h"
 #include "funcapi.h"
 #include "access/tupmacs.h"
+#include "access/tuptoaster.h"
 #include "utils/array.h"
 #include "utils/lsyscache.h"
 
@@ -27,6 +28,7 @@
 Datum PGISDirectFunctionCall1(PGFunction func, Datum arg1);
 Datum PGISDirectFunctionCall2(PGFunction func, Datum arg1, Datum arg2);
 Datum pgis_geometry_accum_transfn(PG_FUNCTION_ARGS);
+Datum pgis_geometry_union_transfn(PG_FUNCTION_ARGS);
 Datum pgis_geometry_accum_finalfn(PG_FUNCTION_ARGS);
 Datum pgis_geometry_union_finalfn(PG_FUNCTION_ARGS);
 Datum pgis_geometry_collect_finalfn(PG_FUNCTION_ARGS);
@@ -63,6 +65,10 @@ Datum LWGEOM_makeline_garray(PG_FUNCTION_ARGS);
 ** transfn and finalfn we need to wrap it into a custom type first,
 ** the pgis_abs type in our case.  The extra "data" member can optionally
 ** be used to pass an additional constant argument to a finalizer function.
+**
+** Note that the SQL pgis_abs type has a fixed internallength of 16 bytes
+** and PostgreSQL copies the state by value, so no members can be added
+** here without changing the type definition too.
 */
 
 typedef struct
@@ -72,6 +78,34 @@ typedef struct
 }
 pgis_abs;
 
+/**
+** ST_Union does not wait for the final function to union all of its
+** inputs at once, which would need every input in memory both as
+** GSERIALIZED and as GEOS geometry. Instead, every time the buffered
+** batch grows past UNION_BATCH_MAX_GEOMS geometries or
+** UNION_BATCH_MAX_BYTES bytes it is cascade-unioned into a partial
+** result and dropped.
+**
+** Partial results are kept in a binary counter: the partial of level N
+** stands for 2^N batches, and two partials of the same level are merged
+** into one of the next level. This keeps the number of partials
+** logarithmic in the input size while making sure no big partial gets
+** re-unioned with every single batch.
+**
+** The union state hangs off the "data" member of pgis_abs.
+*/
+#define UNION_BATCH_MAX_GEOMS 4096
+#define UNION_BATCH_MAX_BYTES (64 * 1024 * 1024)
+#define UNION_MAX_LEVELS 32
+
+typedef struct
+{
+	Oid elemtype;
+	size_t batch_bytes;
+	GSERIALIZED *partials[UNION_MAX_LEVELS];
+}
+pgis_union_state;
+
 
 
 /**
@@ -149,7 +183,157 @@ pgis_geometry_accum_transfn(PG_FUNCTION_ARGS)
 	PG_RETURN_POINTER(p);
 }
 
+/**
+** Union two geometries, either of which can be NULL.
+** Returns a GSERIALIZED allocated in the current memory context or NULL.
+*/
+static GSERIALIZED *
+pgis_union_pair(GSERIALIZED *g1, GSERIALIZED *g2, Oid elemtype)
+{
+	Datum elems[2];
+	int nelems = 0;
+	int16 elmlen;
+	bool elmbyval;
+	char elmalign;
+	Datum result;
+
+	if ( g1 ) elems[nelems++] = PointerGetDatum(g1);
+	if ( g2 ) elems[nelems++] = PointerGetDatum(g2);
+	if ( ! nelems )
+		return NULL;
+
+	get_typlenbyvalalign(elemtype, &elmlen, &elmbyval, &elmalign);
+	result = PGISDirectFunctionCall1(pgis_union_geometry_array,
+	             PointerGetDatum(construct_array(elems, nelems, elemtype, elmlen, elmbyval, elmalign)));
+	if ( ! result )
+		return NULL;
+
+	/* The union of a single geometry can point inside the input array */
+	return (GSERIALIZED *) PG_DETOAST_DATUM_COPY(result);
+}
+
+/**
+** Cascade-union the current batch into a partial result and merge it
+** into the partials binary counter, releasing the batch memory.
+*/
+static void
+pgis_union_state_reduce(pgis_abs *p, MemoryContext aggcontext)
+{
+	pgis_union_state *u = (pgis_union_state *) DatumGetPointer(p->data);
+	MemoryContext old;
+	GSERIALIZED *carry = NULL;
+	Datum batch;
+	Datum result;
+	int dims[1];
+	int lbs[1];
+	int i;
+
+	if ( ! p->a )
+		return;
+
+	POSTGIS_DEBUGF(3, "%s: reducing batch of %d geometries (%zu bytes)",
+	               __func__, p->a->nelems, u->batch_bytes);
+
+	/* Releasing the build state frees all the buffered inputs */
+	dims[0] = p->a->nelems;
+	lbs[0] = 1;
+	batch = makeMdArrayResult(p->a, 1, dims, lbs, CurrentMemoryContext, true);
+	p->a = NULL;
+	u->batch_bytes = 0;
+
+	result = PGISDirectFunctionCall1(pgis_union_geometry_array, batch);
+	if ( result )
+		carry = (GSERIALIZED *) DatumGetPointer(result);
+
+	/* Propagate the carry up the levels, like an increment of a binary number */
+	for ( i = 0; carry && i < UNION_MAX_LEVELS; i++ )
+	{
+		GSERIALIZED *merged;
+
+		if ( ! u->partials[i] )
+		{
+			old = MemoryContextSwitchTo(aggcontext);
+			u->partials[i] = (GSERIALIZED *) PG_DETOAST_DATUM_COPY(PointerGetDatum(carry));
+			MemoryContextSwitchTo(old);
+			carry = NULL;
+			break;
+		}
+
+		merged = pgis_union_pair(u->partials[i], carry, u->elemtype);
+		pfree(u->partials[i]);
+		u->partials[i] = NULL;
+		carry = merged;
+	}
+
+	/* Ran out of levels (never happens in practice), keep it on top */
+	if ( carry )
+	{
+		GSERIALIZED *merged = pgis_union_pair(u->partials[UNION_MAX_LEVELS-1], carry, u->elemtype);
+		old = MemoryContextSwitchTo(aggcontext);
+		if ( u->partials[UNION_MAX_LEVELS-1] )
+			pfree(u->partials[UNION_MAX_LEVELS-1]);
+		u->partials[UNION_MAX_LEVELS-1] = merged ? (GSERIALIZED *) PG_DETOAST_DATUM_COPY(PointerGetDatum(merged)) : NULL;
+		MemoryContextSwitchTo(old);
+	}
+}
+
+/**
+** Move the partial unions back into the buffered batch so that the
+** final (or serialization) step sees every pending input.
+*/
+static void
+pgis_union_state_flush(pgis_abs *p, MemoryContext aggcontext)
+{
+	pgis_union_state *u;
+	int i;
+
+	if ( ! p->data )
+		return;
 
+	u = (pgis_union_state *) DatumGetPointer(p->data);
+	for ( i = 0; i < UNION_MAX_LEVELS; i++ )
+	{
+		if ( ! u->partials[i] )
+			continue;
+		p->a = accumArrayResult(p->a, PointerGetDatum(u->partials[i]), false, u->elemtype, aggcontext);
+		pfree(u->partials[i]);
+		u->partials[i] = NULL;
+	}
+}
+
+/**
+** The "union" transfer function accumulates like the generic one, and
+** reduces the buffered batch whenever it gets too big.
+*/
+PG_FUNCTION_INFO_V1(pgis_geometry_union_transfn);
+Datum
+pgis_geometry_union_transfn(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	pgis_union_state *u;
+	pgis_abs *p;
+
+	p = (pgis_abs*) DatumGetPointer(pgis_geometry_accum_transfn(fcinfo));
+
+	/* pgis_geometry_accum_transfn already complained if this fails */
+	AggCheckCallContext(fcinfo, &aggcontext);
+
+	if ( ! p->data )
+	{
+		u = (pgis_union_state *) MemoryContextAllocZero(aggcontext, sizeof(pgis_union_state));
+		u->elemtype = get_fn_expr_argtype(fcinfo->flinfo, 1);
+		p->data = PointerGetDatum(u);
+	}
+	u = (pgis_union_state *) DatumGetPointer(p->data);
+
+	if ( ! PG_ARGISNULL(1) )
+		u->batch_bytes += toast_raw_datum_size(PG_GETARG_DATUM(1));
+
+	if ( p->a->nelems >= UNION_BATCH_MAX_GEOMS || u->batch_bytes >= UNION_BATCH_MAX_BYTES )
+		pgis_union_state_reduce(p, aggcontext);
+
+	PG_RETURN_POINTER(p);
+}
 
 Datum pgis_accum_finalfn(pgis_abs *p, MemoryContext mctx, FunctionCallInfo fcinfo);
 
@@ -216,6 +400,17 @@ pgis_geometry_union_finalfn(PG_FUNCTION_ARGS)
 
 	p = (pgis_abs*) PG_GETARG_POINTER(0);
 
+	/* Bring back the partial unions computed by the transfer function */
+	if ( p->data )
+	{
+		MemoryContext aggcontext;
+		if ( ! AggCheckCallContext(fcinfo, &aggcontext) )
+			aggcontext = CurrentMemoryContext;
+		pgis_union_state_flush(p, aggcontext);
+	}
+	if ( ! p->a )
+		PG_RETURN_NULL();
+
 	geometry_array = pgis_accum_finalfn(p, CurrentMemoryContext, fcinfo);
 	result = PGISDirectFunctionCall1( pgis_union_geometry_array, geometry_array );
 	if (!result)
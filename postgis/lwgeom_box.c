@@ -122,14 +122,19 @@ Datum LWGEOM_to_BOX2D(PG_FUNCTION_ARGS)
 }
 
 
-/*convert a GSERIALIZED to BOX2D */
+/*
+* Return the box a GSERIALIZED carries (the one the GiST index keys on),
+* computing it only when there is none. Reads just the front of large
+* geometries stored out of line, so box-only queries do not pay for
+* detoasting the coordinates.
+*/
 PG_FUNCTION_INFO_V1(LWGEOM_to_BOX2DF);
 Datum LWGEOM_to_BOX2DF(PG_FUNCTION_ARGS)
 {
-	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
+	GSERIALIZED *geom = gserialized_datum_get_header(PG_GETARG_DATUM(0));
 	GBOX gbox;
 
-	if ( gserialized_get_gbox_p(geom, &gbox) == LW_FAILURE )
+	if ( gserialized_header_get_gbox_p(geom, PG_GETARG_DATUM(0), &gbox) == LW_FAILURE )
 		PG_RETURN_NULL();
 
 	/* Strip out higher dimensions */
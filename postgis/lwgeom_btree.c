@@ -37,6 +37,8 @@ Datum lwgeom_eq(PG_FUNCTION_ARGS);
 Datum lwgeom_ge(PG_FUNCTION_ARGS);
 Datum lwgeom_gt(PG_FUNCTION_ARGS);
 Datum lwgeom_cmp(PG_FUNCTION_ARGS);
+Datum ST_HilbertKey(PG_FUNCTION_ARGS);
+Datum ST_MortonKey(PG_FUNCTION_ARGS);
 
 PG_FUNCTION_INFO_V1(lwgeom_lt);
 Datum lwgeom_lt(PG_FUNCTION_ARGS)
@@ -350,3 +352,34 @@ Datum lwgeom_cmp(PG_FUNCTION_ARGS)
 	PG_RETURN_INT32(0);
 }
 
+/*
+ * Spatial ordering keys. The sortable curve position is unsigned,
+ * flip the top bit so that it keeps its order as a signed bigint.
+ * Only the box is read, so large toasted geometries are not fully
+ * detoasted when they carry a cached bbox.
+ */
+#define SORTABLE_TO_INT64(u) ((int64)((u) ^ UINT64CONST(0x8000000000000000)))
+
+PG_FUNCTION_INFO_V1(ST_HilbertKey);
+Datum ST_HilbertKey(PG_FUNCTION_ARGS)
+{
+	GBOX box;
+
+	/* Empty geometries have no position */
+	if ( gserialized_datum_get_gbox_p(PG_GETARG_DATUM(0), &box) == LW_FAILURE )
+		PG_RETURN_NULL();
+
+	PG_RETURN_INT64(SORTABLE_TO_INT64(gbox_get_sortable_hash(&box)));
+}
+
+PG_FUNCTION_INFO_V1(ST_MortonKey);
+Datum ST_MortonKey(PG_FUNCTION_ARGS)
+{
+	GBOX box;
+
+	/* Empty geometries have no position */
+	if ( gserialized_datum_get_gbox_p(PG_GETARG_DATUM(0), &box) == LW_FAILURE )
+		PG_RETURN_NULL();
+
+	PG_RETURN_INT64(SORTABLE_TO_INT64(gbox_get_sortable_morton(&box)));
+}
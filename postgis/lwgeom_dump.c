@@ -21,9 +21,19 @@
 #include "utils/elog.h"
 #include "utils/array.h"
 #include "utils/geo_decls.h"
+#include "utils/builtins.h"
 #include "funcapi.h"
+#include "executor/spi.h"
+#include "catalog/pg_type.h"
 
 #include "../postgis_config.h"
+
+#if POSTGIS_PGSQL_VERSION >= 93
+#include "access/htup_details.h"
+#else
+#include "access/htup.h"
+#endif
+
 #include "liblwgeom.h"
 #include "lwgeom_pg.h"
 
@@ -31,6 +41,8 @@
 Datum LWGEOM_dump(PG_FUNCTION_ARGS);
 Datum LWGEOM_dump_rings(PG_FUNCTION_ARGS);
 Datum ST_Subdivide(PG_FUNCTION_ARGS);
+Datum TWKB_dump(PG_FUNCTION_ARGS);
+Datum TWKB_dump_chunks(PG_FUNCTION_ARGS);
 
 typedef struct GEOMDUMPNODE_T
 {
@@ -402,3 +414,215 @@ Datum ST_Subdivide(PG_FUNCTION_ARGS)
 #endif /* POSTGIS_GEOS_VERSION >= 35 */
 }
 
+
+/*
+** TWKB bundles. The members of TWKB collections with an idlist come
+** out as (id, geom) rows, decoded one per call by a single iterator.
+*/
+typedef struct
+{
+	LWTWKB_ITERATOR *it;
+	char *portal; /* Name of the cursor over the chunks, when streaming */
+}
+TWKBDUMPSTATE;
+
+static void
+twkb_dump_init(FunctionCallInfo fcinfo, FuncCallContext *funcctx)
+{
+	TupleDesc tupdesc;
+
+	if ( get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE )
+		elog(ERROR, "%s: function returning record called in context that cannot accept type record", __func__);
+
+	funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+}
+
+/* The iterator keeps its buffers across calls, so it runs in the multi call context */
+static LWGEOM *
+twkb_dump_next(FuncCallContext *funcctx, TWKBDUMPSTATE *state, int64_t *id, int *has_id)
+{
+	MemoryContext oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+	LWGEOM *lwgeom = lwtwkb_iterator_next(state->it, id, has_id);
+	MemoryContextSwitchTo(oldcontext);
+	return lwgeom;
+}
+
+/* Serialize in the per call context, so rows do not pile up */
+static Datum
+twkb_dump_result(FuncCallContext *funcctx, LWGEOM *lwgeom, int64_t id, int has_id)
+{
+	Datum values[2];
+	bool nulls[2];
+	HeapTuple tuple;
+
+	if ( lwgeom_needs_bbox(lwgeom) )
+		lwgeom_add_bbox(lwgeom);
+
+	values[0] = Int64GetDatum(id);
+	nulls[0] = ! has_id;
+	values[1] = PointerGetDatum(geometry_serialize(lwgeom));
+	nulls[1] = false;
+
+	lwgeom_free(lwgeom);
+
+	tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+	return HeapTupleGetDatum(tuple);
+}
+
+/*
+** Fetch the next chunk from the cursor into the iterator. Returns
+** false once the cursor is used up. The cursor belongs to the caller,
+** so it is left open.
+*/
+static bool
+twkb_dump_fetch(FuncCallContext *funcctx, TWKBDUMPSTATE *state)
+{
+	MemoryContext oldcontext;
+	Portal portal;
+	bytea *chunk;
+	Datum datum;
+	bool isnull;
+
+	if ( SPI_OK_CONNECT != SPI_connect() )
+		elog(ERROR, "%s: could not connect to SPI manager", __func__);
+
+	portal = SPI_cursor_find(state->portal);
+	if ( ! portal )
+		elog(ERROR, "%s: cursor %s has gone", __func__, state->portal);
+
+	do
+	{
+		SPI_cursor_fetch(portal, true, 1);
+		if ( SPI_processed == 0 )
+		{
+			SPI_finish();
+			pfree(state->portal);
+			state->portal = NULL;
+			return false;
+		}
+		datum = SPI_getbinval(SPI_tuptable->vals[0], SPI_tuptable->tupdesc, 1, &isnull);
+	}
+	while ( isnull );
+
+	chunk = (bytea*) PG_DETOAST_DATUM(datum);
+
+	oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+	lwtwkb_iterator_append(state->it, (uint8_t*) VARDATA(chunk), VARSIZE(chunk) - VARHDRSZ);
+	MemoryContextSwitchTo(oldcontext);
+
+	SPI_finish();
+	return true;
+}
+
+/*
+** ST_DumpTWKB(twkb bytea) returns (id, geom) rows for each member of
+** the TWKB collections in the bytea. Geometries without an idlist
+** come out whole, with a null id.
+*/
+PG_FUNCTION_INFO_V1(TWKB_dump);
+Datum TWKB_dump(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	TWKBDUMPSTATE *state;
+	LWGEOM *lwgeom;
+	int64_t id = 0;
+	int has_id;
+
+	if ( SRF_IS_FIRSTCALL() )
+	{
+		MemoryContext oldcontext;
+		bytea *twkb;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		twkb_dump_init(fcinfo, funcctx);
+
+		/* The iterator reads in place, so the bytes have to stay put */
+		twkb = PG_GETARG_BYTEA_P_COPY(0);
+
+		state = palloc0(sizeof(TWKBDUMPSTATE));
+		state->it = lwtwkb_iterator_create((uint8_t*) VARDATA(twkb), VARSIZE(twkb) - VARHDRSZ, LW_PARSER_CHECK_ALL);
+		funcctx->user_fctx = state;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	state = funcctx->user_fctx;
+
+	lwgeom = twkb_dump_next(funcctx, state, &id, &has_id);
+	if ( ! lwgeom )
+	{
+		lwtwkb_iterator_destroy(state->it);
+		SRF_RETURN_DONE(funcctx);
+	}
+
+	SRF_RETURN_NEXT(funcctx, twkb_dump_result(funcctx, lwgeom, id, has_id));
+}
+
+/*
+** ST_DumpTWKBChunks(chunks refcursor) reads the TWKB as a stream of
+** bytea chunks, the first column of the rows of a cursor the caller
+** opened, in order. This gets around the size limit of a single bytea
+** value. Chunks need not end on geometry boundaries, and only one chunk
+** plus whatever geometry is cut across it is held at a time.
+*/
+PG_FUNCTION_INFO_V1(TWKB_dump_chunks);
+Datum TWKB_dump_chunks(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	TWKBDUMPSTATE *state;
+	LWGEOM *lwgeom;
+	int64_t id = 0;
+	int has_id;
+
+	if ( SRF_IS_FIRSTCALL() )
+	{
+		MemoryContext oldcontext;
+		char *name;
+		Portal portal;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		twkb_dump_init(fcinfo, funcctx);
+		name = text_to_cstring(PG_GETARG_TEXT_P(0));
+
+		state = palloc0(sizeof(TWKBDUMPSTATE));
+		state->it = lwtwkb_iterator_create_stream(LW_PARSER_CHECK_ALL);
+		funcctx->user_fctx = state;
+
+		MemoryContextSwitchTo(oldcontext);
+
+		if ( SPI_OK_CONNECT != SPI_connect() )
+			elog(ERROR, "%s: could not connect to SPI manager", __func__);
+
+		portal = SPI_cursor_find(name);
+		if ( ! portal )
+			elog(ERROR, "%s: cursor %s does not exist", __func__, name);
+		if ( ! portal->tupDesc || portal->tupDesc->natts < 1 || SPI_gettypeid(portal->tupDesc, 1) != BYTEAOID )
+			elog(ERROR, "%s: the first column of the cursor must be a bytea", __func__);
+
+		state->portal = MemoryContextStrdup(funcctx->multi_call_memory_ctx, name);
+		SPI_finish();
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	state = funcctx->user_fctx;
+
+	/* Read chunks until a whole geometry is in */
+	while ( ! (lwgeom = twkb_dump_next(funcctx, state, &id, &has_id)) )
+	{
+		if ( ! state->portal )
+		{
+			lwtwkb_iterator_destroy(state->it);
+			SRF_RETURN_DONE(funcctx);
+		}
+
+		if ( ! twkb_dump_fetch(funcctx, state) )
+			lwtwkb_iterator_end(state->it);
+	}
+
+	SRF_RETURN_NEXT(funcctx, twkb_dump_result(funcctx, lwgeom, id, has_id));
+}
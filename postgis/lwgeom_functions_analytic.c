@@ -691,72 +691,14 @@ int isOnSegment(POINT2D *seg1, POINT2D *seg2, POINT2D *point)
 int point_in_ring_rtree(RTREE_NODE *root, POINT2D *point)
 {
 	int wn = 0;
-	int i;
-	double side;
-	POINT2D seg1;
-	POINT2D seg2;
-	LWMLINE *lines;
 
 	POSTGIS_DEBUG(2, "point_in_ring called.");
 
-	lines = RTreeFindLineSegments(root, point->y);
-	if (!lines)
-		return -1;
-
-	for (i=0; i<lines->ngeoms; i++)
+	if (RTreeWindingNumber(root, point, &wn))
 	{
-		getPoint2d_p(lines->geoms[i]->points, 0, &seg1);
-		getPoint2d_p(lines->geoms[i]->points, 1, &seg2);
-
-
-		side = determineSide(&seg1, &seg2, point);
-
-		POSTGIS_DEBUGF(3, "segment: (%.8f, %.8f),(%.8f, %.8f)", seg1.x, seg1.y, seg2.x, seg2.y);
-		POSTGIS_DEBUGF(3, "side result: %.8f", side);
-		POSTGIS_DEBUGF(3, "counterclockwise wrap %d, clockwise wrap %d", FP_CONTAINS_BOTTOM(seg1.y,point->y,seg2.y), FP_CONTAINS_BOTTOM(seg2.y,point->y,seg1.y));
-
-		/* zero length segments are ignored. */
-		if (((seg2.x-seg1.x)*(seg2.x-seg1.x)+(seg2.y-seg1.y)*(seg2.y-seg1.y)) < 1e-12*1e-12)
-		{
-			POSTGIS_DEBUG(3, "segment is zero length... ignoring.");
-
-			continue;
-		}
-
-		/* a point on the boundary of a ring is not contained. */
-		/* WAS: if (fabs(side) < 1e-12), see #852 */
-		if (side == 0.0)
-		{
-			if (isOnSegment(&seg1, &seg2, point) == 1)
-			{
-				POSTGIS_DEBUGF(3, "point on ring boundary between points %d, %d", i, i+1);
+		POSTGIS_DEBUG(3, "point on ring boundary");
 
-				return 0;
-			}
-		}
-
-		/*
-		 * If the point is to the left of the line, and it's rising,
-		 * then the line is to the right of the point and
-		 * circling counter-clockwise, so incremement.
-		 */
-		if (FP_CONTAINS_BOTTOM(seg1.y,point->y,seg2.y) && side>0)
-		{
-			POSTGIS_DEBUG(3, "incrementing winding number.");
-
-			++wn;
-		}
-		/*
-		 * If the point is to the right of the line, and it's falling,
-		 * then the line is to the right of the point and circling
-		 * clockwise, so decrement.
-		 */
-		else if (FP_CONTAINS_BOTTOM(seg2.y,point->y,seg1.y) && side<0)
-		{
-			POSTGIS_DEBUG(3, "decrementing winding number.");
-
-			--wn;
-		}
+		return 0;
 	}
 
 	POSTGIS_DEBUGF(3, "winding number %d", wn);
@@ -946,6 +888,78 @@ int point_in_multipolygon_rtree(RTREE_NODE **root, int polyCount, int *ringCount
 
 }
 
+/*
+ * Batched version of point_in_multipolygon_rtree, tests npoints points
+ * against the same polygon index and sets results[i] for each of them:
+ *
+ * -1 if point outside polygon
+ * 0 if point on boundary
+ * 1 if point inside polygon
+ *
+ * Rings are visited in the outer loop, so each ring tree is walked for all
+ * the points in a row while it is hot in the CPU cache.
+ */
+void point_in_multipolygon_rtree_batch(RTREE_NODE **root, int polyCount, int *ringCounts, POINT2D *pts, int npoints, int *results)
+{
+	int i, p, r, k, in_ring, result;
+	char *done;
+
+	POSTGIS_DEBUGF(2, "point_in_multipolygon_rtree_batch called for %p %d, %d points.", root, polyCount, npoints);
+
+	done = lwalloc(npoints);
+	for ( k = 0; k < npoints; k++ )
+	{
+		results[k] = -1;
+		done[k] = LW_FALSE;
+	}
+
+	i = 0; /* the current index into the root array */
+	for ( p = 0; p < polyCount; p++ )
+	{
+		for ( k = 0; k < npoints; k++ )
+		{
+			if ( done[k] )
+				continue;
+
+			in_ring = point_in_ring_rtree(root[i], &pts[k]);
+			if ( in_ring == -1 ) /* outside the exterior ring */
+				continue;
+
+			if ( in_ring == 0 ) /* on the boundary */
+			{
+				results[k] = 0;
+				done[k] = LW_TRUE;
+				continue;
+			}
+
+			result = 1;
+			for ( r = 1; r < ringCounts[p]; r++ )
+			{
+				in_ring = point_in_ring_rtree(root[i+r], &pts[k]);
+				if ( in_ring == 1 ) /* inside a hole => outside the polygon */
+				{
+					result = -1;
+					break;
+				}
+				if ( in_ring == 0 ) /* on the edge of a hole */
+				{
+					result = 0;
+					break;
+				}
+			}
+
+			if ( result != -1 )
+			{
+				results[k] = result;
+				done[k] = LW_TRUE;
+			}
+		}
+		i += ringCounts[p];
+	}
+
+	lwfree(done);
+}
+
 /*
  * return -1 iff point outside polygon
  * return 0 iff point on boundary
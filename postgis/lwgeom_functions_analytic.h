@@ -17,6 +17,7 @@
 
 int point_in_polygon_rtree(RTREE_NODE **root, int ringCount, LWPOINT *point);
 int point_in_multipolygon_rtree(RTREE_NODE **root, int polyCount, int *ringCounts, LWPOINT *point);
+void point_in_multipolygon_rtree_batch(RTREE_NODE **root, int polyCount, int *ringCounts, POINT2D *pts, int npoints, int *results);
 int point_in_polygon(LWPOLY *polygon, LWPOINT *point);
 int point_in_multipolygon(LWMPOLY *mpolygon, LWPOINT *pont);
 
@@ -11,6 +11,7 @@
 
 #include "postgres.h"
 #include "fmgr.h"
+#include "funcapi.h"
 #include "utils/elog.h"
 #include "utils/array.h"
 #include "utils/geo_decls.h"
@@ -18,6 +19,8 @@
 #include "../postgis_config.h"
 #include "liblwgeom.h"
 #include "lwgeom_pg.h"
+#include "lwgeom_cache.h"
+#include "lwgeom_rectree.h"
 
 #include <math.h>
 #include <float.h>
@@ -38,6 +41,8 @@ Datum postgis_lib_version(PG_FUNCTION_ARGS);
 Datum postgis_svn_version(PG_FUNCTION_ARGS);
 Datum postgis_libxml_version(PG_FUNCTION_ARGS);
 Datum postgis_lib_build_date(PG_FUNCTION_ARGS);
+Datum postgis_cache_stats(PG_FUNCTION_ARGS);
+Datum postgis_cache_stats_reset(PG_FUNCTION_ARGS);
 Datum LWGEOM_length2d_linestring(PG_FUNCTION_ARGS);
 Datum LWGEOM_length_linestring(PG_FUNCTION_ARGS);
 Datum LWGEOM_perimeter2d_poly(PG_FUNCTION_ARGS);
@@ -206,16 +211,89 @@ Datum postgis_libxml_version(PG_FUNCTION_ARGS)
 	PG_RETURN_TEXT_P(result);
 }
 
+/*
+* Geometry caches reported by postgis_cache_stats(), in
+* entry number order.
+*/
+static const struct
+{
+	int entry_number;
+	const char *name;
+} geom_cache_names[] =
+{
+	{ PREP_CACHE_ENTRY, "prepared" },
+	{ RTREE_CACHE_ENTRY, "rtree" },
+	{ CIRC_CACHE_ENTRY, "circ" },
+	{ RECT_CACHE_ENTRY, "rect" }
+};
+
+/**
+* Report the per-backend usage counters of the geometry caches,
+* one row per kind of cache.
+*/
+PG_FUNCTION_INFO_V1(postgis_cache_stats);
+Datum postgis_cache_stats(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	const GeomCacheStats *stats;
+	Datum values[7];
+	bool nulls[7] = {0,0,0,0,0,0,0};
+	HeapTuple tuple;
+	int i;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, 0, &tupdesc) != TYPEFUNC_COMPOSITE)
+		{
+			ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				errmsg("function returning record called in context that cannot accept type record")));
+		}
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+		funcctx->max_calls = sizeof(geom_cache_names) / sizeof(geom_cache_names[0]);
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	if (funcctx->call_cntr >= funcctx->max_calls)
+		SRF_RETURN_DONE(funcctx);
+
+	i = funcctx->call_cntr;
+	stats = GetGeomCacheStats(geom_cache_names[i].entry_number);
+
+	values[0] = PointerGetDatum(cstring2text(geom_cache_names[i].name));
+	values[1] = Int64GetDatum(stats->hits);
+	values[2] = Int64GetDatum(stats->misses);
+	values[3] = Int64GetDatum(stats->builds);
+	values[4] = Int64GetDatum(stats->flips);
+	values[5] = Int64GetDatum(stats->evictions);
+	values[6] = Float8GetDatum(stats->build_time);
+
+	tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+	SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+}
+
+PG_FUNCTION_INFO_V1(postgis_cache_stats_reset);
+Datum postgis_cache_stats_reset(PG_FUNCTION_ARGS)
+{
+	ResetGeomCacheStats();
+	PG_RETURN_VOID();
+}
+
 /** number of points in an object */
 PG_FUNCTION_INFO_V1(LWGEOM_npoints);
 Datum LWGEOM_npoints(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
 	int npoints = 0;
 
-	npoints = lwgeom_count_vertices(lwgeom);
-	lwgeom_free(lwgeom);
+	npoints = gserialized_peek_npoints(geom);
 
 	PG_FREE_IF_COPY(geom, 0);
 	PG_RETURN_INT32(npoints);
@@ -226,11 +304,9 @@ PG_FUNCTION_INFO_V1(LWGEOM_nrings);
 Datum LWGEOM_nrings(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
 	int nrings = 0;
 
-	nrings = lwgeom_count_rings(lwgeom);
-	lwgeom_free(lwgeom);
+	nrings = gserialized_peek_nrings(geom);
 
 	PG_FREE_IF_COPY(geom, 0);
 	PG_RETURN_INT32(nrings);
@@ -589,10 +665,15 @@ Datum LWGEOM_closestpoint(PG_FUNCTION_ARGS)
 	LWGEOM *point;
 	LWGEOM *lwgeom1 = lwgeom_from_gserialized(geom1);
 	LWGEOM *lwgeom2 = lwgeom_from_gserialized(geom2);
+	DISTPTS dl;
 
 	error_if_srid_mismatch(lwgeom1->srid, lwgeom2->srid);
 
-	point = lwgeom_closest_point(lwgeom1, lwgeom2);
+	lw_dist2d_distpts_init(&dl, DIST_MIN);
+	if ( geometry_distance_cache(fcinfo, geom1, lwgeom1, geom2, lwgeom2, &dl) == LW_SUCCESS )
+		point = lwpoint_as_lwgeom(lwpoint_make2d(lwgeom1->srid, dl.p1.x, dl.p1.y));
+	else
+		point = lwgeom_closest_point(lwgeom1, lwgeom2);
 
 	if (lwgeom_is_empty(point))
 		PG_RETURN_NULL();
@@ -619,10 +700,20 @@ Datum LWGEOM_shortestline2d(PG_FUNCTION_ARGS)
 	LWGEOM *theline;
 	LWGEOM *lwgeom1 = lwgeom_from_gserialized(geom1);
 	LWGEOM *lwgeom2 = lwgeom_from_gserialized(geom2);
+	DISTPTS dl;
 
 	error_if_srid_mismatch(lwgeom1->srid, lwgeom2->srid);
 
-	theline = lwgeom_closest_line(lwgeom1, lwgeom2);
+	lw_dist2d_distpts_init(&dl, DIST_MIN);
+	if ( geometry_distance_cache(fcinfo, geom1, lwgeom1, geom2, lwgeom2, &dl) == LW_SUCCESS )
+	{
+		LWPOINT *points[2];
+		points[0] = lwpoint_make2d(lwgeom1->srid, dl.p1.x, dl.p1.y);
+		points[1] = lwpoint_make2d(lwgeom1->srid, dl.p2.x, dl.p2.y);
+		theline = lwline_as_lwgeom(lwline_from_ptarray(lwgeom1->srid, 2, points));
+	}
+	else
+		theline = lwgeom_closest_line(lwgeom1, lwgeom2);
 	
 	if (lwgeom_is_empty(theline))
 		PG_RETURN_NULL();	
@@ -677,10 +768,16 @@ Datum LWGEOM_mindistance2d(PG_FUNCTION_ARGS)
 	GSERIALIZED *geom2 = PG_GETARG_GSERIALIZED_P(1);
 	LWGEOM *lwgeom1 = lwgeom_from_gserialized(geom1);
 	LWGEOM *lwgeom2 = lwgeom_from_gserialized(geom2);
+	DISTPTS dl;
 
 	error_if_srid_mismatch(lwgeom1->srid, lwgeom2->srid);
 
-	mindist = lwgeom_mindistance2d(lwgeom1, lwgeom2);
+	/* Big geometries measured again and again keep their edge tree */
+	lw_dist2d_distpts_init(&dl, DIST_MIN);
+	if ( geometry_distance_cache(fcinfo, geom1, lwgeom1, geom2, lwgeom2, &dl) == LW_SUCCESS )
+		mindist = dl.distance;
+	else
+		mindist = lwgeom_mindistance2d(lwgeom1, lwgeom2);
 
 	lwgeom_free(lwgeom1);
 	lwgeom_free(lwgeom2);
@@ -703,12 +800,13 @@ geom1 and geom2 is shorter than tolerance
 PG_FUNCTION_INFO_V1(LWGEOM_dwithin);
 Datum LWGEOM_dwithin(PG_FUNCTION_ARGS)
 {
-	double mindist;
+	int dwithin;
 	GSERIALIZED *geom1 = PG_GETARG_GSERIALIZED_P(0);
 	GSERIALIZED *geom2 = PG_GETARG_GSERIALIZED_P(1);
 	double tolerance = PG_GETARG_FLOAT8(2);	
 	LWGEOM *lwgeom1 = lwgeom_from_gserialized(geom1);
 	LWGEOM *lwgeom2 = lwgeom_from_gserialized(geom2);
+	DISTPTS dl;
 
 	if ( tolerance < 0 )
 	{
@@ -718,13 +816,17 @@ Datum LWGEOM_dwithin(PG_FUNCTION_ARGS)
 
 	error_if_srid_mismatch(lwgeom1->srid, lwgeom2->srid);
 
-	mindist = lwgeom_mindistance2d_tolerance(lwgeom1,lwgeom2,tolerance);
+	/* Only looking for a distance within the tolerance, not the minimum */
+	lw_dist2d_distpts_init_within(&dl, tolerance);
+	if ( geometry_distance_cache(fcinfo, geom1, lwgeom1, geom2, lwgeom2, &dl) == LW_SUCCESS )
+		dwithin = (dl.distance <= tolerance);
+	else
+		dwithin = lwgeom_dwithin2d(lwgeom1, lwgeom2, tolerance);
 
 	PG_FREE_IF_COPY(geom1, 0);
 	PG_FREE_IF_COPY(geom2, 1);
-	/*empty geometries cases should be right handled since return from underlying
-	 functions should be FLT_MAX which causes false as answer*/
-	PG_RETURN_BOOL(tolerance >= mindist);
+	/*empty geometries have no distance within the tolerance, the answer is false*/
+	PG_RETURN_BOOL(dwithin);
 }
 
 /**
@@ -1749,11 +1851,9 @@ Datum LWGEOM_envelope(PG_FUNCTION_ARGS)
 PG_FUNCTION_INFO_V1(LWGEOM_isempty);
 Datum LWGEOM_isempty(PG_FUNCTION_ARGS)
 {
-	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
-	bool empty = lwgeom_is_empty(lwgeom);
+	GSERIALIZED *geom = gserialized_datum_get_header(PG_GETARG_DATUM(0));
+	bool empty = gserialized_header_is_empty(geom, PG_GETARG_DATUM(0));
 
-	lwgeom_free(lwgeom);
 	PG_FREE_IF_COPY(geom, 0);
 	PG_RETURN_BOOL(empty);
 }
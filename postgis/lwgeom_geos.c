@@ -1738,6 +1738,66 @@ void errorIfGeometryCollection(GSERIALIZED *g1, GSERIALIZED *g2)
 	}
 }
 
+/* Returned by predicate_args when the answer needs the coordinates */
+#define PREDICATE_UNDECIDED -1
+
+/* What settles a predicate with an empty argument */
+typedef enum
+{
+	PREDICATE_EMPTY_EITHER,	/* either argument empty */
+	PREDICATE_EMPTY_BOTH	/* both arguments empty */
+} predicate_empty;
+
+static int gbox_within_2d(const GBOX *g1, const GBOX *g2)
+{
+	return gbox_contains_2d(g2, g1);
+}
+
+/*
+* The steps the binary predicates share before calling GEOS, on the
+* fronts of the arguments fetched with gserialized_datum_get_header so
+* that large geometries are not detoasted for them: the argument
+* checks, then if_empty when the arguments are empty as the empty rule
+* says, then if_box_fails when both have a box and box_test(box1, box2)
+* is false. A collection is fetched whole, only to be quoted in the
+* error. When none of them settles it, returns PREDICATE_UNDECIDED with
+* geom1 and geom2 set to the whole arguments, the fronts freed.
+*/
+static int predicate_args(FunctionCallInfo fcinfo, GSERIALIZED **geom1, GSERIALIZED **geom2,
+                          predicate_empty empty, int if_empty,
+                          int (*box_test)(const GBOX *, const GBOX *), int if_box_fails)
+{
+	GSERIALIZED *header1 = gserialized_datum_get_header(PG_GETARG_DATUM(0));
+	GSERIALIZED *header2 = gserialized_datum_get_header(PG_GETARG_DATUM(1));
+	int empty1, empty2;
+	GBOX box1, box2;
+
+	if ( gserialized_get_type(header1) == COLLECTIONTYPE || gserialized_get_type(header2) == COLLECTIONTYPE )
+		errorIfGeometryCollection(PG_GETARG_GSERIALIZED_P(0), PG_GETARG_GSERIALIZED_P(1));
+
+	error_if_srid_mismatch(gserialized_get_srid(header1), gserialized_get_srid(header2));
+
+	empty1 = gserialized_header_is_empty(header1, PG_GETARG_DATUM(0));
+	empty2 = gserialized_header_is_empty(header2, PG_GETARG_DATUM(1));
+	if ( empty == PREDICATE_EMPTY_EITHER ? (empty1 || empty2) : (empty1 && empty2) )
+		return if_empty;
+
+	if ( gserialized_header_get_gbox_p(header1, PG_GETARG_DATUM(0), &box1) &&
+	     gserialized_header_get_gbox_p(header2, PG_GETARG_DATUM(1), &box2) &&
+	     ! box_test(&box1, &box2) )
+		return if_box_fails;
+
+	/* Past the box test, the coordinates are needed */
+	*geom1 = gserialized_header_detoast(header1, PG_GETARG_DATUM(0));
+	if ( *geom1 != header1 )
+		pfree(header1);
+	*geom2 = gserialized_header_detoast(header2, PG_GETARG_DATUM(1));
+	if ( *geom2 != header2 )
+		pfree(header2);
+
+	return PREDICATE_UNDECIDED;
+}
+
 PG_FUNCTION_INFO_V1(isvalid);
 Datum isvalid(PG_FUNCTION_ARGS)
 {
@@ -1982,31 +2042,12 @@ Datum overlaps(PG_FUNCTION_ARGS)
 	GSERIALIZED *geom2;
 	GEOSGeometry *g1, *g2;
 	bool result;
-	GBOX box1, box2;
-
-	geom1 = PG_GETARG_GSERIALIZED_P(0);
-	geom2 = PG_GETARG_GSERIALIZED_P(1);
+	int decided;
 
-	errorIfGeometryCollection(geom1,geom2);
-	error_if_srid_mismatch(gserialized_get_srid(geom1), gserialized_get_srid(geom2));
-
-	/* A.Overlaps(Empty) == FALSE */
-	if ( gserialized_is_empty(geom1) || gserialized_is_empty(geom2) )
-		PG_RETURN_BOOL(false);
-
-	/*
-	 * short-circuit 1: if geom2 bounding box does not overlap
-	 * geom1 bounding box we can prematurely return FALSE.
-	 * Do the test IFF BOUNDING BOX AVAILABLE.
-	 */
-	if ( gserialized_get_gbox_p(geom1, &box1) &&
-	        gserialized_get_gbox_p(geom2, &box2) )
-	{
-		if ( ! gbox_overlaps_2d(&box1, &box2) )
-		{
-			PG_RETURN_BOOL(FALSE);
-		}
-	}
+	/* A.Overlaps(Empty) == FALSE, and if the bounding boxes do not overlap, FALSE */
+	decided = predicate_args(fcinfo, &geom1, &geom2, PREDICATE_EMPTY_EITHER, LW_FALSE, gbox_overlaps_2d, LW_FALSE);
+	if ( decided != PREDICATE_UNDECIDED )
+		PG_RETURN_BOOL(decided);
 
 	initGEOS(lwpgnotice, lwgeom_geos_error);
 
@@ -2043,13 +2084,46 @@ Datum overlaps(PG_FUNCTION_ARGS)
 }
 
 
+/*
+ * Test all the points of a multipoint against a cached polygon index in
+ * one batch. Fills counts[] with the number of points outside (counts[0]),
+ * on the boundary (counts[1]) and inside (counts[2]) the polygon.
+ */
+static void
+pip_multipoint_rtree(RTREE_POLY_CACHE *poly_cache, GSERIALIZED *gser_mpoint, int counts[3])
+{
+	LWMPOINT *mpoint = lwgeom_as_lwmpoint(lwgeom_from_gserialized(gser_mpoint));
+	POINT2D *pts = palloc(sizeof(POINT2D) * mpoint->ngeoms);
+	int *results = palloc(sizeof(int) * mpoint->ngeoms);
+	int i, npoints = 0;
+
+	for ( i = 0; i < mpoint->ngeoms; i++ )
+	{
+		/* Skip empty points */
+		if ( lwpoint_is_empty(mpoint->geoms[i]) )
+			continue;
+		getPoint2d_p(mpoint->geoms[i]->point, 0, &pts[npoints++]);
+	}
+
+	point_in_multipolygon_rtree_batch(poly_cache->ringIndices, poly_cache->polyCount,
+	                                  poly_cache->ringCounts, pts, npoints, results);
+
+	counts[0] = counts[1] = counts[2] = 0;
+	for ( i = 0; i < npoints; i++ )
+		counts[results[i] + 1]++;
+
+	pfree(results);
+	pfree(pts);
+	lwmpoint_free(mpoint);
+}
+
 PG_FUNCTION_INFO_V1(contains);
 Datum contains(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom1;
 	GSERIALIZED *geom2;
 	GEOSGeometry *g1, *g2;
-	GBOX box1, box2;
+	int decided;
 	int type1, type2;
 	LWGEOM *lwgeom;
 	LWPOINT *point;
@@ -2057,31 +2131,12 @@ Datum contains(PG_FUNCTION_ARGS)
 	int result;
 	PrepGeomCache *prep_cache;
 
-	geom1 = PG_GETARG_GSERIALIZED_P(0);
-	geom2 = PG_GETARG_GSERIALIZED_P(1);
-
-	errorIfGeometryCollection(geom1,geom2);
-	error_if_srid_mismatch(gserialized_get_srid(geom1), gserialized_get_srid(geom2));
-
-	/* A.Contains(Empty) == FALSE */
-	if ( gserialized_is_empty(geom1) || gserialized_is_empty(geom2) )
-		PG_RETURN_BOOL(false);
-
 	POSTGIS_DEBUG(3, "contains called.");
 
-	/*
-	** short-circuit 1: if geom2 bounding box is not completely inside
-	** geom1 bounding box we can prematurely return FALSE.
-	** Do the test IFF BOUNDING BOX AVAILABLE.
-	*/
-	if ( gserialized_get_gbox_p(geom1, &box1) &&
-	        gserialized_get_gbox_p(geom2, &box2) )
-	{
-		if ( ! gbox_contains_2d(&box1, &box2) )
-		{
-			PG_RETURN_BOOL(FALSE);
-		}
-	}
+	/* A.Contains(Empty) == FALSE, and if the geom2 box is not completely inside the geom1 box, FALSE */
+	decided = predicate_args(fcinfo, &geom1, &geom2, PREDICATE_EMPTY_EITHER, LW_FALSE, gbox_contains_2d, LW_FALSE);
+	if ( decided != PREDICATE_UNDECIDED )
+		PG_RETURN_BOOL(decided);
 
 	/*
 	** short-circuit 2: if geom2 is a point and geom1 is a polygon
@@ -2135,6 +2190,25 @@ Datum contains(PG_FUNCTION_ARGS)
 		POSTGIS_DEBUGF(3, "Contains: type1: %d, type2: %d", type1, type2);
 	}
 
+	/*
+	** short-circuit 3: if geom2 is a multipoint and geom1 is a polygon
+	** with a cached index, test all the points in one batch.
+	** Contained if no point is outside and at least one is inside.
+	*/
+	if ((type1 == POLYGONTYPE || type1 == MULTIPOLYGONTYPE) && type2 == MULTIPOINTTYPE)
+	{
+		int counts[3];
+
+		poly_cache = GetRtreeCache(fcinfo, geom1);
+		if ( poly_cache && poly_cache->ringIndices )
+		{
+			pip_multipoint_rtree(poly_cache, geom2, counts);
+			PG_FREE_IF_COPY(geom1, 0);
+			PG_FREE_IF_COPY(geom2, 1);
+			PG_RETURN_BOOL(counts[0] == 0 && counts[2] > 0);
+		}
+	}
+
 	initGEOS(lwpgnotice, lwgeom_geos_error);
 
 	prep_cache = GetPrepGeomCache( fcinfo, geom1, 0 );
@@ -2191,30 +2265,13 @@ Datum containsproperly(PG_FUNCTION_ARGS)
 	GSERIALIZED *				geom1;
 	GSERIALIZED *				geom2;
 	bool 					result;
-	GBOX 			box1, box2;
+	int 					decided;
 	PrepGeomCache *	prep_cache;
 
-	geom1 = PG_GETARG_GSERIALIZED_P(0);
-	geom2 = PG_GETARG_GSERIALIZED_P(1);
-
-	errorIfGeometryCollection(geom1,geom2);
-	error_if_srid_mismatch(gserialized_get_srid(geom1), gserialized_get_srid(geom2));
-
-	/* A.ContainsProperly(Empty) == FALSE */
-	if ( gserialized_is_empty(geom1) || gserialized_is_empty(geom2) )
-		PG_RETURN_BOOL(false);
-
-	/*
-	* short-circuit: if geom2 bounding box is not completely inside
-	* geom1 bounding box we can prematurely return FALSE.
-	* Do the test IFF BOUNDING BOX AVAILABLE.
-	*/
-	if ( gserialized_get_gbox_p(geom1, &box1) &&
-	        gserialized_get_gbox_p(geom2, &box2) )
-	{
-		if ( ! gbox_contains_2d(&box1, &box2) )
-			PG_RETURN_BOOL(FALSE);
-	}
+	/* A.ContainsProperly(Empty) == FALSE, and if the geom2 box is not completely inside the geom1 box, FALSE */
+	decided = predicate_args(fcinfo, &geom1, &geom2, PREDICATE_EMPTY_EITHER, LW_FALSE, gbox_contains_2d, LW_FALSE);
+	if ( decided != PREDICATE_UNDECIDED )
+		PG_RETURN_BOOL(decided);
 
 	initGEOS(lwpgnotice, lwgeom_geos_error);
 
@@ -2276,36 +2333,18 @@ Datum covers(PG_FUNCTION_ARGS)
 	GSERIALIZED *geom1;
 	GSERIALIZED *geom2;
 	int result;
-	GBOX box1, box2;
+	int decided;
 	int type1, type2;
 	LWGEOM *lwgeom;
 	LWPOINT *point;
 	RTREE_POLY_CACHE *poly_cache;
 	PrepGeomCache *prep_cache;
 
-	geom1 = PG_GETARG_GSERIALIZED_P(0);
-	geom2 = PG_GETARG_GSERIALIZED_P(1);
-
-	/* A.Covers(Empty) == FALSE */
-	if ( gserialized_is_empty(geom1) || gserialized_is_empty(geom2) )
-		PG_RETURN_BOOL(false);
-
-	errorIfGeometryCollection(geom1,geom2);
-	error_if_srid_mismatch(gserialized_get_srid(geom1), gserialized_get_srid(geom2));
+	/* A.Covers(Empty) == FALSE, and if the geom2 box is not completely inside the geom1 box, FALSE */
+	decided = predicate_args(fcinfo, &geom1, &geom2, PREDICATE_EMPTY_EITHER, LW_FALSE, gbox_contains_2d, LW_FALSE);
+	if ( decided != PREDICATE_UNDECIDED )
+		PG_RETURN_BOOL(decided);
 
-	/*
-	 * short-circuit 1: if geom2 bounding box is not completely inside
-	 * geom1 bounding box we can prematurely return FALSE.
-	 * Do the test IFF BOUNDING BOX AVAILABLE.
-	 */
-	if ( gserialized_get_gbox_p(geom1, &box1) &&
-	        gserialized_get_gbox_p(geom2, &box2) )
-	{
-		if ( ! gbox_contains_2d(&box1, &box2) )
-		{
-			PG_RETURN_BOOL(FALSE);
-		}
-	}
 	/*
 	 * short-circuit 2: if geom2 is a point and geom1 is a polygon
 	 * call the point-in-polygon function.
@@ -2360,6 +2399,25 @@ Datum covers(PG_FUNCTION_ARGS)
 		POSTGIS_DEBUGF(3, "Covers: type1: %d, type2: %d", type1, type2);
 	}
 
+	/*
+	 * short-circuit 3: if geom2 is a multipoint and geom1 is a polygon
+	 * with a cached index, test all the points in one batch.
+	 * Covered if no point is outside.
+	 */
+	if ((type1 == POLYGONTYPE || type1 == MULTIPOLYGONTYPE) && type2 == MULTIPOINTTYPE)
+	{
+		int counts[3];
+
+		poly_cache = GetRtreeCache(fcinfo, geom1);
+		if ( poly_cache && poly_cache->ringIndices )
+		{
+			pip_multipoint_rtree(poly_cache, geom2, counts);
+			PG_FREE_IF_COPY(geom1, 0);
+			PG_FREE_IF_COPY(geom2, 1);
+			PG_RETURN_BOOL(counts[0] == 0);
+		}
+	}
+
 	initGEOS(lwpgnotice, lwgeom_geos_error);
 
 	prep_cache = GetPrepGeomCache( fcinfo, geom1, 0 );
@@ -2430,38 +2488,18 @@ Datum coveredby(PG_FUNCTION_ARGS)
 	GSERIALIZED *geom2;
 	GEOSGeometry *g1, *g2;
 	int result;
-	GBOX box1, box2;
+	int decided;
 	LWGEOM *lwgeom;
 	LWPOINT *point;
 	int type1, type2;
 	RTREE_POLY_CACHE *poly_cache;
 	char *patt = "**F**F***";
 
-	geom1 = PG_GETARG_GSERIALIZED_P(0);
-	geom2 = PG_GETARG_GSERIALIZED_P(1);
-
-	errorIfGeometryCollection(geom1,geom2);
-	error_if_srid_mismatch(gserialized_get_srid(geom1), gserialized_get_srid(geom2));
-
-	/* A.CoveredBy(Empty) == FALSE */
-	if ( gserialized_is_empty(geom1) || gserialized_is_empty(geom2) )
-		PG_RETURN_BOOL(false);
+	/* A.CoveredBy(Empty) == FALSE, and if the geom1 box is not completely inside the geom2 box, FALSE */
+	decided = predicate_args(fcinfo, &geom1, &geom2, PREDICATE_EMPTY_EITHER, LW_FALSE, gbox_within_2d, LW_FALSE);
+	if ( decided != PREDICATE_UNDECIDED )
+		PG_RETURN_BOOL(decided);
 
-	/*
-	 * short-circuit 1: if geom1 bounding box is not completely inside
-	 * geom2 bounding box we can prematurely return FALSE.
-	 * Do the test IFF BOUNDING BOX AVAILABLE.
-	 */
-	if ( gserialized_get_gbox_p(geom1, &box1) &&
-	        gserialized_get_gbox_p(geom2, &box2) )
-	{
-		if ( ! gbox_contains_2d(&box2, &box1) )
-		{
-			PG_RETURN_BOOL(FALSE);
-		}
-
-		POSTGIS_DEBUG(3, "bounding box short-circuit missed.");
-	}
 	/*
 	 * short-circuit 2: if geom1 is a point and geom2 is a polygon
 	 * call the point-in-polygon function.
@@ -2555,31 +2593,12 @@ Datum crosses(PG_FUNCTION_ARGS)
 	GSERIALIZED *geom2;
 	GEOSGeometry *g1, *g2;
 	int result;
-	GBOX box1, box2;
-
-	geom1 = PG_GETARG_GSERIALIZED_P(0);
-	geom2 = PG_GETARG_GSERIALIZED_P(1);
+	int decided;
 
-	errorIfGeometryCollection(geom1,geom2);
-	error_if_srid_mismatch(gserialized_get_srid(geom1), gserialized_get_srid(geom2));
-
-	/* A.Crosses(Empty) == FALSE */
-	if ( gserialized_is_empty(geom1) || gserialized_is_empty(geom2) )
-		PG_RETURN_BOOL(false);
-
-	/*
-	 * short-circuit 1: if geom2 bounding box does not overlap
-	 * geom1 bounding box we can prematurely return FALSE.
-	 * Do the test IFF BOUNDING BOX AVAILABLE.
-	 */
-	if ( gserialized_get_gbox_p(geom1, &box1) &&
-	        gserialized_get_gbox_p(geom2, &box2) )
-	{
-		if ( gbox_overlaps_2d(&box1, &box2) == LW_FALSE )
-		{
-			PG_RETURN_BOOL(FALSE);
-		}
-	}
+	/* A.Crosses(Empty) == FALSE, and if the bounding boxes do not overlap, FALSE */
+	decided = predicate_args(fcinfo, &geom1, &geom2, PREDICATE_EMPTY_EITHER, LW_FALSE, gbox_overlaps_2d, LW_FALSE);
+	if ( decided != PREDICATE_UNDECIDED )
+		PG_RETURN_BOOL(decided);
 
 	initGEOS(lwpgnotice, lwgeom_geos_error);
 
@@ -2623,36 +2642,17 @@ Datum geos_intersects(PG_FUNCTION_ARGS)
 	GSERIALIZED *geom2;
 	GSERIALIZED *serialized_poly;
 	int result;
-	GBOX box1, box2;
+	int decided;
 	int type1, type2, polytype;
 	LWPOINT *point;
 	LWGEOM *lwgeom;
 	RTREE_POLY_CACHE *poly_cache;
 	PrepGeomCache *prep_cache;
 
-	geom1 = PG_GETARG_GSERIALIZED_P(0);
-	geom2 = PG_GETARG_GSERIALIZED_P(1);
-
-	errorIfGeometryCollection(geom1,geom2);
-	error_if_srid_mismatch(gserialized_get_srid(geom1), gserialized_get_srid(geom2));
-
-	/* A.Intersects(Empty) == FALSE */
-	if ( gserialized_is_empty(geom1) || gserialized_is_empty(geom2) )
-		PG_RETURN_BOOL(false);
-
-	/*
-	 * short-circuit 1: if geom2 bounding box does not overlap
-	 * geom1 bounding box we can prematurely return FALSE.
-	 * Do the test IFF BOUNDING BOX AVAILABLE.
-	 */
-	if ( gserialized_get_gbox_p(geom1, &box1) &&
-	        gserialized_get_gbox_p(geom2, &box2) )
-	{
-		if ( gbox_overlaps_2d(&box1, &box2) == LW_FALSE )
-		{
-			PG_RETURN_BOOL(FALSE);
-		}
-	}
+	/* A.Intersects(Empty) == FALSE, and if the bounding boxes do not overlap, FALSE */
+	decided = predicate_args(fcinfo, &geom1, &geom2, PREDICATE_EMPTY_EITHER, LW_FALSE, gbox_overlaps_2d, LW_FALSE);
+	if ( decided != PREDICATE_UNDECIDED )
+		PG_RETURN_BOOL(decided);
 
 	/*
 	 * short-circuit 2: if the geoms are a point and a polygon,
@@ -2715,6 +2715,28 @@ Datum geos_intersects(PG_FUNCTION_ARGS)
 		}
 	}
 
+	/*
+	 * short-circuit 3: if the geoms are a multipoint and a polygon with a
+	 * cached index, test all the points in one batch.
+	 * Intersecting if any point is not outside.
+	 */
+	if ( (type1 == MULTIPOINTTYPE && (type2 == POLYGONTYPE || type2 == MULTIPOLYGONTYPE)) ||
+	        (type2 == MULTIPOINTTYPE && (type1 == POLYGONTYPE || type1 == MULTIPOLYGONTYPE)))
+	{
+		GSERIALIZED *serialized_mpoint = (type1 == MULTIPOINTTYPE) ? geom1 : geom2;
+		int counts[3];
+
+		serialized_poly = (type1 == MULTIPOINTTYPE) ? geom2 : geom1;
+		poly_cache = GetRtreeCache(fcinfo, serialized_poly);
+		if ( poly_cache && poly_cache->ringIndices )
+		{
+			pip_multipoint_rtree(poly_cache, serialized_mpoint, counts);
+			PG_FREE_IF_COPY(geom1, 0);
+			PG_FREE_IF_COPY(geom2, 1);
+			PG_RETURN_BOOL(counts[1] + counts[2] > 0);
+		}
+	}
+
 	initGEOS(lwpgnotice, lwgeom_geos_error);
 	prep_cache = GetPrepGeomCache( fcinfo, geom1, geom2 );
 
@@ -2785,31 +2807,12 @@ Datum touches(PG_FUNCTION_ARGS)
 	GSERIALIZED *geom2;
 	GEOSGeometry *g1, *g2;
 	bool result;
-	GBOX box1, box2;
-
-	geom1 = PG_GETARG_GSERIALIZED_P(0);
-	geom2 = PG_GETARG_GSERIALIZED_P(1);
+	int decided;
 
-	errorIfGeometryCollection(geom1,geom2);
-	error_if_srid_mismatch(gserialized_get_srid(geom1), gserialized_get_srid(geom2));
-
-	/* A.Touches(Empty) == FALSE */
-	if ( gserialized_is_empty(geom1) || gserialized_is_empty(geom2) )
-		PG_RETURN_BOOL(false);
-
-	/*
-	 * short-circuit 1: if geom2 bounding box does not overlap
-	 * geom1 bounding box we can prematurely return FALSE.
-	 * Do the test IFF BOUNDING BOX AVAILABLE.
-	 */
-	if ( gserialized_get_gbox_p(geom1, &box1) &&
-	        gserialized_get_gbox_p(geom2, &box2) )
-	{
-		if ( gbox_overlaps_2d(&box1, &box2) == LW_FALSE )
-		{
-			PG_RETURN_BOOL(FALSE);
-		}
-	}
+	/* A.Touches(Empty) == FALSE, and if the bounding boxes do not overlap, FALSE */
+	decided = predicate_args(fcinfo, &geom1, &geom2, PREDICATE_EMPTY_EITHER, LW_FALSE, gbox_overlaps_2d, LW_FALSE);
+	if ( decided != PREDICATE_UNDECIDED )
+		PG_RETURN_BOOL(decided);
 
 	initGEOS(lwpgnotice, lwgeom_geos_error);
 
@@ -2853,31 +2856,12 @@ Datum disjoint(PG_FUNCTION_ARGS)
 	GSERIALIZED *geom2;
 	GEOSGeometry *g1, *g2;
 	bool result;
-	GBOX box1, box2;
-
-	geom1 = PG_GETARG_GSERIALIZED_P(0);
-	geom2 = PG_GETARG_GSERIALIZED_P(1);
-
-	errorIfGeometryCollection(geom1,geom2);
-	error_if_srid_mismatch(gserialized_get_srid(geom1), gserialized_get_srid(geom2));
-
-	/* A.Disjoint(Empty) == TRUE */
-	if ( gserialized_is_empty(geom1) || gserialized_is_empty(geom2) )
-		PG_RETURN_BOOL(true);
+	int decided;
 
-	/*
-	 * short-circuit 1: if geom2 bounding box does not overlap
-	 * geom1 bounding box we can prematurely return TRUE.
-	 * Do the test IFF BOUNDING BOX AVAILABLE.
-	 */
-	if ( gserialized_get_gbox_p(geom1, &box1) &&
-	        gserialized_get_gbox_p(geom2, &box2) )
-	{
-		if ( gbox_overlaps_2d(&box1, &box2) == LW_FALSE )
-		{
-			PG_RETURN_BOOL(TRUE);
-		}
-	}
+	/* A.Disjoint(Empty) == TRUE, and if the bounding boxes do not overlap, TRUE */
+	decided = predicate_args(fcinfo, &geom1, &geom2, PREDICATE_EMPTY_EITHER, LW_TRUE, gbox_overlaps_2d, LW_TRUE);
+	if ( decided != PREDICATE_UNDECIDED )
+		PG_RETURN_BOOL(decided);
 
 	initGEOS(lwpgnotice, lwgeom_geos_error);
 
@@ -3072,30 +3056,12 @@ Datum ST_Equals(PG_FUNCTION_ARGS)
 	GSERIALIZED *geom2;
 	GEOSGeometry *g1, *g2;
 	bool result;
-	GBOX box1, box2;
+	int decided;
 
-	geom1 = PG_GETARG_GSERIALIZED_P(0);
-	geom2 = PG_GETARG_GSERIALIZED_P(1);
-
-	errorIfGeometryCollection(geom1,geom2);
-	error_if_srid_mismatch(gserialized_get_srid(geom1), gserialized_get_srid(geom2));
-
-	/* Empty == Empty */
-	if ( gserialized_is_empty(geom1) && gserialized_is_empty(geom2) )
-		PG_RETURN_BOOL(TRUE);
-
-	/*
-	 * short-circuit: If geom1 and geom2 do not have the same bounding box
-	 * we can return FALSE.
-	 */
-	if ( gserialized_get_gbox_p(geom1, &box1) &&
-	     gserialized_get_gbox_p(geom2, &box2) )
-	{
-		if ( gbox_same_2d_float(&box1, &box2) == LW_FALSE )
-		{
-			PG_RETURN_BOOL(FALSE);
-		}
-	}
+	/* Empty == Empty, and if the bounding boxes are not the same, FALSE */
+	decided = predicate_args(fcinfo, &geom1, &geom2, PREDICATE_EMPTY_BOTH, LW_TRUE, gbox_same_2d_float, LW_FALSE);
+	if ( decided != PREDICATE_UNDECIDED )
+		PG_RETURN_BOOL(decided);
 
 	initGEOS(lwpgnotice, lwgeom_geos_error);
 
@@ -349,7 +349,22 @@ Datum LWGEOMFromEWKB(PG_FUNCTION_ARGS)
 	GSERIALIZED *geom;
 	LWGEOM *lwgeom;
 	uint8_t *wkb = (uint8_t*)VARDATA(bytea_wkb);
+	size_t size = VARSIZE(bytea_wkb)-VARHDRSZ;
 	
+	/* Simple features go straight to the serialized form */
+	geom = gserialized_from_wkb(wkb, size, LW_PARSER_CHECK_ALL, &size);
+	if ( geom )
+	{
+		SET_VARSIZE(geom, size);
+		if (  ( PG_NARGS()>1) && ( ! PG_ARGISNULL(1) ))
+		{
+			srid = PG_GETARG_INT32(1);
+			gserialized_set_srid(geom, srid);
+		}
+		PG_FREE_IF_COPY(bytea_wkb, 0);
+		PG_RETURN_POINTER(geom);
+	}
+
 	lwgeom = lwgeom_from_wkb(wkb, VARSIZE(bytea_wkb)-VARHDRSZ, LW_PARSER_CHECK_ALL);
 	
 	if (  ( PG_NARGS()>1) && ( ! PG_ARGISNULL(1) ))
@@ -398,7 +413,6 @@ PG_FUNCTION_INFO_V1(WKBFromLWGEOM);
 Datum WKBFromLWGEOM(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
-	LWGEOM *lwgeom;
 	uint8_t *wkb;
 	size_t wkb_size;
 	uint8_t variant = 0;
@@ -419,12 +433,8 @@ Datum WKBFromLWGEOM(PG_FUNCTION_ARGS)
 			variant = variant | WKB_NDR;
 		}
 	}
-	wkb_size= VARSIZE(geom) - VARHDRSZ;
-	/* Create WKB hex string */
-	lwgeom = lwgeom_from_gserialized(geom);
-
-	wkb = lwgeom_to_wkb(lwgeom, variant | WKB_EXTENDED , &wkb_size);
-	lwgeom_free(lwgeom);
+	/* Write the WKB straight from the serialized form */
+	wkb = gserialized_to_wkb(geom, variant | WKB_EXTENDED , &wkb_size);
 	
 	/* Prepare the PgSQL text return type */
 	result = palloc(wkb_size + VARHDRSZ);
@@ -737,22 +747,70 @@ Datum LWGEOM_recv(PG_FUNCTION_ARGS)
 	int32 geom_typmod = -1;
 	GSERIALIZED *geom;
 	LWGEOM *lwgeom;
+	size_t size;
 
 	if ( (PG_NARGS()>2) && (!PG_ARGISNULL(2)) ) {
 		geom_typmod = PG_GETARG_INT32(2);
 	}
 	
-	lwgeom = lwgeom_from_wkb((uint8_t*)buf->data, buf->len, LW_PARSER_CHECK_ALL);
+	/* Another PostGIS may send the serialized form itself */
+	geom = gserialized_binary_recv(buf);
+	if ( geom )
+	{
+		GBOX gbox;
+		int have_box;
 
-	if ( lwgeom_needs_bbox(lwgeom) )
-		lwgeom_add_bbox(lwgeom);
+		/* A geography has a geocentric box, of another size */
+		if ( gserialized_is_geodetic(geom) )
+		{
+			geom = gserialized_drop_gbox(geom);
+			FLAGS_SET_GEODETIC(geom->flags, 0);
+		}
+
+		/*
+		* The box is not trusted, a stale or forged one would corrupt
+		* && results and index contents, so it gets computed again from
+		* a read-only view of the coordinates and written over the slot.
+		*/
+		lwgeom = lwgeom_from_gserialized(geom);
+		have_box = (lwgeom_calculate_gbox(lwgeom, &gbox) == LW_SUCCESS);
+		if ( have_box && ! gserialized_has_bbox(geom) && ! lwgeom_needs_bbox(lwgeom) )
+			have_box = LW_FALSE;
+		lwgeom_free(lwgeom);
+
+		if ( have_box )
+		{
+			GSERIALIZED *g_box = gserialized_set_gbox(geom, &gbox);
+			if ( g_box != geom )
+			{
+				pfree(geom);
+				geom = g_box;
+			}
+		}
+		else
+		{
+			geom = gserialized_drop_gbox(geom);
+		}
+	}
+	/* Simple features go straight to the serialized form */
+	else if ( (geom = gserialized_from_wkb((uint8_t*)buf->data, buf->len, LW_PARSER_CHECK_ALL, &size)) )
+	{
+		SET_VARSIZE(geom, size);
+	}
+	else
+	{
+		lwgeom = lwgeom_from_wkb((uint8_t*)buf->data, buf->len, LW_PARSER_CHECK_ALL);
+
+		if ( lwgeom_needs_bbox(lwgeom) )
+			lwgeom_add_bbox(lwgeom);
+
+		geom = geometry_serialize(lwgeom);
+		lwgeom_free(lwgeom);
+	}
 
 	/* Set cursor to the end of buffer (so the backend is happy) */
 	buf->cursor = buf->len;
 
-	geom = geometry_serialize(lwgeom);
-	lwgeom_free(lwgeom);
-
 	if ( geom_typmod >= 0 )
 	{
 		geom = postgis_valid_typmod(geom, geom_typmod);
@@ -774,6 +832,9 @@ Datum LWGEOM_send(PG_FUNCTION_ARGS)
 {
 	POSTGIS_DEBUG(2, "LWGEOM_send called");
 
+	if ( postgis_binary_format == POSTGIS_BINARY_FORMAT_NATIVE )
+		PG_RETURN_BYTEA_P(gserialized_binary_send(PG_GETARG_GSERIALIZED_P(0)));
+
 	PG_RETURN_POINTER(
 	  DatumGetPointer(
 	    DirectFunctionCall1(
@@ -81,7 +81,7 @@ Datum LWGEOM_isclosed(PG_FUNCTION_ARGS);
 PG_FUNCTION_INFO_V1(LWGEOM_get_srid);
 Datum LWGEOM_get_srid(PG_FUNCTION_ARGS)
 {
-	GSERIALIZED *geom=PG_GETARG_GSERIALIZED_P(0);
+	GSERIALIZED *geom = gserialized_datum_get_header(PG_GETARG_DATUM(0));
 	int srid = gserialized_get_srid (geom);
 	PG_FREE_IF_COPY(geom,0);
 	PG_RETURN_INT32(srid);
@@ -107,7 +107,7 @@ Datum LWGEOM_getTYPE(PG_FUNCTION_ARGS)
 	uint8_t type;
 	static int maxtyplen = 20;
 
-	gser = PG_GETARG_GSERIALIZED_P_SLICE(0, 0, gserialized_max_header_size());
+	gser = gserialized_datum_get_header(PG_GETARG_DATUM(0));
 	text_ob = palloc0(VARHDRSZ + maxtyplen);
 	result = VARDATA(text_ob);
 
@@ -167,7 +167,7 @@ Datum geometry_geometrytype(PG_FUNCTION_ARGS)
 	char type_str[type_str_len];
 
 	/* Read just the header from the toasted tuple */
-	gser = PG_GETARG_GSERIALIZED_P_SLICE(0, 0, gserialized_max_header_size());
+	gser = gserialized_datum_get_header(PG_GETARG_DATUM(0));
 
 	/* Make it empty string to start */
 	type_str[0] = 0;
@@ -193,14 +193,12 @@ PG_FUNCTION_INFO_V1(LWGEOM_numpoints_linestring);
 Datum LWGEOM_numpoints_linestring(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
 	int count = -1;
-	int type = lwgeom->type;
+	int type = gserialized_get_type(geom);
 	
 	if ( type == LINETYPE || type == CIRCSTRINGTYPE || type == COMPOUNDTYPE )
-		count = lwgeom_count_vertices(lwgeom);
+		count = gserialized_peek_npoints(geom);
 
-	lwgeom_free(lwgeom);
 	PG_FREE_IF_COPY(geom, 0);
 
 	/* OGC says this functions is only valid on LINESTRING */
@@ -214,20 +212,16 @@ PG_FUNCTION_INFO_V1(LWGEOM_numgeometries_collection);
 Datum LWGEOM_numgeometries_collection(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
-	LWGEOM *lwgeom;
 	int32 ret = 1;
 
-	lwgeom = lwgeom_from_gserialized(geom);
-	if ( lwgeom_is_empty(lwgeom) )
+	if ( gserialized_is_empty(geom) )
 	{
 		ret = 0;
 	}
-	else if ( lwgeom_is_collection(lwgeom) )
+	else if ( lwtype_is_collection(gserialized_get_type(geom)) )
 	{
-		LWCOLLECTION *col = lwgeom_as_lwcollection(lwgeom);
-		ret = col->ngeoms;
+		ret = gserialized_peek_count(geom);
 	}
-	lwgeom_free(lwgeom);
 	PG_FREE_IF_COPY(geom, 0);
 	PG_RETURN_INT32(ret);
 }
@@ -398,23 +392,13 @@ PG_FUNCTION_INFO_V1(LWGEOM_numinteriorrings_polygon);
 Datum LWGEOM_numinteriorrings_polygon(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
-	LWPOLY *poly = NULL;
-	LWCURVEPOLY *curvepoly = NULL;
+	int type = gserialized_get_type(geom);
 	int result = -1;
 
-	if ( lwgeom->type == POLYGONTYPE )
-	{
-		poly = lwgeom_as_lwpoly(lwgeom);
-		result = poly->nrings - 1;
-	}
-	else if ( lwgeom->type == CURVEPOLYTYPE )
-	{
-		curvepoly = lwgeom_as_lwcurvepoly(lwgeom);
-		result = curvepoly->nrings - 1;
-	}
+	/* Rings of a polygon, or members of a curve polygon */
+	if ( type == POLYGONTYPE || type == CURVEPOLYTYPE )
+		result = (int)gserialized_peek_count(geom) - 1;
 	
-	lwgeom_free(lwgeom);
 	PG_FREE_IF_COPY(geom, 0);
 	
 	if ( result < 0 )
@@ -518,6 +502,31 @@ Datum LWGEOM_interiorringn_polygon(PG_FUNCTION_ARGS)
 	PG_RETURN_POINTER(result);
 }
 
+/*
+ * A new point geometry with the SRID and dimensions of geom.
+ */
+static GSERIALIZED* gserialized_point_like(const GSERIALIZED *geom, const POINT4D *p)
+{
+	LWPOINT *lwpoint = lwpoint_make(gserialized_get_srid(geom), gserialized_has_z(geom), gserialized_has_m(geom), p);
+	GSERIALIZED *result = geometry_serialize(lwpoint_as_lwgeom(lwpoint));
+	lwpoint_free(lwpoint);
+	return result;
+}
+
+/*
+ * Point n (0-based) of a serialized point array type as a new
+ * geometry, read without deserializing the input. NULL if out of range.
+ */
+static GSERIALIZED* gserialized_point_n(const GSERIALIZED *geom, int n)
+{
+	POINT4D p;
+
+	if ( gserialized_peek_point(geom, n, &p) == LW_FAILURE )
+		return NULL;
+
+	return gserialized_point_like(geom, &p);
+}
+
 /**
  * PointN(GEOMETRY,INTEGER) -- find the first linestring in GEOMETRY,
  * @return the point at index INTEGER (1 is 1st point).  Return NULL if
@@ -528,9 +537,8 @@ Datum LWGEOM_pointn_linestring(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
 	int where = PG_GETARG_INT32(1);
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
-	LWPOINT *lwpoint = NULL;
-	int type = lwgeom->type;
+	GSERIALIZED *result = NULL;
+	int type = gserialized_get_type(geom);
 	
 	/* Can't handle crazy index! */
 	if ( where < 1 )
@@ -539,20 +547,23 @@ Datum LWGEOM_pointn_linestring(PG_FUNCTION_ARGS)
 	if ( type == LINETYPE || type == CIRCSTRINGTYPE )
 	{
 		/* OGC index starts at one, so we substract first. */
-		lwpoint = lwline_get_lwpoint((LWLINE*)lwgeom, where - 1);
+		result = gserialized_point_n(geom, where - 1);
 	}
 	else if ( type == COMPOUNDTYPE )
 	{
-		lwpoint = lwcompound_get_lwpoint((LWCOMPOUND*)lwgeom, where - 1);
+		LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
+		LWPOINT *lwpoint = lwcompound_get_lwpoint((LWCOMPOUND*)lwgeom, where - 1);
+		if ( lwpoint )
+			result = geometry_serialize(lwpoint_as_lwgeom(lwpoint));
+		lwgeom_free(lwgeom);
 	}	
 
-	lwgeom_free(lwgeom);
 	PG_FREE_IF_COPY(geom, 0);
 
-	if ( ! lwpoint )
+	if ( ! result )
 		PG_RETURN_NULL();
 
-	PG_RETURN_POINTER(geometry_serialize(lwpoint_as_lwgeom(lwpoint)));
+	PG_RETURN_POINTER(result);
 }
 
 /**
@@ -563,23 +574,17 @@ PG_FUNCTION_INFO_V1(LWGEOM_x_point);
 Datum LWGEOM_x_point(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom;
-	LWGEOM *lwgeom;
-	LWPOINT *point = NULL;
-	POINT2D p;
+	POINT4D p;
 
 	geom = PG_GETARG_GSERIALIZED_P(0);
 
 	if ( gserialized_get_type(geom) != POINTTYPE )
 		lwpgerror("Argument to ST_X() must be a point");
 
-	lwgeom = lwgeom_from_gserialized(geom);
-	point = lwgeom_as_lwpoint(lwgeom);
-	
-	if ( lwgeom_is_empty(lwgeom) )
+	/* Nothing to read from an empty point */
+	if ( gserialized_peek_point(geom, 0, &p) == LW_FAILURE )
 		PG_RETURN_NULL();
 
-	getPoint2d_p(point->point, 0, &p);
-
 	PG_FREE_IF_COPY(geom, 0);
 	PG_RETURN_FLOAT8(p.x);
 }
@@ -592,23 +597,16 @@ PG_FUNCTION_INFO_V1(LWGEOM_y_point);
 Datum LWGEOM_y_point(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom;
-	LWPOINT *point = NULL;
-	LWGEOM *lwgeom;
-	POINT2D p;
+	POINT4D p;
 
 	geom = PG_GETARG_GSERIALIZED_P(0);
 
 	if ( gserialized_get_type(geom) != POINTTYPE )
 		lwpgerror("Argument to ST_Y() must be a point");
 
-	lwgeom = lwgeom_from_gserialized(geom);
-	point = lwgeom_as_lwpoint(lwgeom);
-	
-	if ( lwgeom_is_empty(lwgeom) )
+	if ( gserialized_peek_point(geom, 0, &p) == LW_FAILURE )
 		PG_RETURN_NULL();
 
-	getPoint2d_p(point->point, 0, &p);
-
 	PG_FREE_IF_COPY(geom, 0);
 
 	PG_RETURN_FLOAT8(p.y);
@@ -623,26 +621,19 @@ PG_FUNCTION_INFO_V1(LWGEOM_z_point);
 Datum LWGEOM_z_point(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom;
-	LWPOINT *point = NULL;
-	LWGEOM *lwgeom;
-	POINT3DZ p;
+	POINT4D p;
 
 	geom = PG_GETARG_GSERIALIZED_P(0);
 
 	if ( gserialized_get_type(geom) != POINTTYPE )
 		lwpgerror("Argument to ST_Z() must be a point");
 
-	lwgeom = lwgeom_from_gserialized(geom);
-	point = lwgeom_as_lwpoint(lwgeom);
-	
-	if ( lwgeom_is_empty(lwgeom) )
+	if ( gserialized_peek_point(geom, 0, &p) == LW_FAILURE )
 		PG_RETURN_NULL();
 
 	/* no Z in input */
 	if ( ! gserialized_has_z(geom) ) PG_RETURN_NULL();
 
-	getPoint3dz_p(point->point, 0, &p);
-
 	PG_FREE_IF_COPY(geom, 0);
 
 	PG_RETURN_FLOAT8(p.z);
@@ -656,25 +647,18 @@ PG_FUNCTION_INFO_V1(LWGEOM_m_point);
 Datum LWGEOM_m_point(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom;
-	LWPOINT *point = NULL;
-	LWGEOM *lwgeom;
-	POINT3DM p;
+	POINT4D p;
 
 	geom = PG_GETARG_GSERIALIZED_P(0);
 
 	if ( gserialized_get_type(geom) != POINTTYPE )
 		lwpgerror("Argument to ST_M() must be a point");
 
-	lwgeom = lwgeom_from_gserialized(geom);
-	point = lwgeom_as_lwpoint(lwgeom);
-	
-	if ( lwgeom_is_empty(lwgeom) )
+	if ( gserialized_peek_point(geom, 0, &p) == LW_FAILURE )
 		PG_RETURN_NULL();
 
 	/* no M in input */
-	if ( ! FLAGS_GET_M(point->flags) ) PG_RETURN_NULL();
-
-	getPoint3dm_p(point->point, 0, &p);
+	if ( ! gserialized_has_m(geom) ) PG_RETURN_NULL();
 
 	PG_FREE_IF_COPY(geom, 0);
 
@@ -689,27 +673,35 @@ Datum LWGEOM_m_point(PG_FUNCTION_ARGS)
 PG_FUNCTION_INFO_V1(LWGEOM_startpoint_linestring);
 Datum LWGEOM_startpoint_linestring(PG_FUNCTION_ARGS)
 {
-	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
-	LWPOINT *lwpoint = NULL;
-	int type = lwgeom->type;
+	GSERIALIZED *geom = gserialized_datum_get_header(PG_GETARG_DATUM(0));
+	GSERIALIZED *result = NULL;
+	int type = gserialized_get_type(geom);
+	POINT4D p;
 
+	/* Only the front of a long line is fetched */
 	if ( type == LINETYPE || type == CIRCSTRINGTYPE )
 	{
-		lwpoint = lwline_get_lwpoint((LWLINE*)lwgeom, 0);
+		if ( gserialized_datum_peek_first_point(PG_GETARG_DATUM(0), &p) == LW_SUCCESS )
+			result = gserialized_point_like(geom, &p);
 	}
 	else if ( type == COMPOUNDTYPE )
 	{
+		LWGEOM *lwgeom;
+		LWPOINT *lwpoint;
+		geom = gserialized_header_detoast(geom, PG_GETARG_DATUM(0));
+		lwgeom = lwgeom_from_gserialized(geom);
 		lwpoint = lwcompound_get_startpoint((LWCOMPOUND*)lwgeom);
+		if ( lwpoint )
+			result = geometry_serialize(lwpoint_as_lwgeom(lwpoint));
+		lwgeom_free(lwgeom);
 	}
 
-	lwgeom_free(lwgeom);
 	PG_FREE_IF_COPY(geom, 0);
 
-	if ( ! lwpoint )
+	if ( ! result )
 		PG_RETURN_NULL();
 
-	PG_RETURN_POINTER(geometry_serialize(lwpoint_as_lwgeom(lwpoint)));
+	PG_RETURN_POINTER(result);
 }
 
 /** EndPoint(GEOMETRY) -- find the first linestring in GEOMETRY,
@@ -720,28 +712,28 @@ PG_FUNCTION_INFO_V1(LWGEOM_endpoint_linestring);
 Datum LWGEOM_endpoint_linestring(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
-	LWPOINT *lwpoint = NULL;
-	int type = lwgeom->type;
+	GSERIALIZED *result = NULL;
+	int type = gserialized_get_type(geom);
 
 	if ( type == LINETYPE || type == CIRCSTRINGTYPE )
 	{
-		LWLINE *line = (LWLINE*)lwgeom;
-		if ( line->points )
-			lwpoint = lwline_get_lwpoint((LWLINE*)lwgeom, line->points->npoints - 1);
+		result = gserialized_point_n(geom, (int)gserialized_peek_count(geom) - 1);
 	}
 	else if ( type == COMPOUNDTYPE )
 	{
-		lwpoint = lwcompound_get_endpoint((LWCOMPOUND*)lwgeom);
+		LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
+		LWPOINT *lwpoint = lwcompound_get_endpoint((LWCOMPOUND*)lwgeom);
+		if ( lwpoint )
+			result = geometry_serialize(lwpoint_as_lwgeom(lwpoint));
+		lwgeom_free(lwgeom);
 	}
 
-	lwgeom_free(lwgeom);
 	PG_FREE_IF_COPY(geom, 0);
 
-	if ( ! lwpoint )
+	if ( ! result )
 		PG_RETURN_NULL();
 
-	PG_RETURN_POINTER(geometry_serialize(lwpoint_as_lwgeom(lwpoint)));
+	PG_RETURN_POINTER(result);
 }
 
 /**
@@ -0,0 +1,109 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+/*
+** Row handling shared by the aggregates writing a feature per row,
+** ST_AsMVT() and ST_AsGeoJSONFeatureCollection().
+*/
+
+#include "../postgis_config.h"
+
+#include "postgres.h"
+#include "fmgr.h"
+#include "catalog/pg_type.h"
+#include "utils/lsyscache.h"
+#include "utils/syscache.h"
+#include "utils/typcache.h"
+
+#if POSTGIS_PGSQL_VERSION >= 93
+#include "access/htup_details.h"
+#else
+#include "access/htup.h"
+#endif
+
+#include "lwgeom_out_feature.h"
+
+static bool
+feature_type_is_geometry(Oid typoid)
+{
+	HeapTuple tp = SearchSysCache1(TYPEOID, ObjectIdGetDatum(typoid));
+	bool result = false;
+
+	if ( HeapTupleIsValid(tp) )
+	{
+		result = strcmp(NameStr(((Form_pg_type) GETSTRUCT(tp))->typname), "geometry") == 0;
+		ReleaseSysCache(tp);
+	}
+
+	return result;
+}
+
+void
+feature_columns_init(FEATURE_COLUMNS *cols, TupleDesc tupdesc, const char *geom_name, const char *funcname, MemoryContext mcxt)
+{
+	MemoryContext oldcontext;
+	int i, n;
+
+	cols->geom_index = -1;
+	for ( i = 0; i < tupdesc->natts && cols->geom_index < 0; i++ )
+	{
+		if ( tupdesc->attrs[i]->attisdropped )
+			continue;
+		if ( geom_name ?
+		     strcmp(NameStr(tupdesc->attrs[i]->attname), geom_name) == 0 :
+		     feature_type_is_geometry(tupdesc->attrs[i]->atttypid) )
+			cols->geom_index = i;
+	}
+	if ( cols->geom_index < 0 )
+	{
+		if ( geom_name )
+			elog(ERROR, "%s: could not find column '%s'", funcname, geom_name);
+		elog(ERROR, "%s: could not find a geometry column", funcname);
+	}
+
+	oldcontext = MemoryContextSwitchTo(mcxt);
+	cols->columns = palloc(tupdesc->natts * sizeof(int));
+	cols->names = palloc(tupdesc->natts * sizeof(char*));
+	cols->types = palloc(tupdesc->natts * sizeof(Oid));
+	cols->outfuncs = palloc(tupdesc->natts * sizeof(FmgrInfo));
+	for ( i = 0, n = 0; i < tupdesc->natts; i++ )
+	{
+		Oid outfunc;
+		bool isvarlena;
+
+		if ( tupdesc->attrs[i]->attisdropped || i == cols->geom_index )
+			continue;
+
+		cols->columns[n] = i;
+		cols->names[n] = pstrdup(NameStr(tupdesc->attrs[i]->attname));
+		cols->types[n] = tupdesc->attrs[i]->atttypid;
+		getTypeOutputInfo(cols->types[n], &outfunc, &isvarlena);
+		fmgr_info_cxt(outfunc, &cols->outfuncs[n], mcxt);
+		n++;
+	}
+	cols->ncolumns = n;
+	MemoryContextSwitchTo(oldcontext);
+}
+
+void
+feature_row_deform(HeapTupleHeader rec, TupleDesc tupdesc, Datum **values, bool **nulls)
+{
+	HeapTupleData tuple;
+
+	tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
+	ItemPointerSetInvalid(&(tuple.t_self));
+	tuple.t_tableOid = InvalidOid;
+	tuple.t_data = rec;
+
+	*values = palloc(tupdesc->natts * sizeof(Datum));
+	*nulls = palloc(tupdesc->natts * sizeof(bool));
+	heap_deform_tuple(&tuple, tupdesc, *values, *nulls);
+	ReleaseTupleDesc(tupdesc);
+}
@@ -0,0 +1,47 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#ifndef _LWGEOM_OUT_FEATURE_H
+#define _LWGEOM_OUT_FEATURE_H 1
+
+#include "fmgr.h"
+#include "access/htup.h"
+#include "access/tupdesc.h"
+
+/**
+* Columns of the rows given to the feature aggregates. The geometry
+* column is apart, the other ones become the feature attributes, in
+* order, with their names, types and text output functions.
+*/
+typedef struct
+{
+	int geom_index;
+	uint32_t ncolumns;
+	int *columns;
+	char **names;
+	Oid *types;
+	FmgrInfo *outfuncs;
+}
+FEATURE_COLUMNS;
+
+/**
+* Set up the columns from the row type, in the given memory context.
+* The geometry column is the one named geom_name, or else the first
+* one of type geometry. Errors are reported under funcname.
+*/
+void feature_columns_init(FEATURE_COLUMNS *cols, TupleDesc tupdesc, const char *geom_name, const char *funcname, MemoryContext mcxt);
+
+/**
+* Split the row into values and nulls, indexed as the row type. The
+* tuple descriptor is released.
+*/
+void feature_row_deform(HeapTupleHeader rec, TupleDesc tupdesc, Datum **values, bool **nulls);
+
+#endif /* _LWGEOM_OUT_FEATURE_H */
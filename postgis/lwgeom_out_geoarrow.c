@@ -0,0 +1,95 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+/*
+** GeoArrow output.
+**
+** The ST_AsGeoArrow() aggregate writes the geometries of all the rows
+** as one column in the GeoArrow layout, so that a client reads one
+** blob instead of decoding a WKB value per row. The coordinates go
+** straight from the serialized geometries into the column buffers.
+*/
+
+#include "../postgis_config.h"
+
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/memutils.h"
+
+#include "liblwgeom.h"
+#include "lwgeom_pg.h"
+
+Datum pgis_asgeoarrow_transfn(PG_FUNCTION_ARGS);
+Datum pgis_asgeoarrow_finalfn(PG_FUNCTION_ARGS);
+
+/**
+** Add the geometry of the row to the column, a null geometry
+** making a null row.
+*/
+PG_FUNCTION_INFO_V1(pgis_asgeoarrow_transfn);
+Datum pgis_asgeoarrow_transfn(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext, oldcontext;
+	LWGEOARROW *ga;
+	GSERIALIZED *geom = NULL;
+	LWGEOM *lwgeom = NULL;
+
+	if ( ! AggCheckCallContext(fcinfo, &aggcontext) )
+		elog(ERROR, "%s called in non-aggregate context", __func__);
+
+	if ( ! PG_ARGISNULL(1) )
+	{
+		geom = PG_GETARG_GSERIALIZED_P(1);
+		lwgeom = lwgeom_from_gserialized(geom);
+	}
+
+	/* The column grows in the aggregate context */
+	oldcontext = MemoryContextSwitchTo(aggcontext);
+	ga = PG_ARGISNULL(0) ? lwgeoarrow_create() : (LWGEOARROW*) PG_GETARG_POINTER(0);
+	lwgeoarrow_append(ga, lwgeom);
+	MemoryContextSwitchTo(oldcontext);
+
+	if ( lwgeom )
+	{
+		lwgeom_free(lwgeom);
+		PG_FREE_IF_COPY(geom, 1);
+	}
+
+	PG_RETURN_POINTER(ga);
+}
+
+/**
+** Write the column. The state is left as it is, so that the final
+** function can run more than once.
+*/
+PG_FUNCTION_INFO_V1(pgis_asgeoarrow_finalfn);
+Datum pgis_asgeoarrow_finalfn(PG_FUNCTION_ARGS)
+{
+	LWGEOARROW *ga;
+	bytea *result;
+	size_t size;
+
+	if ( ! AggCheckCallContext(fcinfo, NULL) )
+		elog(ERROR, "%s called in non-aggregate context", __func__);
+
+	if ( PG_ARGISNULL(0) )
+		PG_RETURN_NULL();
+
+	ga = (LWGEOARROW*) PG_GETARG_POINTER(0);
+	size = lwgeoarrow_size(ga);
+	if ( size > MaxAllocSize - VARHDRSZ )
+		elog(ERROR, "ST_AsGeoArrow: column of %lu bytes is too big for a bytea", (unsigned long) size);
+
+	result = palloc(VARHDRSZ + size);
+	lwgeoarrow_write(ga, (uint8_t*) VARDATA(result));
+	SET_VARSIZE(result, VARHDRSZ + size);
+
+	PG_RETURN_BYTEA_P(result);
+}
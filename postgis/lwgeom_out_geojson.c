@@ -0,0 +1,306 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+/*
+** GeoJSON FeatureCollection output.
+**
+** The ST_AsGeoJSONFeatureCollection() aggregate writes a feature per
+** row, the other columns of the row becoming the feature properties.
+** Geometries and properties are appended in place to a single string
+** buffer kept in the aggregate state, so no text is built per row.
+*/
+
+#include "../postgis_config.h"
+
+#include "postgres.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "catalog/pg_type.h"
+#include "utils/builtins.h"
+#include "utils/lsyscache.h"
+#include "utils/typcache.h"
+
+#if POSTGIS_PGSQL_VERSION >= 93
+#include "access/htup_details.h"
+#else
+#include "access/htup.h"
+#endif
+
+#include <float.h> /* For DBL_DIG */
+
+#include "liblwgeom_internal.h" /* For lwgeom_to_geojson_sb */
+#include "lwgeom_pg.h"
+#include "lwgeom_out_feature.h"
+
+Datum pgis_asgeojson_transfn(PG_FUNCTION_ARGS);
+Datum pgis_asgeojson_finalfn(PG_FUNCTION_ARGS);
+
+#define GEOJSON_COLLECTION_HEAD "{\"type\":\"FeatureCollection\",\"features\":["
+#define GEOJSON_COLLECTION_TAIL "]}"
+
+/*
+** Aggregate state, the collection being written. Keys are the names
+** of the non geometry columns, already quoted and followed by a colon.
+*/
+typedef struct
+{
+	int precision;
+
+	/* Columns of the rows */
+	FEATURE_COLUMNS cols;
+	char **keys;
+
+	/* The collection, without its tail */
+	stringbuffer_t *sb;
+	uint32_t nfeatures;
+}
+geojson_agg_state;
+
+
+/*
+** Append a JSON string, quoted and with the characters JSON does
+** not allow in strings escaped.
+*/
+static void
+geojson_append_string(stringbuffer_t *sb, const char *str)
+{
+	const unsigned char *p;
+	char *ptr;
+
+	/* At worst each character becomes a \u00XX sequence */
+	stringbuffer_makeroom(sb, 6 * strlen(str) + 3);
+	ptr = sb->str_end;
+
+	*ptr++ = '"';
+	for ( p = (const unsigned char*) str; *p; p++ )
+	{
+		switch ( *p )
+		{
+			case '"':  *ptr++ = '\\'; *ptr++ = '"'; break;
+			case '\\': *ptr++ = '\\'; *ptr++ = '\\'; break;
+			case '\b': *ptr++ = '\\'; *ptr++ = 'b'; break;
+			case '\f': *ptr++ = '\\'; *ptr++ = 'f'; break;
+			case '\n': *ptr++ = '\\'; *ptr++ = 'n'; break;
+			case '\r': *ptr++ = '\\'; *ptr++ = 'r'; break;
+			case '\t': *ptr++ = '\\'; *ptr++ = 't'; break;
+			default:
+				if ( *p < 0x20 )
+					ptr += sprintf(ptr, "\\u%04x", *p);
+				else
+					*ptr++ = *p;
+		}
+	}
+	*ptr++ = '"';
+	*ptr = '\0';
+
+	sb->str_end = ptr;
+}
+
+/* NaN and infinities have no JSON number form */
+static bool
+geojson_is_number(const char *str)
+{
+	if ( *str == '-' )
+		str++;
+	return *str >= '0' && *str <= '9';
+}
+
+/*
+** Write the value of a column. Numbers and booleans keep their type,
+** json values are written as they are, anything else is written as
+** the string of its text output.
+*/
+static void
+geojson_append_value(geojson_agg_state *state, int column, Datum value)
+{
+	char *str;
+
+	switch ( state->cols.types[column] )
+	{
+		case BOOLOID:
+			stringbuffer_append(state->sb, DatumGetBool(value) ? "true" : "false");
+			return;
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case FLOAT4OID:
+		case FLOAT8OID:
+		case NUMERICOID:
+			str = OutputFunctionCall(&state->cols.outfuncs[column], value);
+			if ( geojson_is_number(str) )
+				stringbuffer_append(state->sb, str);
+			else
+				geojson_append_string(state->sb, str);
+			break;
+#ifdef JSONOID
+		case JSONOID:
+#endif
+#ifdef JSONBOID
+		case JSONBOID:
+#endif
+			str = OutputFunctionCall(&state->cols.outfuncs[column], value);
+			stringbuffer_append(state->sb, str);
+			break;
+		default:
+			str = OutputFunctionCall(&state->cols.outfuncs[column], value);
+			geojson_append_string(state->sb, str);
+			break;
+	}
+	pfree(str);
+}
+
+/*
+** Set up the collection from the aggregate arguments and the row
+** type, the geometry column is the one named by the arguments, or
+** else the first one of type geometry.
+*/
+static geojson_agg_state *
+geojson_agg_state_create(FunctionCallInfo fcinfo, TupleDesc tupdesc, MemoryContext aggcontext)
+{
+	MemoryContext oldcontext = MemoryContextSwitchTo(aggcontext);
+	geojson_agg_state *state = palloc0(sizeof(geojson_agg_state));
+	stringbuffer_t *key;
+	char *geom_name = NULL;
+	uint32_t i;
+
+	/* Default is max precision, as ST_AsGeoJson */
+	state->precision = DBL_DIG;
+	if ( PG_NARGS() > 2 && ! PG_ARGISNULL(2) )
+	{
+		state->precision = PG_GETARG_INT32(2);
+		if ( state->precision > DBL_DIG )
+			state->precision = DBL_DIG;
+		else if ( state->precision < 0 )
+			state->precision = 0;
+	}
+
+	if ( PG_NARGS() > 3 && ! PG_ARGISNULL(3) )
+		geom_name = text_to_cstring(PG_GETARG_TEXT_P(3));
+
+	feature_columns_init(&state->cols, tupdesc, geom_name, "ST_AsGeoJSONFeatureCollection", aggcontext);
+
+	state->keys = palloc(state->cols.ncolumns * sizeof(char*));
+	key = stringbuffer_create();
+	for ( i = 0; i < state->cols.ncolumns; i++ )
+	{
+		stringbuffer_clear(key);
+		geojson_append_string(key, state->cols.names[i]);
+		stringbuffer_append(key, ":");
+		state->keys[i] = stringbuffer_getstringcopy(key);
+	}
+	stringbuffer_destroy(key);
+
+	state->sb = stringbuffer_create_with_size(8192);
+	stringbuffer_append(state->sb, GEOJSON_COLLECTION_HEAD);
+
+	MemoryContextSwitchTo(oldcontext);
+	return state;
+}
+
+/**
+** Append a feature for the row. Rows without geometry get a null
+** geometry, null columns get null properties.
+*/
+PG_FUNCTION_INFO_V1(pgis_asgeojson_transfn);
+Datum pgis_asgeojson_transfn(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	geojson_agg_state *state;
+	HeapTupleHeader rec;
+	TupleDesc tupdesc;
+	Datum *values;
+	bool *nulls;
+	GSERIALIZED *geom;
+	LWGEOM *lwgeom;
+	uint32_t i;
+
+	if ( ! AggCheckCallContext(fcinfo, &aggcontext) )
+		elog(ERROR, "%s called in non-aggregate context", __func__);
+
+	if ( PG_ARGISNULL(0) && ! type_is_rowtype(get_fn_expr_argtype(fcinfo->flinfo, 1)) )
+		elog(ERROR, "ST_AsGeoJSONFeatureCollection: parameter row cannot be other than a rowtype");
+
+	state = PG_ARGISNULL(0) ? NULL : (geojson_agg_state*) PG_GETARG_POINTER(0);
+	if ( PG_ARGISNULL(1) )
+		PG_RETURN_POINTER(state);
+
+	rec = PG_GETARG_HEAPTUPLEHEADER(1);
+	tupdesc = lookup_rowtype_tupdesc(HeapTupleHeaderGetTypeId(rec), HeapTupleHeaderGetTypMod(rec));
+
+	if ( ! state )
+		state = geojson_agg_state_create(fcinfo, tupdesc, aggcontext);
+
+	feature_row_deform(rec, tupdesc, &values, &nulls);
+
+	if ( state->nfeatures++ )
+		stringbuffer_append(state->sb, ",");
+	stringbuffer_append(state->sb, "{\"type\":\"Feature\",\"geometry\":");
+
+	if ( nulls[state->cols.geom_index] )
+	{
+		stringbuffer_append(state->sb, "null");
+	}
+	else
+	{
+		geom = (GSERIALIZED*) PG_DETOAST_DATUM(values[state->cols.geom_index]);
+		lwgeom = lwgeom_from_gserialized(geom);
+		lwgeom_to_geojson_sb(lwgeom, state->sb, state->precision);
+		lwgeom_free(lwgeom);
+		if ( (Pointer) geom != DatumGetPointer(values[state->cols.geom_index]) )
+			pfree(geom);
+	}
+
+	stringbuffer_append(state->sb, ",\"properties\":{");
+	for ( i = 0; i < state->cols.ncolumns; i++ )
+	{
+		if ( i )
+			stringbuffer_append(state->sb, ",");
+		stringbuffer_append(state->sb, state->keys[i]);
+
+		if ( nulls[state->cols.columns[i]] )
+			stringbuffer_append(state->sb, "null");
+		else
+			geojson_append_value(state, i, values[state->cols.columns[i]]);
+	}
+	stringbuffer_append(state->sb, "}}");
+
+	pfree(values);
+	pfree(nulls);
+
+	PG_RETURN_POINTER(state);
+}
+
+/**
+** Close the collection built by the transfer function. The state is
+** left as it is, so that the final function can run more than once.
+*/
+PG_FUNCTION_INFO_V1(pgis_asgeojson_finalfn);
+Datum pgis_asgeojson_finalfn(PG_FUNCTION_ARGS)
+{
+	geojson_agg_state *state;
+	text *result;
+	size_t size;
+
+	if ( ! AggCheckCallContext(fcinfo, NULL) )
+		elog(ERROR, "%s called in non-aggregate context", __func__);
+
+	if ( PG_ARGISNULL(0) )
+		PG_RETURN_TEXT_P(cstring_to_text(GEOJSON_COLLECTION_HEAD GEOJSON_COLLECTION_TAIL));
+
+	state = (geojson_agg_state*) PG_GETARG_POINTER(0);
+	size = stringbuffer_getlength(state->sb);
+
+	result = palloc(VARHDRSZ + size + sizeof(GEOJSON_COLLECTION_TAIL) - 1);
+	memcpy(VARDATA(result), stringbuffer_getstring(state->sb), size);
+	memcpy(VARDATA(result) + size, GEOJSON_COLLECTION_TAIL, sizeof(GEOJSON_COLLECTION_TAIL) - 1);
+	SET_VARSIZE(result, VARHDRSZ + size + sizeof(GEOJSON_COLLECTION_TAIL) - 1);
+
+	PG_RETURN_TEXT_P(result);
+}
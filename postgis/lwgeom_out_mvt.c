@@ -0,0 +1,475 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+/*
+** Mapbox Vector Tile output.
+**
+** ST_AsMVTGeom() brings geometries into tile coordinates, and the
+** ST_AsMVT() aggregate writes a tile with one layer holding a feature
+** per row, the other columns of the row becoming the feature
+** attributes. The protocol buffer messages are written directly,
+** see https://github.com/mapbox/vector-tile-spec/tree/master/2.1
+*/
+
+#include "../postgis_config.h"
+
+#include "postgres.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "access/hash.h"
+#include "catalog/pg_type.h"
+#include "utils/builtins.h"
+#include "utils/lsyscache.h"
+#include "utils/typcache.h"
+
+#if POSTGIS_PGSQL_VERSION >= 93
+#include "access/htup_details.h"
+#else
+#include "access/htup.h"
+#endif
+
+#include "liblwgeom.h"
+#include "lwgeom_pg.h"
+#include "lwgeom_out_feature.h"
+#include "bytebuffer.h"
+
+Datum ST_AsMVTGeom(PG_FUNCTION_ARGS);
+Datum pgis_asmvt_transfn(PG_FUNCTION_ARGS);
+Datum pgis_asmvt_finalfn(PG_FUNCTION_ARGS);
+
+#define MVT_DEFAULT_NAME "default"
+#define MVT_DEFAULT_EXTENT 4096
+#define MVT_VERSION 2
+
+/* Protocol buffer wire types */
+#define MVT_WIRE_VARINT 0
+#define MVT_WIRE_64BIT 1
+#define MVT_WIRE_BYTES 2
+#define MVT_WIRE_32BIT 5
+
+/* Fields of the Tile, Layer, Feature and Value messages */
+#define MVT_TILE_LAYERS 3
+#define MVT_LAYER_NAME 1
+#define MVT_LAYER_FEATURES 2
+#define MVT_LAYER_KEYS 3
+#define MVT_LAYER_VALUES 4
+#define MVT_LAYER_EXTENT 5
+#define MVT_LAYER_VERSION 15
+#define MVT_FEATURE_TAGS 2
+#define MVT_FEATURE_TYPE 3
+#define MVT_FEATURE_GEOMETRY 4
+#define MVT_VALUE_STRING 1
+#define MVT_VALUE_FLOAT 2
+#define MVT_VALUE_DOUBLE 3
+#define MVT_VALUE_UINT 5
+#define MVT_VALUE_SINT 6
+#define MVT_VALUE_BOOL 7
+
+/*
+** Aggregate state, a layer being built. Values are shared by the
+** features, the encoded Value messages are kept back to back with a
+** hash table over them to find the repeated ones.
+*/
+typedef struct
+{
+	char *name;
+	uint32_t extent;
+
+	/* Columns of the rows, their names are the layer keys */
+	FEATURE_COLUMNS cols;
+
+	/* Values, value i spans value_offsets[i] to value_offsets[i+1] */
+	bytebuffer_t *values;
+	uint32_t *value_offsets;
+	uint32_t nvalues;
+	uint32_t maxvalues;
+	int32_t *value_slots;
+	uint32_t nslots;
+
+	/* Features, already framed as layer fields */
+	bytebuffer_t *features;
+}
+mvt_agg_state;
+
+
+static void
+mvt_append_key(bytebuffer_t *buf, uint32_t field, uint32_t wire_type)
+{
+	bytebuffer_append_uvarint(buf, (field << 3) | wire_type);
+}
+
+static void
+mvt_append_bytes(bytebuffer_t *buf, uint32_t field, const void *data, size_t size)
+{
+	mvt_append_key(buf, field, MVT_WIRE_BYTES);
+	bytebuffer_append_uvarint(buf, size);
+	bytebuffer_append_bulk(buf, (void*)data, size);
+}
+
+/* Fixed size fields are little endian whatever the platform */
+static void
+mvt_append_fixed(bytebuffer_t *buf, uint64_t bits, int nbytes)
+{
+	int i;
+	for ( i = 0; i < nbytes; i++ )
+		bytebuffer_append_byte(buf, (uint8_t)(bits >> (8 * i)));
+}
+
+static void
+mvt_encode_int(bytebuffer_t *buf, int64_t value)
+{
+	if ( value >= 0 )
+	{
+		mvt_append_key(buf, MVT_VALUE_UINT, MVT_WIRE_VARINT);
+		bytebuffer_append_uvarint(buf, (uint64_t) value);
+	}
+	else
+	{
+		mvt_append_key(buf, MVT_VALUE_SINT, MVT_WIRE_VARINT);
+		bytebuffer_append_uvarint(buf, zigzag64(value));
+	}
+}
+
+/*
+** Write the Value message of a column. Numbers and booleans keep
+** their type, anything else is written as its text output.
+*/
+static void
+mvt_encode_value(mvt_agg_state *state, int column, Datum value, bytebuffer_t *buf)
+{
+	switch ( state->cols.types[column] )
+	{
+		case BOOLOID:
+			mvt_append_key(buf, MVT_VALUE_BOOL, MVT_WIRE_VARINT);
+			bytebuffer_append_uvarint(buf, DatumGetBool(value) ? 1 : 0);
+			break;
+		case INT2OID:
+			mvt_encode_int(buf, DatumGetInt16(value));
+			break;
+		case INT4OID:
+			mvt_encode_int(buf, DatumGetInt32(value));
+			break;
+		case INT8OID:
+			mvt_encode_int(buf, DatumGetInt64(value));
+			break;
+		case FLOAT4OID:
+		{
+			float4 f = DatumGetFloat4(value);
+			uint32_t bits;
+			memcpy(&bits, &f, sizeof(uint32_t));
+			mvt_append_key(buf, MVT_VALUE_FLOAT, MVT_WIRE_32BIT);
+			mvt_append_fixed(buf, bits, 4);
+			break;
+		}
+		case FLOAT8OID:
+		{
+			float8 d = DatumGetFloat8(value);
+			uint64_t bits;
+			memcpy(&bits, &d, sizeof(uint64_t));
+			mvt_append_key(buf, MVT_VALUE_DOUBLE, MVT_WIRE_64BIT);
+			mvt_append_fixed(buf, bits, 8);
+			break;
+		}
+		default:
+		{
+			char *str = OutputFunctionCall(&state->cols.outfuncs[column], value);
+			mvt_append_bytes(buf, MVT_VALUE_STRING, str, strlen(str));
+			pfree(str);
+			break;
+		}
+	}
+}
+
+static uint32_t
+mvt_value_hash(const uint8_t *data, size_t size)
+{
+	return DatumGetUInt32(hash_any(data, size));
+}
+
+/* Put a value in the first free slot of its hash chain */
+static void
+mvt_value_slot_insert(mvt_agg_state *state, uint32_t hash, int32_t index)
+{
+	uint32_t mask = state->nslots - 1;
+	uint32_t slot = hash & mask;
+
+	while ( state->value_slots[slot] >= 0 )
+		slot = (slot + 1) & mask;
+
+	state->value_slots[slot] = index;
+}
+
+/* Double the hash table, keeping it at most half full */
+static void
+mvt_value_slots_grow(mvt_agg_state *state, MemoryContext aggcontext)
+{
+	uint32_t i, start, size;
+
+	pfree(state->value_slots);
+	state->nslots *= 2;
+	state->value_slots = MemoryContextAlloc(aggcontext, state->nslots * sizeof(int32_t));
+	memset(state->value_slots, 0xFF, state->nslots * sizeof(int32_t));
+
+	for ( i = 0; i < state->nvalues; i++ )
+	{
+		start = state->value_offsets[i];
+		size = state->value_offsets[i+1] - start;
+		mvt_value_slot_insert(state, mvt_value_hash(state->values->buf_start + start, size), i);
+	}
+}
+
+/*
+** Return the index of an encoded value in the layer, adding it
+** if it is not there yet.
+*/
+static uint32_t
+mvt_value_index(mvt_agg_state *state, bytebuffer_t *value, MemoryContext aggcontext)
+{
+	const uint8_t *data = value->buf_start;
+	size_t size = bytebuffer_getlength(value);
+	uint32_t hash = mvt_value_hash(data, size);
+	uint32_t mask = state->nslots - 1;
+	uint32_t slot, start;
+	int32_t index;
+
+	for ( slot = hash & mask; state->value_slots[slot] >= 0; slot = (slot + 1) & mask )
+	{
+		index = state->value_slots[slot];
+		start = state->value_offsets[index];
+		if ( state->value_offsets[index+1] - start == size &&
+		     memcmp(state->values->buf_start + start, data, size) == 0 )
+			return index;
+	}
+
+	index = state->nvalues++;
+	bytebuffer_append_bytebuffer(state->values, value);
+
+	if ( state->nvalues + 1 > state->maxvalues )
+	{
+		state->maxvalues *= 2;
+		state->value_offsets = repalloc(state->value_offsets, state->maxvalues * sizeof(uint32_t));
+	}
+	state->value_offsets[state->nvalues] = bytebuffer_getlength(state->values);
+
+	if ( 2 * state->nvalues > state->nslots )
+		mvt_value_slots_grow(state, aggcontext);
+	else
+		state->value_slots[slot] = index;
+
+	return index;
+}
+
+/*
+** Set up the layer from the aggregate arguments and the row type,
+** the geometry column is the one named by the arguments, or else the
+** first one of type geometry.
+*/
+static mvt_agg_state *
+mvt_agg_state_create(FunctionCallInfo fcinfo, TupleDesc tupdesc, MemoryContext aggcontext)
+{
+	MemoryContext oldcontext = MemoryContextSwitchTo(aggcontext);
+	mvt_agg_state *state = palloc0(sizeof(mvt_agg_state));
+	char *geom_name = NULL;
+
+	if ( PG_NARGS() > 2 && ! PG_ARGISNULL(2) )
+		state->name = text_to_cstring(PG_GETARG_TEXT_P(2));
+	else
+		state->name = pstrdup(MVT_DEFAULT_NAME);
+
+	state->extent = MVT_DEFAULT_EXTENT;
+	if ( PG_NARGS() > 3 && ! PG_ARGISNULL(3) )
+	{
+		if ( PG_GETARG_INT32(3) <= 0 )
+			elog(ERROR, "ST_AsMVT: extent must be greater than 0");
+		state->extent = PG_GETARG_INT32(3);
+	}
+
+	if ( PG_NARGS() > 4 && ! PG_ARGISNULL(4) )
+		geom_name = text_to_cstring(PG_GETARG_TEXT_P(4));
+
+	feature_columns_init(&state->cols, tupdesc, geom_name, "ST_AsMVT", aggcontext);
+
+	state->values = bytebuffer_create();
+	state->maxvalues = 64;
+	state->value_offsets = palloc(state->maxvalues * sizeof(uint32_t));
+	state->value_offsets[0] = 0;
+	state->nslots = 128;
+	state->value_slots = palloc(state->nslots * sizeof(int32_t));
+	memset(state->value_slots, 0xFF, state->nslots * sizeof(int32_t));
+
+	state->features = bytebuffer_create();
+
+	MemoryContextSwitchTo(oldcontext);
+	return state;
+}
+
+PG_FUNCTION_INFO_V1(ST_AsMVTGeom);
+Datum ST_AsMVTGeom(PG_FUNCTION_ARGS)
+{
+	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
+	GBOX *bounds = (GBOX*) PG_GETARG_POINTER(1);
+	int32 extent = PG_GETARG_INT32(2);
+	int32 buffer = PG_GETARG_INT32(3);
+	bool clip_geom = PG_GETARG_BOOL(4);
+	GSERIALIZED *result;
+	LWGEOM *lwgeom_in, *lwgeom_out;
+
+	if ( extent <= 0 )
+		elog(ERROR, "%s: extent must be greater than 0", __func__);
+	if ( buffer < 0 )
+		elog(ERROR, "%s: buffer must not be negative", __func__);
+
+	lwgeom_in = lwgeom_from_gserialized(geom);
+	lwgeom_out = lwgeom_to_mvt_geom(lwgeom_in, bounds, extent, buffer, clip_geom);
+	lwgeom_free(lwgeom_in);
+	PG_FREE_IF_COPY(geom, 0);
+
+	if ( ! lwgeom_out )
+		PG_RETURN_NULL();
+
+	result = geometry_serialize(lwgeom_out);
+	lwgeom_free(lwgeom_out);
+	PG_RETURN_POINTER(result);
+}
+
+/**
+** Add a feature for the row, skipping the rows without geometry
+** or whose geometry has nothing to draw. Null attributes are left
+** out of the feature tags.
+*/
+PG_FUNCTION_INFO_V1(pgis_asmvt_transfn);
+Datum pgis_asmvt_transfn(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	mvt_agg_state *state;
+	HeapTupleHeader rec;
+	TupleDesc tupdesc;
+	Datum *values;
+	bool *nulls;
+	bytebuffer_t *tags, *value, *feature;
+	GSERIALIZED *geom;
+	LWGEOM *lwgeom;
+	uint8_t *mvt_geom, mvt_type;
+	size_t mvt_size;
+	uint32_t i;
+
+	if ( ! AggCheckCallContext(fcinfo, &aggcontext) )
+		elog(ERROR, "%s called in non-aggregate context", __func__);
+
+	if ( PG_ARGISNULL(0) && ! type_is_rowtype(get_fn_expr_argtype(fcinfo->flinfo, 1)) )
+		elog(ERROR, "ST_AsMVT: parameter row cannot be other than a rowtype");
+
+	state = PG_ARGISNULL(0) ? NULL : (mvt_agg_state*) PG_GETARG_POINTER(0);
+	if ( PG_ARGISNULL(1) )
+		PG_RETURN_POINTER(state);
+
+	rec = PG_GETARG_HEAPTUPLEHEADER(1);
+	tupdesc = lookup_rowtype_tupdesc(HeapTupleHeaderGetTypeId(rec), HeapTupleHeaderGetTypMod(rec));
+
+	if ( ! state )
+		state = mvt_agg_state_create(fcinfo, tupdesc, aggcontext);
+
+	feature_row_deform(rec, tupdesc, &values, &nulls);
+
+	if ( nulls[state->cols.geom_index] )
+		PG_RETURN_POINTER(state);
+
+	geom = (GSERIALIZED*) PG_DETOAST_DATUM(values[state->cols.geom_index]);
+	lwgeom = lwgeom_from_gserialized(geom);
+	mvt_geom = lwgeom_to_mvt_geometry(lwgeom, &mvt_type, &mvt_size);
+	lwgeom_free(lwgeom);
+	if ( ! mvt_geom )
+		PG_RETURN_POINTER(state);
+
+	/* Pairs of key and value indexes */
+	tags = bytebuffer_create();
+	value = bytebuffer_create();
+	for ( i = 0; i < state->cols.ncolumns; i++ )
+	{
+		if ( nulls[state->cols.columns[i]] )
+			continue;
+
+		bytebuffer_clear(value);
+		mvt_encode_value(state, i, values[state->cols.columns[i]], value);
+		bytebuffer_append_uvarint(tags, i);
+		bytebuffer_append_uvarint(tags, mvt_value_index(state, value, aggcontext));
+	}
+
+	feature = bytebuffer_create();
+	if ( bytebuffer_getlength(tags) )
+		mvt_append_bytes(feature, MVT_FEATURE_TAGS, tags->buf_start, bytebuffer_getlength(tags));
+	mvt_append_key(feature, MVT_FEATURE_TYPE, MVT_WIRE_VARINT);
+	bytebuffer_append_uvarint(feature, mvt_type);
+	mvt_append_bytes(feature, MVT_FEATURE_GEOMETRY, mvt_geom, mvt_size);
+
+	mvt_append_bytes(state->features, MVT_LAYER_FEATURES, feature->buf_start, bytebuffer_getlength(feature));
+
+	bytebuffer_destroy(feature);
+	bytebuffer_destroy(value);
+	bytebuffer_destroy(tags);
+	lwfree(mvt_geom);
+
+	PG_RETURN_POINTER(state);
+}
+
+/**
+** Write the tile, with the layer built by the transfer function.
+** A tile without rows is empty.
+*/
+PG_FUNCTION_INFO_V1(pgis_asmvt_finalfn);
+Datum pgis_asmvt_finalfn(PG_FUNCTION_ARGS)
+{
+	mvt_agg_state *state;
+	bytebuffer_t *layer, *tile;
+	bytea *result;
+	size_t size;
+	uint32_t i;
+
+	if ( ! AggCheckCallContext(fcinfo, NULL) )
+		elog(ERROR, "%s called in non-aggregate context", __func__);
+
+	if ( PG_ARGISNULL(0) )
+	{
+		result = palloc(VARHDRSZ);
+		SET_VARSIZE(result, VARHDRSZ);
+		PG_RETURN_BYTEA_P(result);
+	}
+
+	state = (mvt_agg_state*) PG_GETARG_POINTER(0);
+
+	layer = bytebuffer_create_with_size(bytebuffer_getlength(state->features) + bytebuffer_getlength(state->values) + 256);
+	mvt_append_bytes(layer, MVT_LAYER_NAME, state->name, strlen(state->name));
+	bytebuffer_append_bytebuffer(layer, state->features);
+	for ( i = 0; i < state->cols.ncolumns; i++ )
+		mvt_append_bytes(layer, MVT_LAYER_KEYS, state->cols.names[i], strlen(state->cols.names[i]));
+	for ( i = 0; i < state->nvalues; i++ )
+	{
+		mvt_append_bytes(layer, MVT_LAYER_VALUES,
+		                 state->values->buf_start + state->value_offsets[i],
+		                 state->value_offsets[i+1] - state->value_offsets[i]);
+	}
+	mvt_append_key(layer, MVT_LAYER_EXTENT, MVT_WIRE_VARINT);
+	bytebuffer_append_uvarint(layer, state->extent);
+	mvt_append_key(layer, MVT_LAYER_VERSION, MVT_WIRE_VARINT);
+	bytebuffer_append_uvarint(layer, MVT_VERSION);
+
+	tile = bytebuffer_create_with_size(bytebuffer_getlength(layer) + 16);
+	mvt_append_bytes(tile, MVT_TILE_LAYERS, layer->buf_start, bytebuffer_getlength(layer));
+
+	size = bytebuffer_getlength(tile);
+	result = palloc(size + VARHDRSZ);
+	SET_VARSIZE(result, size + VARHDRSZ);
+	memcpy(VARDATA(result), tile->buf_start, size);
+
+	bytebuffer_destroy(layer);
+	bytebuffer_destroy(tile);
+
+	PG_RETURN_BYTEA_P(result);
+}
@@ -0,0 +1,110 @@
+#include "lwgeom_rectree.h"
+
+
+/*
+* Cached RECT_NODE edge trees for the planar distance functions,
+* laid out like the CircTreeGeomCache of the geography functions.
+* The leaves point straight at the coordinates of the cached
+* serialized geometry, so only the tree itself needs keeping.
+*/
+typedef struct {
+	int                         type;       // <GeomCache>
+	GSERIALIZED*                geom1;      // 
+	GSERIALIZED*                geom2;      // 
+	size_t                      geom1_size; // 
+	size_t                      geom2_size; // 
+	int32                       argnum;     // </GeomCache>
+	RECT_NODE*                  index;
+} RectTreeGeomCache;
+
+
+
+/**
+* Builder, freeer and public accessor for cached RECT_NODE trees
+*/
+static int
+RectTreeBuilder(const LWGEOM* lwgeom, GeomCache* cache)
+{
+	RectTreeGeomCache* rect_cache = (RectTreeGeomCache*)cache;
+	RECT_NODE* tree = rect_tree_from_lwgeom(lwgeom);
+
+	if ( rect_cache->index )
+	{
+		rect_tree_free(rect_cache->index);
+		rect_cache->index = 0;
+	}
+	if ( ! tree )
+		return LW_FAILURE;
+
+	rect_cache->index = tree;
+	return LW_SUCCESS;
+}
+
+static int
+RectTreeFreer(GeomCache* cache)
+{
+	RectTreeGeomCache* rect_cache = (RectTreeGeomCache*)cache;
+	if ( rect_cache->index )
+	{
+		rect_tree_free(rect_cache->index);
+		rect_cache->index = 0;
+		rect_cache->argnum = 0;
+	}
+	return LW_SUCCESS;
+}
+
+static GeomCache*
+RectTreeAllocator(void)
+{
+	RectTreeGeomCache* cache = palloc(sizeof(RectTreeGeomCache));
+	memset(cache, 0, sizeof(RectTreeGeomCache));
+	return (GeomCache*)cache;
+}
+
+static GeomCacheMethods RectTreeCacheMethods =
+{
+	RECT_CACHE_ENTRY,
+	RectTreeBuilder,
+	RectTreeFreer,
+	RectTreeAllocator
+};
+
+static RectTreeGeomCache*
+GetRectTreeGeomCache(FunctionCallInfoData* fcinfo, const GSERIALIZED* g1, const GSERIALIZED* g2)
+{
+	return (RectTreeGeomCache*)GetGeomCache(fcinfo, &RectTreeCacheMethods, g1, g2);
+}
+
+
+/**
+* Minimum distance through the cached edge tree of whichever argument
+* has one, filling in dl (set up by the caller, tolerance included).
+* Returns LW_FAILURE when there is no tree to use yet, and the caller
+* should measure the usual way.
+*/
+int
+geometry_distance_cache(FunctionCallInfoData* fcinfo, const GSERIALIZED* g1, const LWGEOM* lwgeom1, const GSERIALIZED* g2, const LWGEOM* lwgeom2, DISTPTS* dl)
+{
+	RectTreeGeomCache* tree_cache = NULL;
+
+	/* Called through DirectFunctionCall, no place to keep a cache */
+	if ( ! fcinfo->flinfo )
+		return LW_FAILURE;
+
+	/* Small geometries are quicker to measure than to index */
+	if ( ! lw_dist2d_tree_worthwhile(lwgeom1, lwgeom2) )
+		return LW_FAILURE;
+
+	tree_cache = GetRectTreeGeomCache(fcinfo, g1, g2);
+	if ( ! tree_cache || ! tree_cache->index )
+		return LW_FAILURE;
+
+	POSTGIS_DEBUGF(3, "using cached tree of argument %d", tree_cache->argnum);
+
+	if ( tree_cache->argnum == 1 )
+		return lw_dist2d_tree(lwgeom1, tree_cache->index, lwgeom2, NULL, dl);
+	else if ( tree_cache->argnum == 2 )
+		return lw_dist2d_tree(lwgeom1, NULL, lwgeom2, tree_cache->index, dl);
+
+	return LW_FAILURE;
+}
@@ -0,0 +1,5 @@
+#include "liblwgeom_internal.h"
+#include "measures.h"
+#include "lwgeom_cache.h"
+
+int geometry_distance_cache(FunctionCallInfoData* fcinfo, const GSERIALIZED* g1, const LWGEOM* lwgeom1, const GSERIALIZED* g2, const LWGEOM* lwgeom2, DISTPTS* dl);
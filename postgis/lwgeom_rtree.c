@@ -18,6 +18,11 @@
 #include "lwgeom_cache.h"
 #include "lwgeom_rtree.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RTREE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
 
 /* Prototypes */
 static void RTreeFree(RTREE_NODE* root);
@@ -48,9 +53,9 @@ RTreeFree(RTREE_NODE* root)
 	if (root->rightNode)
 		RTreeFree(root->rightNode);
 	lwfree(root->interval);
-	if (root->segment)
+	if (root->segments)
 	{
-		lwline_free(root->segment);
+		lwfree(root->segments);
 	}
 	lwfree(root);
 }
@@ -141,7 +146,7 @@ RTreeCreateInteriorNode(RTREE_NODE* left, RTREE_NODE* right)
 	parent->leftNode = left;
 	parent->rightNode = right;
 	parent->interval = RTreeMergeIntervals(left->interval, right->interval);
-	parent->segment = NULL;
+	parent->segments = NULL;
 
 	POSTGIS_DEBUGF(3, "RTreeCreateInteriorNode returning %p", parent);
 
@@ -149,45 +154,55 @@ RTreeCreateInteriorNode(RTREE_NODE* left, RTREE_NODE* right)
 }
 
 /**
-* Creates a leaf node given the pointer to the start point of the segment.
+* Creates a leaf node holding the nsegs segments starting at the given
+* point of the point array.
 */
 static RTREE_NODE* 
-RTreeCreateLeafNode(POINTARRAY* pa, int startPoint)
+RTreeCreateLeafNode(POINTARRAY* pa, int startPoint, int nsegs)
 {
 	RTREE_NODE *parent;
-	LWLINE *line;
-	double value1;
-	double value2;
-	POINT4D tmp;
-	POINTARRAY *npa;
+	RTREE_SEGMENTS *segs;
+	double ymin, ymax;
+	POINT2D p1, p2;
+	int i;
 
-	POSTGIS_DEBUGF(2, "RTreeCreateLeafNode called for point %d of %p", startPoint, pa);
+	POSTGIS_DEBUGF(2, "RTreeCreateLeafNode called for points %d-%d of %p", startPoint, startPoint + nsegs, pa);
 
-	if (pa->npoints < startPoint + 2)
+	if (pa->npoints < startPoint + nsegs + 1)
 	{
-		lwpgerror("RTreeCreateLeafNode: npoints = %d, startPoint = %d", pa->npoints, startPoint);
+		lwpgerror("RTreeCreateLeafNode: npoints = %d, startPoint = %d, nsegs = %d", pa->npoints, startPoint, nsegs);
 	}
 
 	/*
 	 * The given point array will be part of a geometry that will be freed
 	 * independently of the index.	Since we may want to cache the index,
-	 * we must create independent arrays.
+	 * we must copy the coordinates. The segments and their four
+	 * coordinate arrays share a single allocation.
 	 */
-	npa = ptarray_construct_empty(0,0,2);
-
-	getPoint4d_p(pa, startPoint, &tmp);
-	value1 = tmp.y;
-	ptarray_append_point(npa,&tmp,LW_TRUE);
-	
-	getPoint4d_p(pa, startPoint+1, &tmp);
-	value2 = tmp.y;
-	ptarray_append_point(npa,&tmp,LW_TRUE);
+	segs = lwalloc(sizeof(RTREE_SEGMENTS) + 4 * nsegs * sizeof(double));
+	segs->nsegs = nsegs;
+	segs->x1 = (double*)(segs + 1);
+	segs->y1 = segs->x1 + nsegs;
+	segs->x2 = segs->y1 + nsegs;
+	segs->y2 = segs->x2 + nsegs;
+
+	getPoint2d_p(pa, startPoint, &p1);
+	ymin = ymax = p1.y;
+	for (i = 0; i < nsegs; i++)
+	{
+		getPoint2d_p(pa, startPoint + i + 1, &p2);
+		segs->x1[i] = p1.x;
+		segs->y1[i] = p1.y;
+		segs->x2[i] = p2.x;
+		segs->y2[i] = p2.y;
+		ymin = FP_MIN(ymin, p2.y);
+		ymax = FP_MAX(ymax, p2.y);
+		p1 = p2;
+	}
 
-	line = lwline_construct(SRID_UNKNOWN, NULL, npa);
-	
 	parent = lwalloc(sizeof(RTREE_NODE));
-	parent->interval = RTreeCreateInterval(value1, value2);
-	parent->segment = line;
+	parent->interval = RTreeCreateInterval(ymin, ymax);
+	parent->segments = segs;
 	parent->leftNode = NULL;
 	parent->rightNode = NULL;
 
@@ -205,21 +220,23 @@ RTreeCreate(POINTARRAY* pointArray)
 {
 	RTREE_NODE* root;
 	RTREE_NODE** nodes = lwalloc(pointArray->npoints * sizeof(RTREE_NODE*));
-	int i, nodeCount;
+	int i, nodeCount, nsegs;
 	int childNodes, parentNodes;
 
 	POSTGIS_DEBUGF(2, "RTreeCreate called with pointarray %p", pointArray);
 
-	nodeCount = pointArray->npoints - 1;
+	nsegs = pointArray->npoints - 1;
+	nodeCount = (nsegs + RTREE_LEAF_SEGMENTS - 1) / RTREE_LEAF_SEGMENTS;
 
 	POSTGIS_DEBUGF(3, "Total leaf nodes: %d", nodeCount);
 
 	/*
-	 * Create a leaf node for every line segment.
+	 * Create a leaf node for every run of RTREE_LEAF_SEGMENTS segments.
 	 */
 	for (i = 0; i < nodeCount; i++)
 	{
-		nodes[i] = RTreeCreateLeafNode(pointArray, i);
+		int start = i * RTREE_LEAF_SEGMENTS;
+		nodes[i] = RTreeCreateLeafNode(pointArray, start, FP_MIN(RTREE_LEAF_SEGMENTS, nsegs - start));
 	}
 
 	/*
@@ -261,38 +278,6 @@ RTreeCreate(POINTARRAY* pointArray)
 }
 
 
-/** 
-* Merges two multilinestrings into a single multilinestring. 
-*/
-static LWMLINE* 
-RTreeMergeMultiLines(LWMLINE *line1, LWMLINE *line2)
-{
-	LWGEOM **geoms;
-	LWCOLLECTION *col;
-	int i, j, ngeoms;
-
-	POSTGIS_DEBUGF(2, "RTreeMergeMultiLines called on %p, %d, %d; %p, %d, %d", line1, line1->ngeoms, line1->type, line2, line2->ngeoms, line2->type);
-
-	ngeoms = line1->ngeoms + line2->ngeoms;
-	geoms = lwalloc(sizeof(LWGEOM *) * ngeoms);
-
-	j = 0;
-	for (i = 0; i < line1->ngeoms; i++, j++)
-	{
-		geoms[j] = lwgeom_clone((LWGEOM *)line1->geoms[i]);
-	}
-	for (i = 0; i < line2->ngeoms; i++, j++)
-	{
-		geoms[j] = lwgeom_clone((LWGEOM *)line2->geoms[i]);
-	}
-	col = lwcollection_construct(MULTILINETYPE, SRID_UNKNOWN, NULL, ngeoms, geoms);
-
-	POSTGIS_DEBUGF(3, "RTreeMergeMultiLines returning %p, %d, %d", col, col->ngeoms, col->type);
-
-	return (LWMLINE *)col;
-}
-
-
 /**
 * Callback function sent into the GetGeomCache generic caching system. Given a
 * LWGEOM* this function builds and stores an RTREE_POLY_CACHE into the provided
@@ -427,77 +412,245 @@ GetRtreeCache(FunctionCallInfoData* fcinfo, GSERIALIZED* g1)
 }
 
 
-/**
-* Retrieves a collection of line segments given the root and crossing value.
-* The collection is a multilinestring consisting of two point lines
-* representing the segments of the ring that may be crossed by the
-* horizontal projection line at the given y value.
-*/
-LWMLINE *RTreeFindLineSegments(RTREE_NODE *root, double value)
+/*
+ * Point-in-ring kernels.
+ *
+ * Each kernel adds to *wn the winding number contribution of a run of
+ * segments for the given point and returns LW_TRUE as soon as the point is
+ * found on one of the segments. They all implement exactly the same tests
+ * as point_in_ring(), in the same floating point operation order, so that
+ * the results never depend on the kernel in use:
+ *
+ *  - zero length segments are ignored,
+ *  - a point with a zero side value within the segment extent is on the
+ *    boundary,
+ *  - an upward segment with the point on its left increments the winding
+ *    number, a downward one with the point on its right decrements it.
+ */
+typedef int (*RTreeSegmentsKernel)(const RTREE_SEGMENTS *segs, double px, double py, int *wn);
+
+static int
+RTreeSegmentsWindingScalar(const RTREE_SEGMENTS *segs, double px, double py, int *wn)
 {
-	LWMLINE *tmp, *result;
-	LWGEOM **lwgeoms;
+	int i;
 
-	POSTGIS_DEBUGF(2, "RTreeFindLineSegments called for tree %p and value %8.3f", root, value);
+	for (i = 0; i < segs->nsegs; i++)
+	{
+		double x1 = segs->x1[i], y1 = segs->y1[i];
+		double x2 = segs->x2[i], y2 = segs->y2[i];
+		double side;
 
-	result = NULL;
+		/* zero length segments are ignored. */
+		if (((x2-x1)*(x2-x1)+(y2-y1)*(y2-y1)) < 1e-12*1e-12)
+			continue;
 
-	if (!IntervalIsContained(root->interval, value))
-	{
-		POSTGIS_DEBUGF(3, "RTreeFindLineSegments %p: not contained.", root);
+		side = (x2-x1)*(py-y1)-(px-x1)*(y2-y1);
 
-		return NULL;
-	}
+		/* a point on the boundary of a ring is not contained. */
+		if (side == 0.0 &&
+		    FP_MIN(x1, x2) <= px && px <= FP_MAX(x1, x2) &&
+		    FP_MIN(y1, y2) <= py && py <= FP_MAX(y1, y2))
+		{
+			return LW_TRUE;
+		}
 
-	/* If there is a segment defined for this node, include it. */
-	if (root->segment)
-	{
-		POSTGIS_DEBUGF(3, "RTreeFindLineSegments %p: adding segment %p %d.", root, root->segment, root->segment->type);
+		if (FP_CONTAINS_BOTTOM(y1, py, y2) && side > 0)
+			++*wn;
+		else if (FP_CONTAINS_BOTTOM(y2, py, y1) && side < 0)
+			--*wn;
+	}
+	return LW_FALSE;
+}
 
-		lwgeoms = lwalloc(sizeof(LWGEOM *));
-		lwgeoms[0] = (LWGEOM *)root->segment;
+#ifdef RTREE_X86_KERNELS
 
-		POSTGIS_DEBUGF(3, "Found geom %p, type %d, dim %d", root->segment, root->segment->type, FLAGS_GET_Z(root->segment->flags));
+/* Number of set lanes in a movemask result */
+static const int rtree_popcount4[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
 
-		result = (LWMLINE *)lwcollection_construct(MULTILINETYPE, SRID_UNKNOWN, NULL, 1, lwgeoms);
+/**
+* SSE2 kernel, two segments per iteration.
+*/
+__attribute__((target("sse2")))
+static int
+RTreeSegmentsWindingSSE2(const RTREE_SEGMENTS *segs, double px, double py, int *wn)
+{
+	const __m128d vpx = _mm_set1_pd(px);
+	const __m128d vpy = _mm_set1_pd(py);
+	const __m128d vzero = _mm_setzero_pd();
+	const __m128d vzerolen = _mm_set1_pd(1e-12*1e-12);
+	const __m128d vtol = _mm_set1_pd(FP_TOLERANCE);
+	const __m128d vpy_up = _mm_add_pd(vpy, vtol);
+	int i;
+
+	for (i = 0; i + 2 <= segs->nsegs; i += 2)
+	{
+		__m128d x1 = _mm_loadu_pd(segs->x1 + i);
+		__m128d y1 = _mm_loadu_pd(segs->y1 + i);
+		__m128d x2 = _mm_loadu_pd(segs->x2 + i);
+		__m128d y2 = _mm_loadu_pd(segs->y2 + i);
+		__m128d dx = _mm_sub_pd(x2, x1);
+		__m128d dy = _mm_sub_pd(y2, y1);
+		__m128d len = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+		__m128d valid = _mm_cmpge_pd(len, vzerolen);
+		__m128d side = _mm_sub_pd(_mm_mul_pd(dx, _mm_sub_pd(vpy, y1)),
+		                          _mm_mul_pd(_mm_sub_pd(vpx, x1), dy));
+		__m128d on, up, down;
+
+		on = _mm_and_pd(valid, _mm_cmpeq_pd(side, vzero));
+		on = _mm_and_pd(on, _mm_cmple_pd(_mm_min_pd(x1, x2), vpx));
+		on = _mm_and_pd(on, _mm_cmple_pd(vpx, _mm_max_pd(x1, x2)));
+		on = _mm_and_pd(on, _mm_cmple_pd(_mm_min_pd(y1, y2), vpy));
+		on = _mm_and_pd(on, _mm_cmple_pd(vpy, _mm_max_pd(y1, y2)));
+		if (_mm_movemask_pd(on))
+			return LW_TRUE;
+
+		up = _mm_and_pd(_mm_cmple_pd(_mm_sub_pd(y1, vtol), vpy), _mm_cmplt_pd(vpy_up, y2));
+		up = _mm_and_pd(_mm_and_pd(up, valid), _mm_cmpgt_pd(side, vzero));
+		down = _mm_and_pd(_mm_cmple_pd(_mm_sub_pd(y2, vtol), vpy), _mm_cmplt_pd(vpy_up, y1));
+		down = _mm_and_pd(_mm_and_pd(down, valid), _mm_cmplt_pd(side, vzero));
+
+		*wn += rtree_popcount4[_mm_movemask_pd(up)] - rtree_popcount4[_mm_movemask_pd(down)];
 	}
 
-	/* If there is a left child node, recursively include its results. */
-	if (root->leftNode)
+	/* Leftover segment */
+	if (i < segs->nsegs)
 	{
-		POSTGIS_DEBUGF(3, "RTreeFindLineSegments %p: recursing left.", root);
+		RTREE_SEGMENTS tail;
+		tail.nsegs = segs->nsegs - i;
+		tail.x1 = segs->x1 + i;
+		tail.y1 = segs->y1 + i;
+		tail.x2 = segs->x2 + i;
+		tail.y2 = segs->y2 + i;
+		return RTreeSegmentsWindingScalar(&tail, px, py, wn);
+	}
+	return LW_FALSE;
+}
 
-		tmp = RTreeFindLineSegments(root->leftNode, value);
-		if (tmp)
+/**
+* AVX kernel, four segments per iteration.
+*/
+__attribute__((target("avx")))
+static int
+RTreeSegmentsWindingAVX(const RTREE_SEGMENTS *segs, double px, double py, int *wn)
+{
+	const __m256d vpx = _mm256_set1_pd(px);
+	const __m256d vpy = _mm256_set1_pd(py);
+	const __m256d vzero = _mm256_setzero_pd();
+	const __m256d vzerolen = _mm256_set1_pd(1e-12*1e-12);
+	const __m256d vtol = _mm256_set1_pd(FP_TOLERANCE);
+	const __m256d vpy_up = _mm256_add_pd(vpy, vtol);
+	int i, boundary = LW_FALSE;
+
+	for (i = 0; i + 4 <= segs->nsegs; i += 4)
+	{
+		__m256d x1 = _mm256_loadu_pd(segs->x1 + i);
+		__m256d y1 = _mm256_loadu_pd(segs->y1 + i);
+		__m256d x2 = _mm256_loadu_pd(segs->x2 + i);
+		__m256d y2 = _mm256_loadu_pd(segs->y2 + i);
+		__m256d dx = _mm256_sub_pd(x2, x1);
+		__m256d dy = _mm256_sub_pd(y2, y1);
+		__m256d len = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+		__m256d valid = _mm256_cmp_pd(len, vzerolen, _CMP_GE_OQ);
+		__m256d side = _mm256_sub_pd(_mm256_mul_pd(dx, _mm256_sub_pd(vpy, y1)),
+		                             _mm256_mul_pd(_mm256_sub_pd(vpx, x1), dy));
+		__m256d on, up, down;
+
+		on = _mm256_and_pd(valid, _mm256_cmp_pd(side, vzero, _CMP_EQ_OQ));
+		on = _mm256_and_pd(on, _mm256_cmp_pd(_mm256_min_pd(x1, x2), vpx, _CMP_LE_OQ));
+		on = _mm256_and_pd(on, _mm256_cmp_pd(vpx, _mm256_max_pd(x1, x2), _CMP_LE_OQ));
+		on = _mm256_and_pd(on, _mm256_cmp_pd(_mm256_min_pd(y1, y2), vpy, _CMP_LE_OQ));
+		on = _mm256_and_pd(on, _mm256_cmp_pd(vpy, _mm256_max_pd(y1, y2), _CMP_LE_OQ));
+		if (_mm256_movemask_pd(on))
 		{
-			POSTGIS_DEBUGF(3, "Found geom %p, type %d, dim %d", tmp, tmp->type, FLAGS_GET_Z(tmp->flags));
-
-			if (result)
-				result = RTreeMergeMultiLines(result, tmp);
-			else
-				result = tmp;
+			boundary = LW_TRUE;
+			break;
 		}
+
+		up = _mm256_and_pd(_mm256_cmp_pd(_mm256_sub_pd(y1, vtol), vpy, _CMP_LE_OQ),
+		                   _mm256_cmp_pd(vpy_up, y2, _CMP_LT_OQ));
+		up = _mm256_and_pd(_mm256_and_pd(up, valid), _mm256_cmp_pd(side, vzero, _CMP_GT_OQ));
+		down = _mm256_and_pd(_mm256_cmp_pd(_mm256_sub_pd(y2, vtol), vpy, _CMP_LE_OQ),
+		                     _mm256_cmp_pd(vpy_up, y1, _CMP_LT_OQ));
+		down = _mm256_and_pd(_mm256_and_pd(down, valid), _mm256_cmp_pd(side, vzero, _CMP_LT_OQ));
+
+		*wn += rtree_popcount4[_mm256_movemask_pd(up)] - rtree_popcount4[_mm256_movemask_pd(down)];
 	}
 
-	/* Same for any right child. */
-	if (root->rightNode)
+	/* Clear the upper halves before any SSE code runs, the tail included */
+	_mm256_zeroupper();
+	if (boundary)
+		return LW_TRUE;
+
+	/* Leftover segments */
+	if (i < segs->nsegs)
 	{
-		POSTGIS_DEBUGF(3, "RTreeFindLineSegments %p: recursing right.", root);
+		RTREE_SEGMENTS tail;
+		tail.nsegs = segs->nsegs - i;
+		tail.x1 = segs->x1 + i;
+		tail.y1 = segs->y1 + i;
+		tail.x2 = segs->x2 + i;
+		tail.y2 = segs->y2 + i;
+		return RTreeSegmentsWindingSSE2(&tail, px, py, wn);
+	}
+	return LW_FALSE;
+}
 
-		tmp = RTreeFindLineSegments(root->rightNode, value);
-		if (tmp)
-		{
-			POSTGIS_DEBUGF(3, "Found geom %p, type %d, dim %d", tmp, tmp->type, FLAGS_GET_Z(tmp->flags));
+#endif /* RTREE_X86_KERNELS */
 
-			if (result)
-				result = RTreeMergeMultiLines(result, tmp);
-			else
-				result = tmp;
-		}
+/**
+* Pick the widest kernel supported by the CPU we are running on.
+*/
+static RTreeSegmentsKernel
+RTreeSelectKernel(void)
+{
+#ifdef RTREE_X86_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx"))
+	{
+		POSTGIS_DEBUG(3, "RTreeSelectKernel: using AVX point-in-ring kernel");
+		return RTreeSegmentsWindingAVX;
+	}
+	if (__builtin_cpu_supports("sse2"))
+	{
+		POSTGIS_DEBUG(3, "RTreeSelectKernel: using SSE2 point-in-ring kernel");
+		return RTreeSegmentsWindingSSE2;
 	}
+#endif
+	POSTGIS_DEBUG(3, "RTreeSelectKernel: using scalar point-in-ring kernel");
+	return RTreeSegmentsWindingScalar;
+}
 
-	return result;
+static RTreeSegmentsKernel RTreeSegmentsWinding = NULL;
+
+static int
+RTreeWindingNumberRecursive(const RTREE_NODE *root, const POINT2D *point, int *wn)
+{
+	if (!IntervalIsContained(root->interval, point->y))
+		return LW_FALSE;
+
+	if (root->segments && RTreeSegmentsWinding(root->segments, point->x, point->y, wn))
+		return LW_TRUE;
+
+	if (root->leftNode && RTreeWindingNumberRecursive(root->leftNode, point, wn))
+		return LW_TRUE;
+
+	if (root->rightNode && RTreeWindingNumberRecursive(root->rightNode, point, wn))
+		return LW_TRUE;
+
+	return LW_FALSE;
 }
 
+/**
+* Walks the tree down to the leaves whose interval contains the point y
+* value and runs the point-in-ring kernel on their segments.
+*/
+int
+RTreeWindingNumber(const RTREE_NODE *root, const POINT2D *point, int *wn)
+{
+	POSTGIS_DEBUGF(2, "RTreeWindingNumber called for tree %p and point %8.3f %8.3f", root, point->x, point->y);
 
+	if (!RTreeSegmentsWinding)
+		RTreeSegmentsWinding = RTreeSelectKernel();
 
+	return RTreeWindingNumberRecursive(root, point, wn);
+}
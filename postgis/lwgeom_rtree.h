@@ -13,6 +13,26 @@ typedef struct
 }
 RTREE_INTERVAL;
 
+/**
+* Number of consecutive ring segments stored in each leaf of the tree.
+*/
+#define RTREE_LEAF_SEGMENTS 8
+
+/**
+* A run of consecutive ring segments. Coordinates are kept in separate
+* arrays (start x, start y, end x, end y) so the point-in-ring kernels can
+* test a point against several segments at once.
+*/
+typedef struct
+{
+	int nsegs;
+	double *x1;
+	double *y1;
+	double *x2;
+	double *y2;
+}
+RTREE_SEGMENTS;
+
 /**
 * The following struct and methods are used for a 1D RTree implementation,
 * described at:
@@ -23,7 +43,7 @@ typedef struct rtree_node
 	RTREE_INTERVAL *interval;
 	struct rtree_node *leftNode;
 	struct rtree_node *rightNode;
-	LWLINE *segment;
+	RTREE_SEGMENTS *segments;
 }
 RTREE_NODE;
 
@@ -52,9 +72,11 @@ typedef struct {
 
 
 /**
-* Retrieves a collection of line segments given the root and crossing value. 
+* Adds to *wn the winding number contribution of the ring segments crossed
+* by the horizontal line through the point. Returns LW_TRUE if the point
+* lies on the ring, in which case the winding number is meaningless.
 */
-LWMLINE *RTreeFindLineSegments(RTREE_NODE *root, double value);
+int RTreeWindingNumber(const RTREE_NODE *root, const POINT2D *point, int *wn);
 
 
 /**
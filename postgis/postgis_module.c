@@ -20,6 +20,7 @@
 
 #include "lwgeom_log.h"
 #include "lwgeom_pg.h"
+#include "lwgeom_cache.h"
 #include "geos_c.h"
 #include "lwgeom_backend_api.h"
 
@@ -31,6 +32,14 @@ PG_MODULE_MAGIC;
 static pqsigfunc coreIntHandler = 0;
 static void handleInterrupt(int sig);
 
+/* Choices of postgis.binary_format */
+static const struct config_enum_entry binary_format_options[] =
+{
+  {"ewkb", POSTGIS_BINARY_FORMAT_EWKB, false},
+  {"native", POSTGIS_BINARY_FORMAT_NATIVE, false},
+  {NULL, 0, false}
+};
+
 #ifdef WIN32
 static void interruptCallback() {
   if (UNBLOCKED_SIGNAL_QUEUE()) 
@@ -92,6 +101,38 @@ _PG_init(void)
    );
 #endif
 
+  DefineCustomIntVariable(
+    "postgis.geometry_cache_size", /* name */
+    "Sets the memory budget of the backend geometry cache.", /* short_desc */
+    "Prepared geometries and index trees built for repeated geometry arguments are kept across statements up to this size. Zero disables the cache.", /* long_desc */
+    &postgis_geometry_cache_size, /* valueAddr */
+    GEOMETRY_CACHE_SIZE_DEFAULT, /* bootValue */
+    0, MAX_KILOBYTES, /* min-max */
+    PGC_USERSET, /* GucContext context */
+    GUC_UNIT_KB, /* int flags */
+#if POSTGIS_PGSQL_VERSION >= 91
+    NULL, /* GucIntCheckHook check_hook */
+#endif
+    NULL, /* GucIntAssignHook assign_hook */
+    NULL  /* GucShowHook show_hook */
+   );
+
+  DefineCustomEnumVariable(
+    "postgis.binary_format", /* name */
+    "Sets the binary output format of geometry and geography.", /* short_desc */
+    "ewkb is read by any client. native sends the serialized form, which another PostGIS server of the same byte order receives without parsing.", /* long_desc */
+    &postgis_binary_format, /* valueAddr */
+    POSTGIS_BINARY_FORMAT_EWKB, /* bootValue */
+    binary_format_options, /* options */
+    PGC_USERSET, /* GucContext context */
+    0, /* int flags */
+#if POSTGIS_PGSQL_VERSION >= 91
+    NULL, /* GucEnumCheckHook check_hook */
+#endif
+    NULL, /* GucEnumAssignHook assign_hook */
+    NULL  /* GucShowHook show_hook */
+   );
+
     /* install PostgreSQL handlers */
     pg_install_lwgeom_handlers();
 
@@ -51,4 +51,69 @@ COPY tm.geogs_in FROM :tmpfile WITH BINARY;
 SELECT 'geometry', count(*) FROM tm.geogs_in i, tm.geogs o WHERE i.id = o.id
  AND ST_OrderingEquals(i.g::geometry, o.g::geometry);
 
+-- native serialized form
+SET postgis.binary_format = native;
+
+SELECT 'header', substring(geometry_send('POINT(1 2)'::geometry) from 1 for 3);
+
+INSERT INTO tm.geoms(g) VALUES
+ ('SRID=4326;POLYGON((0 0,10 0,10 10,0 0),(1 1,2 1,2 2,1 1))'),
+ ('MULTILINESTRING ZM ((0 0 1 2,1 1 3 4),(5 5 5 5,6 6 6 6))'),
+ ('GEOMETRYCOLLECTION(POINT(1 2),CIRCULARSTRING(0 0,1 1,2 0))');
+
+COPY tm.geoms TO :tmpfile WITH BINARY;
+CREATE TABLE tm.geoms_native AS SELECT * FROM tm.geoms LIMIT 0;
+COPY tm.geoms_native FROM :tmpfile WITH BINARY;
+SELECT 'geometry native', count(*) FROM tm.geoms_native i, tm.geoms o WHERE i.id = o.id
+ AND ST_OrderingEquals(i.g, o.g);
+
+COPY tm.geogs TO :tmpfile WITH BINARY;
+CREATE TABLE tm.geogs_native AS SELECT * FROM tm.geogs LIMIT 0;
+COPY tm.geogs_native FROM :tmpfile WITH BINARY;
+SELECT 'geography native', count(*) FROM tm.geogs_native i, tm.geogs o WHERE i.id = o.id
+ AND ST_OrderingEquals(i.g::geometry, o.g::geometry);
+
+-- geography received as geometry
+CREATE TABLE tm.geogs_geoms (id integer, g geometry);
+COPY tm.geogs_geoms FROM :tmpfile WITH BINARY;
+SELECT 'geography native to geometry', count(*) FROM tm.geogs_geoms i, tm.geogs o WHERE i.id = o.id
+ AND ST_OrderingEquals(i.g, o.g::geometry);
+
+-- a wrong box, taken from another geometry, is computed again
+CREATE TABLE tm.forged (id integer, g bytea);
+INSERT INTO tm.forged SELECT 1,
+ overlay(geometry_send('LINESTRING(0 0,5 5,10 10)'::geometry)
+  placing substring(geometry_send('LINESTRING(100 100,105 105,110 110)'::geometry) from 9 for 16)
+  from 9 for 16);
+COPY tm.forged TO :tmpfile WITH BINARY;
+CREATE TABLE tm.forged_in (id integer, g geometry);
+COPY tm.forged_in FROM :tmpfile WITH BINARY;
+SELECT 'forged box', Box2D(g), g && ST_MakeEnvelope(0,0,1,1), g && ST_MakeEnvelope(100,100,110,110) FROM tm.forged_in;
+
+-- a large geometry keeps its serialization, box slot and all
+CREATE TABLE tm.large AS SELECT 1 AS id,
+ ST_MakeLine(ARRAY(SELECT ST_MakePoint(i, i % 7) FROM generate_series(1, 100000) i)) AS g;
+COPY tm.large TO :tmpfile WITH BINARY;
+CREATE TABLE tm.large_in AS SELECT * FROM tm.large LIMIT 0;
+COPY tm.large_in FROM :tmpfile WITH BINARY;
+SELECT 'large native', ST_NPoints(i.g), Box2D(i.g),
+ geometry_send(i.g) = geometry_send(o.g)
+ FROM tm.large_in i, tm.large o;
+
+-- a point sent with a box slot keeps it, filled with its own box
+CREATE TABLE tm.boxed (id integer, g bytea);
+INSERT INTO tm.boxed SELECT 1,
+ substring(b from 1 for 7) || set_byte('\x00'::bytea, 0, get_byte(b, 7) | 4)
+ || '\x00000000000000000000000000000000'::bytea || substring(b from 9)
+ FROM geometry_send('POINT(1 2)'::geometry) b;
+COPY tm.boxed TO :tmpfile WITH BINARY;
+CREATE TABLE tm.boxed_in (id integer, g geometry);
+COPY tm.boxed_in FROM :tmpfile WITH BINARY;
+SELECT 'boxed point', ST_AsText(g),
+ octet_length(geometry_send(g)) - octet_length(geometry_send('POINT(1 2)'::geometry)),
+ g && ST_MakeEnvelope(0,0,3,3)
+ FROM tm.boxed_in;
+
+RESET postgis.binary_format;
+
 DROP SCHEMA tm CASCADE;
@@ -0,0 +1,24 @@
+-- ST_AsGeoArrow: length, type, dimensions, rows, null rows
+SELECT 'ga1', length(b), get_byte(b, 4), get_byte(b, 5), get_byte(b, 16), get_byte(b, 24) FROM (
+	SELECT ST_AsGeoArrow(g) AS b FROM (VALUES
+		('LINESTRING(0 0,1 1)'::geometry),
+		(NULL),
+		('LINESTRING(2 2,3 3,4 4)')
+	) AS q(g)
+) AS foo;
+-- Polygons with multipolygons make multipolygons
+SELECT 'ga2', length(b), get_byte(b, 4), get_byte(b, 5), get_byte(b, 16), get_byte(b, 24) FROM (
+	SELECT ST_AsGeoArrow(g) AS b FROM (VALUES
+		('POLYGON((0 0,0 1,1 1,0 0))'::geometry),
+		('MULTIPOLYGON(((0 0,0 1,1 1,0 0)),((2 2,2 3,3 3,2 2)))')
+	) AS q(g)
+) AS foo;
+-- Points, with the srid
+SELECT 'ga3', length(b), get_byte(b, 4), get_byte(b, 8), get_byte(b, 9) FROM (
+	SELECT ST_AsGeoArrow(g) AS b FROM (VALUES
+		('SRID=4326;POINT(1 2)'::geometry),
+		('SRID=4326;POINT(3 4)')
+	) AS q(g)
+) AS foo;
+SELECT 'ga4', length(ST_AsGeoArrow(g)) FROM (VALUES ('POINT(0 0)'::geometry), ('LINESTRING(0 0,1 1)')) AS q(g);
+SELECT 'ga5', ST_AsGeoArrow(g) IS NULL FROM (SELECT 'POINT(0 0)'::geometry AS g WHERE false) AS q;
@@ -86,6 +86,16 @@ INSERT INTO test VALUES (1, 'SRID=4269;MULTILINESTRING((0 0, 1 1))');
 SELECT id,ST_AsText(geog) FROM test;
 DROP TABLE test;
 
+-- Large geographies are searched through trees of their edges, and
+-- geographies far apart are turned down on their boxes
+WITH l AS (
+	SELECT ST_MakeLine(ST_MakePoint(i * 0.1, 0) ORDER BY i)::geography AS a,
+	       ST_MakeLine(ST_MakePoint(i * 0.1, 1) ORDER BY i)::geography AS b
+	FROM generate_series(0, 99) i
+)
+SELECT 'geog_dwithin_tree', _ST_DWithin(a, b, 110000, true), _ST_DWithin(a, b, 111000, true), ST_DWithin(a, b, 111000) FROM l;
+SELECT 'geog_dwithin_box', ST_DWithin('POINT(0 0)'::geography, 'POINT(10 0)'::geography, 1000), ST_DWithin('POINT(0 0)'::geography, 'POINT(0.001 0)'::geography, 1000);
+
 -- Clean up spatial_ref_sys
 DELETE FROM spatial_ref_sys WHERE srid IN (4269,4326);
     
\ No newline at end of file
@@ -114,6 +114,10 @@ SELECT '#3069',  postgis_getbbox('SRID=0;LINESTRING(0 0, 1 1)'::geometry);
 SELECT '#3069',  postgis_getbbox('SRID=0;MULTILINESTRING((0 0, 1 1))'::geometry);
 SELECT '#3069',  postgis_getbbox('SRID=0;MULTIPOINT(1 1)'::geometry);
 SELECT '#3069',  postgis_getbbox('SRID=0;MULTILINESTRING((0 0,1 1))'::geometry);
+SELECT 'getbbox1', postgis_getbbox(postgis_addbbox('SRID=0;LINESTRING(0 0,2 3)'::geometry));
+CREATE TEMP TABLE getbbox AS SELECT ST_Segmentize('LINESTRING(0 0,10000 4)'::geometry, 1) AS g;
+SELECT 'getbbox2', postgis_getbbox(g) FROM getbbox;
+DROP TABLE getbbox;
 
 -- ST_BoundingDiagonal
 
@@ -288,3 +288,29 @@ select 'spheroidLength1', round(ST_LengthSpheroid('MULTILINESTRING((-118.584 38.
 
 select 'length2d_spheroid', ST_Length2DSpheroid('LINESTRING(0 0 0, 0 0 100)'::geometry, 'SPHEROID["GRS_1980",6378137,298.257222101]');
 select 'length_spheroid', ST_LengthSpheroid('LINESTRING(0 0 0, 0 0 100)'::geometry, 'SPHEROID["GRS_1980",6378137,298.257222101]');
+
+-- Large lines are measured through trees of their edges, the
+-- repeated arguments keeping their tree from one row to the next
+WITH w AS (
+	SELECT ST_MakeLine(ST_MakePoint(i, 10 * sin(i * 0.37)) ORDER BY i) AS a
+	FROM generate_series(0, 499) i
+), v AS (
+	SELECT ST_MakeLine(ST_MakePoint(i + 0.5, 20.5 + 10 * sin(i * 0.37 + 0.5)) ORDER BY i) AS b
+	FROM generate_series(0, 399) i
+)
+SELECT 'bigdist', n, round(ST_Distance(a, b)::numeric, 6),
+	ST_DWithin(a, b, 5.9), ST_DWithin(a, b, 5.8),
+	ST_AsText(ST_SnapToGrid(ST_ShortestLine(a, b), 0.001)),
+	ST_AsText(ST_SnapToGrid(ST_ClosestPoint(b, a), 0.001))
+FROM w, v, generate_series(1, 3) n ORDER BY n;
+
+-- Within distance searches skip the parts out of reach, pass over the
+-- empty ones, and stop at the first pair close enough
+SELECT 'dwithin_parts', ST_DWithin('MULTILINESTRING((100 100,200 200),(0 1,1 1))'::geometry, 'POINT(0 0)'::geometry, 1.0),
+	ST_DWithin('MULTILINESTRING((100 100,200 200),(0 1,1 1))'::geometry, 'POINT(0 0)'::geometry, 0.5);
+SELECT 'dwithin_empty_part', ST_DWithin('GEOMETRYCOLLECTION(POINT EMPTY,POINT(0 0))'::geometry, 'POINT(0 1)'::geometry, 1.0);
+SELECT 'distance_empty_part', ST_Distance('GEOMETRYCOLLECTION(POINT EMPTY,POINT(0 0))'::geometry, 'POINT(0 1)'::geometry),
+	ST_AsText(ST_ClosestPoint('GEOMETRYCOLLECTION(POINT EMPTY,POINT(0 0))'::geometry, 'POINT(0 1)'::geometry)),
+	ST_AsText(ST_ShortestLine('GEOMETRYCOLLECTION(POINT EMPTY,POINT(0 0))'::geometry, 'POINT(0 1)'::geometry));
+SELECT 'dwithin_curve', ST_DWithin('CIRCULARSTRING(-1 0,0 1,1 0)'::geometry, 'POINT(0 3)'::geometry, 2.0001),
+	ST_DWithin('CIRCULARSTRING(-1 0,0 1,1 0)'::geometry, 'POINT(0 3)'::geometry, 1.9999);
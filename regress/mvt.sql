@@ -0,0 +1,30 @@
+-- ST_AsMVTGeom
+SELECT 'geom1', ST_AsText(ST_AsMVTGeom('POINT(25 17)'::geometry, 'BOX(0 0,4096 4096)'::box2d, 4096, 0, false));
+SELECT 'geom2', ST_AsText(ST_AsMVTGeom('LINESTRING(0 0,10 10)'::geometry, 'BOX(0 0,10 10)'::box2d, 10, 0, true));
+SELECT 'geom3', ST_AsText(ST_AsMVTGeom('POLYGON((0 0,10 0,10 10,0.1 10,0 10,0 0))'::geometry, 'BOX(0 0,10 10)'::box2d, 10, 0, true));
+SELECT 'geom4', ST_AsMVTGeom('POINT(-1 5)'::geometry, 'BOX(0 0,10 10)'::box2d, 10, 0, true) IS NULL;
+SELECT 'geom5', ST_AsText(ST_AsMVTGeom('POINT(-1 5)'::geometry, 'BOX(0 0,10 10)'::box2d, 10, 2, true));
+SELECT 'geom6', ST_AsText(ST_AsMVTGeom('LINESTRING(-1000 100,100 100)'::geometry, 'BOX(0 0,4096 4096)'::box2d));
+SELECT 'geom7', ST_AsText(ST_AsMVTGeom('GEOMETRYCOLLECTION(POINT(1 1),LINESTRING(0 0,10 10))'::geometry, 'BOX(0 0,10 10)'::box2d, 10, 0, true));
+SELECT 'geom8', ST_AsMVTGeom('POINT EMPTY'::geometry, 'BOX(0 0,10 10)'::box2d) IS NULL;
+SELECT 'geom9', ST_AsMVTGeom('POINT(1 1)'::geometry, 'BOX(0 0,10 10)'::box2d, 0);
+
+-- ST_AsMVT
+SELECT 'mvt1', encode(ST_AsMVT(q, 'test', 4096, 'geom'), 'hex') FROM (
+	SELECT 1 AS c1, 'abcd'::text AS c2,
+	ST_AsMVTGeom('POINT(25 17)'::geometry, 'BOX(0 0,4096 4096)'::box2d, 4096, 0, false) AS geom
+) AS q;
+-- Shared values, nulls left out
+SELECT 'mvt2', encode(ST_AsMVT(q), 'hex') FROM (VALUES
+	(1, 'a', 'POINT(1 1)'::geometry),
+	(-2, 'a', 'POINT(2 2)'),
+	(NULL, 'b', 'LINESTRING(0 0,1 1)')
+) AS q(c1, c2, geom);
+-- Rows without geometry have no feature
+SELECT 'mvt3', encode(ST_AsMVT(q), 'hex') FROM (SELECT NULL::geometry AS geom, 1 AS c1) AS q;
+SELECT 'mvt4', encode(ST_AsMVT(q), 'hex') FROM (
+	SELECT true AS c1, 1.5::float8 AS c2, 2.5::float4 AS c3, 'POINT(0 0)'::geometry AS geom
+) AS q;
+SELECT 'mvt5', encode(ST_AsMVT(q), 'hex') FROM (SELECT 1 AS c1, 'POINT(0 0)'::geometry AS geom WHERE false) AS q;
+SELECT 'mvt6', ST_AsMVT(q, 'test', 4096, 'nogeom') FROM (SELECT 1 AS c1, 'POINT(0 0)'::geometry AS geom) AS q;
+SELECT 'mvt7', ST_AsMVT(1);
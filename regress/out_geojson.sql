@@ -0,0 +1,22 @@
+-- ST_AsGeoJSONFeatureCollection
+SELECT 'fc1', ST_AsGeoJSONFeatureCollection(q) FROM (
+	SELECT 1 AS c1, 'abcd'::text AS c2, 'POINT(1.123456 2.123456)'::geometry AS geom
+) AS q;
+-- Precision, and the geometry column picked by name
+SELECT 'fc2', ST_AsGeoJSONFeatureCollection(q, 2, 'g2') FROM (
+	SELECT 'POINT(0 0)'::geometry AS g1, 'LINESTRING(0.123 0.456,1 1)'::geometry AS g2
+) AS q;
+-- Nulls, in the properties and as the geometry
+SELECT 'fc3', ST_AsGeoJSONFeatureCollection(q ORDER BY c1) FROM (VALUES
+	(1, NULL, 'POINT(1 1)'::geometry),
+	(2, 'b', NULL)
+) AS q(c1, c2, geom);
+-- Typed properties, strings are escaped
+SELECT 'fc4', ST_AsGeoJSONFeatureCollection(q) FROM (
+	SELECT true AS c1, 1.5::float8 AS c2, 'NaN'::float8 AS c3, 12.50::numeric AS c4,
+	E'a"b\\c\nd'::text AS "k""ey", 'GEOMETRYCOLLECTION(POINT(0 1))'::geometry AS geom
+) AS q;
+-- No rows
+SELECT 'fc5', ST_AsGeoJSONFeatureCollection(q) FROM (SELECT 1 AS c1, 'POINT(0 0)'::geometry AS geom WHERE false) AS q;
+SELECT 'fc6', ST_AsGeoJSONFeatureCollection(q, 15, 'nogeom') FROM (SELECT 1 AS c1, 'POINT(0 0)'::geometry AS geom) AS q;
+SELECT 'fc7', ST_AsGeoJSONFeatureCollection(1);
@@ -0,0 +1,87 @@
+--- build a larger database
+\i regress_lots_of_points.sql
+
+--- test some of the searching capabilities
+
+CREATE OR REPLACE FUNCTION qnodes(q text) RETURNS text
+LANGUAGE 'plpgsql' AS
+$$
+DECLARE
+  exp TEXT;
+  mat TEXT[];
+  ret TEXT[];
+BEGIN
+  FOR exp IN EXECUTE 'EXPLAIN ' || q
+  LOOP
+    mat := regexp_matches(exp, ' *(?:-> *)?(.*Scan)');
+    IF mat IS NOT NULL THEN
+      ret := array_append(ret, mat[1]);
+    END IF;
+  END LOOP;
+  RETURN array_to_string(ret,',');
+END;
+$$;
+
+-- A few rows that are not 2D points
+INSERT INTO test VALUES (50001, 'POLYGON((120 120,120 140,140 140,140 120,120 120))');
+INSERT INTO test VALUES (50002, 'POINT EMPTY');
+INSERT INTO test VALUES (50003, NULL);
+INSERT INTO test VALUES (50004, 'POINT(130 130 10)');
+
+-- BRIN 2D index
+
+CREATE INDEX quick_brin on test using brin (the_geom) WITH (pages_per_range = 4);
+
+set enable_indexscan = off;
+set enable_bitmapscan = off;
+set enable_seqscan = on;
+
+SELECT 'scan_seq', qnodes('select * from test where the_geom && ST_MakePoint(0,0)');
+ select num,ST_astext(the_geom) from test where the_geom && 'BOX3D(125 125,135 135)'::box3d order by num;
+ select 'overlaps', count(*) from test where the_geom && ST_MakeEnvelope(0,0,500,500);
+ select 'within', count(*) from test where the_geom @ ST_MakeEnvelope(0,0,135,135);
+ select 'contains', count(*) from test where the_geom ~ ST_MakeEnvelope(125,125,135,135);
+ select 'empty', count(*) from test where the_geom && 'POINT EMPTY'::geometry;
+
+set enable_indexscan = off;
+set enable_bitmapscan = on;
+set enable_seqscan = off;
+
+SELECT 'scan_idx', qnodes('select * from test where the_geom && ST_MakePoint(0,0)');
+ select num,ST_astext(the_geom) from test where the_geom && 'BOX3D(125 125,135 135)'::box3d order by num;
+ select 'overlaps', count(*) from test where the_geom && ST_MakeEnvelope(0,0,500,500);
+ select 'within', count(*) from test where the_geom @ ST_MakeEnvelope(0,0,135,135);
+ select 'contains', count(*) from test where the_geom ~ ST_MakeEnvelope(125,125,135,135);
+ select 'empty', count(*) from test where the_geom && 'POINT EMPTY'::geometry;
+
+DROP INDEX quick_brin;
+
+-- BRIN ND index
+
+CREATE INDEX quick_brin_nd on test using brin (the_geom brin_geometry_inclusion_ops_nd) WITH (pages_per_range = 4);
+
+set enable_indexscan = off;
+set enable_bitmapscan = off;
+set enable_seqscan = on;
+
+SELECT 'scan_seq_nd', qnodes('select * from test where the_geom &&& ST_MakePoint(0,0)');
+ select num,ST_astext(the_geom) from test where the_geom &&& ST_MakeEnvelope(125,125,135,135) order by num;
+ select 'overlaps_nd', count(*) from test where the_geom &&& ST_MakeEnvelope(0,0,500,500);
+ select 'overlaps_3d', count(*) from test where the_geom &&& 'LINESTRING(125 125 5,135 135 15)'::geometry;
+
+set enable_indexscan = off;
+set enable_bitmapscan = on;
+set enable_seqscan = off;
+
+SELECT 'scan_idx_nd', qnodes('select * from test where the_geom &&& ST_MakePoint(0,0)');
+ select num,ST_astext(the_geom) from test where the_geom &&& ST_MakeEnvelope(125,125,135,135) order by num;
+ select 'overlaps_nd', count(*) from test where the_geom &&& ST_MakeEnvelope(0,0,500,500);
+ select 'overlaps_3d', count(*) from test where the_geom &&& 'LINESTRING(125 125 5,135 135 15)'::geometry;
+
+DROP TABLE test;
+
+DROP FUNCTION qnodes(text);
+
+set enable_indexscan = on;
+set enable_bitmapscan = on;
+set enable_seqscan = on;
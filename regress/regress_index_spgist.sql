@@ -0,0 +1,72 @@
+--- build a larger database
+\i regress_lots_of_points.sql
+
+--- test some of the searching capabilities
+
+CREATE OR REPLACE FUNCTION qnodes(q text) RETURNS text
+LANGUAGE 'plpgsql' AS
+$$
+DECLARE
+  exp TEXT;
+  mat TEXT[];
+  ret TEXT[];
+BEGIN
+  FOR exp IN EXECUTE 'EXPLAIN ' || q
+  LOOP
+    mat := regexp_matches(exp, ' *(?:-> *)?(.*Scan)');
+    IF mat IS NOT NULL THEN
+      ret := array_append(ret, mat[1]);
+    END IF;
+  END LOOP;
+  RETURN array_to_string(ret,',');
+END;
+$$;
+
+-- A few rows that are not points
+INSERT INTO test VALUES (50001, 'POLYGON((120 120,120 140,140 140,140 120,120 120))');
+INSERT INTO test VALUES (50002, 'POINT EMPTY');
+INSERT INTO test VALUES (50003, NULL);
+-- Larger than an index page, once detoasted
+INSERT INTO test VALUES (50004, ST_Segmentize(ST_MakeEnvelope(-2010,-2010,-2000,-2000), 0.01));
+
+-- SP-GiST index
+
+CREATE INDEX quick_spgist on test using spgist (the_geom spgist_geometry_ops_2d);
+INSERT INTO test VALUES (50005, ST_Segmentize(ST_MakeEnvelope(-3010,-3010,-3000,-3000), 0.01));
+SELECT 'big_size', min(pg_column_size(ST_AsBinary(the_geom))) > 8192 FROM test WHERE num > 50003;
+
+set enable_indexscan = off;
+set enable_bitmapscan = off;
+set enable_seqscan = on;
+
+SELECT 'scan_seq', qnodes('select * from test where the_geom && ST_MakePoint(0,0)');
+ select num,ST_astext(the_geom) from test where the_geom && 'BOX3D(125 125,135 135)'::box3d order by num;
+ select 'overlaps', count(*) from test where the_geom && ST_MakeEnvelope(0,0,500,500);
+ select 'within', count(*) from test where the_geom @ ST_MakeEnvelope(0,0,135,135);
+ select 'contains', count(*) from test where the_geom ~ ST_MakeEnvelope(125,125,135,135);
+ select 'contains_point', count(*) from test where the_geom ~ (select the_geom from test where num = 2594);
+ select 'empty', count(*) from test where the_geom && 'POINT EMPTY'::geometry;
+ select 'big', num from test where the_geom && ST_MakeEnvelope(-3005,-3005,-2005,-2005) order by num;
+ select 'big_within', num from test where the_geom @ ST_MakeEnvelope(-2020,-2020,-1990,-1990);
+
+set enable_indexscan = on;
+set enable_bitmapscan = off;
+set enable_seqscan = off;
+
+SELECT 'scan_idx', qnodes('select * from test where the_geom && ST_MakePoint(0,0)');
+ select num,ST_astext(the_geom) from test where the_geom && 'BOX3D(125 125,135 135)'::box3d order by num;
+ select 'overlaps', count(*) from test where the_geom && ST_MakeEnvelope(0,0,500,500);
+ select 'within', count(*) from test where the_geom @ ST_MakeEnvelope(0,0,135,135);
+ select 'contains', count(*) from test where the_geom ~ ST_MakeEnvelope(125,125,135,135);
+ select 'contains_point', count(*) from test where the_geom ~ (select the_geom from test where num = 2594);
+ select 'empty', count(*) from test where the_geom && 'POINT EMPTY'::geometry;
+ select 'big', num from test where the_geom && ST_MakeEnvelope(-3005,-3005,-2005,-2005) order by num;
+ select 'big_within', num from test where the_geom @ ST_MakeEnvelope(-2020,-2020,-1990,-1990);
+
+DROP TABLE test;
+
+DROP FUNCTION qnodes(text);
+
+set enable_indexscan = on;
+set enable_bitmapscan = on;
+set enable_seqscan = on;
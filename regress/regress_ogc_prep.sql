@@ -296,3 +296,100 @@ SELECT 'covers311', ST_Covers('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))', p) FROM
 ('LINESTRING(1 10, 10 10, 10 8)'),('LINESTRING(1 10, 10 10, 10 8)'),('LINESTRING(1 10, 10 10, 10 8)')
 ) AS v(p);
 
+
+-- PIP - multipoints against a polygon with a hole, batched once cached
+SELECT 'intersects320', ST_Intersects('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES 
+('MULTIPOINT(1 1, 0 5)'),('MULTIPOINT(1 1, 0 5)'),('MULTIPOINT(1 1, 0 5)')
+) AS v(p);
+SELECT 'intersects321', ST_Intersects('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES 
+('MULTIPOINT(1 1, 5 5)'),('MULTIPOINT(1 1, 5 5)'),('MULTIPOINT(1 1, 5 5)')
+) AS v(p);
+SELECT 'intersects322', ST_Intersects('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES 
+('MULTIPOINT(5 5, 4 5)'),('MULTIPOINT(5 5, 4 5)'),('MULTIPOINT(5 5, 4 5)')
+) AS v(p);
+SELECT 'intersects323', ST_Intersects('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES 
+('MULTIPOINT(0 0, 10 10)'),('MULTIPOINT(0 0, 10 10)'),('MULTIPOINT(0 0, 10 10)')
+) AS v(p);
+SELECT 'intersects324', ST_Intersects('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES 
+('MULTIPOINT(5 5, 5.5 5.5)'),('MULTIPOINT(5 5, 5.5 5.5)'),('MULTIPOINT(5 5, 5.5 5.5)')
+) AS v(p);
+SELECT 'contains320', ST_Contains('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES 
+('MULTIPOINT(1 1, 0 5)'),('MULTIPOINT(1 1, 0 5)'),('MULTIPOINT(1 1, 0 5)')
+) AS v(p);
+SELECT 'contains321', ST_Contains('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES 
+('MULTIPOINT(1 1, 5 5)'),('MULTIPOINT(1 1, 5 5)'),('MULTIPOINT(1 1, 5 5)')
+) AS v(p);
+SELECT 'contains322', ST_Contains('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES 
+('MULTIPOINT(5 5, 4 5)'),('MULTIPOINT(5 5, 4 5)'),('MULTIPOINT(5 5, 4 5)')
+) AS v(p);
+SELECT 'contains323', ST_Contains('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES 
+('MULTIPOINT(0 0, 10 10)'),('MULTIPOINT(0 0, 10 10)'),('MULTIPOINT(0 0, 10 10)')
+) AS v(p);
+SELECT 'contains324', ST_Contains('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES 
+('MULTIPOINT(5 5, 5.5 5.5)'),('MULTIPOINT(5 5, 5.5 5.5)'),('MULTIPOINT(5 5, 5.5 5.5)')
+) AS v(p);
+SELECT 'covers320', ST_Covers('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES 
+('MULTIPOINT(1 1, 0 5)'),('MULTIPOINT(1 1, 0 5)'),('MULTIPOINT(1 1, 0 5)')
+) AS v(p);
+SELECT 'covers321', ST_Covers('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES 
+('MULTIPOINT(1 1, 5 5)'),('MULTIPOINT(1 1, 5 5)'),('MULTIPOINT(1 1, 5 5)')
+) AS v(p);
+SELECT 'covers322', ST_Covers('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES 
+('MULTIPOINT(5 5, 4 5)'),('MULTIPOINT(5 5, 4 5)'),('MULTIPOINT(5 5, 4 5)')
+) AS v(p);
+SELECT 'covers323', ST_Covers('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES 
+('MULTIPOINT(0 0, 10 10)'),('MULTIPOINT(0 0, 10 10)'),('MULTIPOINT(0 0, 10 10)')
+) AS v(p);
+SELECT 'covers324', ST_Covers('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES 
+('MULTIPOINT(5 5, 5.5 5.5)'),('MULTIPOINT(5 5, 5.5 5.5)'),('MULTIPOINT(5 5, 5.5 5.5)')
+) AS v(p);
+-- Backend geometry cache, one row per statement
+SELECT 'intersects330', ST_Intersects('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', 'POINT(5 5)');
+SELECT 'intersects330', ST_Intersects('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', 'POINT(1 1)');
+SELECT 'intersects330', ST_Intersects('POINT(5 5)', 'POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))');
+SELECT 'intersects330', ST_Intersects('POINT(2 2)', 'POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))');
+SELECT 'contains330', ST_Contains('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', 'LINESTRING(1 1, 3 3)');
+SELECT 'contains330', ST_Contains('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', 'LINESTRING(1 1, 5 5)');
+SET postgis.geometry_cache_size = 0;
+SELECT 'intersects331', ST_Intersects('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', 'POINT(5 5)');
+SELECT 'intersects331', ST_Intersects('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', 'POINT(1 1)');
+RESET postgis.geometry_cache_size;
+-- Cache instrumentation
+SELECT 'cachestats1', count(*) FROM (SELECT postgis_cache_stats_reset()) AS r;
+SELECT 'cachestats2', count(*) FROM (SELECT ST_Intersects('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0),(4 4, 4 6, 6 6, 6 4, 4 4))', p) FROM ( VALUES
+('POINT(1 1)'),('POINT(2 2)'),('POINT(5 5)')
+) AS v(p)) AS q;
+SELECT 'cachestats3', cache, hits, misses, builds, flips, evictions FROM postgis_cache_stats() WHERE cache = 'rtree';
+-- Statement cache with alternating arguments
+SET postgis.geometry_cache_size = 0;
+SELECT 'cachestats4', count(*) FROM (SELECT postgis_cache_stats_reset()) AS r;
+SELECT 'cachestats5', ST_Intersects(g, p) FROM ( VALUES
+('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))', 'POINT(1 1)'),
+('POLYGON((20 0, 20 10, 30 10, 30 0, 20 0))', 'POINT(21 1)'),
+('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))', 'POINT(2 2)'),
+('POLYGON((20 0, 20 10, 30 10, 30 0, 20 0))', 'POINT(25 5)'),
+('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))', 'POINT(3 3)'),
+('POLYGON((20 0, 20 10, 30 10, 30 0, 20 0))', 'POINT(22 2)')
+) AS v(g, p);
+SELECT 'cachestats6', cache, hits, misses, builds, flips FROM postgis_cache_stats() WHERE cache = 'rtree';
+RESET postgis.geometry_cache_size;
+-- Backend cache, built once a later statement uses the geometry again
+SELECT 'cachestats7', count(*) FROM (SELECT postgis_cache_stats_reset()) AS r;
+SELECT 'cachestats8', ST_Intersects('POLYGON((100 0, 100 10, 110 10, 110 0, 100 0))', 'POINT(101 1)');
+SELECT 'cachestats8', ST_Intersects('POLYGON((100 0, 100 10, 110 10, 110 0, 100 0))', 'POINT(102 2)');
+SELECT 'cachestats8', ST_Intersects('POLYGON((100 0, 100 10, 110 10, 110 0, 100 0))', 'POINT(105 5)');
+SELECT 'cachestats9', cache, hits, misses, builds, flips FROM postgis_cache_stats() WHERE cache = 'rtree';
+-- Statement cache first with the backend cache on, the backend
+-- cache only builds the geometry for the next statement
+SELECT 'cachestats10', count(*) FROM (SELECT postgis_cache_stats_reset()) AS r;
+SELECT 'cachestats11', ST_Intersects(g, p) FROM ( VALUES
+('POLYGON((200 0, 200 10, 210 10, 210 0, 200 0))', 'POINT(201 1)'),
+('POLYGON((220 0, 220 10, 230 10, 230 0, 220 0))', 'POINT(221 1)'),
+('POLYGON((200 0, 200 10, 210 10, 210 0, 200 0))', 'POINT(202 2)'),
+('POLYGON((220 0, 220 10, 230 10, 230 0, 220 0))', 'POINT(225 5)'),
+('POLYGON((200 0, 200 10, 210 10, 210 0, 200 0))', 'POINT(203 3)'),
+('POLYGON((220 0, 220 10, 230 10, 230 0, 220 0))', 'POINT(222 2)')
+) AS v(g, p);
+SELECT 'cachestats12', cache, hits, misses, builds, flips FROM postgis_cache_stats() WHERE cache = 'rtree';
+SELECT 'cachestats13', ST_Intersects('POLYGON((200 0, 200 10, 210 10, 210 0, 200 0))', 'POINT(204 4)');
+SELECT 'cachestats14', cache, hits, misses, builds, flips FROM postgis_cache_stats() WHERE cache = 'rtree';
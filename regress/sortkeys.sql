@@ -0,0 +1,27 @@
+-- Spatial ordering keys
+CREATE TEMP TABLE sortkeys (id int, geom geometry);
+INSERT INTO sortkeys VALUES
+  (1, 'POINT(-1 -1)'),
+  (2, 'POINT(-1 1)'),
+  (3, 'POINT(1 1)'),
+  (4, 'POINT(1 -1)'),
+  (5, 'POLYGON((10 10,10 12,12 12,12 10,10 10))'),
+  (6, 'LINESTRING(-12 -12,-10 -10)');
+
+-- Hilbert walks the quadrants in a U, Morton in a Z
+SELECT 'hilbert1', string_agg(id::text, ',' ORDER BY ST_HilbertKey(geom)) FROM sortkeys WHERE id <= 4;
+SELECT 'morton1', string_agg(id::text, ',' ORDER BY ST_MortonKey(geom)) FROM sortkeys WHERE id <= 4;
+
+-- Keys follow the box center, and keep their order as signed bigints
+SELECT 'hilbert2', string_agg(id::text, ',' ORDER BY ST_HilbertKey(geom)) FROM sortkeys;
+SELECT 'morton2', string_agg(id::text, ',' ORDER BY ST_MortonKey(geom)) FROM sortkeys;
+
+-- Empty geometries have no key
+SELECT 'empty1', ST_HilbertKey('POINT EMPTY') IS NULL, ST_MortonKey('GEOMETRYCOLLECTION EMPTY') IS NULL;
+
+-- Usable as an index expression for CLUSTER
+CREATE INDEX sortkeys_hilbert_idx ON sortkeys (ST_HilbertKey(geom));
+CLUSTER sortkeys USING sortkeys_hilbert_idx;
+SELECT 'cluster1', string_agg(id::text, ',') FROM sortkeys;
+
+DROP TABLE sortkeys;
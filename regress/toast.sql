@@ -0,0 +1,49 @@
+-- Large geometries stored out of line, so that the functions reading
+-- only the front of them get slices rather than the whole value
+SET client_min_messages TO warning;
+CREATE TABLE toast_geoms (id int, g geometry);
+ALTER TABLE toast_geoms ALTER COLUMN g SET STORAGE EXTERNAL;
+
+INSERT INTO toast_geoms SELECT 1, ST_SetSRID(ST_MakeLine(ST_MakePoint(i, i) ORDER BY i), 4326)
+FROM generate_series(1, 10000) i;
+INSERT INTO toast_geoms SELECT 2, ST_SetSRID(ST_Buffer('POINT(0 0)'::geometry, 10, 1000), 4326);
+INSERT INTO toast_geoms SELECT 3, ST_SetSRID(('GEOMETRYCOLLECTION(' || repeat('POINT EMPTY,', 1000) || 'POINT EMPTY)')::geometry, 4326);
+INSERT INTO toast_geoms SELECT 4, ST_Multi(g) FROM toast_geoms WHERE id = 2;
+
+SELECT 'header', id, ST_SRID(g), GeometryType(g), ST_GeometryType(g), ST_IsEmpty(g)
+FROM toast_geoms ORDER BY id;
+SELECT 'startpoint', id, ST_AsText(ST_StartPoint(g)) FROM toast_geoms WHERE id = 1;
+
+-- Rejected on the boxes
+SELECT 'far', id, ST_Intersects(g, 'SRID=4326;POINT(-100 -100)'::geometry),
+  ST_Disjoint(g, 'SRID=4326;POINT(-100 -100)'::geometry),
+  ST_Contains(g, 'SRID=4326;POINT(-100 -100)'::geometry),
+  ST_Equals(g, 'SRID=4326;POINT(-100 -100)'::geometry)
+FROM toast_geoms WHERE id <> 3 ORDER BY id;
+
+-- Past the boxes, on the whole geometries
+SELECT 'near', id, ST_Intersects(g, 'SRID=4326;POINT(5000 5000)'::geometry),
+  ST_Disjoint(g, 'SRID=4326;POINT(5000 5000)'::geometry),
+  ST_Equals(g, g)
+FROM toast_geoms WHERE id = 1;
+SELECT 'near', id, ST_Contains(g, 'SRID=4326;POINT(0 0)'::geometry),
+  ST_Covers(g, 'SRID=4326;POINT(0 0)'::geometry),
+  ST_Touches(g, 'SRID=4326;POINT(0 0)'::geometry)
+FROM toast_geoms WHERE id IN (2, 4) ORDER BY id;
+
+-- Default storage, where large values are compressed before they go
+-- out of line and are detoasted whole
+CREATE TABLE toast_geoms_main (id int, g geometry);
+INSERT INTO toast_geoms_main SELECT id, g FROM toast_geoms;
+
+SELECT 'main_header', id, ST_SRID(g), GeometryType(g), ST_IsEmpty(g)
+FROM toast_geoms_main ORDER BY id;
+SELECT 'main_far', id, ST_Intersects(g, 'SRID=4326;POINT(-100 -100)'::geometry),
+  ST_Disjoint(g, 'SRID=4326;POINT(-100 -100)'::geometry)
+FROM toast_geoms_main WHERE id <> 3 ORDER BY id;
+SELECT 'main_near', id, ST_Intersects(g, 'SRID=4326;POINT(0 0)'::geometry),
+  ST_Contains(g, 'SRID=4326;POINT(0 0)'::geometry)
+FROM toast_geoms_main WHERE id <> 3 ORDER BY id;
+
+DROP TABLE toast_geoms_main;
+DROP TABLE toast_geoms;
@@ -64,3 +64,18 @@ select 'POLYGON((1 1, 1 2, 2 2, 2 1, 1 1))'::text g
 --GEOMETRYCOLLECTION with bounding box ref #3187
 select encode(st_astwkb(st_collect('point(4 1)'::geometry,'linestring(1 1, 0 3)'::geometry),0,0,0,false,true),'hex');
 
+
+--ST_DumpTWKB, members of a collection with ids
+select 'dump1', id, st_astext(geom) from ST_DumpTWKB(ST_AsTWKB(array['POINT(1 1)'::geometry,'POINT(2 3)'::geometry], array[10,20]::bigint[]));
+select 'dump2', id, st_astext(geom) from ST_DumpTWKB(ST_AsTWKB(array['LINESTRING(0 0,5 5)'::geometry,'POLYGON((1 1,1 2,2 2,2 1,1 1))'::geometry,'POINT(78 -78)'::geometry], array[-1,2,3000000000]::bigint[]));
+--ST_DumpTWKB, geometries without ids come out whole
+select 'dump3', id, st_astext(geom) from ST_DumpTWKB(ST_AsTWKB('MULTIPOINT((1 1),(2 2))'::geometry) || ST_AsTWKB(array['POINT(1 1)'::geometry,'POINT(2 3)'::geometry], array[10,20]::bigint[]));
+--ST_DumpTWKBChunks, the same bytes cut three at a time
+create temp table twkb_chunks as select n, substring(b from n for 3) c from
+(select ST_AsTWKB(array['LINESTRING(0 0,5 5)'::geometry,'POLYGON((1 1,1 2,2 2,2 1,1 1))'::geometry,'POINT(78 -78)'::geometry], array[-1,2,3000000000]::bigint[]) b) foo,
+generate_series(1, 100, 3) n where n <= length(b);
+begin;
+declare twkb_cur cursor for select c from twkb_chunks order by n;
+select 'chunks1', id, st_astext(geom) from ST_DumpTWKBChunks('twkb_cur');
+commit;
+drop table twkb_chunks;
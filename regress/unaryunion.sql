@@ -8,3 +8,9 @@ SELECT 2, ST_AsText(ST_UnaryUnion('GEOMETRYCOLLECTION(POLYGON((0 0, 10 0, 10 10,
 -- Unioning an heterogeneous collection of geometries
 SELECT 3, ST_AsText(ST_UnaryUnion('GEOMETRYCOLLECTION(POLYGON((0 0, 10 0, 10 10, 0 10, 0 0)),POLYGON((5 5, 15 5, 15 15, 5 15, 5 5)), MULTIPOINT(5 4, -5 4),LINESTRING(2 -10, 2 20))'));
 
+
+-- Aggregate union large enough to be reduced in batches
+SELECT 4, ST_Area(u), ST_GeometryType(u), ST_NPoints(ST_Simplify(u, 0)) FROM (
+  SELECT ST_Union(ST_MakeEnvelope(x, y, x + 1, y + 1)) u
+  FROM generate_series(0, 99) x, generate_series(0, 99) y
+) foo;